@@ -0,0 +1,237 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "util.h"
+
+/* The memory of a functional: its lda/gga/mgga structure, its
+   parameters, and all its auxiliary functionals with their own
+   structures and parameters. A B3LYP is a few hundred bytes that fit
+   in the first block, so the whole tree is one allocation, and the
+   structures that the mixing visits are next to each other. */
+
+/* all the allocations are aligned to this number of bytes */
+#define ARENA_ALIGN(size) (((size) + 15) & ~((size_t) 15))
+
+/* size of the first block, and minimum size of the next ones */
+#define ARENA_BLOCK_SIZE   2048
+
+/* scratch memory in the first block, see XC(arena_scratch_get) */
+#define ARENA_SCRATCH_SIZE 512
+
+typedef struct arena_block{
+  char  *base;
+  size_t size, used;                    /* in bytes */
+  struct arena_block *next;             /* the block allocated when this one was full */
+} arena_block;
+
+struct XC(struct_arena_type){
+  arena_block  first;                   /* its memory follows the scratch region */
+  arena_block *last;                    /* the block we are filling */
+
+  void  *scratch;                       /* scratch memory of the evaluations */
+  size_t scratch_size;
+  int    scratch_busy;                  /* 1 while an evaluation holds the scratch memory */
+};
+
+/* an evaluation holds the scratch memory until it releases it. Other
+   threads that evaluate the same functional at the same time get
+   their own memory. */
+#if defined(__GNUC__)
+#  define SCRATCH_ACQUIRE(a) (__sync_lock_test_and_set(&(a)->scratch_busy, 1) == 0)
+#  define SCRATCH_RELEASE(a) __sync_lock_release(&(a)->scratch_busy)
+#else
+#  define SCRATCH_ACQUIRE(a) 0
+#  define SCRATCH_RELEASE(a) ((void) 0)
+#endif
+
+
+/*------------------------------------------------------*/
+/* an arena whose first block holds at least size bytes */
+static XC(arena_type) *arena_new(size_t size)
+{
+  XC(arena_type) *a;
+  size_t head = ARENA_ALIGN(sizeof(XC(arena_type)));
+
+  size = (size > ARENA_BLOCK_SIZE) ? ARENA_ALIGN(size) : ARENA_BLOCK_SIZE;
+
+  a = (XC(arena_type) *) calloc(1, head + ARENA_SCRATCH_SIZE + size);
+  if(a == NULL){
+    fprintf(stderr, "Could not allocate the memory of the functional\n");
+    exit(1);
+  }
+
+  a->scratch      = (char *) a + head;
+  a->scratch_size = ARENA_SCRATCH_SIZE;
+  a->first.base   = (char *) a + head + ARENA_SCRATCH_SIZE;
+  a->first.size   = size;
+  a->last         = &(a->first);
+
+  return a;
+}
+
+/* the scratch region that was allocated with the arena */
+#define SCRATCH_EMBEDDED(a) ((char *) (a) + ARENA_ALIGN(sizeof(XC(arena_type))))
+
+
+/*------------------------------------------------------*/
+XC(arena_type) *XC(arena_new)(void)
+{
+  return arena_new(0);
+}
+
+
+/*------------------------------------------------------*/
+/* returns size bytes, set to zero, that live as long as the arena */
+void *XC(arena_alloc)(XC(arena_type) *a, size_t size)
+{
+  arena_block *b;
+  void *mem;
+
+  assert(a != NULL);
+
+  size = ARENA_ALIGN(size);
+  b    = a->last;
+  if(b->used + size > b->size){
+    size_t head  = ARENA_ALIGN(sizeof(arena_block));
+    size_t bsize = (size > ARENA_BLOCK_SIZE) ? size : ARENA_BLOCK_SIZE;
+
+    b = (arena_block *) calloc(1, head + bsize);
+    if(b == NULL){
+      fprintf(stderr, "Could not allocate the memory of the functional\n");
+      exit(1);
+    }
+    b->base = (char *) b + head;
+    b->size = bsize;
+
+    a->last->next = b;
+    a->last       = b;
+  }
+
+  mem = b->base + b->used;
+  b->used += size;
+
+  return mem;
+}
+
+
+/*------------------------------------------------------*/
+void XC(arena_free)(XC(arena_type) *a)
+{
+  arena_block *b, *next;
+
+  if(a == NULL) return;
+
+  for(b=a->first.next; b!=NULL; b=next){
+    next = b->next;
+    free(b);
+  }
+
+  if(a->scratch != SCRATCH_EMBEDDED(a))
+    free(a->scratch);
+
+  free(a);
+}
+
+
+/*------------------------------------------------------*/
+/* Returns a new arena with a copy of the memory of src in its first
+   block, followed by extra free bytes. The pointers into src that the
+   copy contains are translated with XC(arena_relocate). */
+XC(arena_type) *XC(arena_copy)(const XC(arena_type) *src, size_t extra)
+{
+  XC(arena_type) *a;
+  const arena_block *b;
+  size_t size = ARENA_ALIGN(extra);
+
+  for(b=&(src->first); b!=NULL; b=b->next)
+    size += b->used;
+
+  a = arena_new(size);
+  for(b=&(src->first); b!=NULL; b=b->next){
+    memcpy(a->first.base + a->first.used, b->base, b->used);
+    a->first.used += b->used;
+  }
+
+  return a;
+}
+
+
+/*------------------------------------------------------*/
+/* the address in the copy dst = XC(arena_copy)(src, ...) of ptr, that
+   points to memory of src */
+void *XC(arena_relocate)(const XC(arena_type) *src, XC(arena_type) *dst, const void *ptr)
+{
+  const arena_block *b;
+  const char *c = (const char *) ptr;
+  size_t offset = 0;
+
+  if(ptr == NULL) return NULL;
+
+  for(b=&(src->first); b!=NULL; b=b->next){
+    if(c >= b->base && c < b->base + b->used)
+      return dst->first.base + offset + (c - b->base);
+    offset += b->used;
+  }
+
+  assert(0); /* ptr is not in the arena */
+  return NULL;
+}
+
+
+/*------------------------------------------------------*/
+/* Temporary memory for an evaluation, returned with
+   XC(arena_scratch_release). The arena keeps the largest one it was
+   asked for, so the repeated calls of a program do not allocate. */
+void *XC(arena_scratch_get)(XC(arena_type) *a, size_t size)
+{
+  void *mem;
+
+  if(a != NULL && SCRATCH_ACQUIRE(a)){
+    if(size <= a->scratch_size)
+      return a->scratch;
+
+    mem = malloc(size);
+    if(mem != NULL){
+      if(a->scratch != SCRATCH_EMBEDDED(a))
+	free(a->scratch);
+      a->scratch      = mem;
+      a->scratch_size = size;
+      return mem;
+    }
+
+    SCRATCH_RELEASE(a);
+  }
+
+  return malloc(size);
+}
+
+
+/*------------------------------------------------------*/
+void XC(arena_scratch_release)(XC(arena_type) *a, void *mem)
+{
+  if(mem == NULL) return;
+
+  if(a != NULL && mem == a->scratch)
+    SCRATCH_RELEASE(a);
+  else
+    free(mem);
+}
@@ -0,0 +1,460 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(HAVE_CLOCK_GETTIME)
+#include <time.h>
+#else
+#include <sys/time.h>
+#endif
+
+#if defined(HAVE_LINUX_PERF_EVENT_H) && defined(HAVE_SYSCALL)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#  if defined(SYS_perf_event_open)
+#    define HAVE_PERF_EVENTS 1
+#  endif
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "util.h"
+
+/* Statistics of the evaluations of the functionals. They are disabled
+   by default: the drivers and the kernels then only test the stats
+   pointer. When they are enabled every functional of the tree (the
+   functional and its auxiliary functionals) gets its own counters. */
+
+
+/*------------------------------------------------------*/
+/* The hardware counters (XC_STATS_COUNTERS) are read with
+   perf_event_open. They are opened once, as a group, for the thread
+   that enables them first, and only count user space. They are read
+   around the calls made by that thread outside of parallel regions:
+   the calls of the other threads, the clones of the functional used by
+   other host threads included, and the calls with more than one
+   thread only measure the time. The events that the kernel refuses (no
+   PMU in a virtual machine, perf_event_paranoid, ...) are left out;
+   without any the statistics fall back to the timers. */
+#if defined(HAVE_PERF_EVENTS)
+static int   perf_leader = -2;               /* -2 if not opened yet, -1 if not available */
+static int   perf_nopen  = 0;                /* events in the group                       */
+static int   perf_event[XC_STATS_NEVENTS];   /* event of each member of the group         */
+static pid_t perf_tid    = 0;                /* thread that the counters count            */
+
+/* the counters are opened by one thread at a time */
+#if defined(__GNUC__)
+static int perf_lock = 0;
+#  define PERF_LOCK()   while(__sync_lock_test_and_set(&perf_lock, 1)) {}
+#  define PERF_UNLOCK() __sync_lock_release(&perf_lock)
+#else
+#  define PERF_LOCK()
+#  define PERF_UNLOCK()
+#endif
+
+static int
+perf_open(int event, int group)
+{
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size           = sizeof(attr);
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  switch(event){
+  case XC_STATS_CYCLES:
+    attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case XC_STATS_INSTRUCTIONS:
+    attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case XC_STATS_BRANCH_MISSES:
+    attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    break;
+  case XC_STATS_L1D_MISSES:
+    attr.type   = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    break;
+  case XC_STATS_LLC_MISSES:
+    attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    break;
+  }
+
+  return (int) syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+/* returns the mask of the events that are counted */
+static int
+perf_init(void)
+{
+  int ie, fd, mask;
+
+  PERF_LOCK();
+  if(perf_leader == -2){
+    perf_leader = -1;
+    for(ie=0; ie<XC_STATS_NEVENTS; ie++){
+      fd = perf_open(ie, perf_leader);
+      if(fd < 0) continue;
+
+      if(perf_leader < 0) perf_leader = fd;
+      perf_event[perf_nopen++] = ie;
+    }
+    perf_tid = (pid_t) syscall(SYS_gettid);
+  }
+
+  for(ie=0, mask=0; ie<perf_nopen; ie++)
+    mask |= 1 << perf_event[ie];
+  PERF_UNLOCK();
+
+  return mask;
+}
+
+/* the events since the counters were opened, scaled up if they were
+   multiplexed with other users of the counters. Returns 0 in the
+   threads that the counters do not count. */
+static int
+perf_read(double *events)
+{
+  unsigned long long buf[3 + XC_STATS_NEVENTS];
+  int ie, ok;
+
+  PERF_LOCK();
+  ok = (perf_leader >= 0 && perf_tid == (pid_t) syscall(SYS_gettid));
+  PERF_UNLOCK();
+
+  if(!ok || read(perf_leader, buf, sizeof(buf)) < (ssize_t) ((3 + perf_nopen)*sizeof(buf[0])) || buf[2] == 0)
+    return 0;
+
+  for(ie=0; ie<perf_nopen; ie++)
+    events[perf_event[ie]] = (double) buf[3 + ie]*((double) buf[1]/(double) buf[2]);
+  return 1;
+}
+#else
+static int perf_init(void) { return 0; }
+static int perf_read(double *events) { return 0; }
+#endif
+
+/* the events below XC_STATS_POW are the hardware counters */
+#define HW_EVENTS ((1 << XC_STATS_POW) - 1)
+
+#if defined(XC_COUNT_OPS)
+long XC(op_count)[XC_STATS_NEVENTS];
+#define OP_EVENTS (((1 << XC_STATS_NEVENTS) - 1) & ~HW_EVENTS)
+#else
+#define OP_EVENTS 0
+#endif
+
+/* all the events counted so far by this thread */
+static int
+stats_read(int counters, double *events)
+{
+#if defined(XC_COUNT_OPS)
+  int ie;
+#endif
+
+  if((counters & HW_EVENTS) && !perf_read(events))
+    return 0;
+
+#if defined(XC_COUNT_OPS)
+  for(ie=XC_STATS_POW; ie<XC_STATS_NEVENTS; ie++)
+    if(counters & (1 << ie))
+      events[ie] = (double) XC(op_count)[ie];
+#endif
+  return 1;
+}
+
+/* the auxiliary functionals of p, or NULL */
+static int
+stats_aux(const XC(func_type) *p, XC(func_type) ***aux, FLOAT **coef)
+{
+  switch(p->info->family){
+  case(XC_FAMILY_GGA):
+  case(XC_FAMILY_HYB_GGA):
+    *aux = p->gga->func_aux;  *coef = p->gga->mix_coef;
+    return p->gga->n_func_aux;
+  case(XC_FAMILY_MGGA):
+    *aux = p->mgga->func_aux; *coef = p->mgga->mix_coef;
+    return p->mgga->n_func_aux;
+  }
+
+  *aux = NULL; *coef = NULL;
+  return 0;
+}
+
+
+/*------------------------------------------------------*/
+/* enables (XC_STATS_ON or XC_STATS_COUNTERS) or disables (XC_STATS_OFF)
+   the statistics of p and of its auxiliary functionals. Enabling them
+   again keeps the counters. */
+void XC(func_set_stats)(XC(func_type) *p, int enable)
+{
+  XC(func_type) **aux;
+  FLOAT *coef;
+  int ii, naux;
+
+  assert(p != NULL && p->info != NULL);
+
+  if(enable && p->stats == NULL)
+    p->stats = (XC(func_stats_type) *) calloc(1, sizeof(XC(func_stats_type)));
+  if(!enable && p->stats != NULL){
+    free(p->stats);
+    p->stats = NULL;
+  }
+  if(p->stats != NULL){
+    p->stats->mode     = enable;
+    p->stats->counters = ((enable == XC_STATS_COUNTERS) ? perf_init() : 0) | OP_EVENTS;
+  }
+
+  /* the kernels only see the family structure */
+  switch(p->info->family){
+  case(XC_FAMILY_LDA):
+    p->lda->stats  = p->stats;
+    break;
+  case(XC_FAMILY_GGA):
+  case(XC_FAMILY_HYB_GGA):
+    p->gga->stats  = p->stats;
+    break;
+  case(XC_FAMILY_MGGA):
+    p->mgga->stats = p->stats;
+    break;
+  }
+
+  naux = stats_aux(p, &aux, &coef);
+  for(ii=0; ii<naux; ii++)
+    XC(func_set_stats)(aux[ii], enable);
+}
+
+
+/*------------------------------------------------------*/
+void XC(func_stats_reset)(XC(func_type) *p)
+{
+  XC(func_type) **aux;
+  FLOAT *coef;
+  int ii, naux;
+
+  assert(p != NULL && p->info != NULL);
+
+  if(p->stats != NULL){
+    int mode = p->stats->mode, counters = p->stats->counters;
+
+    memset(p->stats, 0, sizeof(XC(func_stats_type)));
+    p->stats->mode     = mode;
+    p->stats->counters = counters;
+  }
+
+  naux = stats_aux(p, &aux, &coef);
+  for(ii=0; ii<naux; ii++)
+    XC(func_stats_reset)(aux[ii]);
+}
+
+
+/*------------------------------------------------------*/
+/* copies the statistics of p (not of its auxiliary functionals, which
+   can be queried directly) to stats. Returns -1 if they are disabled. */
+int XC(func_stats_get)(const XC(func_type) *p, XC(func_stats_type) *stats)
+{
+  assert(p != NULL && stats != NULL);
+
+  if(p->stats == NULL){
+    memset(stats, 0, sizeof(XC(func_stats_type)));
+    return -1;
+  }
+
+  *stats = *(p->stats);
+  return 0;
+}
+
+
+/*------------------------------------------------------*/
+static const char *event_name[XC_STATS_NEVENTS] = 
+  {"cycles", "instructions", "branch misses", "L1d misses", "LLC misses",
+   "pow", "log", "exp", "sqrt", "cbrt", "asinh", "atan", "erf"};
+
+static void
+stats_print(const XC(func_type) *p, FILE *out, int depth, FLOAT coef, int has_coef)
+{
+  const XC(func_stats_type) *s = p->stats;
+  XC(func_type) **aux;
+  FLOAT *mix;
+  int ii, naux, order, ie;
+
+  fprintf(out, "%*s", 2*depth, "");
+  if(has_coef) fprintf(out, "%g x ", (double) coef);
+  fprintf(out, "%s (%d)", p->info->name, p->info->number);
+
+  if(s == NULL)
+    fprintf(out, ": disabled\n");
+  else{
+    fprintf(out, ": %ld calls, %ld points, %ld screened by density, %ld by gradient",
+	    s->calls, s->points, s->screened_dens, s->screened_grad);
+    fprintf(out, ", orders %ld/%ld/%ld/%ld, %.6f s",
+	    s->orders[0], s->orders[1], s->orders[2], s->orders[3], s->time);
+    if(s->points > 0)
+      fprintf(out, " (%.1f ns/point)", 1e9*s->time/s->points);
+    fprintf(out, "\n");
+
+    /* the profile: figures per point of every derivative order */
+    for(order=0; (s->mode == XC_STATS_COUNTERS || s->counters != 0) && order<4; order++){
+      if(s->order_points[order] == 0) continue;
+
+      fprintf(out, "%*s  order %d: %ld points, %.1f ns", 2*depth, "", order,
+	      s->order_points[order], 1e9*s->order_time[order]/s->order_points[order]);
+      for(ie=0; ie<XC_STATS_NEVENTS; ie++)
+	if(s->counters & (1 << ie) && s->order_counted[order] > 0)
+	  fprintf(out, ", %.1f %s", s->events[order][ie]/s->order_counted[order], event_name[ie]);
+      fprintf(out, " per point\n");
+    }
+  }
+
+  naux = stats_aux(p, &aux, &mix);
+  for(ii=0; ii<naux; ii++)
+    stats_print(aux[ii], out, depth + 1, (mix == NULL) ? 0.0 : mix[ii], mix != NULL);
+}
+
+/* prints the statistics of p and of its auxiliary functionals, one
+   line per functional, the auxiliary ones indented below their parent
+   with their mixing coefficients (when they are mixed) */
+void XC(func_stats_print)(const XC(func_type) *p, FILE *out)
+{
+  assert(p != NULL && p->info != NULL);
+
+  stats_print(p, (out == NULL) ? stdout : out, 0, 0.0, 0);
+}
+
+
+/*------------------------------------------------------*/
+/* wall time in seconds */
+static double
+stats_time(void)
+{
+#if defined(HAVE_CLOCK_GETTIME)
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+#else
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+#endif
+}
+
+/* called by the drivers before the evaluation, when the statistics of p are enabled */
+void XC(stats_begin)(const XC(func_type) *p, XC(stats_mark_type) *m)
+{
+  m->counted = 0;
+  if(p->stats->counters != 0 && p->nthreads == 1){
+#ifdef _OPENMP
+    if(!omp_in_parallel())
+#endif
+      m->counted = stats_read(p->stats->counters, m->events);
+  }
+
+  m->time = stats_time();
+}
+
+/* and after it. The aux functionals are called from the threads of
+   their parent, so the counters are updated atomically. */
+void XC(stats_end)(const XC(func_type) *p, const XC(stats_mark_type) *m, size_t np, int order)
+{
+  XC(func_stats_type) *s = p->stats;
+  double time, events[XC_STATS_NEVENTS];
+  int ie;
+
+  time = stats_time() - m->time;
+
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  s->calls++;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  s->points += np;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  s->orders[order]++;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  s->order_points[order] += np;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  s->time += time;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  s->order_time[order] += time;
+
+  /* m->counted is only set in the thread that the counters count */
+  if(m->counted && stats_read(s->counters, events)){
+    s->order_counted[order] += np;
+    for(ie=0; ie<XC_STATS_NEVENTS; ie++)
+      if(s->counters & (1 << ie))
+	s->events[order][ie] += events[ie] - m->events[ie];
+  }
+}
+
+void XC(stats_screened)(XC(func_stats_type) *s, int ndens, int ngrad)
+{
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  s->screened_dens += ndens;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  s->screened_grad += ngrad;
+}
+
+/* counts, in a block of np points, the points with the density below
+   MIN_DENS and, among the others, the spin channels with the gradient
+   below MIN_GRAD; for the kernels that screen point by point */
+void XC(stats_screen_block)(XC(func_stats_type) *s, int nspin, int np,
+			    const FLOAT *rho, int n_rho, const FLOAT *sigma, int n_sigma)
+{
+  FLOAT sfact2 = (nspin == XC_POLARIZED) ? 1.0 : 4.0;
+  int ip, is, ndens = 0, ngrad = 0;
+
+  for(ip=0; ip<np; ip++, rho+=n_rho, sigma+=n_sigma){
+    if(((nspin == XC_POLARIZED) ? rho[0] + rho[1] : rho[0]) < MIN_DENS){
+      ndens++;
+      continue;
+    }
+
+    for(is=0; is<nspin; is++)
+      ngrad += (rho[is] >= MIN_DENS && sigma[(is == 0) ? 0 : 2]/sfact2 <= MIN_GRAD*MIN_GRAD);
+  }
+
+  XC(stats_screened)(s, ndens, ngrad);
+}
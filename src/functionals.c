@@ -17,9 +17,11 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include <assert.h>
 
-#include "xc.h"
+#include "util.h"
 
 extern XC(func_info_type) 
   *XC(lda_known_funct)[], 
@@ -27,84 +29,153 @@ extern XC(func_info_type)
   *XC(hyb_gga_known_funct)[],
   *XC(mgga_known_funct)[];
 
+/* The registry of the functionals, written by get_funcs.pl: func_key
+   gives the family of every id up to FUNC_MAX_ID, and the position of
+   the functional in the list of its family. The names are the ones of
+   the XC_ macros, in lowercase and without the prefix, and are found
+   through a perfect hash: the id of a name is in func_name_slot, at
+   the position given by func_name_hash and func_name_disp. */
+typedef struct{
+  int family;                           /* XC_FAMILY_UNKNOWN for the unused ids */
+  int number;                           /* position in XC(lda_known_funct), ... */
+  const char *name;                     /* e.g. "gga_x_pbe" for XC_GGA_X_PBE */
+} func_key_type;
+
+#include "funcs_key.c"
+
+/* 32 bit FNV-1a, starting from the offset basis xor d; get_funcs.pl
+   computes the same numbers */
+static unsigned long func_name_hash(const char *name, unsigned long d)
+{
+  unsigned long h = 2166136261UL ^ d;
+
+  for(; *name != '\0'; name++){
+    h ^= (unsigned char) *name;
+    h  = (h*16777619UL) & 0xffffffffUL;
+  }
+  return h;
+}
+
+
 /*------------------------------------------------------*/
 int XC(family_from_id)(int id, int *family, int *number)
 {
-  int ii;
+  if(id < 0 || id > FUNC_MAX_ID || func_key[id].family == XC_FAMILY_UNKNOWN)
+    return XC_FAMILY_UNKNOWN;
 
-  /* first let us check if it is an LDA */
-  for(ii=0; XC(lda_known_funct)[ii]!=NULL; ii++){
-    if(XC(lda_known_funct)[ii]->number == id){
-      if(family != NULL) *family = XC_FAMILY_LDA;
-      if(number != NULL) *number = ii;
-      return XC_FAMILY_LDA;
-    }
-  }
+  if(family != NULL) *family = func_key[id].family;
+  if(number != NULL) *number = func_key[id].number;
+  return func_key[id].family;
+}
 
-  /* or is it a GGA? */
-  for(ii=0; XC(gga_known_funct)[ii]!=NULL; ii++){
-    if(XC(gga_known_funct)[ii]->number == id){
-      if(family != NULL) *family = XC_FAMILY_GGA;
-      if(number != NULL) *number = ii;
-      return XC_FAMILY_GGA;
-    }
-  }
 
-  /* or is it a hybrid GGA? */
-  for(ii=0; XC(hyb_gga_known_funct)[ii]!=NULL; ii++){
-    if(XC(hyb_gga_known_funct)[ii]->number == id){
-      if(family != NULL) *family = XC_FAMILY_HYB_GGA;
-      if(number != NULL) *number = ii;
-      return XC_FAMILY_HYB_GGA;
-    }
-  }
+/*------------------------------------------------------*/
+/* returns the id of a functional from its name, e.g. "XC_GGA_X_PBE" or
+   "gga_x_pbe", or -1 if there is no such functional. The prefix XC_ is
+   optional and the case does not matter. */
+int XC(functional_get_number)(const char *name)
+{
+  char key[64];
+  int ii, id;
+
+  if(name == NULL) return -1;
+
+  if(toupper((unsigned char) name[0]) == 'X' && toupper((unsigned char) name[1]) == 'C' && name[2] == '_')
+    name += 3;
 
-  /* or is it a meta GGA? */
-  for(ii=0; XC(mgga_known_funct)[ii]!=NULL; ii++){
-    if(XC(mgga_known_funct)[ii]->number == id){
-      if(family != NULL) *family = XC_FAMILY_MGGA;
-      if(number != NULL) *number = ii;
-      return XC_FAMILY_MGGA;
-    }
+  for(ii=0; name[ii] != '\0'; ii++){
+    if(ii == sizeof(key) - 1) return -1; /* longer than any name */
+    key[ii] = tolower((unsigned char) name[ii]);
   }
+  key[ii] = '\0';
+
+  id = func_name_hash(key, 0) % FUNC_NAME_BUCKETS;
+  id = func_name_slot[func_name_hash(key, func_name_disp[id]) % FUNC_NAME_SLOTS];
+
+  return (id >= 0 && strcmp(func_key[id].name, key) == 0) ? id : -1;
+}
+
+
+/*------------------------------------------------------*/
+/* the name of a functional, in lowercase and without the XC_ prefix,
+   or NULL if there is no functional with this id */
+const char *XC(functional_get_name)(int id)
+{
+  if(id < 0 || id > FUNC_MAX_ID) return NULL;
+
+  return func_key[id].name;
+}
+
+
+/*------------------------------------------------------*/
+int XC(number_of_functionals)(void)
+{
+  return FUNC_NUMBER;
+}
+
+
+/*------------------------------------------------------*/
+/* fills list, of XC(number_of_functionals)() elements, with the ids
+   of all the functionals, in increasing order */
+void XC(available_functional_numbers)(int *list)
+{
+  int id, n = 0;
 
-  return XC_FAMILY_UNKNOWN;
+  for(id=0; id<=FUNC_MAX_ID; id++)
+    if(func_key[id].family != XC_FAMILY_UNKNOWN)
+      list[n++] = id;
 }
 
 
 /*------------------------------------------------------*/
 int XC(func_init)(XC(func_type) *p, int functional, int nspin)
 {
-  int number;
+  return XC(func_init_aux)(p, functional, nspin, NULL);
+}
+
+
+/*------------------------------------------------------*/
+/* With a NULL arena the functional gets its own one */
+int XC(func_init_aux)(XC(func_type) *p, int functional, int nspin, XC(arena_type) *arena)
+{
+  int number, family;
 
   assert(p != NULL);
   assert(nspin==XC_UNPOLARIZED || nspin==XC_POLARIZED);
 
-  p->nspin = nspin;
+  p->nspin       = nspin;
+  p->nthreads    = 1;
+  p->layout      = NULL;
+  p->output_mode = XC_OUTPUT_OVERWRITE;
+  p->stats       = NULL;
+
+  family = XC(family_from_id)(functional, NULL, &number);
+  if(family == XC_FAMILY_UNKNOWN)
+    return -2; /* family not found */
+
+  p->own_arena = (arena == NULL);
+  p->arena     = (arena == NULL) ? XC(arena_new)() : arena;
 
-  switch(XC(family_from_id)(functional, NULL, &number)){
+  switch(family){
   case(XC_FAMILY_LDA):
-    p->lda  = (XC(lda_type) *) malloc(sizeof(XC(lda_type)));
+    p->lda  = (XC(lda_type) *) XC(arena_alloc)(p->arena, sizeof(XC(lda_type)));
     p->info = XC(lda_known_funct)[number];
     return XC(lda_init)(p, p->info, nspin);
 
   case(XC_FAMILY_GGA):
-    p->gga = (XC(gga_type) *) malloc(sizeof(XC(gga_type)));
+    p->gga = (XC(gga_type) *) XC(arena_alloc)(p->arena, sizeof(XC(gga_type)));
     p->info = XC(gga_known_funct)[number];
     return XC(gga_init)(p, p->info, nspin);
 
   case(XC_FAMILY_HYB_GGA):
-    p->gga = (XC(gga_type) *) malloc(sizeof(XC(gga_type)));
+    p->gga = (XC(gga_type) *) XC(arena_alloc)(p->arena, sizeof(XC(gga_type)));
     p->info = XC(hyb_gga_known_funct)[number];
     return XC(gga_init)(p, p->info, nspin);
 
-  case(XC_FAMILY_MGGA):
-    p->mgga = (XC(mgga_type) *) malloc(sizeof(XC(mgga_type)));
+  default: /* XC_FAMILY_MGGA */
+    p->mgga = (XC(mgga_type) *) XC(arena_alloc)(p->arena, sizeof(XC(mgga_type)));
     p->info = XC(mgga_known_funct)[number];
     return XC(mgga_init)(p, p->info, nspin);
-
-  default:
-    return -2; /* family not found */
   }
 }
 
@@ -112,25 +183,224 @@ int XC(func_init)(XC(func_type) *p, int functional, int nspin)
 /*------------------------------------------------------*/
 void XC(func_end)(XC(func_type) *p)
 {
+  XC(arena_type) *arena;
+
   assert(p != NULL && p->info != NULL);
 
   switch(p->info->family){
   case(XC_FAMILY_LDA):
     XC(lda_end)(p);
-    free(p->lda);
     break;
 
   case(XC_FAMILY_GGA):
   case(XC_FAMILY_HYB_GGA):
     XC(gga_end)(p);
-    free(p->gga);
     break;
 
   case(XC_FAMILY_MGGA):
     XC(mgga_end)(p);
-    free(p->mgga);
     break;
   }
 
-  p->info = NULL;  
+  if(p->layout != NULL){
+    free(p->layout);
+    p->layout = NULL;
+  }
+
+  if(p->stats != NULL){
+    free(p->stats);
+    p->stats = NULL;
+  }
+
+  /* the structures of the functional, and of its auxiliary
+     functionals, are all in the arena. So is p itself, when it was
+     made by XC(func_clone). */
+  arena = p->own_arena ? p->arena : NULL;
+  p->arena = NULL;
+  p->info  = NULL;
+
+  XC(arena_free)(arena);
+}
+
+
+/*------------------------------------------------------*/
+/* p is a byte copy of a functional whose arena, from, was copied to
+   the arena to. Points p and its auxiliary functionals to the copies
+   in to, and gives them their own copies of the memory that is not
+   in the arena. */
+#define RELOCATE(ptr) ((ptr) = XC(arena_relocate)(from, to, (ptr)))
+
+static void
+func_relocate(XC(func_type) *p, const XC(arena_type) *from, XC(arena_type) *to)
+{
+  XC(func_type) **aux = NULL;
+  int ii, naux = 0;
+
+  p->arena = to;
+  p->stats = NULL;
+
+  if(p->layout != NULL){
+    const XC(layout_type) *layout = p->layout;
+
+    p->layout = (XC(layout_type) *) malloc(sizeof(XC(layout_type)));
+    *(p->layout) = *layout;
+  }
+
+  switch(p->info->family){
+  case(XC_FAMILY_LDA):
+    RELOCATE(p->lda);
+    RELOCATE(p->lda->params);
+    p->lda->arena  = to;
+    p->lda->layout = p->layout;
+    p->lda->stats  = NULL;
+    XC(lda_table_dup)(p->lda);
+    break;
+
+  case(XC_FAMILY_GGA):
+  case(XC_FAMILY_HYB_GGA):
+    RELOCATE(p->gga);
+    RELOCATE(p->gga->params);
+    RELOCATE(p->gga->func_aux);
+    RELOCATE(p->gga->mix_coef);
+    p->gga->arena = to;
+    p->gga->stats = NULL;
+    XC(gga_x_table_dup)(p->gga);
+
+    aux  = p->gga->func_aux;
+    naux = p->gga->n_func_aux;
+    break;
+
+  case(XC_FAMILY_MGGA):
+    RELOCATE(p->mgga);
+    RELOCATE(p->mgga->params);
+    RELOCATE(p->mgga->func_aux);
+    RELOCATE(p->mgga->mix_coef);
+    p->mgga->arena = to;
+    p->mgga->stats = NULL;
+
+    aux  = p->mgga->func_aux;
+    naux = p->mgga->n_func_aux;
+    break;
+  }
+
+  for(ii=0; ii<naux; ii++){
+    RELOCATE(aux[ii]);
+    func_relocate(aux[ii], from, to);
+  }
+}
+
+#undef RELOCATE
+
+static void
+func_copy(XC(func_type) *dst, const XC(func_type) *src, XC(arena_type) *arena)
+{
+  *dst = *src;
+  dst->own_arena = 1;
+  func_relocate(dst, src->arena, arena);
+
+  /* the copy counts its own evaluations */
+  if(src->stats != NULL)
+    XC(func_set_stats)(dst, src->stats->mode);
+}
+
+
+/*------------------------------------------------------*/
+/* Initializes dst as a copy of the initialized functional src, with
+   the same parameters, tables, layout and settings. The whole tree of
+   auxiliary functionals is copied in one allocation, and the copy
+   shares nothing with src: it can be evaluated by another thread
+   while src is used or changed. Free it with XC(func_end). */
+int XC(func_copy)(XC(func_type) *dst, const XC(func_type) *src)
+{
+  assert(dst != NULL && src != NULL && src->info != NULL);
+
+  func_copy(dst, src, XC(arena_copy)(src->arena, 0));
+  return 0;
+}
+
+
+/*------------------------------------------------------*/
+/* the same, but the func_type of the copy is also allocated in its
+   arena. XC(func_end) frees it. */
+XC(func_type) *XC(func_clone)(const XC(func_type) *src)
+{
+  XC(arena_type) *arena;
+  XC(func_type) *p;
+
+  assert(src != NULL && src->info != NULL);
+
+  arena = XC(arena_copy)(src->arena, sizeof(XC(func_type)));
+  p     = (XC(func_type) *) XC(arena_alloc)(arena, sizeof(XC(func_type)));
+
+  func_copy(p, src, arena);
+  return p;
+}
+
+
+/*------------------------------------------------------*/
+/* the points are split in blocks that are evaluated in parallel by
+   nthreads OpenMP threads. Without OpenMP support this is a no-op. */
+void XC(func_set_nthreads)(XC(func_type) *p, int nthreads)
+{
+  assert(p != NULL);
+
+  p->nthreads = (nthreads > 1) ? nthreads : 1;
+}
+
+
+/*------------------------------------------------------*/
+/* sets the memory layout of the arrays passed to XC(lda), XC(gga) and
+   XC(mgga). A NULL layout restores the default interleaved one. */
+void XC(func_set_layout)(XC(func_type) *p, const XC(layout_type) *layout)
+{
+  assert(p != NULL && p->info != NULL);
+
+  if(layout == NULL){
+    if(p->layout != NULL)
+      free(p->layout);
+    p->layout = NULL;
+  }else{
+    if(p->layout == NULL)
+      p->layout = (XC(layout_type) *) malloc(sizeof(XC(layout_type)));
+    *(p->layout) = *layout;
+  }
+
+  /* the LDA kernels read and write the arrays directly in this layout */
+  if(p->info->family == XC_FAMILY_LDA)
+    p->lda->layout = p->layout;
+}
+
+
+/*------------------------------------------------------*/
+/* spin-planar layout: every component (rho_up, rho_dn, sigma_uu, ...)
+   is stored in a contiguous array, and consecutive components are ld
+   elements apart */
+void XC(func_set_layout_planar)(XC(func_type) *p, size_t ld)
+{
+  XC(layout_type) layout;
+  XC(stride_type) s;
+
+  s.point = 1;
+  s.comp  = ld;
+
+  layout.rho    = layout.sigma  = layout.lapl_rho  = layout.tau  = s;
+  layout.zk     = layout.vrho   = layout.vsigma    = layout.vlapl_rho = layout.vtau = s;
+  layout.v2rho2 = layout.v2rhosigma = layout.v2sigma2 = s;
+  layout.v2rhotau = layout.v2tausigma = layout.v2tau2 = s;
+  layout.v3rho3 = s;
+
+  XC(func_set_layout)(p, &layout);
+}
+
+
+/*------------------------------------------------------*/
+/* by default the outputs are overwritten with the results; with
+   XC_OUTPUT_ACCUMULATE the results are added to the values that are
+   already in the output arrays */
+void XC(func_set_output_mode)(XC(func_type) *p, int mode)
+{
+  assert(p != NULL);
+  assert(mode == XC_OUTPUT_OVERWRITE || mode == XC_OUTPUT_ACCUMULATE);
+
+  p->output_mode = mode;
 }
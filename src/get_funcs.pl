@@ -30,7 +30,7 @@ foreach $func (@funcs){
 
   read_file($srcdir, $func);
 
-  $s1 = ""; $s2 = "";
+  $s1 = ""; $s2 = ""; $number = 0;
   foreach $key (sort { $a <=> $b } keys %deflist_f) {
     $s0 .= sprintf "%s %-20s %3s  /*%-60s*/\n", "#define ",
       $deflist_f{$key}, $key, $deflist_c{$key};
@@ -41,6 +41,13 @@ foreach $func (@funcs){
     $t = $deflist_f{$key};
     $t =~ s/XC_(.*)/\L$1/;
 
+    # the registry only knows the families of XC(func_init)
+    if($func ne "lca"){
+      $key_family{$key} = "XC_FAMILY_\U$func";
+      $key_number{$key} = $number++;
+      $key_name{$key}   = $t;
+    }
+
     $s1 .= "extern XC(func_info_type) XC(func_info_$t);\n";
     $s2 .= "  &XC(func_info_$t),\n";
   }
@@ -59,6 +66,8 @@ EOF
   close OUT;
 }
 
+write_registry("$builddir/funcs_key.c");
+
 open(OUT, ">$builddir/xc_funcs.h");
 print OUT $s0;
 print $so;
@@ -99,3 +108,100 @@ sub read_file() {
   }
   closedir DIR;
 }
+
+# The registry of the functionals, included by functionals.c: the
+# family of every id, and a perfect hash of the names. A name is in
+# the slot hash(name, disp[hash(name, 0) % nbuckets]) % nslots, where
+# disp is chosen below, bucket by bucket, so that no two names share
+# a slot. The hash is the 32 bit FNV-1a of the name, starting from the
+# FNV offset xor the displacement; func_name_hash in functionals.c
+# must compute the same numbers.
+sub write_registry() {
+  my ($file) = @_;
+  my (@ids, $maxid, $nslots, $nbuckets, @buckets, @slot, @disp, $s, $id, $k, $d);
+
+  @ids   = sort { $a <=> $b } keys %key_name;
+  $maxid = $ids[-1];
+
+  for($nslots=1; $nslots < @ids; $nslots*=2){}
+  $nbuckets = $nslots/4;
+
+  foreach $id (@ids){
+    push @{$buckets[name_hash($key_name{$id}, 0) % $nbuckets]}, $id;
+  }
+
+  @slot = (-1) x $nslots;
+  @disp = (0) x $nbuckets;
+  # the largest buckets first, while most slots are free
+  foreach $k (sort { scalar(@{$buckets[$b]}) <=> scalar(@{$buckets[$a]}) || $a <=> $b }
+	      grep { defined $buckets[$_] } 0..$nbuckets-1){
+    for($d=0; ; $d++){
+      die "get_funcs.pl: no perfect hash of the names" if($d > 65535);
+
+      my (%used, $ok);
+      $ok = 1;
+      foreach $id (@{$buckets[$k]}){
+	my $i = name_hash($key_name{$id}, $d) % $nslots;
+	if($slot[$i] != -1 || $used{$i}){ $ok = 0; last; }
+	$used{$i} = $id;
+      }
+      next if(!$ok);
+
+      foreach (keys %used){ $slot[$_] = $used{$_}; }
+      $disp[$k] = $d;
+      last;
+    }
+  }
+
+  open(OUT, ">$file");
+  print OUT "/* the registry of the functionals, generated by get_funcs.pl */\n\n";
+  printf OUT "#define FUNC_MAX_ID       %d\n", $maxid;
+  printf OUT "#define FUNC_NUMBER       %d\n", scalar(@ids);
+  printf OUT "#define FUNC_NAME_SLOTS   %d\n", $nslots;
+  printf OUT "#define FUNC_NAME_BUCKETS %d\n\n", $nbuckets;
+
+  print OUT "static const func_key_type func_key[FUNC_MAX_ID + 1] = {\n";
+  for($id=0; $id<=$maxid; $id++){
+    if(defined $key_name{$id}){
+      $s = sprintf "{%s, %d, \"%s\"}", $key_family{$id}, $key_number{$id}, $key_name{$id};
+    }else{
+      $s = "{XC_FAMILY_UNKNOWN, -1, NULL}";
+    }
+    printf OUT "  %-50s /* %3d */\n", $s.(($id < $maxid) ? "," : ""), $id;
+  }
+  print OUT "};\n\n";
+
+  print OUT "static const unsigned short func_name_disp[FUNC_NAME_BUCKETS] = {\n";
+  print OUT list_lines(@disp);
+  print OUT "};\n\n";
+
+  print OUT "static const short func_name_slot[FUNC_NAME_SLOTS] = {\n";
+  print OUT list_lines(@slot);
+  print OUT "};\n";
+  close OUT;
+}
+
+sub list_lines() {
+  my $s = "";
+  my $i;
+
+  for($i=0; $i<@_; $i++){
+    $s .= ($i % 12 == 0) ? "  " : " ";
+    $s .= sprintf "%4d", $_[$i];
+    $s .= "," if($i < $#_);
+    $s .= "\n" if($i % 12 == 11 || $i == $#_);
+  }
+  return $s;
+}
+
+# FNV-1a, with the products split so that they stay exact without 64 bit integers
+sub name_hash() {
+  my ($name, $d) = @_;
+  my $h = (2166136261 ^ $d);
+
+  foreach (unpack("C*", $name)){
+    $h ^= $_;
+    $h = (($h % 65536)*16777619 + (((int($h/65536)*16777619) % 65536)*65536)) % 4294967296;
+  }
+  return $h;
+}
@@ -43,6 +43,9 @@ int XC(gga_init)(XC(func_type) *p, const XC(func_info_type) *info, int nspin)
   func->func_aux   = NULL;
   func->mix_coef   = NULL;
   func->exx_coef   = 0.0;
+  func->x_table    = NULL;
+  func->stats      = p->stats;
+  func->arena      = p->arena;
 
   /* initialize spin counters */
   func->n_zk  = 1;
@@ -70,6 +73,8 @@ void XC(gga_end)(XC(func_type) *p)
   assert(p != NULL && p->gga != NULL);
   func = p->gga;
 
+  XC(gga_x_table_end)(func);
+
   /* call internal termination routine */
   if(func->info->end != NULL)
     func->info->end(func);
@@ -78,26 +83,144 @@ void XC(gga_end)(XC(func_type) *p)
   if(func->n_func_aux > 0){
     int ii;
 
-    for(ii=0; ii<func->n_func_aux; ii++){
+    for(ii=0; ii<func->n_func_aux; ii++)
       XC(func_end)(func->func_aux[ii]);
-      free(func->func_aux[ii]);
-    }
-    free(func->func_aux);
+    func->func_aux   = NULL;
     func->n_func_aux = 0;
   }
 
-  if(func->mix_coef != NULL){
-    free(func->mix_coef);
-    func->mix_coef = NULL;
+  func->mix_coef = NULL;
+
+  /* the parameters are in the arena of the functional */
+  func->params = NULL;
+}
+
+/* evaluates a contiguous block of points. The kernels add to outputs
+   that must be zero, so these are cleared OUTPUT_BLOCK_SIZE points at
+   a time, right before the kernel fills them */
+static void
+gga_block(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigma,
+	  FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
+	  FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
+{
+  XC(gga_type) *func = p->gga;
+  int ib, nb;
+
+  for(ib=0; ib<np; ib+=OUTPUT_BLOCK_SIZE){
+    nb = min(np - ib, OUTPUT_BLOCK_SIZE);
+
+    /* initialize output to zero */
+    if(zk != NULL)
+      memset(zk, 0, nb*sizeof(FLOAT)*func->n_zk);
+
+    if(vrho != NULL){
+      assert(vsigma != NULL);
+    
+      memset(vrho,   0, nb*sizeof(FLOAT)*func->n_vrho);
+      memset(vsigma, 0, nb*sizeof(FLOAT)*func->n_vsigma);
+    }
+
+    if(v2rho2 != NULL){
+      assert(v2rhosigma!=NULL && v2sigma2!=NULL);
+
+      memset(v2rho2,     0, nb*sizeof(FLOAT)*func->n_v2rho2);
+      memset(v2rhosigma, 0, nb*sizeof(FLOAT)*func->n_v2rhosigma);
+      memset(v2sigma2,   0, nb*sizeof(FLOAT)*func->n_v2sigma2);
+    }
+
+    /* call functional */
+    if(func->info->gga != NULL)
+      func->info->gga(func, nb, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+
+    if(func->mix_coef != NULL){
+      XC(mix_func)(p, func->n_func_aux, func->func_aux, func->mix_coef, 
+		   nb, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+    }
+
+    /* increment pointers */
+    rho   += nb*func->n_rho;
+    sigma += nb*func->n_sigma;
+
+    if(zk != NULL)
+      zk += nb*func->n_zk;
+
+    if(vrho != NULL){
+      vrho   += nb*func->n_vrho;
+      vsigma += nb*func->n_vsigma;
+    }
+
+    if(v2rho2 != NULL){
+      v2rho2     += nb*func->n_v2rho2;
+      v2rhosigma += nb*func->n_v2rhosigma;
+      v2sigma2   += nb*func->n_v2sigma2;
+    }
+  }
+}
+
+
+/* evaluates a block of points stored in the layout of p, or adds the
+   results to the output arrays. The GGA kernels work on interleaved
+   arrays that they overwrite, so the points are copied in chunks to
+   buffers, evaluated, and the results copied or added back */
+static void
+gga_block_layout(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigma,
+		 FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
+		 FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
+{
+  const XC(gga_type) *func = p->gga;
+  const XC(layout_type) *l = p->layout;
+  int accumulate = (p->output_mode == XC_OUTPUT_ACCUMULATE);
+
+  FLOAT rho_[2*LAYOUT_BLOCK_SIZE], sigma_[3*LAYOUT_BLOCK_SIZE], zk_[LAYOUT_BLOCK_SIZE];
+  FLOAT vrho_[2*LAYOUT_BLOCK_SIZE], vsigma_[3*LAYOUT_BLOCK_SIZE];
+  FLOAT v2rho2_[3*LAYOUT_BLOCK_SIZE], v2rhosigma_[6*LAYOUT_BLOCK_SIZE], v2sigma2_[6*LAYOUT_BLOCK_SIZE];
+  const FLOAT *rho_in, *sigma_in;
+  int ip, nb;
+
+  if(l == NULL && !accumulate){
+    gga_block(p, np, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+    return;
   }
 
-  /* deallocate any used parameter */
-  if(func->params != NULL){
-    free(func->params);
-    func->params = NULL;
+  for(ip=0; ip<np; ip+=LAYOUT_BLOCK_SIZE){
+    nb = min(np - ip, LAYOUT_BLOCK_SIZE);
+
+    if(l != NULL){
+      XC(layout_gather)(nb, func->n_rho,   &l->rho,   rho   + ip*l->rho.point,   rho_);
+      XC(layout_gather)(nb, func->n_sigma, &l->sigma, sigma + ip*l->sigma.point, sigma_);
+      rho_in   = rho_;
+      sigma_in = sigma_;
+    }else{
+      /* the input is already interleaved */
+      rho_in   = rho   + ip*func->n_rho;
+      sigma_in = sigma + ip*func->n_sigma;
+    }
+
+    gga_block(p, nb, rho_in, sigma_in, (zk == NULL) ? NULL : zk_,
+	      (vrho   == NULL) ? NULL : vrho_,   (vrho   == NULL) ? NULL : vsigma_,
+	      (v2rho2 == NULL) ? NULL : v2rho2_, (v2rho2 == NULL) ? NULL : v2rhosigma_,
+	      (v2rho2 == NULL) ? NULL : v2sigma2_);
+
+#define SCATTER(q) XC(layout_scatter)(nb, func->n_##q, (l == NULL) ? NULL : &l->q, \
+				      q##_, q + ip*PT_STRIDE(l, q, func->n_##q), accumulate)
+    if(zk != NULL)
+      SCATTER(zk);
+
+    if(vrho != NULL){
+      SCATTER(vrho);
+      SCATTER(vsigma);
+    }
+
+    if(v2rho2 != NULL){
+      SCATTER(v2rho2);
+      SCATTER(v2rhosigma);
+      SCATTER(v2sigma2);
+    }
+#undef SCATTER
   }
 }
 
+
 /* Some useful formulas:
 
    sigma_st       = grad rho_s . grad rho_t
@@ -121,11 +244,14 @@ if nspin == 2
    v2rhosigma(6) = (u_uu, u_ud, u_dd, d_uu, d_ud, d_dd)
    v2sigma2(6)   = (uu_uu, uu_ud, uu_dd, ud_ud, ud_dd, dd_dd)
 */
-void XC(gga)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigma,
-	     FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
-	     FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
+void XC(gga64)(const XC(func_type) *p, size_t np, const FLOAT *rho, const FLOAT *sigma,
+	       FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
+	       FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
   XC(gga_type) *func;
+  size_t bs;
+  int ib, nblocks;
+  XC(stats_mark_type) mark;
 
   assert(p != NULL && p->gga != NULL);
   func = p->gga;
@@ -149,33 +275,36 @@ void XC(gga)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigm
     exit(1);
   }
 
-  /* initialize output to zero */
-  if(zk != NULL)
-    memset(zk, 0, func->n_zk*np*sizeof(FLOAT));
-
-  if(vrho != NULL){
-    assert(vsigma != NULL);
-    
-    memset(vrho,   0, func->n_vrho  *np*sizeof(FLOAT));
-    memset(vsigma, 0, func->n_vsigma*np*sizeof(FLOAT));
-  }
-
-  if(v2rho2 != NULL){
-    assert(v2rhosigma!=NULL && v2sigma2!=NULL);
-
-    memset(v2rho2,     0, func->n_v2rho2    *np*sizeof(FLOAT));
-    memset(v2rhosigma, 0, func->n_v2rhosigma*np*sizeof(FLOAT));
-    memset(v2sigma2,   0, func->n_v2sigma2  *np*sizeof(FLOAT));
+  nblocks = XC(get_nblocks)(np, p->nthreads, &bs);
+
+  if(p->stats != NULL) XC(stats_begin)(p, &mark);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(p->nthreads) schedule(dynamic) if(nblocks > 1 && p->nthreads > 1)
+#endif
+  for(ib=0; ib<nblocks; ib++){
+    size_t ip = ib*bs;
+
+    gga_block_layout(p, (ip + bs < np) ? bs : np - ip,
+		     rho   + ip*PT_STRIDE(p->layout, rho,   func->n_rho),
+		     sigma + ip*PT_STRIDE(p->layout, sigma, func->n_sigma),
+		     PT_OFFSET(zk,         ip, PT_STRIDE(p->layout, zk,         func->n_zk)),
+		     PT_OFFSET(vrho,       ip, PT_STRIDE(p->layout, vrho,       func->n_vrho)),
+		     PT_OFFSET(vsigma,     ip, PT_STRIDE(p->layout, vsigma,     func->n_vsigma)),
+		     PT_OFFSET(v2rho2,     ip, PT_STRIDE(p->layout, v2rho2,     func->n_v2rho2)),
+		     PT_OFFSET(v2rhosigma, ip, PT_STRIDE(p->layout, v2rhosigma, func->n_v2rhosigma)),
+		     PT_OFFSET(v2sigma2,   ip, PT_STRIDE(p->layout, v2sigma2,   func->n_v2sigma2)));
   }
 
-  /* call functional */
-  if(func->info->gga != NULL)
-    func->info->gga(func, np, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+  if(p->stats != NULL)
+    XC(stats_end)(p, &mark, np, (v2rho2 != NULL) ? 2 : (vrho != NULL) ? 1 : 0);
+}
 
-  if(func->mix_coef != NULL){
-    XC(mix_func)(p, func->n_func_aux, func->func_aux, func->mix_coef, 
-		 np, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
-  }
+void XC(gga)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigma,
+	     FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
+	     FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
+{
+  XC(gga64)(p, (np > 0) ? np : 0, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
 }
 
 /* especializations */
@@ -211,6 +340,98 @@ XC(gga_fxc)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigma
   XC(gga)(p, np, rho, sigma, NULL, NULL, NULL, v2rho2, v2rhosigma, v2sigma2);
 }
 
+/* evaluates a chunk of points for XC(gga_exc_vxc_weighted) */
+static void
+gga_weighted_block(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigma, const FLOAT *weights,
+		   FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, int accumulate)
+{
+  XC(gga_type) *func = p->gga;
+  FLOAT zk_[WEIGHTED_BLOCK_SIZE], vrho_[2*WEIGHTED_BLOCK_SIZE], vsigma_[3*WEIGHTED_BLOCK_SIZE];
+  FLOAT *lvrho, *lvsigma;
+
+  /* without accumulation the potential is written in place and then weighted */
+  lvrho   = (vrho == NULL) ? NULL : (accumulate ? vrho_   : vrho);
+  lvsigma = (vrho == NULL) ? NULL : (accumulate ? vsigma_ : vsigma);
+
+  gga_block(p, np, rho, sigma, (exc != NULL) ? zk_ : NULL, lvrho, lvsigma, NULL, NULL, NULL);
+
+  if(exc != NULL)
+    *exc = XC(weighted_energy)(np, func->nspin, func->n_rho, rho, weights, zk_);
+
+  if(vrho != NULL){
+    XC(weight_potential)(np, func->n_vrho,   weights, lvrho,   vrho,   accumulate);
+    XC(weight_potential)(np, func->n_vsigma, weights, lvsigma, vsigma, accumulate);
+  }
+}
+
+
+/* Returns the integrated energy exc = sum_i weights_i rho_i zk_i and the
+   potentials multiplied by the weights. See XC(lda_exc_vxc_weighted). */
+void 
+XC(gga_exc_vxc_weighted64)(const XC(func_type) *p, size_t np, const FLOAT *rho, const FLOAT *sigma, const FLOAT *weights,
+			   FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, int accumulate)
+{
+  XC(gga_type) *func;
+  FLOAT *partial;
+  size_t ic, nchunks;
+  long long jc;
+  XC(stats_mark_type) mark;
+
+  assert(p != NULL && p->gga != NULL);
+  func = p->gga;
+
+  if(exc != NULL && !(func->info->flags & XC_FLAGS_HAVE_EXC)){
+    fprintf(stderr, "Functional '%s' does not provide an implementation of Exc",
+	    func->info->name);
+    exit(1);
+  }
+
+  if(vrho != NULL && !(func->info->flags & XC_FLAGS_HAVE_VXC)){
+    fprintf(stderr, "Functional '%s' does not provide an implementation of vxc",
+	    func->info->name);
+    exit(1);
+  }
+
+  if(p->layout != NULL){
+    fprintf(stderr, "The weighted entry points only work with the default memory layout");
+    exit(1);
+  }
+
+  nchunks = (np + WEIGHTED_BLOCK_SIZE - 1)/WEIGHTED_BLOCK_SIZE;
+  partial = (exc == NULL) ? NULL : (FLOAT *) XC(arena_scratch_get)(p->arena, nchunks*sizeof(FLOAT));
+
+  if(p->stats != NULL) XC(stats_begin)(p, &mark);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(p->nthreads) schedule(dynamic) if(p->nthreads > 1)
+#endif
+  for(jc=0; jc<(long long) nchunks; jc++){
+    size_t ip = (size_t) jc*WEIGHTED_BLOCK_SIZE;
+
+    gga_weighted_block(p, (np - ip < WEIGHTED_BLOCK_SIZE) ? np - ip : WEIGHTED_BLOCK_SIZE, 
+		       rho + ip*func->n_rho, sigma + ip*func->n_sigma, weights + ip, 
+		       (partial == NULL) ? NULL : partial + jc, 
+		       PT_OFFSET(vrho, ip, func->n_vrho), PT_OFFSET(vsigma, ip, func->n_vsigma), accumulate);
+  }
+
+  if(exc != NULL){
+    *exc = 0.0;
+    for(ic=0; ic<nchunks; ic++)
+      *exc += partial[ic];
+    XC(arena_scratch_release)(p->arena, partial);
+  }
+
+  if(p->stats != NULL)
+    XC(stats_end)(p, &mark, np, (vrho != NULL) ? 1 : 0);
+}
+
+void 
+XC(gga_exc_vxc_weighted)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigma, const FLOAT *weights,
+			 FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, int accumulate)
+{
+  XC(gga_exc_vxc_weighted64)(p, (np > 0) ? np : 0, rho, sigma, weights, exc, vrho, vsigma, accumulate);
+}
+
 /* initializes the mixing for GGAs */
 void 
 gga_init_mix(XC(gga_type) *p, int n_funcs, const int *funcs_id, const FLOAT *mix_coef)
@@ -222,13 +443,13 @@ gga_init_mix(XC(gga_type) *p, int n_funcs, const int *funcs_id, const FLOAT *mix
 
   /* allocate structures needed for */
   p->n_func_aux = n_funcs;
-  p->mix_coef   = (FLOAT *) malloc(n_funcs*sizeof(FLOAT));
-  p->func_aux   = (XC(func_type) **) malloc(n_funcs*sizeof(XC(func_type) *));
+  p->mix_coef   = (FLOAT *) XC(arena_alloc)(p->arena, n_funcs*sizeof(FLOAT));
+  p->func_aux   = (XC(func_type) **) XC(arena_alloc)(p->arena, n_funcs*sizeof(XC(func_type) *));
 
   for(ii=0; ii<n_funcs; ii++){
     p->mix_coef[ii] = mix_coef[ii];
-    p->func_aux[ii] = (XC(func_type) *) malloc(sizeof(XC(func_type)));
-    XC(func_init) (p->func_aux[ii], funcs_id[ii], p->nspin);
+    p->func_aux[ii] = (XC(func_type) *) XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
+    XC(func_init_aux) (p->func_aux[ii], funcs_id[ii], p->nspin, p->arena);
   }
   
 }
@@ -29,30 +29,23 @@ gga_c_am05_init(void *p_)
 {
   XC(gga_type) *p = (XC(gga_type) *)p_;
 
-  p->func_aux    = (XC(func_type) **) malloc(1*sizeof(XC(func_type) *));
-  p->func_aux[0] = (XC(func_type) *)  malloc(  sizeof(XC(func_type)));
+  p->n_func_aux  = 1;
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, sizeof(XC(func_type) *)*p->n_func_aux);
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  XC(func_init)(p->func_aux[0], XC_LDA_C_PW_MOD, p->nspin);
+  XC(func_init_aux)(p->func_aux[0], XC_LDA_C_PW_MOD, p->nspin, p->arena);
 }
 
-static void
-gga_c_am05_end(void *p_)
-{
-  XC(gga_type) *p = (XC(gga_type) *)p_;
-
-  free(p->func_aux[0]);
-  free(p->func_aux);
-}
 
 static void 
-my_gga_c_am05(const void *p_, const FLOAT *rho, const FLOAT *sigma,
+my_gga_c_am05(const void *p_, FLOAT m_zk, const FLOAT *vrho_LDA, const FLOAT *rho, const FLOAT *sigma,
 	   FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
 	   FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
   const FLOAT am05_alpha = 2.804;
   const FLOAT am05_gamma = 0.8098;
 
-  FLOAT sfact, dens, m_zk, vrho_LDA[2];
+  FLOAT sfact, dens;
   int is;
 
   XC(gga_type) *p = (XC(gga_type) *)p_;
@@ -62,20 +55,18 @@ my_gga_c_am05(const void *p_, const FLOAT *rho, const FLOAT *sigma,
   dens = rho[0];
   if(p->nspin == XC_POLARIZED) dens += rho[1];
 
-  XC(lda_exc_vxc)(p->func_aux[0], 1, rho, &m_zk, vrho_LDA);
-
   for(is=0; is<p->nspin; is++){
     FLOAT gdm, ds, rho13;
     FLOAT x=0.0, ss=0.0, XX, f;
     int js = is==0 ? 0 : 2;
 
-    gdm   = sqrt(sigma[js])/sfact;  
+    gdm   = SQRT(sigma[js])/sfact;  
     ds    = rho[is]/sfact;
-    rho13 = POW(ds, 1.0/3.0);
+    rho13 = CBRT(ds);
 
     if(rho[is] < MIN_DENS){
-      /* This is how I think it should be */
-      XX = (vsigma[js] < MIN_GRAD) ? 1.0 : 0.0;
+      /* This is how I think it should be; vsigma is not available for exc alone */
+      XX = (gdm < MIN_GRAD) ? 1.0 : 0.0;
     }else{
       x  = gdm/(ds*rho13);
       ss = x*X2S;
@@ -122,11 +113,17 @@ gga_c_am05(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
 	  FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
 	  FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
-  int ip;
+  FLOAT m_zk[GGA_BATCH_SIZE], vrho_LDA[2*GGA_BATCH_SIZE];
+  int ip, ib;
   const XC(gga_type) *p = p_;
 
   for(ip=0; ip<np; ip++){
-    my_gga_c_am05(p_, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+    /* the uniform gas is computed at the beginning of each block */
+    ib = ip % GGA_BATCH_SIZE;
+    if(ib == 0)
+      XC(lda_exc_vxc)(p->func_aux[0], min(np - ip, GGA_BATCH_SIZE), rho, m_zk, vrho_LDA);
+
+    my_gga_c_am05(p_, m_zk[ib], vrho_LDA + ib*p->nspin, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
 
     /* increment pointers */
     rho   += p->n_rho;
@@ -157,7 +154,7 @@ const XC(func_info_type) XC(func_info_gga_c_am05) = {
   "AE Mattsson, R Armiento, J Paier, G Kresse, JM Wills, and TR Mattsson, J. Chem. Phys. 128, 084714 (2008).",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC,
   gga_c_am05_init,
-  gga_c_am05_end,
+  NULL,
   NULL,            /* this is not an LDA                   */
   gga_c_am05,
 };
@@ -34,75 +34,58 @@ gga_c_lm_init(void *p_)
 {
   XC(gga_type) *p = (XC(gga_type) *)p_;
 
-  p->func_aux    = (XC(func_type) **) malloc(1*sizeof(XC(func_type) *));
-  p->func_aux[0] = (XC(func_type) *)  malloc(  sizeof(XC(func_type)));
+  p->n_func_aux  = 1;
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, sizeof(XC(func_type) *)*p->n_func_aux);
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  XC(func_init)(p->func_aux[0], XC_LDA_C_vBH, p->nspin);
+  XC(func_init_aux)(p->func_aux[0], XC_LDA_C_vBH, p->nspin, p->arena);
 }
 
 
-static void 
-gga_c_lm_end(void *p_)
-{
-  XC(gga_type) *p = (XC(gga_type) *)p_;
-
-  free(p->func_aux[0]);
-  free(p->func_aux);
-}
-
+/* sqrt(4/pi) (3 pi^2)^(1/6), converts t to the variable of the functional */
+static const FLOAT grad_to_t = 1.9846863952198557;
 
 static void 
-my_gga_c_lm(const void *p_, const FLOAT *rho, const FLOAT *sigma,
+my_gga_c_lm(const void *p_, int order, XC(perdew_t) *pt, const FLOAT *rho,
 	 FLOAT *e, FLOAT *vrho, FLOAT *vsigma,
 	 FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
-  XC(gga_type) *p = (XC(gga_type) *)p_;
-  XC(perdew_t) pt;
-
-  int order;
   FLOAT me;
   FLOAT H, dHdx1, d2Hdx12, dx1dt, dx1dphi;
-  FLOAT grad_to_t;
   FLOAT x1;
 
   const FLOAT a1 = 4.28e-3/2.0; /* The factor of 2 converts from Rydberg to Hartree */
   const FLOAT a2 = -0.262;
   const FLOAT a3 = 7.0/9.0;
 
-  order = 0;
-  if(vrho   != NULL) order = 1;
-  if(v2rho2 != NULL) order = 2;
+  if(pt->dens < MIN_DENS) return;
 
-  XC(perdew_params)(p, rho, sigma, order, &pt);
-  if(pt.dens < MIN_DENS) return;
+  x1 = 2.0*grad_to_t*pt->phi*pt->t;
 
-  grad_to_t = sqrt(4.0/M_PI)*POW(3*M_PI*M_PI, 1.0/6.0);
-  x1 = 2.0*grad_to_t*pt.phi*pt.t;
+  H = a1*x1*x1*(EXP(a2*x1) - a3);
 
-  H = a1*x1*x1*(exp(a2*x1) - a3);
-
-  me = pt.ecunif + H;
+  me = pt->ecunif + H;
   if(e != NULL) *e = me;
 
   if(order >= 1){
-    dHdx1      = a1*x1*((2.0 + x1*a2)*exp(a2*x1) - 2.0*a3);
-    dx1dphi    = 2.0*grad_to_t*  pt.t;
-    dx1dt      = 2.0*grad_to_t*pt.phi;
+    dHdx1      = a1*x1*((2.0 + x1*a2)*EXP(a2*x1) - 2.0*a3);
+    dx1dphi    = 2.0*grad_to_t*  pt->t;
+    dx1dt      = 2.0*grad_to_t*pt->phi;
 
-    pt.dphi    = dHdx1 * dx1dphi;
-    pt.dt      = dHdx1 * dx1dt;
-    pt.decunif = 1.0;
+    pt->dphi    = dHdx1 * dx1dphi;
+    pt->dt      = dHdx1 * dx1dt;
+    pt->decunif = 1.0;
   }
 
   if(order >= 2){
-    d2Hdx12 = a1*((2.0 + a2*x1*(4.0 + a2*x1))*exp(a2*x1) - 2.0*a3);
+    d2Hdx12 = a1*((2.0 + a2*x1*(4.0 + a2*x1))*EXP(a2*x1) - 2.0*a3);
 
-    pt.d2phi2 = d2Hdx12*dx1dphi*dx1dphi;
-    pt.d2phit = 2.0*grad_to_t*dHdx1 + d2Hdx12*dx1dphi*dx1dt;
-    pt.d2t2   = d2Hdx12*dx1dt*dx1dt;
+    pt->d2phi2 = d2Hdx12*dx1dphi*dx1dphi;
+    pt->d2phit = 2.0*grad_to_t*dHdx1 + d2Hdx12*dx1dphi*dx1dt;
+    pt->d2t2   = d2Hdx12*dx1dt*dx1dt;
   }
 
-  XC(perdew_potentials)(&pt, rho, me, order, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+  XC(perdew_potentials)(pt, rho, me, order, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
 }
 
 /* Warning: this is a workaround to support blocks while waiting for the next interface */
@@ -111,11 +94,20 @@ gga_c_lm(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
 	  FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
 	  FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
-  int ip;
+  XC(perdew_t) pt[GGA_BATCH_SIZE];
+  int ip, order;
   const XC(gga_type) *p = p_;
 
+  order = 0;
+  if(vrho   != NULL) order = 1;
+  if(v2rho2 != NULL) order = 2;
+
   for(ip=0; ip<np; ip++){
-    my_gga_c_lm(p_, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+    /* the uniform gas is computed at the beginning of each block */
+    if(ip % GGA_BATCH_SIZE == 0)
+      XC(perdew_params)(p, min(np - ip, GGA_BATCH_SIZE), rho, sigma, order, pt);
+
+    my_gga_c_lm(p_, order, &pt[ip % GGA_BATCH_SIZE], rho, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
 
     /* increment pointers */
     rho   += p->n_rho;
@@ -145,7 +137,7 @@ const XC(func_info_type) XC(func_info_gga_c_lm) = {
   "DC Langreth and MJ Mehl, Phys. Rev. Lett. 47, 446 (1981)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_c_lm_init,
-  gga_c_lm_end,
+  NULL,
   NULL,            /* this is not an LDA                   */
   gga_c_lm,
 };
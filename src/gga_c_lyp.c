@@ -36,7 +36,7 @@ void XC(gga_c_lyp_init)(void *p_)
 
   assert(p->params == NULL);
 
-  p->params = malloc(sizeof(gga_c_lyp_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(gga_c_lyp_params));
   params = (gga_c_lyp_params *) (p->params);
 
   /* values of constants in standard LYP functional */
@@ -111,14 +111,14 @@ my_gga_c_lyp(const void *p_, const FLOAT *rho_, const FLOAT *sigma_,
   if(rhot < MIN_DENS) return;
 
   /* some handy functions of the total density */
-  rhot13   = POW(rhot, 1.0/3.0);
-  rhot43   = rhot*rhot13;
-  rho83[0] = POW(rho[0], 8.0/3.0);
-  rho83[1] = POW(rho[1], 8.0/3.0);
+  rhot13   = CBRT(rhot);
+  rhot43   = POW_4_3(rhot, rhot13);
+  rho83[0] = POW_8_3(rho[0], CBRT(rho[0]));
+  rho83[1] = POW_8_3(rho[1], CBRT(rho[1]));
 
   ZZ     = rhot13/(rhot13 + dd);
   delta  = (cc + dd*ZZ)/rhot13;
-  omega  = exp(-cc/rhot13) * ZZ * POW(rhot, -11.0/3.0);
+  omega  = EXP(-cc/rhot13) * ZZ / (rhot*POW_8_3(rhot, rhot13));
 
   /* and their derivatives */
   dZZdr    = dd*ZZ*ZZ/(3.0*rhot43);
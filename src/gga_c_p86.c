@@ -37,10 +37,10 @@ gga_c_p86_init(void *p_)
   XC(gga_type) *p = (XC(gga_type) *)p_;
 
   p->n_func_aux  = 1;
-  p->func_aux    = (XC(func_type) **) malloc(sizeof(XC(func_type) *)*p->n_func_aux);
-  p->func_aux[0] = (XC(func_type) *)  malloc(sizeof(XC(func_type)));
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, sizeof(XC(func_type) *)*p->n_func_aux);
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  XC(func_init)(p->func_aux[0], XC_LDA_C_PZ, p->nspin);
+  XC(func_init_aux)(p->func_aux[0], XC_LDA_C_PZ, p->nspin, p->arena);
 }
 
 
@@ -51,7 +51,8 @@ my_gga_c_p86(const void *p_, const FLOAT *rho, const FLOAT *sigma,
   XC(gga_type) *p = (XC(gga_type) *)p_;
 
   FLOAT dens, zeta, dzdd[2], gdmt, ecunif, vcunif[2];
-  FLOAT rs, DD, dDDdzeta, CC, CCinf, dCCdd;
+  FLOAT dens13, rs, DD, dDDdzeta, CC, CCinf, dCCdd;
+  XC(spin_scaling_batch) ss;
   FLOAT Phi, dPhidd, dPhidgdmt;
 
   XC(lda_exc_vxc)(p->func_aux[0], 1, rho, &ecunif, vcunif);
@@ -62,18 +63,20 @@ my_gga_c_p86(const void *p_, const FLOAT *rho, const FLOAT *sigma,
   dzdd[0] =  (1.0 - zeta)/dens;
   dzdd[1] = -(1.0 + zeta)/dens;
     
-  rs = RS(dens);
+  dens13 = CBRT(dens);
+  rs     = RS_FACTOR/dens13;
 
   /* get gdmt = |nabla n| */
   gdmt = sigma[0];
   if(p->nspin == XC_POLARIZED) gdmt += 2.0*sigma[1] + sigma[2];
-  gdmt = sqrt(gdmt);
+  gdmt = SQRT(gdmt);
   if(gdmt < MIN_GRAD) gdmt = MIN_GRAD;
 
 
   { /* Equation [1].(4) */ 
-    DD       = sqrt(POW(1.0 + zeta, 5.0/3.0) + POW(1.0 - zeta, 5.0/3.0))/M_SQRT2;
-    dDDdzeta = 5.0/(3.0*4.0*DD)*(POW(1.0 + zeta, 2.0/3.0) - POW(1.0 - zeta, 2.0/3.0));
+    XC(spin_scaling)(1, 1, &zeta, &ss);
+    DD       = ss.dd[0][0];
+    dDDdzeta = ss.dd[1][0];
   }
 
   { /* Equation (6) of [1] */
@@ -99,11 +102,11 @@ my_gga_c_p86(const void *p_, const FLOAT *rho, const FLOAT *sigma,
     FLOAT f1, f2, df1, df2;
 
     f1  = ftilde*(CCinf/CC);
-    f2  = POW(dens, -7.0/6.0);
+    f2  = 1.0/POW_7_6(dens, dens13);
     Phi = f1*gdmt*f2;
 
     df1 = -f1/(CC)*dCCdd;
-    df2 = -7.0/6.0*POW(dens, -13.0/6.0);
+    df2 = -7.0/6.0*f2/dens;
     dPhidd    = gdmt*(df1*f2 + f1*df2);
     dPhidgdmt = f1*f2;
   }
@@ -114,13 +117,13 @@ my_gga_c_p86(const void *p_, const FLOAT *rho, const FLOAT *sigma,
 
     gdmt2 = gdmt*gdmt;
 
-    f1 = exp(-Phi);
-    f2 = POW(dens, -4.0/3.0);
+    f1 = EXP(-Phi);
+    f2 = 1.0/POW_4_3(dens, dens13);
     f3 = f1*CC*gdmt2*f2;
 
     df1      = -f1*dPhidd;
     df1dgdmt = -f1*dPhidgdmt;
-    df2      = -4.0/3.0*POW(dens, -7.0/3.0);
+    df2      = -4.0/3.0*f2/dens;
     df3      = gdmt2*(df1*CC*f2 + f1*dCCdd*f2 + f1*CC*df2);
     df3dgdmt = CC*f2*(df1dgdmt*gdmt2 + f1*2.0*gdmt);
 
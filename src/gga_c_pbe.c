@@ -42,46 +42,65 @@ static const FLOAT beta[5]  = {
   3.0*10.0/(81.0*M_PI*M_PI), /* PBE_JRGX */
   0.053,                     /* RGE2 */
 };
-static FLOAT gamm[5];
+
+typedef struct{
+  FLOAT beta, gamma;
+} gga_c_pbe_params;
 
 
 static void gga_c_pbe_init(void *p_)
 {
-  int ii;
+  int func;
+  gga_c_pbe_params *params;
 
   XC(gga_type) *p = (XC(gga_type) *)p_;
 
-  p->func_aux    = (XC(func_type) **) malloc(1*sizeof(XC(func_type) *));
-  p->func_aux[0] = (XC(func_type) *)  malloc(  sizeof(XC(func_type)));
+  p->n_func_aux  = 1;
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, sizeof(XC(func_type) *)*p->n_func_aux);
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  XC(func_init)(p->func_aux[0], XC_LDA_C_PW_MOD, p->nspin);
+  XC(func_init_aux)(p->func_aux[0], XC_LDA_C_PW_MOD, p->nspin, p->arena);
 
-  for(ii=0; ii<5; ii++)
-    gamm[ii] = (1.0 - log(2.0))/(M_PI*M_PI);
-  gamm[2] = beta[2]*beta[2]/(2.0*0.197363);
+  switch(p->info->number){
+  case XC_GGA_C_PBE_SOL:  func = 1; break;
+  case XC_GGA_C_XPBE:     func = 2; break;
+  case XC_GGA_C_PBE_JRGX: func = 3; break;
+  case XC_GGA_C_RGE2:     func = 4; break;
+  default:                func = 0; /* original PBE */
+  }
+
+  assert(p->params == NULL);
+  p->params = XC(arena_alloc)(p->arena, sizeof(gga_c_pbe_params));
+  params = (gga_c_pbe_params *) (p->params);
+
+  params->beta = beta[func];
+  if(func == 2)
+    params->gamma = beta[2]*beta[2]/(2.0*0.197363);
+  else
+    params->gamma = (1.0 - LOG(2.0))/(M_PI*M_PI);
 }
 
 
 static inline void 
-pbe_eq8(int func, int order, FLOAT ecunif, FLOAT phi, 
+pbe_eq8(const gga_c_pbe_params *params, int order, FLOAT ecunif, FLOAT phi, 
 	FLOAT *A, FLOAT *dec, FLOAT *dphi,
 	FLOAT *dec2, FLOAT *decphi, FLOAT *dphi2)
 {
   FLOAT phi3, f1, df1dphi, d2f1dphi2, f2, f3, dx, d2x;
 
-  phi3 = POW(phi, 3);
-  f1   = ecunif/(gamm[func]*phi3);
-  f2   = exp(-f1);
+  phi3 = phi*phi*phi;
+  f1   = ecunif/(params->gamma*phi3);
+  f2   = EXP(-f1);
   f3   = f2 - 1.0;
 
-  *A   = beta[func]/(gamm[func]*f3);
+  *A   = params->beta/(params->gamma*f3);
 
   if(order < 1) return;
 
   df1dphi = -3.0*f1/phi;
   dx      = (*A)*f2/f3;
 
-  *dec    = dx/(gamm[func]*phi3);
+  *dec    = dx/(params->gamma*phi3);
   *dphi   = dx*df1dphi;
 
   if(order < 2) return;
@@ -90,12 +109,12 @@ pbe_eq8(int func, int order, FLOAT ecunif, FLOAT phi,
   d2x       = dx*(2.0*f2 - f3)/f3;
   *dphi2    = d2x*df1dphi*df1dphi + dx*d2f1dphi2;
   *decphi   = (d2x*df1dphi*f1 + dx*df1dphi)/ecunif;
-  *dec2     = d2x/(gamm[func]*gamm[func]*phi3*phi3);
+  *dec2     = d2x/(params->gamma*params->gamma*phi3*phi3);
 }
 
 
 static void 
-pbe_eq7(int func, int order, FLOAT phi, FLOAT t, FLOAT A, 
+pbe_eq7(const gga_c_pbe_params *params, int order, FLOAT phi, FLOAT t, FLOAT A, 
 	FLOAT *H, FLOAT *dphi, FLOAT *dt, FLOAT *dA,
 	FLOAT *d2phi, FLOAT *d2phit, FLOAT *d2phiA, FLOAT *d2t2, FLOAT *d2tA, FLOAT *d2A2)
 {
@@ -104,25 +123,25 @@ pbe_eq7(int func, int order, FLOAT phi, FLOAT t, FLOAT A,
   FLOAT d2f1dt2, d2f2dt2, d2f2dA2, d2f1dtA, d2f2dtA;
 
   t2   = t*t;
-  phi3 = POW(phi, 3);
+  phi3 = phi*phi*phi;
 
   f1 = t2 + A*t2*t2;
   f3 = 1.0 + A*f1;
-  f2 = beta[func]*f1/(gamm[func]*f3);
+  f2 = params->beta*f1/(params->gamma*f3);
 
-  *H = gamm[func]*phi3*log(1.0 + f2);
+  *H = params->gamma*phi3*LOG(1.0 + f2);
 
   if(order < 1) return;
 
   *dphi  = 3.0*(*H)/phi;
     
   df1dt  = t*(2.0 + 4.0*A*t2);
-  df2dt  = beta[func]/(gamm[func]*f3*f3) * df1dt;
-  *dt    = gamm[func]*phi3*df2dt/(1.0 + f2);
+  df2dt  = params->beta/(params->gamma*f3*f3) * df1dt;
+  *dt    = params->gamma*phi3*df2dt/(1.0 + f2);
     
   df1dA  = t2*t2;
-  df2dA  = beta[func]/(gamm[func]*f3*f3) * (df1dA - f1*f1);
-  *dA    = gamm[func]*phi3*df2dA/(1.0 + f2);
+  df2dA  = params->beta/(params->gamma*f3*f3) * (df1dA - f1*f1);
+  *dA    = params->gamma*phi3*df2dA/(1.0 + f2);
 
   if(order < 2) return;
 
@@ -131,73 +150,60 @@ pbe_eq7(int func, int order, FLOAT phi, FLOAT t, FLOAT A,
   *d2phiA = 3.0*(*dA)/phi;
 
   d2f1dt2 = 2.0 + 4.0*3.0*A*t2;
-  d2f2dt2 = beta[func]/(gamm[func]*f3*f3) * (d2f1dt2 - 2.0*A/f3*df1dt*df1dt);
-  *d2t2   = gamm[func]*phi3*(d2f2dt2*(1.0 + f2) - df2dt*df2dt)/((1.0 + f2)*(1.0 + f2));
+  d2f2dt2 = params->beta/(params->gamma*f3*f3) * (d2f1dt2 - 2.0*A/f3*df1dt*df1dt);
+  *d2t2   = params->gamma*phi3*(d2f2dt2*(1.0 + f2) - df2dt*df2dt)/((1.0 + f2)*(1.0 + f2));
 
   d2f1dtA = 4.0*t*t2;
-  d2f2dtA = beta[func]/(gamm[func]*f3*f3) * 
+  d2f2dtA = params->beta/(params->gamma*f3*f3) * 
     (d2f1dtA - 2.0*df1dt*(f1 + A*df1dA)/f3);
-  *d2tA   = gamm[func]*phi3*(d2f2dtA*(1.0 + f2) - df2dt*df2dA)/((1.0 + f2)*(1.0 + f2));
+  *d2tA   = params->gamma*phi3*(d2f2dtA*(1.0 + f2) - df2dt*df2dA)/((1.0 + f2)*(1.0 + f2));
 
-  d2f2dA2 = beta[func]/(gamm[func]*f3*f3*f3) *(-2.0)*(2.0*f1*df1dA - f1*f1*f1 + A*df1dA*df1dA);
-  *d2A2   = gamm[func]*phi3*(d2f2dA2*(1.0 + f2) - df2dA*df2dA)/((1.0 + f2)*(1.0 + f2));
+  d2f2dA2 = params->beta/(params->gamma*f3*f3*f3) *(-2.0)*(2.0*f1*df1dA - f1*f1*f1 + A*df1dA*df1dA);
+  *d2A2   = params->gamma*phi3*(d2f2dA2*(1.0 + f2) - df2dA*df2dA)/((1.0 + f2)*(1.0 + f2));
 }
 
 static void 
-my_gga_c_pbe(const void *p_, const FLOAT *rho, const FLOAT *sigma,
+my_gga_c_pbe(const void *p_, int order, XC(perdew_t) *pt, const FLOAT *rho,
 	  FLOAT *e, FLOAT *vrho, FLOAT *vsigma,
 	  FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
   XC(gga_type) *p = (XC(gga_type) *)p_;
-  XC(perdew_t) pt;
 
-  int func, order;
   FLOAT me;
   FLOAT A, dAdec, dAdphi, d2Adec2, d2Adecphi, d2Adphi2;
   FLOAT H, dHdphi, dHdt, dHdA, d2Hdphi2, d2Hdphit, d2HdphiA, d2Hdt2, d2HdtA, d2HdA2;
 
-  switch(p->info->number){
-  case XC_GGA_C_PBE_SOL:  func = 1; break;
-  case XC_GGA_C_XPBE:     func = 2; break;
-  case XC_GGA_C_PBE_JRGX: func = 3; break;
-  case XC_GGA_C_RGE2:     func = 4; break;
-  default:                func = 0; /* original PBE */
-  }
-
-  order = 0;
-  if(vrho   != NULL) order = 1;
-  if(v2rho2 != NULL) order = 2;
+  assert(p->params != NULL);
 
-  XC(perdew_params)(p, rho, sigma, order, &pt);
-  if(pt.dens < MIN_DENS) return;
+  if(pt->dens < MIN_DENS) return;
 
-  pbe_eq8(func, order, pt.ecunif, pt.phi,
+  pbe_eq8((gga_c_pbe_params *)(p->params), order, pt->ecunif, pt->phi,
 	  &A, &dAdec, &dAdphi, &d2Adec2, &d2Adecphi, &d2Adphi2);
 
-  pbe_eq7(func, order, pt.phi, pt.t, A, 
+  pbe_eq7((gga_c_pbe_params *)(p->params), order, pt->phi, pt->t, A, 
 	  &H, &dHdphi, &dHdt, &dHdA, &d2Hdphi2, &d2Hdphit, &d2HdphiA, &d2Hdt2, &d2HdtA, &d2HdA2);
 
-  me = pt.ecunif + H;
+  me = pt->ecunif + H;
   if(e != NULL) *e = me;
 
   if(order >= 1){
-    pt.dphi    = dHdphi + dHdA*dAdphi;
-    pt.dt      = dHdt;
-    pt.decunif = 1.0 + dHdA*dAdec;
+    pt->dphi    = dHdphi + dHdA*dAdphi;
+    pt->dt      = dHdt;
+    pt->decunif = 1.0 + dHdA*dAdec;
   }
 
   if(order >= 2){
-    pt.d2phi2      = d2Hdphi2 + 2.0*d2HdphiA*dAdphi + dHdA*d2Adphi2 + d2HdA2*dAdphi*dAdphi;
-    pt.d2phit      = d2Hdphit + d2HdtA*dAdphi;
-    pt.d2phiecunif = d2HdphiA*dAdec + d2HdA2*dAdphi*dAdec + dHdA*d2Adecphi;
+    pt->d2phi2      = d2Hdphi2 + 2.0*d2HdphiA*dAdphi + dHdA*d2Adphi2 + d2HdA2*dAdphi*dAdphi;
+    pt->d2phit      = d2Hdphit + d2HdtA*dAdphi;
+    pt->d2phiecunif = d2HdphiA*dAdec + d2HdA2*dAdphi*dAdec + dHdA*d2Adecphi;
 
-    pt.d2t2        = d2Hdt2;
-    pt.d2tecunif   = d2HdtA*dAdec;
+    pt->d2t2        = d2Hdt2;
+    pt->d2tecunif   = d2HdtA*dAdec;
 
-    pt.d2ecunif2   = d2HdA2*dAdec*dAdec + dHdA*d2Adec2;
+    pt->d2ecunif2   = d2HdA2*dAdec*dAdec + dHdA*d2Adec2;
   }
 
-  XC(perdew_potentials)(&pt, rho, me, order, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+  XC(perdew_potentials)(pt, rho, me, order, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
 }
 
 /* Warning: this is a workaround to support blocks while waiting for the next interface */
@@ -206,11 +212,20 @@ gga_c_pbe(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
 	  FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
 	  FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
-  int ip;
+  XC(perdew_t) pt[GGA_BATCH_SIZE];
+  int ip, order;
   const XC(gga_type) *p = p_;
 
+  order = 0;
+  if(vrho   != NULL) order = 1;
+  if(v2rho2 != NULL) order = 2;
+
   for(ip=0; ip<np; ip++){
-    my_gga_c_pbe(p_, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+    /* the uniform gas is computed at the beginning of each block */
+    if(ip % GGA_BATCH_SIZE == 0)
+      XC(perdew_params)(p, min(np - ip, GGA_BATCH_SIZE), rho, sigma, order, pt);
+
+    my_gga_c_pbe(p_, order, &pt[ip % GGA_BATCH_SIZE], rho, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
 
     /* increment pointers */
     rho   += p->n_rho;
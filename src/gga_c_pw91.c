@@ -35,7 +35,10 @@
 
    both results agree. I already mailed Huub van Dam to try to clarify the problem.
 */
-static FLOAT pw91_nu, pw91_beta;
+typedef struct{
+  FLOAT nu, beta;
+} gga_c_pw91_params;
+
 static const FLOAT
   pw91_C_c0  = 4.235e-3, 
   pw91_alpha = 0.09;
@@ -43,51 +46,48 @@ static const FLOAT
 static void gga_c_pw91_init(void *p_)
 {
   XC(gga_type) *p = (XC(gga_type) *)p_;
+  gga_c_pw91_params *params;
 
-  p->func_aux    = (XC(func_type) **) malloc(1*sizeof(XC(func_type) *));
-  p->func_aux[0] = (XC(func_type) *)  malloc(  sizeof(XC(func_type)));
-
-  XC(func_init)(p->func_aux[0], XC_LDA_C_PW, p->nspin);
+  p->n_func_aux  = 1;
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, sizeof(XC(func_type) *)*p->n_func_aux);
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  pw91_nu   = 16.0/M_PI * POW(3.0*M_PI*M_PI, 1.0/3.0);
-  pw91_beta = pw91_nu*pw91_C_c0;
-}
+  XC(func_init_aux)(p->func_aux[0], XC_LDA_C_PW, p->nspin, p->arena);
 
+  assert(p->params == NULL);
+  p->params = XC(arena_alloc)(p->arena, sizeof(gga_c_pw91_params));
+  params = (gga_c_pw91_params *) (p->params);
 
-static void gga_c_pw91_end(void *p_)
-{
-  XC(gga_type) *p = (XC(gga_type) *)p_;
-
-  free(p->func_aux[0]);
-  free(p->func_aux);
+  params->nu   = 16.0/M_PI * POW(3.0*M_PI*M_PI, 1.0/3.0);
+  params->beta = params->nu*pw91_C_c0;
 }
 
 
 static void
-A_eq14(FLOAT ec, FLOAT g, FLOAT *A, FLOAT *dec, FLOAT *dg)
+A_eq14(const gga_c_pw91_params *params, FLOAT ec, FLOAT g, FLOAT *A, FLOAT *dec, FLOAT *dg)
 {
   FLOAT g2, g3, dd;
 
   g2 = g*g;
   g3 = g*g2;
 
-  dd = -2.0*pw91_alpha*ec/(g3*pw91_beta*pw91_beta);
-  dd = exp(dd);
+  dd = -2.0*pw91_alpha*ec/(g3*params->beta*params->beta);
+  dd = EXP(dd);
 
-  *A   = (2.0*pw91_alpha/pw91_beta) / (dd - 1.0);
+  *A   = (2.0*pw91_alpha/params->beta) / (dd - 1.0);
 
-  *dec = -(*A)/(dd - 1.0) * dd * (-2.0*pw91_alpha/(g3*pw91_beta*pw91_beta));
-  *dg  = -(*A)/(dd - 1.0) * dd * (+6.0*pw91_alpha*ec/(g*g3*pw91_beta*pw91_beta));
+  *dec = -(*A)/(dd - 1.0) * dd * (-2.0*pw91_alpha/(g3*params->beta*params->beta));
+  *dg  = -(*A)/(dd - 1.0) * dd * (+6.0*pw91_alpha*ec/(g*g3*params->beta*params->beta));
 }
 
 static void
-H0_eq13(FLOAT   ec, FLOAT   g, FLOAT   t, FLOAT *H0,
+H0_eq13(const gga_c_pw91_params *params, FLOAT   ec, FLOAT   g, FLOAT   t, FLOAT *H0,
 	FLOAT *dec, FLOAT *dg, FLOAT *dt)
 {
   FLOAT A, dAdec, dAdg;
   FLOAT g3, t2, t4, n0, d0, dd, dA;
 
-  A_eq14(ec, g, &A, &dAdec, &dAdg);
+  A_eq14(params, ec, g, &A, &dAdec, &dAdg);
 
   g3 = g*g*g;
   t2 = t*t;
@@ -96,15 +96,15 @@ H0_eq13(FLOAT   ec, FLOAT   g, FLOAT   t, FLOAT *H0,
   n0 = t2 + A*t4;
   d0 = 1.0 + A*t2 + A*A*t4;
 
-  *H0 = g3 * pw91_beta*pw91_beta/(2.0*pw91_alpha) *
-    log(1.0 + 2.0*pw91_alpha/pw91_beta * n0/d0);
+  *H0 = g3 * params->beta*params->beta/(2.0*pw91_alpha) *
+    LOG(1.0 + 2.0*pw91_alpha/params->beta * n0/d0);
 
-  dd = d0*(pw91_beta + n0*(2.0*pw91_alpha + A*pw91_beta));
-  dA = -A*g3*t2*t4*(2.0 + A*t2)*pw91_beta*pw91_beta/dd;
+  dd = d0*(params->beta + n0*(2.0*pw91_alpha + A*params->beta));
+  dA = -A*g3*t2*t4*(2.0 + A*t2)*params->beta*params->beta/dd;
 
   *dec = dA * dAdec;
   *dg  = (*H0)*3.0/g + dA*dAdg;
-  *dt  = 2.0*g3*t*(1.0 + 2.0*A*t2)*pw91_beta*pw91_beta/dd;
+  *dt  = 2.0*g3*t*(1.0 + 2.0*A*t2)*params->beta*params->beta/dd;
 }
 
 
@@ -132,7 +132,7 @@ Rasold_Geldart_C_xc(FLOAT rs, FLOAT *C_xc, FLOAT *drs)
 
 
 static void 
-H1_eq15(FLOAT   rs, FLOAT   g, FLOAT   t, FLOAT   ks, FLOAT   kf, FLOAT *H1,
+H1_eq15(const gga_c_pw91_params *params, FLOAT   rs, FLOAT   g, FLOAT   t, FLOAT   ks, FLOAT   kf, FLOAT *H1,
 	FLOAT *drs, FLOAT *dg, FLOAT *dt, FLOAT *dks, FLOAT *dkf)
 {
   const FLOAT C_xc0 = 2.568e-3, C_x = -0.001667;
@@ -147,16 +147,16 @@ H1_eq15(FLOAT   rs, FLOAT   g, FLOAT   t, FLOAT   ks, FLOAT   kf, FLOAT *H1,
   kf2 = kf*kf;
 
   dd1 = -100.0 * g4 * (ks2/kf2) * t2;
-  dd1 = exp(dd1);
+  dd1 = EXP(dd1);
 
   Rasold_Geldart_C_xc(rs, &C_xc, &dC_xc);
   dd2 = C_xc - C_xc0 - 3.0*C_x/7.0;
 
-  *H1  = pw91_nu * dd2 * g3 * t2 * dd1;
+  *H1  = params->nu * dd2 * g3 * t2 * dd1;
 
-  *drs = pw91_nu * dC_xc * g3 * t2 * dd1;
+  *drs = params->nu * dC_xc * g3 * t2 * dd1;
   *dg  = (*H1) * (3.0/g - 100.0* 4.0*g3 *(ks2/kf2)*t2); /* g can not be zero */
-  *dt  = pw91_nu * dd2 * g3 * dd1 * 
+  *dt  = params->nu * dd2 * g3 * dd1 * 
     (2.0*t - t2*100.0*g4*(ks2/kf2)* 2.0*t);
   *dks = (*H1) * (-100.0*g4*( 2.0*ks /kf2)*t2);
   *dkf = (*H1) * (+100.0*g4*( 2.0*ks2/(kf*kf2) )*t2);
@@ -164,15 +164,15 @@ H1_eq15(FLOAT   rs, FLOAT   g, FLOAT   t, FLOAT   ks, FLOAT   kf, FLOAT *H1,
 
 
 static inline void 
-ec_eq9(FLOAT   ec, FLOAT   rs, FLOAT   t, FLOAT   g, FLOAT   ks, FLOAT   kf, FLOAT  *ec_gga,
+ec_eq9(const gga_c_pw91_params *params, FLOAT   ec, FLOAT   rs, FLOAT   t, FLOAT   g, FLOAT   ks, FLOAT   kf, FLOAT  *ec_gga,
        FLOAT *dec, FLOAT *drs, FLOAT *dt, FLOAT *dg, FLOAT *dks, FLOAT *dkf)
 {
   FLOAT H0, dH0dec, dH0dg, dH0dt;
   FLOAT H1, dH1drs, dH1dg, dH1dt, dH1dks, dH1dkf;
 
-  H0_eq13(ec, g, t, &H0, 
+  H0_eq13(params, ec, g, t, &H0, 
 	  &dH0dec, &dH0dg, &dH0dt);
-  H1_eq15(rs, g, t, ks, kf, &H1,
+  H1_eq15(params, rs, g, t, ks, kf, &H1,
 	  &dH1drs, &dH1dg, &dH1dt, &dH1dks, &dH1dkf);
 
   *ec_gga = ec + H0 + H1;
@@ -185,24 +185,19 @@ ec_eq9(FLOAT   ec, FLOAT   rs, FLOAT   t, FLOAT   g, FLOAT   ks, FLOAT   kf, FLO
 }
 
 static void 
-my_gga_c_pw91(const void *p_, const FLOAT *rho, const FLOAT *sigma,
+my_gga_c_pw91(const void *p_, int order, XC(perdew_t) *pt, const FLOAT *rho,
 	   FLOAT *e, FLOAT *vrho, FLOAT *vsigma,
 	   FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
-  int order;
   XC(gga_type) *p = (XC(gga_type) *)p_;
-  XC(perdew_t) pt;
 
-  order = 0;
-  if(vrho   != NULL) order = 1;
-
-  XC(perdew_params)(p, rho, sigma, order, &pt);
-  if(pt.dens < MIN_DENS) return;
+  if(pt->dens < MIN_DENS) return;
 
-  ec_eq9(pt.ecunif, pt.rs, pt.t, pt.phi, pt.ks, pt.kf, e,
-	 &pt.decunif, &pt.drs, &pt.dt, &pt.dphi, &pt.dks, &pt.dkf);
+  assert(p->params != NULL);
+  ec_eq9((gga_c_pw91_params *)(p->params), pt->ecunif, pt->rs, pt->t, pt->phi, pt->ks, pt->kf, e,
+	 &pt->decunif, &pt->drs, &pt->dt, &pt->dphi, &pt->dks, &pt->dkf);
 
-  XC(perdew_potentials)(&pt, rho, *e, order, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+  XC(perdew_potentials)(pt, rho, *e, order, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
 }
 
 /* Warning: this is a workaround to support blocks while waiting for the next interface */
@@ -211,11 +206,19 @@ gga_c_pw91(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
 	  FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
 	  FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
-  int ip;
+  XC(perdew_t) pt[GGA_BATCH_SIZE];
+  int ip, order;
   const XC(gga_type) *p = p_;
 
+  order = 0;
+  if(vrho   != NULL) order = 1;
+
   for(ip=0; ip<np; ip++){
-    my_gga_c_pw91(p_, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+    /* the uniform gas is computed at the beginning of each block */
+    if(ip % GGA_BATCH_SIZE == 0)
+      XC(perdew_params)(p, min(np - ip, GGA_BATCH_SIZE), rho, sigma, order, pt);
+
+    my_gga_c_pw91(p_, order, &pt[ip % GGA_BATCH_SIZE], rho, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
 
     /* increment pointers */
     rho   += p->n_rho;
@@ -246,7 +249,7 @@ const XC(func_info_type) XC(func_info_gga_c_pw91) = {
   "JP Perdew, JA Chevary, SH Vosko, KA Jackson, MR Pederson, DJ Singh, and C Fiolhais, Phys. Rev. B 48, 4978(E) (1993)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC,
   gga_c_pw91_init,
-  gga_c_pw91_end,
+  NULL,
   NULL,            /* this is not an LDA                   */
   gga_c_pw91,
 };
@@ -50,5 +50,6 @@ const XC(func_info_type) XC(func_info_gga_k_ge2) = {
   "CH Hodges, Can. J. Phys. 51, 1428 (1973)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
@@ -22,50 +22,77 @@
 #include <math.h>
 #include "util.h"
 
+/* fills pt[0..np-1]; the uniform gas is evaluated for all the points with a single call */
 void 
-XC(perdew_params)(const XC(gga_type) *gga_p, const FLOAT *rho, const FLOAT *sigma, int order, XC(perdew_t) *pt)
+XC(perdew_params)(const XC(gga_type) *gga_p, int np, const FLOAT *rho, const FLOAT *sigma, int order, XC(perdew_t) *pt)
 {
-  pt->nspin = gga_p->nspin;
-  XC(rho2dzeta)(pt->nspin, rho, &(pt->dens), &(pt->zeta));
-
-  if(pt->dens < MIN_DENS) return;
-
-  switch (order){
-  case 0:
-    XC(lda_exc) (gga_p->func_aux[0], 1, rho, &(pt->ecunif));
-    break;
-  case 1:
-    XC(lda_exc_vxc)(gga_p->func_aux[0], 1, rho, &(pt->ecunif), pt->vcunif);
-    break;
-  case 2:
-    XC(lda)(gga_p->func_aux[0], 1, rho, &(pt->ecunif), pt->vcunif, pt->fcunif, NULL);
-    break;
+  FLOAT ecunif[GGA_BATCH_SIZE], vcunif[2*GGA_BATCH_SIZE], fcunif[3*GGA_BATCH_SIZE], dens13;
+  FLOAT zeta[GGA_BATCH_SIZE];
+  XC(spin_scaling_batch) ss;
+  int ip, is, nv, nf;
+
+  assert(np <= GGA_BATCH_SIZE);
+
+  XC(lda)(gga_p->func_aux[0], np, rho, ecunif, 
+	  (order > 0) ? vcunif : NULL, (order > 1) ? fcunif : NULL, NULL);
+
+  nv = (gga_p->nspin == XC_POLARIZED) ? 2 : 1;
+  nf = (gga_p->nspin == XC_POLARIZED) ? 3 : 1;
+
+  for(ip=0; ip<np; ip++){
+    pt[ip].nspin = gga_p->nspin;
+    XC(rho2dzeta)(pt[ip].nspin, rho + ip*gga_p->n_rho, &(pt[ip].dens), &(pt[ip].zeta));
+    zeta[ip] = pt[ip].zeta;
   }
 
-  pt->rs = RS(pt->dens);
-  pt->kf = POW(3.0*M_PI*M_PI*pt->dens, 1.0/3.0);
-  pt->ks = sqrt(4.0*pt->kf/M_PI);
+  if(gga_p->nspin == XC_POLARIZED)
+    XC(spin_scaling)(np, order, zeta, &ss);
+
+  if(gga_p->stats != NULL)
+    XC(stats_screen_block)(gga_p->stats, gga_p->nspin, np, rho, gga_p->n_rho, sigma, gga_p->n_sigma);
 
-  /* phi is bounded between 2^(-1/3) and 1 */
-  pt->phi  = 0.5*(POW(1.0 + pt->zeta, 2.0/3.0) + POW(1.0 - pt->zeta, 2.0/3.0));
+  for(ip=0; ip<np; ip++, pt++, rho+=gga_p->n_rho, sigma+=gga_p->n_sigma){
+    if(pt->dens < MIN_DENS) continue;
+
+    pt->ecunif = ecunif[ip];
+    if(order > 0)
+      for(is=0; is<nv; is++) pt->vcunif[is] = vcunif[ip*nv + is];
+    if(order > 1)
+      for(is=0; is<nf; is++) pt->fcunif[is] = fcunif[ip*nf + is];
+
+    dens13 = CBRT(pt->dens);
+    pt->rs = RS_FACTOR/dens13;
+    pt->kf = KF_FACTOR*dens13;
+    pt->ks = SQRT(4.0*pt->kf/M_PI);
+
+    /* phi is bounded between 2^(-1/3) and 1 */
+    if(pt->nspin == XC_POLARIZED){
+      pt->phi      = ss.phi[0][ip];
+      pt->dphidz   = (order > 0) ? ss.phi[1][ip] : 0.0;
+      pt->d2phidz2 = (order > 1) ? ss.phi[2][ip] : 0.0;
+    }else{
+      pt->phi      = 1.0;
+      pt->dphidz   = pt->d2phidz2 = 0.0;
+    }
 
-  /* get gdmt = |nabla n| */
-  pt->gdmt = sigma[0];
-  if(pt->nspin == XC_POLARIZED) pt->gdmt += 2.0*sigma[1] + sigma[2];
-  pt->gdmt = sqrt(max(pt->gdmt, 0.0));
+    /* get gdmt = |nabla n| */
+    pt->gdmt = sigma[0];
+    if(pt->nspin == XC_POLARIZED) pt->gdmt += 2.0*sigma[1] + sigma[2];
+    pt->gdmt = SQRT(max(pt->gdmt, 0.0));
 
-  pt->t = pt->gdmt/(2.0 * pt->phi * pt->ks * pt->dens);
+    pt->t = pt->gdmt/(2.0 * pt->phi * pt->ks * pt->dens);
 
-  if(order > 0)
-    pt->drs = pt->dkf = pt->dks = pt->dphi = pt->dt = pt->decunif = 0.0;
+    if(order > 0)
+      pt->drs = pt->dkf = pt->dks = pt->dphi = pt->dt = pt->decunif = 0.0;
 
-  if(order > 1){
-    pt->d2rs2 = pt->d2rskf = pt->d2rsks = pt->d2rsphi = pt->d2rst  = pt->d2rsecunif  = 0.0;
-                pt->d2kf2  = pt->d2kfks = pt->d2kfphi = pt->d2kft  = pt->d2kfecunif  = 0.0;
-		             pt->d2ks2  = pt->d2ksphi = pt->d2kst  = pt->d2ksecunif  = 0.0;
-                                          pt->d2phi2  = pt->d2phit = pt->d2phiecunif = 0.0;
-                                                        pt->d2t2   = pt->d2tecunif   = 0.0;
-                                                                     pt->d2ecunif2   = 0.0;
+    if(order > 1){
+      pt->d2rs2 = pt->d2rskf = pt->d2rsks = pt->d2rsphi = pt->d2rst  = pt->d2rsecunif  = 0.0;
+                  pt->d2kf2  = pt->d2kfks = pt->d2kfphi = pt->d2kft  = pt->d2kfecunif  = 0.0;
+		               pt->d2ks2  = pt->d2ksphi = pt->d2kst  = pt->d2ksecunif  = 0.0;
+                                            pt->d2phi2  = pt->d2phit = pt->d2phiecunif = 0.0;
+                                                          pt->d2t2   = pt->d2tecunif   = 0.0;
+                                                                       pt->d2ecunif2   = 0.0;
+    }
   }
 }
 
@@ -85,19 +112,7 @@ XC(perdew_potentials)(XC(perdew_t) *pt, const FLOAT *rho, FLOAT e_gga, int order
   if(order < 1) return;
 
   if(pt->nspin == XC_POLARIZED){
-    FLOAT aux;
-
-    dpdz    = 0.0;
-    /* This is written like this to workaround a problem with xlf compilers */
-    if(fabs(1.0 + pt->zeta) >= MIN_DENS){
-      aux   = POW(1.0 + pt->zeta, 1.0/3.0);
-      dpdz += 1.0/(3.0*aux);
-    }
-    if(fabs(1.0 - pt->zeta) >= MIN_DENS){
-      aux   = POW(1.0 - pt->zeta, 1.0/3.0);
-      dpdz -= 1.0/(3.0*aux);
-    }
-
+    dpdz    = pt->dphidz;
     dzdd[0] =  (1.0 - pt->zeta)/pt->dens;
     dzdd[1] = -(1.0 + pt->zeta)/pt->dens;
   }else{
@@ -194,17 +209,7 @@ XC(perdew_potentials)(XC(perdew_t) *pt, const FLOAT *rho, FLOAT e_gga, int order
 
   /* now we sort d2alphadd2 */
   if(pt->nspin == XC_POLARIZED){
-    FLOAT aux;
-
-    d2pdz2 = 0.0;
-    if(fabs(1.0 + pt->zeta) >= MIN_DENS){
-      aux     = POW(1.0 + pt->zeta, 4.0/3.0);
-      d2pdz2 += -1.0/(9.0*aux);
-    }
-    if(fabs(1.0 - pt->zeta) >= MIN_DENS){
-      aux     = POW(1.0 - pt->zeta, 4.0/3.0);
-      d2pdz2 += -1.0/(9.0*aux);
-    }
+    d2pdz2 = pt->d2phidz2;
 
     d2zdd2[0] = -2.0*dzdd[0]/pt->dens;
     d2zdd2[1] =  2.0*pt->zeta/(pt->dens*pt->dens);
@@ -62,6 +62,7 @@ const XC(func_info_type) XC(func_info_gga_x_2d_b86) = {
   "AD Becke, J. Chem. Phys 84, 4524 (1986)",
   XC_FLAGS_2D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
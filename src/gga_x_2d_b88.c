@@ -36,7 +36,7 @@ static void gga_x_2d_b88_init(void *p_)
 
   assert(p->params == NULL);
 
-  p->params = malloc(sizeof(gga_x_2d_b88_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(gga_x_2d_b88_params));
   params = (gga_x_2d_b88_params *) (p->params);
 
   /* value of beta in standard Becke 88 2D functional */
@@ -44,16 +44,6 @@ static void gga_x_2d_b88_init(void *p_)
 }
 
 
-static void gga_x_2d_b88_end(void *p_)
-{
-  XC(gga_type) *p = (XC(gga_type) *)p_;
-
-  assert(p->params != NULL);
-  free(p->params);
-  p->params = NULL;
-}
-
-
 void XC(gga_x_2d_b88_set_params)(XC(func_type) *p, FLOAT beta)
 {
   assert(p != NULL && p->gga != NULL);
@@ -69,6 +59,9 @@ void XC(gga_x_2d_b88_set_params_)(XC(gga_type) *p, FLOAT beta)
   params = (gga_x_2d_b88_params *) (p->params);
 
   params->beta = beta;
+
+  /* a table of the enhancement factor has to follow the parameters */
+  XC(gga_x_table_update)(p);
 }
 
 
@@ -84,13 +77,13 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   csi  = 8.0; /* for harmonic potentials */
 
   f1 = beta/X_FACTOR_2D_C*x*x;
-  f2 = 1.0 + csi*beta*x*asinh(x);
+  f2 = 1.0 + csi*beta*x*ASINH(x);
   *f = 1.0 + f1/f2;
 
   if(order < 1) return;
 
   df1 = 2.0*beta/X_FACTOR_2D_C*x;
-  df2 = csi*beta*(asinh(x) + x/sqrt(1.0 + x*x));
+  df2 = csi*beta*(ASINH(x) + x/SQRT(1.0 + x*x));
 
   *dfdx = (df1*f2 - f1*df2)/(f2*f2);
   *ldfdx= beta/X_FACTOR_2D_C;
@@ -98,7 +91,7 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   if(order < 2) return;
 
   d2f1 = 2.0*beta/X_FACTOR_2D_C;
-  d2f2 = csi*beta*(2.0 + x*x)/pow(1.0 + x*x, 3.0/2.0);
+  d2f2 = csi*beta*(2.0 + x*x)/((1.0 + x*x)*SQRT(1.0 + x*x));
 
   *d2fdx2 = (2.0*f1*df2*df2 + d2f1*f2*f2 - f2*(2.0*df1*df2 + f1*d2f2))/(f2*f2*f2);
 }
@@ -115,7 +108,8 @@ const XC(func_info_type) XC(func_info_gga_x_2d_b88) = {
   "AD Becke, Phys. Rev. A 38, 3098 (1988)",
   XC_FLAGS_2D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_2d_b88_init, 
-  gga_x_2d_b88_end, 
   NULL,
-  work_gga_x
+  NULL,
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
@@ -77,5 +77,6 @@ const XC(func_info_type) XC(func_info_gga_x_2d_pbe) = {
   "JP Perdew, K Burke, and M Ernzerhof, Phys. Rev. Lett. 78, 1396(E) (1997)",
   XC_FLAGS_2D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
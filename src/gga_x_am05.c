@@ -35,7 +35,7 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   const FLOAT z_tt_factor = POW(POW(4.0/3.0, 1.0/3.0) * 2.0*M_PI/3.0, 4);
 
   FLOAT ss, ss2, lam_x, dlam_x, d2lam_x;
-  FLOAT ww, z_t, z_t2, z_tt, fx_b, xx, flaa_1, flaa_2, flaa;
+  FLOAT ww, ww13, z_t, z_t2, z_tt, fx_b, xx, flaa_1, flaa_2, flaa;
   FLOAT dww, dz_t, dz_tt, dfx_b, dxx, dflaa_1, dflaa_2, dflaa;
   FLOAT d2ww, d2z_t, d2z_tt, d2fx_b, d2xx, d2flaa_1, d2flaa_2, d2flaa;;
 
@@ -49,10 +49,11 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   ss  = X2S*x;
   ss2 = ss*ss;
 
-  lam_x  = POW(ss, 1.5)/(2.0*sqrt(6.0));
+  lam_x  = ss*SQRT(ss)/(2.0*SQRT(6.0));
   ww     = (FLOAT)lambert_w((double)lam_x);
 
-  z_t    = POW(1.5*ww, 2.0/3.0);
+  ww13   = CBRT(ww);
+  z_t    = POW(1.5, 2.0/3.0)*POW_2_3(ww13);
   z_t2   = z_t*z_t;
 
   /* This is equal to sqrt(t_zeta) * tt_zeta of the JCP*/
@@ -73,7 +74,7 @@ func(const XC(gga_type) *p, int order, FLOAT x,
 
   dlam_x  = 1.5*lam_x/ss;
   dww     = ww/(lam_x*(1.0 + ww))*dlam_x;
-  dz_t    = POW(1.5, 2.0/3.0)*2.0/3.0*POW(ww, -1.0/3.0)*dww;
+  dz_t    = POW(1.5, 2.0/3.0)*2.0/3.0*dww/ww13;
   dz_tt   = POW(z_tt_factor + z_t2, -3.0/4.0)*(z_tt_factor + 3.0*z_t2/2.0)*dz_t;
   dfx_b   = M_PI/3.0*(z_tt - ss*dz_tt)/(z_tt*z_tt);
 
@@ -93,7 +94,7 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   d2lam_x  = 0.5*dlam_x/ss;
   d2ww     = (dww*lam_x*dlam_x + ww*(1.0 + ww)*lam_x*d2lam_x - ww*(1.0 + ww)*dlam_x*dlam_x) /
     (lam_x*lam_x*(1+ww)*(1+ww));
-  d2z_t    = POW(1.5, 2.0/3.0)*2.0/3.0*(-POW(ww, -4.0/3.0)*dww*dww/3.0 + POW(ww, -1.0/3.0)*d2ww);
+  d2z_t    = POW(1.5, 2.0/3.0)*2.0/3.0*(-dww*dww/(3.0*POW_4_3(ww, ww13)) + d2ww/ww13);
 
   d2z_tt   = POW(z_tt_factor + z_t2, -7.0/4.0)*
     ((d2z_t*(z_tt_factor + z_t2) - 3.0/2.0*z_t*dz_t*dz_t)*(z_tt_factor + 3.0*z_t2/2.0) + 
@@ -121,5 +122,6 @@ const XC(func_info_type) XC(func_info_gga_x_am05) = {
   "AE Mattsson, R Armiento, J Paier, G Kresse, JM Wills, and TR Mattsson, J. Chem. Phys. 128, 084714 (2008).",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
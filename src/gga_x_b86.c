@@ -71,7 +71,8 @@ const XC(func_info_type) XC(func_info_gga_x_b86) = {
   "AD Becke, J. Chem. Phys 84, 4524 (1986)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_b86_r) = {
@@ -83,6 +84,7 @@ const XC(func_info_type) XC(func_info_gga_x_b86_r) = {
   "AD Becke, J. Chem. Phys 107, 8554 (1997)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
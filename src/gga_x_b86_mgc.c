@@ -65,5 +65,6 @@ const XC(func_info_type) XC(func_info_gga_x_b86_mgc) = {
   "AD Becke, J. Chem. Phys 85, 7184 (1986)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
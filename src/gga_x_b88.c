@@ -35,7 +35,7 @@ gga_x_b88_init(void *p_)
   XC(gga_type) *p = (XC(gga_type) *)p_;
 
   assert(p->params == NULL);
-  p->params = malloc(sizeof(gga_x_b88_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(gga_x_b88_params));
 
   /* value of beta in standard Becke 88 functional */
   switch(p->info->number){
@@ -51,17 +51,6 @@ gga_x_b88_init(void *p_)
 }
 
 
-static void 
-gga_x_b88_end(void *p_)
-{
-  XC(gga_type) *p = (XC(gga_type) *)p_;
-
-  assert(p->params != NULL);
-  free(p->params);
-  p->params = NULL;
-}
-
-
 void 
 XC(gga_x_b88_set_params)(XC(func_type) *p, FLOAT beta, FLOAT gamma)
 {
@@ -80,40 +69,50 @@ XC(gga_x_b88_set_params_)(XC(gga_type) *p, FLOAT beta, FLOAT gamma)
 
   params->beta  = beta;
   params->gamma = gamma;
+
+  /* a table of the enhancement factor has to follow the parameters */
+  XC(gga_x_table_update)(p);
 }
 
 
-static inline void 
-func(const XC(gga_type) *p, int order, FLOAT x, 
-     FLOAT *f, FLOAT *dfdx, FLOAT *ldfdx, FLOAT *d2fdx2)
+static void 
+func_batch(const XC(gga_type) *p, XC(gga_x_batch) *b)
 {
-  FLOAT f1, f2, df1, df2, d2f1, d2f2;
+  FLOAT x, f1, f2, df1, df2, d2f1, d2f2, ash[2*GGA_BATCH_SIZE];
   FLOAT beta, gamma;
+  int ip;
 
   assert(p->params != NULL);
   beta  = ((gga_x_b88_params *) (p->params))->beta;
   gamma = ((gga_x_b88_params *) (p->params))->gamma;
 
-  f1 = beta/X_FACTOR_C*x*x;
-  f2 = 1.0 + gamma*beta*x*asinh(x);
-  *f = 1.0 + f1/f2;
+  XC(vasinh)(b->np, b->x, ash);
+
+  for(ip=0; ip<b->np; ip++){
+    x  = b->x[ip];
+
+    f1 = beta/X_FACTOR_C*x*x;
+    f2 = 1.0 + gamma*beta*x*ash[ip];
+    b->f[ip] = 1.0 + f1/f2;
  
-  if(order < 1) return;
+    if(b->order < 1) continue;
 
-  df1 = 2.0*beta/X_FACTOR_C*x;
-  df2 = gamma*beta*(asinh(x) + x/sqrt(1.0 + x*x));
+    df1 = 2.0*beta/X_FACTOR_C*x;
+    df2 = gamma*beta*(ash[ip] + x/SQRT(1.0 + x*x));
 
-  *dfdx = (df1*f2 - f1*df2)/(f2*f2);
-  *ldfdx= beta/X_FACTOR_C;
+    b->dfdx[ip] = (df1*f2 - f1*df2)/(f2*f2);
+    b->ldfdx[ip]= beta/X_FACTOR_C;
 
-  if(order < 2) return;
+    if(b->order < 2) continue;
 
-  d2f1 = 2.0*beta/X_FACTOR_C;
-  d2f2 = gamma*beta*(2.0 + x*x)/pow(1.0 + x*x, 3.0/2.0);
+    d2f1 = 2.0*beta/X_FACTOR_C;
+    d2f2 = gamma*beta*(2.0 + x*x)/((1.0 + x*x)*SQRT(1.0 + x*x));
 
-  *d2fdx2 = (2.0*f1*df2*df2 + d2f1*f2*f2 - f2*(2.0*df1*df2 + f1*d2f2))/(f2*f2*f2);
+    b->d2fdx2[ip] = (2.0*f1*df2*df2 + d2f1*f2*f2 - f2*(2.0*df1*df2 + f1*d2f2))/(f2*f2*f2);
+  }
 }
 
+#define FUNC_BATCH
 #include "work_gga_x.c"
 
 const XC(func_info_type) XC(func_info_gga_x_b88) = {
@@ -124,9 +123,10 @@ const XC(func_info_type) XC(func_info_gga_x_b88) = {
   "AD Becke, Phys. Rev. A 38, 3098 (1988)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_b88_init, 
-  gga_x_b88_end, 
   NULL,
-  work_gga_x
+  NULL,
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_optb88_vdw) = {
@@ -137,7 +137,8 @@ const XC(func_info_type) XC(func_info_gga_x_optb88_vdw) = {
   "J Klimes, DR Bowler, and A Michaelides, J. Phys.: Condens. Matter 22, 022201 (2010)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_b88_init,
-  gga_x_b88_end, 
   NULL,
-  work_gga_x
+  NULL,
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
@@ -71,7 +71,8 @@ const XC(func_info_type) XC(func_info_gga_x_dk87_r1) = {
   "AE DePristo and JD Kress, J. Chem. Phys. 86, 1425 (1987)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_dk87_r2) = {
@@ -82,5 +83,6 @@ const XC(func_info_type) XC(func_info_gga_x_dk87_r2) = {
   "AE DePristo and JD Kress, J. Chem. Phys. 86, 1425 (1987)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
@@ -27,7 +27,7 @@ func(const XC(gga_type) *p, int order, FLOAT x,
      FLOAT *f, FLOAT *dfdx, FLOAT *ldfdx, FLOAT *d2fdx2)
 {
   static const FLOAT c1 = 1.0/137.0;
-  FLOAT sx = sqrt(x);
+  FLOAT sx = SQRT(x);
 
   *f     = 1.0 + c1/X_FACTOR_C*x*sx;
 
@@ -51,5 +51,6 @@ const XC(func_info_type) XC(func_info_gga_x_g96) = {
   "PMW Gill, Mol. Phys. 89, 433 (1996)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
@@ -34,8 +34,8 @@ func(const XC(gga_type) *p, int order, FLOAT x, FLOAT ds,
 
   FLOAT dd, n13, n43;
 
-  n13 = POW(ds, 1.0/3.0);
-  n43 = ds*n13;
+  n13 = CBRT(ds);
+  n43 = POW_4_3(ds, n13);
   dd  = 1.0/(n43 + delta);
  
   *f = 1.0 - gamma/X_FACTOR_C * x*x * n43*dd;
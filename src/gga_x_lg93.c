@@ -72,6 +72,7 @@ const XC(func_info_type) XC(func_info_gga_x_lg93) = {
   "DJ Lacks and RG Gordon, Phys. Rev. A 47, 4681 (1993)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
@@ -62,5 +62,6 @@ const XC(func_info_type) XC(func_info_gga_x_mpbe) = {
   "C Adamo and V Barone, J. Chem. Phys. 116, 5933 (2002)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
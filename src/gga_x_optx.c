@@ -58,5 +58,6 @@ const XC(func_info_type) XC(func_info_gga_x_optx) = {
   "NC Handy and AJ Cohen, Mol. Phys. 99, 403 (2001)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
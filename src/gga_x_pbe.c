@@ -61,7 +61,7 @@ gga_x_pbe_init(void *p_)
   XC(gga_type) *p = (XC(gga_type) *)p_;
 
   assert(p->params == NULL);
-  p->params = malloc(sizeof(gga_x_pbe_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(gga_x_pbe_params));
 
   switch(p->info->number){
   case XC_GGA_X_PBE_R:      p->func = 1; break;
@@ -95,6 +95,9 @@ XC(gga_x_pbe_set_params_)(XC(gga_type) *p, FLOAT kappa, FLOAT mu)
 
   params->kappa = kappa;
   params->mu    = mu;
+
+  /* a table of the enhancement factor has to follow the parameters */
+  XC(gga_x_table_update)(p);
 }
 
 
@@ -136,6 +139,48 @@ func(const XC(gga_type) *p, int order, FLOAT x,
 }
 
 
+/* the same as func, for all the entries of the block */
+static void
+func_batch(const XC(gga_type) *p, XC(gga_x_batch) *b)
+{
+  FLOAT kappa, mu, ss, ss2, f0, df0, d2f0;
+  int ip, rge2;
+
+  assert(p->params != NULL);
+  kappa = ((gga_x_pbe_params *) (p->params))->kappa;
+  mu    = ((gga_x_pbe_params *) (p->params))->mu;
+  rge2  = (p->info->number == XC_GGA_X_RGE2);
+
+  for(ip=0; ip<b->np; ip++){
+    ss  = X2S*b->x[ip];
+    ss2 = ss*ss;
+
+    f0 = kappa + mu*ss2;
+    if(rge2)
+      f0 += mu*mu*ss2*ss2/kappa;
+
+    b->f[ip] = 1.0 + kappa*(1.0 - kappa/f0);
+
+    if(b->order < 1) continue;
+
+    df0 = 2.0*mu*ss;
+    if(rge2)
+      df0 += 4.0*mu*mu*ss2*ss/kappa;
+
+    b->dfdx[ip]  = X2S*kappa*kappa*df0/(f0*f0);
+    b->ldfdx[ip] = X2S*X2S*mu;
+
+    if(b->order < 2) continue;
+
+    d2f0 = 2.0*mu;
+    if(rge2)
+      d2f0 += 4.0*3.0*mu*mu*ss2/kappa;
+
+    b->d2fdx2[ip] = X2S*X2S*kappa*kappa/(f0*f0)*(d2f0 - 2.0*df0*df0/f0);
+  }
+}
+
+
 void 
 XC(gga_x_pbe_enhance)(const XC(gga_type) *p, int order, FLOAT x, 
 		      FLOAT *f, FLOAT *dfdx, FLOAT *ldfdx, FLOAT *d2fdx2)
@@ -144,6 +189,7 @@ XC(gga_x_pbe_enhance)(const XC(gga_type) *p, int order, FLOAT x,
 }
 
 
+#define FUNC_BATCH
 #include "work_gga_x.c"
 
 const XC(func_info_type) XC(func_info_gga_x_pbe) = {
@@ -156,7 +202,8 @@ const XC(func_info_type) XC(func_info_gga_x_pbe) = {
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_pbe_init, 
   NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_pbe_r) = {
@@ -168,7 +215,8 @@ const XC(func_info_type) XC(func_info_gga_x_pbe_r) = {
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_pbe_init, 
   NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_pbe_sol) = {
@@ -180,7 +228,8 @@ const XC(func_info_type) XC(func_info_gga_x_pbe_sol) = {
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_pbe_init, 
   NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_xpbe) = {
@@ -192,7 +241,8 @@ const XC(func_info_type) XC(func_info_gga_x_xpbe) = {
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_pbe_init, 
   NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_pbe_jsjr) = {
@@ -204,7 +254,8 @@ const XC(func_info_type) XC(func_info_gga_x_pbe_jsjr) = {
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_pbe_init, 
   NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_pbek1_vdw) = {
@@ -216,7 +267,8 @@ const XC(func_info_type) XC(func_info_gga_x_pbek1_vdw) = {
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_pbe_init, 
   NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_rge2) = {
@@ -228,6 +280,7 @@ const XC(func_info_type) XC(func_info_gga_x_rge2) = {
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_pbe_init,
   NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
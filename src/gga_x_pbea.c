@@ -61,5 +61,6 @@ const XC(func_info_type) XC(func_info_gga_x_pbea) = {
   "G Madsen, Phys. Rev. B 75, 195108 (2007)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
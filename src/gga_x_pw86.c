@@ -82,7 +82,8 @@ const XC(func_info_type) XC(func_info_gga_x_pw86) = {
   "JP Perdew and Y Wang, Phys. Rev. B 33, 8800 (1986)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_pw86_init, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 const XC(func_info_type) XC(func_info_gga_x_rpw86) = {
@@ -93,6 +94,7 @@ const XC(func_info_type) XC(func_info_gga_x_rpw86) = {
   "ED Murray, K Lee and DC Langreth, J. Chem. Theory Comput. 5, 2754–2762 (2009)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_pw86_init, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
@@ -60,8 +60,8 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   ss2 = ss*ss;
   ss4 = POW(ss, expo[func]);
 
-  f1 = dd[func]*exp(-alpha*ss2);
-  f2 = aa[func]*asinh(bb[func]*ss);
+  f1 = dd[func]*EXP(-alpha*ss2);
+  f2 = aa[func]*ASINH(bb[func]*ss);
   f3 = (cc[func] + f1)*ss2 - ff[func]*ss4;
   f4 = 1.0 + ss*f2 + ff[func]*ss4;
 
@@ -70,7 +70,7 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   if(order < 1) return;
 
   df1 = -2.0*alpha*ss*f1;
-  df2 = aa[func]*bb[func]/sqrt(1.0 + bb[func]*bb[func]*ss2);
+  df2 = aa[func]*bb[func]/SQRT(1.0 + bb[func]*bb[func]*ss2);
   df3 = 2.0*ss*(cc[func] + f1) + ss2*df1 - expo[func]*ff[func]*POW(ss, expo[func] - 1.0);
   df4 = f2 + ss*df2 + expo[func]*ff[func]*POW(ss, expo[func] - 1.0);
 
@@ -83,7 +83,7 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   if(order < 2) return;
 
   d2f1 = -2.0*alpha*(f1 + ss*df1);
-  d2f2 = -aa[func]*bb[func]*bb[func]*bb[func]*ss/POW(1.0 + bb[func]*bb[func]*ss2, 3.0/2.0);
+  d2f2 = -aa[func]*bb[func]*bb[func]*bb[func]*ss/((1.0 + bb[func]*bb[func]*ss2)*SQRT(1.0 + bb[func]*bb[func]*ss2));
   d2f3 = 2.0*(cc[func] + f1 + 2.0*ss*df1) + ss2*d2f1 - 
     expo[func]*(expo[func]-1)*ff[func]*POW(ss, expo[func] - 2.0);
   d2f4 = 2.0*df2 + ss*d2f2 + 
@@ -105,7 +105,8 @@ const XC(func_info_type) XC(func_info_gga_x_pw91) = {
   "JP Perdew, JA Chevary, SH Vosko, KA Jackson, MR Pederson, DJ Singh, and C Fiolhais, Phys. Rev. B 48, 4978(E) (1993)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
 
 
@@ -117,5 +118,6 @@ const XC(func_info_type) XC(func_info_gga_x_mpw91) = {
   "C Adamo and V Barone, J. Chem. Phys. 108, 664 (1998)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   NULL, NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
@@ -35,7 +35,7 @@ gga_x_rpbe_init(void *p_)
   XC(gga_type) *p = (XC(gga_type) *)p_;
 
   assert(p->params == NULL);
-  p->params = malloc(sizeof(gga_x_rpbe_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(gga_x_rpbe_params));
 
   XC(gga_x_rpbe_set_params_)(p, 0.8040, 0.00361218645365094697);
 }
@@ -59,6 +59,9 @@ XC(gga_x_rpbe_set_params_)(XC(gga_type) *p, FLOAT kappa, FLOAT mu)
 
   params->kappa = kappa;
   params->mu    = mu;
+
+  /* a table of the enhancement factor has to follow the parameters */
+  XC(gga_x_table_update)(p);
 }
 
 
@@ -73,7 +76,7 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   kappa = ((gga_x_rpbe_params *) (p->params))->kappa;
   mu    = ((gga_x_rpbe_params *) (p->params))->mu;
 
-  f0 = exp(-mu*x*x/kappa);
+  f0 = EXP(-mu*x*x/kappa);
   *f = 1.0 + kappa*(1.0 - f0);
 
   if(order < 1) return;
@@ -101,5 +104,6 @@ const XC(func_info_type) XC(func_info_gga_x_rpbe) = {
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   gga_x_rpbe_init, 
   NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
@@ -0,0 +1,280 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "util.h"
+
+/************************************************************************
+  Spline tables of the enhancement factor f(x) of GGA exchanges.
+
+  Only the functionals whose f depends on x alone provide the gga_x
+  member of their info (HEADER 1 in work_gga_x.c). For those, f is
+  tabulated as a quintic Hermite spline in
+
+    u = x/(x + GGA_X_TABLE_C)
+
+  on a uniform grid in u, from x = 0 to GGA_X_TABLE_XMAX. The spline
+  matches f, dfdx and d2fdx2 of the functional at the nodes, so it is
+  twice continuously differentiable. The grid is refined until f and
+  x dfdx are reproduced to the requested tolerance, relative to |f|,
+  inside the intervals. Larger values of x, where the derivatives of
+  most enhancement factors are tiny compared to f, are evaluated by
+  the functional itself.
+
+  The table is rebuilt by the set_params routines of the functionals,
+  so it always corresponds to the current parameters.
+************************************************************************/
+
+#define GGA_X_TABLE_C     8.0       /* x at the middle of the u interval */
+#define GGA_X_TABLE_XMAX  100.0
+#define GGA_X_TABLE_NMIN  32
+#define GGA_X_TABLE_NMAX  32768
+
+typedef struct XC(struct_gga_x_table) {
+  FLOAT tol;          /* the tolerance it was built for */
+  int   n;            /* number of intervals */
+  FLOAT h;            /* spacing in u */
+  FLOAT *coef;        /* coef[6*i + k], power k of (u - u_i)/h */
+} XC(gga_x_table_type);
+
+
+/* x and its first two derivatives with respect to u */
+static void
+u_to_x(FLOAT u, FLOAT *x, FLOAT *dxdu, FLOAT *d2xdu2)
+{
+  FLOAT omu = 1.0 - u;
+
+  *x      = GGA_X_TABLE_C*u/omu;
+  *dxdu   = GGA_X_TABLE_C/(omu*omu);
+  *d2xdu2 = 2.0*GGA_X_TABLE_C/(omu*omu*omu);
+}
+
+
+/* fills the table with n intervals; returns the largest relative error at the check points */
+static FLOAT
+gga_x_table_fill(const XC(gga_type) *p, XC(gga_x_table_type) *tab, int n)
+{
+  static const FLOAT check_s[] = {0.25, 0.5, 0.75};
+  const int ncheck = 3;
+
+  FLOAT *x, *f, *dfdx, *d2fdx2, *c, dxdu, d2xdu2, fu[2][3], h, df, err, v, d1, s;
+  int i, j, k, np;
+
+  h = (GGA_X_TABLE_XMAX/(GGA_X_TABLE_XMAX + GGA_X_TABLE_C))/n;
+  tab->n = n;
+  tab->h = h;
+
+  /* the nodes, followed by the check points */
+  np     = (n + 1) + n*ncheck;
+  x      = (FLOAT *) malloc(4*np*sizeof(FLOAT));
+  f      = x + np;
+  dfdx   = x + 2*np;
+  d2fdx2 = x + 3*np;
+
+  for(i=0; i<=n; i++)
+    u_to_x(i*h, &x[i], &dxdu, &d2xdu2);
+  for(i=0; i<n; i++)
+    for(j=0; j<ncheck; j++)
+      u_to_x((i + check_s[j])*h, &x[n + 1 + i*ncheck + j], &dxdu, &d2xdu2);
+
+  p->info->gga_x(p, np, x, f, dfdx, d2fdx2);
+
+  if(tab->coef != NULL) free(tab->coef);
+  tab->coef = (FLOAT *) malloc(6*n*sizeof(FLOAT));
+
+  for(i=0; i<n; i++){
+    /* value and derivatives with respect to s = (u - u_i)/h at both ends */
+    for(j=0; j<2; j++){
+      u_to_x((i + j)*h, &v, &dxdu, &d2xdu2);
+      fu[j][0] = f[i + j];
+      fu[j][1] = h*dfdx[i + j]*dxdu;
+      fu[j][2] = h*h*(d2fdx2[i + j]*dxdu*dxdu + dfdx[i + j]*d2xdu2);
+    }
+
+    c  = tab->coef + 6*i;
+    df = fu[1][0] - fu[0][0];
+
+    c[0] = fu[0][0];
+    c[1] = fu[0][1];
+    c[2] = fu[0][2]/2.0;
+    c[3] =  10.0*df - 6.0*fu[0][1] - 4.0*fu[1][1] - (3.0*fu[0][2] -     fu[1][2])/2.0;
+    c[4] = -15.0*df + 8.0*fu[0][1] + 7.0*fu[1][1] + (3.0*fu[0][2] - 2.0*fu[1][2])/2.0;
+    c[5] =   6.0*df - 3.0*(fu[0][1] + fu[1][1])   - (    fu[0][2] -     fu[1][2])/2.0;
+  }
+
+  err = 0.0;
+  for(i=0; i<n; i++){
+    c = tab->coef + 6*i;
+
+    for(j=0; j<ncheck; j++){
+      k = n + 1 + i*ncheck + j;
+      s = check_s[j];
+
+      u_to_x((i + s)*h, &v, &dxdu, &d2xdu2);
+      v  = ((((c[5]*s + c[4])*s + c[3])*s + c[2])*s + c[1])*s + c[0];
+      d1 = (((((5.0*c[5]*s + 4.0*c[4])*s + 3.0*c[3])*s + 2.0*c[2])*s + c[1])/h)/dxdu;
+
+      err = max(err, ABS(v - f[k])/ABS(f[k]));
+      err = max(err, ABS(x[k]*(d1 - dfdx[k]))/ABS(f[k]));
+    }
+  }
+
+  free(x);
+
+  return err;
+}
+
+
+/* builds the table of p, refining the grid until the tolerance is reached */
+int
+XC(gga_x_table_init)(XC(gga_type) *p, FLOAT tol)
+{
+  XC(gga_x_table_type) *tab;
+  FLOAT err, last;
+  int n;
+
+  XC(gga_x_table_end)(p);
+
+  if(tol <= 0.0 || p->info->gga_x == NULL)
+    return 0;
+
+  tab = (XC(gga_x_table_type) *) malloc(sizeof(XC(gga_x_table_type)));
+  tab->tol  = tol;
+  tab->coef = NULL;
+
+  last = FLOAT_MAX;
+  for(n=GGA_X_TABLE_NMIN; n<=GGA_X_TABLE_NMAX; n*=2){
+    err = gga_x_table_fill(p, tab, n);
+    if(err <= tol){
+      p->x_table = tab;
+      return 1;
+    }
+
+    /* rounding errors dominate the derivatives of the spline from here on */
+    if(err > last) break;
+    last = err;
+  }
+
+  /* the tolerance is too small for the functional */
+  free(tab->coef);
+  free(tab);
+  return 0;
+}
+
+
+/* called by the set_params routines, when the parameters change */
+void
+XC(gga_x_table_update)(XC(gga_type) *p)
+{
+  if(p->x_table != NULL)
+    XC(gga_x_table_init)(p, p->x_table->tol);
+}
+
+
+void
+XC(gga_x_table_end)(XC(gga_type) *p)
+{
+  if(p->x_table == NULL) return;
+
+  free(p->x_table->coef);
+  free(p->x_table);
+  p->x_table = NULL;
+}
+
+
+/* replaces the table of p, that it shares with the functional it was
+   copied from, by a copy of its own */
+void
+XC(gga_x_table_dup)(XC(gga_type) *p)
+{
+  const XC(gga_x_table_type) *src = p->x_table;
+
+  if(src == NULL) return;
+
+  p->x_table = (XC(gga_x_table_type) *) malloc(sizeof(XC(gga_x_table_type)));
+  *(p->x_table) = *src;
+  p->x_table->coef = (FLOAT *) malloc(6*src->n*sizeof(FLOAT));
+  memcpy(p->x_table->coef, src->coef, 6*src->n*sizeof(FLOAT));
+}
+
+
+/* fills f, dfdx and d2fdx2 of the block from the table. The entries
+   beyond the table are listed in miss, and their number is returned. */
+int
+XC(gga_x_table_eval)(const XC(gga_type) *p, XC(gga_x_batch) *b, int *miss)
+{
+  const XC(gga_x_table_type) *tab = p->x_table;
+  const FLOAT *c;
+  FLOAT xc, u, y, s, d1, d2, dudx, d2udx2;
+  int ip, i, nmiss;
+
+  nmiss = 0;
+  for(ip=0; ip<b->np; ip++){
+    xc = b->x[ip] + GGA_X_TABLE_C;
+    u  = b->x[ip]/xc;
+    y  = u/tab->h;
+    i  = (int) y;
+
+    if(i >= tab->n){
+      miss[nmiss++] = ip;
+      continue;
+    }
+
+    s = y - i;
+    c = tab->coef + 6*i;
+
+    b->f[ip] = ((((c[5]*s + c[4])*s + c[3])*s + c[2])*s + c[1])*s + c[0];
+    if(b->order < 1) continue;
+
+    dudx = GGA_X_TABLE_C/(xc*xc);
+    d1   = ((((5.0*c[5]*s + 4.0*c[4])*s + 3.0*c[3])*s + 2.0*c[2])*s + c[1])/tab->h;
+    b->dfdx[ip] = d1*dudx;
+    if(b->order < 2) continue;
+
+    d2udx2 = -2.0*dudx/xc;
+    d2     = (((20.0*c[5]*s + 12.0*c[4])*s + 6.0*c[3])*s + 2.0*c[2])/(tab->h*tab->h);
+    b->d2fdx2[ip] = d2*dudx*dudx + d1*d2udx2;
+  }
+
+  return nmiss;
+}
+
+
+/* tabulates the enhancement factors of the GGA exchanges used by p, including those in mixtures */
+int
+XC(func_set_gga_x_table)(XC(func_type) *p, FLOAT tol)
+{
+  int ii, ntab = 0;
+
+  assert(p != NULL);
+
+  if(p->info->family != XC_FAMILY_GGA && p->info->family != XC_FAMILY_HYB_GGA)
+    return 0;
+
+  ntab += XC(gga_x_table_init)(p->gga, tol);
+
+  for(ii=0; ii<p->gga->n_func_aux; ii++)
+    ntab += XC(func_set_gga_x_table)(p->gga->func_aux[ii], tol);
+
+  return ntab;
+}
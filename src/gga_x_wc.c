@@ -22,14 +22,9 @@
 
 #define XC_GGA_X_WC         118 /* Wu & Cohen */
 
-static FLOAT wc_mu, wc_c;
-
-static void
-gga_x_wc_init(void *p_)
-{
-  wc_mu  = 0.2195149727645171;
-  wc_c   = (146.0/2025.0)*(4.0/9.0) - (73.0/405.0)*(2.0/3.0) + (wc_mu - 10.0/81.0);
-}
+static const FLOAT
+  wc_mu = 0.2195149727645171,
+  wc_c  = (146.0/2025.0)*(4.0/9.0) - (73.0/405.0)*(2.0/3.0) + (0.2195149727645171 - 10.0/81.0);
 
 static inline void 
 func(const XC(gga_type) *p, int order, FLOAT x, 
@@ -44,9 +39,9 @@ func(const XC(gga_type) *p, int order, FLOAT x,
   s2 = s*s;
   
   aux1 = wc_mu - 10.0/81.0;
-  aux2 = exp(-s2);
+  aux2 = EXP(-s2);
 
-  f0 = kappa + 10.0/81.0*s2 + s2*aux1*aux2 + log(1.0 + wc_c*s2*s2);
+  f0 = kappa + 10.0/81.0*s2 + s2*aux1*aux2 + LOG(1.0 + wc_c*s2*s2);
   *f = 1.0 + kappa*(1.0 - kappa/f0);
 
   if(order < 1) return;
@@ -76,7 +71,8 @@ const XC(func_info_type) XC(func_info_gga_x_wc) = {
   XC_FAMILY_GGA,
   "Z Wu and RE Cohen, Phys. Rev. B 73, 235116 (2006)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
-  gga_x_wc_init, 
+  NULL,
   NULL, NULL,
-  work_gga_x
+  work_gga_x, NULL,
+  work_gga_x_enhancement
 };
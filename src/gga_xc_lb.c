@@ -46,26 +46,17 @@ gga_lb_init(void *p_)
 
   assert(p->params == NULL);
 
-  p->func_aux    = (XC(func_type) **) malloc(1*sizeof(XC(func_type) *));
-  p->func_aux[0] = (XC(func_type) *)  malloc(  sizeof(XC(func_type)));
+  p->n_func_aux  = 1;
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, sizeof(XC(func_type) *)*p->n_func_aux);
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  XC(func_init)(p->func_aux[0], XC_LDA_X, p->nspin);
+  XC(func_init_aux)(p->func_aux[0], XC_LDA_X, p->nspin, p->arena);
 
-  p->params = malloc(sizeof(XC(gga_xc_lb_params)));
+  p->params = XC(arena_alloc)(p->arena, sizeof(XC(gga_xc_lb_params)));
   XC(gga_lb_set_params_)(p, 0, 0.0, 0.0, 0.0);
 }
 
 
-static void
-gga_lb_end(void *p_)
-{
-  XC(gga_type) *p = p_;
-
-  free(p->func_aux[0]);
-  free(p->func_aux);
-}
-
-
 void
 XC(gga_lb_set_params)(XC(func_type) *p, int modified, FLOAT threshold, FLOAT ip, FLOAT qtot)
 {
@@ -88,7 +79,7 @@ XC(gga_lb_set_params_)(XC(gga_type) *p, int modified, FLOAT threshold, FLOAT ip,
   params->qtot      = qtot;
 
   if(params->modified){
-    params->alpha = (params->ip > 0.0) ? 2.0*sqrt(2.0*params->ip) : 0.5;
+    params->alpha = (params->ip > 0.0) ? 2.0*SQRT(2.0*params->ip) : 0.5;
     params->gamm  = POW(params->qtot, 1.0/3.0)/(2.0*params->alpha);
   }else{
     params->alpha = 0.5;
@@ -116,27 +107,28 @@ XC(gga_lb_modified)(const XC(gga_type) *func, int np, const FLOAT *rho, const FL
 
   for(ip=0; ip<np; ip++){
     for(is=0; is<func->nspin; is++){
-      gdm = sqrt(sigma[(is==0) ? 0 : 2]);
+      gdm = SQRT(sigma[(is==0) ? 0 : 2]);
 
       if(params->modified == 0 || 
 	 (rho[is] > params->threshold && gdm > params->threshold)){
-	FLOAT f;
+	FLOAT f, rho13;
       
 	if(rho[is] <= MIN_DENS) continue;
 	
-	x =  gdm/POW(rho[is], 4.0/3.0);
+	rho13 = CBRT(rho[is]);
+	x =  gdm/POW_4_3(rho[is], rho13);
 	
 	if(x < 300.0) /* the actual functional */	   
-	  f = -beta*x*x/(1.0 + 3.0*beta*x*asinh(params->gamm*x));
+	  f = -beta*x*x/(1.0 + 3.0*beta*x*ASINH(params->gamm*x));
 	else          /* asymptotic expansion */
-	  f = -x/(3.0*log(2.0*params->gamm*x));
+	  f = -x/(3.0*LOG(2.0*params->gamm*x));
 
-	vrho[is] += f * POW(rho[is], 1.0/3.0);
+	vrho[is] += f * rho13;
 	
       }else if(r > 0.0){
 	/* the aymptotic expansion of LB94 */
 	x = r + (3.0/params->alpha)*
-	  log(2.0*params->gamm * params->alpha * POW(params->qtot, -1.0/3.0));
+	  LOG(2.0*params->gamm * params->alpha * POW(params->qtot, -1.0/3.0));
 	
 	/* x = x + POW(qtot*exp(-alpha*r), 1.0/3.0)/(beta*alpha*alpha); */
 	
@@ -171,7 +163,7 @@ XC(func_info_type) XC(func_info_gga_xc_lb) = {
   "R van Leeuwen and EJ Baerends, Phys. Rev. A. 49, 2421 (1994)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_VXC,
   gga_lb_init,
-  gga_lb_end,
+  NULL,
   NULL,
   gga_xc_lb
 };
@@ -114,9 +114,9 @@ const XC(func_info_type) XC(func_info_hyb_gga_xc_mpw3pw) = {
   XC_HYB_GGA_XC_mPW3PW,
   XC_EXCHANGE_CORRELATION,
   "mPW3PW of Adamo & Barone",
-  XC_FAMILY_GGA,
+  XC_FAMILY_HYB_GGA,
   "C Adamo and V Barone, J. Chem. Phys. 108, 664 (1998)",
-  XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
+  XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC,
   hyb_gga_xc_mpw3pw_init, 
   NULL, NULL, NULL
 };
@@ -48,7 +48,7 @@ void XC(lca_s_lch)(FLOAT rs, FLOAT *s, FLOAT *dsdrs)
   static FLOAT c[3] = {1.0, 0.028, -0.042};
   FLOAT tmp;
 
-  tmp    = exp(c[2]*rs);
+  tmp    = EXP(c[2]*rs);
   *s     = (c[0] + c[1]*rs)*tmp;
   *dsdrs = (c[1] + c[2]*(c[0] + c[1]*rs))*tmp;
 }
@@ -44,9 +44,10 @@ void XC(lca_omc_init)(XC(lca_type) *p)
 void XC(lca_s_omc)(FLOAT rs, FLOAT *s, FLOAT *dsdrs)
 {
   static FLOAT c[5] = {1.1038, -0.4990, 0.4423, -0.06696, 0.0008432};
-  FLOAT tmp;
+  FLOAT tmp, rs13;
   
-  tmp    = sqrt(rs);
-  *s     = c[0] + c[1]*POW(rs, 1.0/3.0) + c[2]*tmp + c[3]*rs + c[4]*rs*rs;
-  *dsdrs = c[1]*POW(rs, -2.0/3.0)/3.0 + c[2]/(2.0*tmp) + c[3] + 2.0*c[4]*rs;
+  tmp    = SQRT(rs);
+  rs13   = CBRT(rs);
+  *s     = c[0] + c[1]*rs13 + c[2]*tmp + c[3]*rs + c[4]*rs*rs;
+  *dsdrs = c[1]/(3.0*POW_2_3(rs13)) + c[2]/(2.0*tmp) + c[3] + 2.0*c[4]*rs;
 }
@@ -39,6 +39,10 @@ XC(lda_init)(XC(func_type) *p, const XC(func_info_type) *info, int nspin)
   func->nspin  = nspin;
   func->params = NULL;
   func->func   = 0;
+  func->layout = p->layout;
+  func->table  = NULL;
+  func->stats  = p->stats;
+  func->arena  = p->arena;
 
   /* initialize spin counters */
   func->n_rho = func->n_vrho = func->nspin;
@@ -66,23 +70,70 @@ XC(lda_end)(XC(func_type) *p)
   assert(p != NULL && p->lda != NULL);
   func = p->lda;
 
+  XC(lda_table_end)(func);
+
   if(func->info->end != NULL)
     func->info->end(func);
 
-  /* deallocate any used parameter */
-  if(func->params != NULL){
-    free(func->params);
-    func->params = NULL;
+  /* the parameters are in the arena of the functional */
+  func->params = NULL;
+}
+
+
+/* evaluates a contiguous block of points. The LDA kernels write every
+   output, in the layout of func, so the arrays are not cleared before.
+   To accumulate, the results are computed in interleaved buffers by a
+   copy of func without layout, and then added to the output */
+static void
+lda_block(const XC(lda_type) *func, int accumulate, int np, const FLOAT *rho,
+	  FLOAT *zk, FLOAT *vrho, FLOAT *v2rho2, FLOAT *v3rho3)
+{
+  const XC(layout_type) *l = func->layout;
+  XC(lda_type) f;
+
+  FLOAT rho_[2*LAYOUT_BLOCK_SIZE], zk_[LAYOUT_BLOCK_SIZE], vrho_[2*LAYOUT_BLOCK_SIZE];
+  FLOAT v2rho2_[3*LAYOUT_BLOCK_SIZE], v3rho3_[4*LAYOUT_BLOCK_SIZE];
+  int ip, nb;
+
+  if(!accumulate){
+    func->info->lda(func, np, rho, zk, vrho, v2rho2, v3rho3);
+    return;
+  }
+
+  f = *func;
+  f.layout = NULL;
+
+  for(ip=0; ip<np; ip+=LAYOUT_BLOCK_SIZE){
+    nb = min(np - ip, LAYOUT_BLOCK_SIZE);
+
+    if(l != NULL)
+      XC(layout_gather)(nb, f.n_rho, &l->rho, rho + ip*l->rho.point, rho_);
+
+    f.info->lda(&f, nb, (l == NULL) ? rho + ip*f.n_rho : rho_,
+		(zk     == NULL) ? NULL : zk_,     (vrho   == NULL) ? NULL : vrho_,
+		(v2rho2 == NULL) ? NULL : v2rho2_, (v3rho3 == NULL) ? NULL : v3rho3_);
+
+    if(zk != NULL)
+      XC(layout_scatter)(nb, f.n_zk,     (l == NULL) ? NULL : &l->zk,     zk_,     zk     + ip*PT_STRIDE(l, zk,     f.n_zk),     1);
+    if(vrho != NULL)
+      XC(layout_scatter)(nb, f.n_vrho,   (l == NULL) ? NULL : &l->vrho,   vrho_,   vrho   + ip*PT_STRIDE(l, vrho,   f.n_vrho),   1);
+    if(v2rho2 != NULL)
+      XC(layout_scatter)(nb, f.n_v2rho2, (l == NULL) ? NULL : &l->v2rho2, v2rho2_, v2rho2 + ip*PT_STRIDE(l, v2rho2, f.n_v2rho2), 1);
+    if(v3rho3 != NULL)
+      XC(layout_scatter)(nb, f.n_v3rho3, (l == NULL) ? NULL : &l->v3rho3, v3rho3_, v3rho3 + ip*PT_STRIDE(l, v3rho3, f.n_v3rho3), 1);
   }
 }
 
 
 /* get the lda functional */
 void 
-XC(lda)(const XC(func_type) *p, int np, const FLOAT *rho, 
-	FLOAT *zk, FLOAT *vrho, FLOAT *v2rho2, FLOAT *v3rho3)
+XC(lda64)(const XC(func_type) *p, size_t np, const FLOAT *rho, 
+	  FLOAT *zk, FLOAT *vrho, FLOAT *v2rho2, FLOAT *v3rho3)
 {
   XC(lda_type) *func;
+  size_t bs;
+  int ib, nblocks;
+  XC(stats_mark_type) mark;
 
   assert(p != NULL && p->lda != NULL);
   func = p->lda;
@@ -112,24 +163,35 @@ XC(lda)(const XC(func_type) *p, int np, const FLOAT *rho,
     exit(1);
   }
 
-  /* initialize output */
-  if(zk != NULL)
-    memset(zk,     0, np*sizeof(FLOAT)*func->n_zk);
-
-  if(vrho != NULL)
-    memset(vrho,   0, np*sizeof(FLOAT)*func->n_vrho);
+  assert(func->info!=NULL && func->info->lda!=NULL);
 
-  if(v2rho2 != NULL)
-    memset(v2rho2, 0, np*sizeof(FLOAT)*func->n_v2rho2);
+  nblocks = XC(get_nblocks)(np, p->nthreads, &bs);
 
-  if(v3rho3 != NULL)
-    memset(v3rho3, 0, np*sizeof(FLOAT)*func->n_v3rho3);
+  if(p->stats != NULL) XC(stats_begin)(p, &mark);
 
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(p->nthreads) schedule(dynamic) if(nblocks > 1 && p->nthreads > 1)
+#endif
+  for(ib=0; ib<nblocks; ib++){
+    size_t ip = ib*bs;
+
+    lda_block(func, p->output_mode == XC_OUTPUT_ACCUMULATE, (ip + bs < np) ? bs : np - ip,
+	      rho + ip*PT_STRIDE(p->layout, rho, func->n_rho),
+	      PT_OFFSET(zk,     ip, PT_STRIDE(p->layout, zk,     func->n_zk)),
+	      PT_OFFSET(vrho,   ip, PT_STRIDE(p->layout, vrho,   func->n_vrho)),
+	      PT_OFFSET(v2rho2, ip, PT_STRIDE(p->layout, v2rho2, func->n_v2rho2)),
+	      PT_OFFSET(v3rho3, ip, PT_STRIDE(p->layout, v3rho3, func->n_v3rho3)));
+  }
 
-  assert(func->info!=NULL && func->info->lda!=NULL);
+  if(p->stats != NULL)
+    XC(stats_end)(p, &mark, np, (v3rho3 != NULL) ? 3 : (v2rho2 != NULL) ? 2 : (vrho != NULL) ? 1 : 0);
+}
 
-  /* call the LDA routines */
-  func->info->lda(func, np, rho, zk, vrho, v2rho2, v3rho3);
+void 
+XC(lda)(const XC(func_type) *p, int np, const FLOAT *rho, 
+	FLOAT *zk, FLOAT *vrho, FLOAT *v2rho2, FLOAT *v3rho3)
+{
+  XC(lda64)(p, (np > 0) ? np : 0, rho, zk, vrho, v2rho2, v3rho3);
 }
 
 
@@ -165,21 +227,128 @@ XC(lda_kxc)(const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *v3rho3)
 }
 
 
+/* evaluates a chunk of points for XC(lda_exc_vxc_weighted) */
+static void
+lda_weighted_block(const XC(lda_type) *func, int np, const FLOAT *rho, const FLOAT *weights,
+		   FLOAT *exc, FLOAT *vrho, int accumulate)
+{
+  FLOAT zk_[WEIGHTED_BLOCK_SIZE], vrho_[2*WEIGHTED_BLOCK_SIZE];
+  FLOAT *lvrho;
+
+  /* without accumulation the potential is written in place and then weighted */
+  lvrho = (vrho == NULL) ? NULL : (accumulate ? vrho_ : vrho);
+
+  lda_block(func, 0, np, rho, (exc != NULL) ? zk_ : NULL, lvrho, NULL, NULL);
+
+  if(exc != NULL)
+    *exc = XC(weighted_energy)(np, func->nspin, func->n_rho, rho, weights, zk_);
+
+  if(vrho != NULL)
+    XC(weight_potential)(np, func->n_vrho, weights, lvrho, vrho, accumulate);
+}
+
+
+/* Returns the integrated energy exc = sum_i weights_i rho_i zk_i and the
+   potential multiplied by the weights. If accumulate is true the weighted
+   potential is added to the values already in vrho. Either exc or vrho
+   may be NULL. */
+void 
+XC(lda_exc_vxc_weighted64)(const XC(func_type) *p, size_t np, const FLOAT *rho, const FLOAT *weights,
+			   FLOAT *exc, FLOAT *vrho, int accumulate)
+{
+  XC(lda_type) *func;
+  FLOAT *partial;
+  size_t ic, nchunks;
+  long long jc;
+  XC(stats_mark_type) mark;
+
+  assert(p != NULL && p->lda != NULL);
+  func = p->lda;
+
+  if(exc != NULL && !(func->info->flags & XC_FLAGS_HAVE_EXC)){
+    fprintf(stderr, "Functional '%s' does not provide an implementation of Exc",
+	    func->info->name);
+    exit(1);
+  }
+
+  if(vrho != NULL && !(func->info->flags & XC_FLAGS_HAVE_VXC)){
+    fprintf(stderr, "Functional '%s' does not provide an implementation of vxc",
+	    func->info->name);
+    exit(1);
+  }
+
+  if(p->layout != NULL){
+    fprintf(stderr, "The weighted entry points only work with the default memory layout");
+    exit(1);
+  }
+
+  nchunks = (np + WEIGHTED_BLOCK_SIZE - 1)/WEIGHTED_BLOCK_SIZE;
+  partial = (exc == NULL) ? NULL : (FLOAT *) XC(arena_scratch_get)(p->arena, nchunks*sizeof(FLOAT));
+
+  if(p->stats != NULL) XC(stats_begin)(p, &mark);
+
+  /* before OpenMP 3.0 the index of a parallel loop has to be signed */
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(p->nthreads) schedule(dynamic) if(p->nthreads > 1)
+#endif
+  for(jc=0; jc<(long long) nchunks; jc++){
+    size_t ip = (size_t) jc*WEIGHTED_BLOCK_SIZE;
+
+    lda_weighted_block(func, (np - ip < WEIGHTED_BLOCK_SIZE) ? np - ip : WEIGHTED_BLOCK_SIZE, 
+		       rho + ip*func->n_rho, weights + ip, 
+		       (partial == NULL) ? NULL : partial + jc, PT_OFFSET(vrho, ip, func->n_vrho), accumulate);
+  }
+
+  if(exc != NULL){
+    *exc = 0.0;
+    for(ic=0; ic<nchunks; ic++)
+      *exc += partial[ic];
+    XC(arena_scratch_release)(p->arena, partial);
+  }
+
+  if(p->stats != NULL)
+    XC(stats_end)(p, &mark, np, (vrho != NULL) ? 1 : 0);
+}
+
+void 
+XC(lda_exc_vxc_weighted)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *weights,
+			 FLOAT *exc, FLOAT *vrho, int accumulate)
+{
+  XC(lda_exc_vxc_weighted64)(p, (np > 0) ? np : 0, rho, weights, exc, vrho, accumulate);
+}
+
+
 #ifdef SINGLE_PRECISION
 #  define DELTA_RHO 1e-4
 #else
 #  define DELTA_RHO 1e-6
 #endif
 
+/* the finite differences evaluate the potential one point at a time, in
+   their own arrays: a copy of the functional without layout, called
+   directly, overwrites them whatever the output mode of p */
+static void
+fd_func(const XC(func_type) *p, XC(lda_type) *f)
+{
+  *f = *p->lda;
+  f->layout = NULL;
+
+  if(!(f->info->flags & XC_FLAGS_HAVE_VXC)){
+    fprintf(stderr, "Functional '%s' does not provide an implementation of vxc",
+	    f->info->name);
+    exit(1);
+  }
+}
+
 /* get the xc kernel through finite differences */
 void 
 XC(lda_fxc_fd)(const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *v2rho2)
 {
-  XC(lda_type) *func;
+  XC(lda_type) f, *func = &f;
   int i, ip;
 
   assert(p != NULL && p->lda != NULL);
-  func = p->lda;
+  fd_func(p, &f);
 
   for(ip=0; ip<np; ip++){
     for(i=0; i<func->nspin; i++){
@@ -191,10 +360,10 @@ XC(lda_fxc_fd)(const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *v2rho2)
       
       rho2[i] = rho[i] + DELTA_RHO;
       rho2[j] = (func->nspin == XC_POLARIZED) ? rho[j] : 0.0;
-      XC(lda_vxc)(p, 1, rho2, vc1);
+      lda_block(func, 0, 1, rho2, NULL, vc1, NULL, NULL);
       
       if(rho[i]<2.0*DELTA_RHO){ /* we have to use a forward difference */
-	XC(lda_vxc)(p, 1, rho, vc2);
+	lda_block(func, 0, 1, rho, NULL, vc2, NULL, NULL);
 	
 	v2rho2[js] = (vc1[i] - vc2[i])/(DELTA_RHO);
 	if(func->nspin == XC_POLARIZED && i==0)
@@ -202,7 +371,7 @@ XC(lda_fxc_fd)(const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *v2rho2)
 	
       }else{                    /* centered difference (more precise)  */
 	rho2[i] = rho[i] - DELTA_RHO;
-	XC(lda_vxc)(p, 1, rho2, vc2);
+	lda_block(func, 0, 1, rho2, NULL, vc2, NULL, NULL);
       
 	v2rho2[js] = (vc1[i] - vc2[i])/(2.0*DELTA_RHO);
 	if(func->nspin == XC_POLARIZED && i==0)
@@ -220,24 +389,24 @@ void
 XC(lda_kxc_fd)(const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *v3rho3)
 {
   /* Kxc, this is a third order tensor with respect to the densities */
-  XC(lda_type) *func;
+  XC(lda_type) f, *func = &f;
   int ip, i, j, n;
 
   assert(p != NULL && p->lda != NULL);
-  func = p->lda;
+  fd_func(p, &f);
 
   for(ip=0; ip<np; ip++){
     for(i=0; i<func->nspin; i++){
       FLOAT rho2[2], vc1[2], vc2[2], vc3[2];
 
       for(n=0; n<func->nspin; n++) rho2[n] = rho[n];
-      XC(lda_vxc)(p, 1, rho, vc2);
+      lda_block(func, 0, 1, rho, NULL, vc2, NULL, NULL);
 
       rho2[i] += DELTA_RHO;
-      XC(lda_vxc)(p, 1, rho2, vc1);
+      lda_block(func, 0, 1, rho2, NULL, vc1, NULL, NULL);
 	
       rho2[i] -= 2.0*DELTA_RHO;
-      XC(lda_vxc)(p, 1, rho2, vc3);    
+      lda_block(func, 0, 1, rho2, NULL, vc3, NULL, NULL);    
     
       for(j=0; j<func->nspin; j++)
 	v3rho3[i*func->nspin + j] = (vc1[j] - 2.0*vc2[j] + vc3[j])/(DELTA_RHO*DELTA_RHO);
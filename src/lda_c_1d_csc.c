@@ -36,22 +36,12 @@ lda_c_1d_csc_init(void *p_)
   XC(lda_type) *p = (XC(lda_type) *)p_;
 
   assert(p->params == NULL);
-  p->params = malloc(sizeof(lda_c_1d_csc_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(lda_c_1d_csc_params));
 
   /* default value is soft-Coulomb with beta=1.0 */
   XC(lda_c_1d_csc_set_params_)(p, 1, 1.0);
 }
 
-static void 
-lda_c_1d_csc_end(void *p_)
-{
-  XC(lda_type) *p = (XC(lda_type) *)p_;
-
-  assert(p->params != NULL);
-  free(p->params);
-  p->params = NULL;
-}
-
 void 
 XC(lda_c_1d_csc_set_params)(XC(func_type) *p, int interaction, FLOAT bb)
 {
@@ -205,6 +195,6 @@ const XC(func_info_type) XC(func_info_lda_c_1d_csc) = {
   "M Casula, S Sorella, and G Senatore, Phys. Rev. B 74, 245427 (2006)",
   XC_FLAGS_1D |  XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC,
   lda_c_1d_csc_init,    /* init */
-  lda_c_1d_csc_end,     /* end  */
+  NULL,                 /* end  */
   work_lda,             /* lda  */
 };
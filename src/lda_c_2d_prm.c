@@ -47,24 +47,13 @@ lda_c_2d_prm_init(void *p_)
 
   assert(p->params == NULL);
 
-  p->params = malloc(sizeof(lda_c_prm_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(lda_c_prm_params));
   params = (lda_c_prm_params *) (p->params);
 
   params->N = 0.0;
 }
 
 
-static void 
-lda_c_2d_prm_end(void *p_)
-{
-  XC(lda_type) *p = (XC(lda_type) *)p_;
-
-  assert(p->params != NULL);
-  free(p->params);
-  p->params = NULL;
-}
-
-
 void 
 XC(lda_c_2d_prm_set_params)(XC(func_type) *p, FLOAT N)
 {
@@ -104,7 +93,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   assert(params->N > 1.0);
   assert(p->nspin == XC_UNPOLARIZED);
   
-  sqpi = sqrt(M_PI);
+  sqpi = SQRT(M_PI);
 
   beta = prm_q/(sqpi*r->rs[1]); /* Eq. (4) */
   c    = params->c;
@@ -114,26 +103,26 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   t3  = phi - 1.0; /* original version has (phi-1)^2 */
   t2  = M_PI/(2.0*prm_q*prm_q);
     
-  t1  = sqpi*beta*t3/(2.0*sqrt(2.0 + c));
+  t1  = sqpi*beta*t3/(2.0*SQRT(2.0 + c));
   t1 += phi*(phi - 1.0)/(2.0 + c);
   t1 += sqpi*phi*phi/(4.0*beta*POW(2.0 + c, 1.5));
-  t1 += sqpi*beta*(phi - 1.0)/sqrt(1.0 + c);
+  t1 += sqpi*beta*(phi - 1.0)/SQRT(1.0 + c);
   t1 += phi/(1.0 + c);
   t1 *= t2;
     
   r->zk = t1;
   if(r->order < 1) return;
 
-  dt1dbeta  = sqpi*t3/(2.0*sqrt(2.0 + c));
+  dt1dbeta  = sqpi*t3/(2.0*SQRT(2.0 + c));
   dt1dbeta -= sqpi*phi*phi/(4.0*beta*beta*POW(2.0 + c, 1.5));
-  dt1dbeta += sqpi*(phi - 1.0)/sqrt(1.0 + c);
+  dt1dbeta += sqpi*(phi - 1.0)/SQRT(1.0 + c);
   dt1dbeta *= t2;
 
   dt3dphi   = 1.0;
-  dt1dphi   = sqpi*beta/(2.0*sqrt(2.0 + c))*dt3dphi;
+  dt1dphi   = sqpi*beta/(2.0*SQRT(2.0 + c))*dt3dphi;
   dt1dphi  += (2.0*phi - 1.0)/(2.0 + c);
   dt1dphi  += sqpi*2.0*phi/(4.0*beta*POW(2.0 + c, 1.5));
-  dt1dphi  += sqpi*beta/sqrt(1.0 + c);
+  dt1dphi  += sqpi*beta/SQRT(1.0 + c);
   dt1dphi  += 1.0/(1.0 + c);
   dt1dphi  *= t2;
 
@@ -158,6 +147,6 @@ const XC(func_info_type) XC(func_info_lda_c_2d_prm) = {
   "S Pittalis, E Rasanen, and MAL Marques, Phys. Rev. B 78, 195322 (2008)",
   XC_FLAGS_2D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC,
   lda_c_2d_prm_init,
-  lda_c_2d_prm_end,
+  NULL,
   work_lda
 };
@@ -48,7 +48,7 @@ hl_f(int func, int order, int i, FLOAT rs, FLOAT *zk, FLOAT *drs, FLOAT *d2rs, F
   x2  = x*x;
   x3  = x2*x;
   
-  a   = log(1.0 + 1.0/x);
+  a   = LOG(1.0 + 1.0/x);
   *zk = -c[func][i]*((1.0 + x3)*a - x2 + 0.5*x - 1.0/3.0);
   
   if(order < 1) return;
@@ -75,6 +75,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   FLOAT ecp, vcp, fcp, kcp;
   FLOAT ecf, vcf, fcf, kcf;
   FLOAT fz, dfz, d2fz, d3fz;
+  XC(spin_scaling_batch) ss;
 
   switch(p->info->number){
   case XC_LDA_C_GL:  func = 1; break;
@@ -90,7 +91,9 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
     /* get ferromagnetic values */
     hl_f(func, r->order, 1, r->rs[1], &ecf, &vcf, &fcf, &kcf);
 
-    fz = FZETA(r->zeta);
+    XC(spin_scaling)(1, r->order, &(r->zeta), &ss);
+
+    fz = ss.fz[0][0];
     r->zk = ecp + (ecf - ecp)*fz;
   }
 
@@ -99,7 +102,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   if(p->nspin == XC_UNPOLARIZED)
     r->dedrs = vcp;
   else{
-    dfz = DFZETA(r->zeta);
+    dfz = ss.fz[1][0];
     r->dedrs = vcp + (vcf - vcp)*fz;
     r->dedz  =       (ecf - ecp)*dfz;
   }
@@ -109,7 +112,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   if(p->nspin == XC_UNPOLARIZED)
     r->d2edrs2 = fcp;
   else{
-    d2fz = D2FZETA(r->zeta);
+    d2fz = ss.fz[2][0];
     r->d2edrs2 = fcp + (fcf - fcp)*fz;
     r->d2edrsz =       (vcf - vcp)*dfz;
     r->d2edz2  =       (ecf - ecp)*d2fz;
@@ -120,7 +123,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   if(p->nspin == XC_UNPOLARIZED)
     r->d3edrs3 = kcp;
   else{
-    d3fz = D3FZETA(r->zeta);
+    d3fz = ss.fz[3][0];
     r->d3edrs3  = kcp + (kcf - kcp)*fz;
     r->d3edrs2z =       (fcf - fcp)*dfz;
     r->d3edrsz2 =       (vcf - vcp)*d2fz;
@@ -38,166 +38,189 @@ the constants of PW.
 #define XC_LDA_C_OB_PW  14   /* Ortiz & Ballone (PW)         */
 
 
+static const FLOAT pw_a[3][3]     = 
+  {
+    {0.031091,  0.015545,   0.016887},    /* PW */
+    {0.0310907, 0.01554535, 0.0168869},   /* PW (modified) */
+    {0.031091,  0.015545,   0.016887}     /* OB */
+  }; 
+static const FLOAT pw_alpha[3][3] = 
+  {
+    {0.21370,  0.20548,  0.11125},    /* PW */
+    {0.21370,  0.20548,  0.11125},    /* PW (modified) */
+    {0.026481, 0.022465, 0.11125}     /* OB */
+  };
+static const FLOAT pw_beta[3][3][4] = {
+  {
+    { 7.5957,  3.5876,   1.6382,  0.49294}, /* PW */
+    {14.1189,  6.1977,   3.3662,  0.62517},
+    {10.357,   3.6231,   0.88026, 0.49671}
+  },{
+    { 7.5957,  3.5876,   1.6382,  0.49294}, /* PW (modified) */
+    {14.1189,  6.1977,   3.3662,  0.62517},
+    {10.357,   3.6231,   0.88026, 0.49671}
+  },{
+    { 7.5957,  3.5876,  -0.46647, 0.13354}, /* OB */
+    {14.1189,  6.1977,  -0.56043, 0.11313},
+    {10.357,   3.6231,   0.88026, 0.49671}
+  }};
+
+static const FLOAT fz20[3] = {
+  1.709921,                           /* PW */
+  1.709920934161365617563962776245,   /* PW (modified) */
+  1.709921                            /* OB */
+};
+
+
 /* Function g defined by Eq. 10 of the original paper,
-   and it's derivative with respect to rs, Eq. A5 */
-static void g(int func, int order, int k, FLOAT *rs, 
+   and it's derivative with respect to rs, Eq. A5.
+   Evaluated for all the points of the block */
+static void g(int func, int order, int k, int np, const FLOAT rs[3][LDA_BATCH_SIZE], 
 	      FLOAT *f, FLOAT *dfdrs, FLOAT *d2fdrs2, FLOAT *d3fdrs3)
 {
-  static FLOAT a[3][3]     = 
-    {
-      {0.031091,  0.015545,   0.016887},    /* PW */
-      {0.0310907, 0.01554535, 0.0168869},   /* PW (modified) */
-      {0.031091,  0.015545,   0.016887}     /* OB */
-  }; 
-  static FLOAT alpha[3][3] = 
-    {
-      {0.21370,  0.20548,  0.11125},    /* PW */
-      {0.21370,  0.20548,  0.11125},    /* PW (modified) */
-      {0.026481, 0.022465, 0.11125}     /* OB */
-    };
-  static FLOAT beta[3][3][4] = {
-    {
-      { 7.5957,  3.5876,   1.6382,  0.49294}, /* PW */
-      {14.1189,  6.1977,   3.3662,  0.62517},
-      {10.357,   3.6231,   0.88026, 0.49671}
-    },{
-      { 7.5957,  3.5876,   1.6382,  0.49294}, /* PW (modified) */
-      {14.1189,  6.1977,   3.3662,  0.62517},
-      {10.357,   3.6231,   0.88026, 0.49671}
-    },{
-      { 7.5957,  3.5876,  -0.46647, 0.13354}, /* OB */
-      {14.1189,  6.1977,  -0.56043, 0.11313},
-      {10.357,   3.6231,   0.88026, 0.49671}
-    }};
-  
-  FLOAT q0, dq0, q1, dq1, q2, d2q1, d3q1, aux1;
-  
-  q0  = -2.0*a[func][k]*(1.0 + alpha[func][k]*rs[1]);
-  q1  =  2.0*a[func][k];
-  q1 *= beta[func][k][0]*rs[0] + beta[func][k][1]*rs[1] + 
-    beta[func][k][2]*rs[0]*rs[1] + beta[func][k][3]*rs[2];
-  q2  = log(1.0 + 1.0/q1);
-
-  /* the function */
-  *f = q0*q2;
+  const FLOAT aa = pw_a[func][k], al = pw_alpha[func][k], *bb = pw_beta[func][k];
+
+  FLOAT q0, dq0, q1, dq1, d2q1, d3q1, aux1;
+  FLOAT q1s[LDA_BATCH_SIZE], q2[LDA_BATCH_SIZE];
+  int ip;
+
+  if(np <= 0) return;
+
+  for(ip=0; ip<np; ip++){
+    q1s[ip]  = 2.0*aa;
+    q1s[ip] *= bb[0]*rs[0][ip] + bb[1]*rs[1][ip] + 
+      bb[2]*rs[0][ip]*rs[1][ip] + bb[3]*rs[2][ip];
+    q2[ip]   = 1.0 + 1.0/q1s[ip];
+  }
+  XC(vlog)(np, q2, q2);
+
+  for(ip=0; ip<np; ip++){
+    q0  = -2.0*aa*(1.0 + al*rs[1][ip]);
+    q1  = q1s[ip];
+
+    /* the function */
+    f[ip] = q0*q2[ip];
   
-  if(order < 1) return; /* nothing else to do */
+    if(order < 1) continue; /* nothing else to do */
 
-  aux1 = q1*(1.0 + q1);
+    aux1 = q1*(1.0 + q1);
 
-  /* and now the derivative */
-  dq0 = -2.0*a[func][k]*alpha[func][k];
-  dq1 = a[func][k]*(beta[func][k][0]/rs[0] + 2.0*beta[func][k][1] + 
-		    3.0*beta[func][k][2]*rs[0] + 4.0*beta[func][k][3]*rs[1]);
+    /* and now the derivative */
+    dq0 = -2.0*aa*al;
+    dq1 = aa*(bb[0]/rs[0][ip] + 2.0*bb[1] + 
+	      3.0*bb[2]*rs[0][ip] + 4.0*bb[3]*rs[1][ip]);
 
-  *dfdrs = dq0*q2 - q0*dq1/aux1;
+    dfdrs[ip] = dq0*q2[ip] - q0*dq1/aux1;
 
-  if(order < 2) return;
+    if(order < 2) continue;
 
-  d2q1 = a[func][k]*(-beta[func][k][0]/(2.0*rs[0]*rs[1]) +
-		     3.0*beta[func][k][2]/(2.0*rs[0]) + 4.0*beta[func][k][3]);
+    d2q1 = aa*(-bb[0]/(2.0*rs[0][ip]*rs[1][ip]) +
+	       3.0*bb[2]/(2.0*rs[0][ip]) + 4.0*bb[3]);
 
-  *d2fdrs2 = 1.0/aux1*(-2*dq0*dq1 - q0*d2q1 + q0*(2.0*q1 + 1.0)*dq1*dq1/aux1);
+    d2fdrs2[ip] = 1.0/aux1*(-2*dq0*dq1 - q0*d2q1 + q0*(2.0*q1 + 1.0)*dq1*dq1/aux1);
 
-  if(order < 3) return;
+    if(order < 3) continue;
   
-  d3q1 = (3.0/4.0)*a[func][k]*(beta[func][k][0]/(rs[0]*rs[2]) - beta[func][k][2]/(rs[0]*rs[1]));
-
-  *d3fdrs3  =  2.0*q0*(2.0 + 3.0*q1)*dq1*dq1*dq1;
-  *d3fdrs3 += -3.0*aux1*dq1*(dq0*dq1 + q0*d2q1);
-  *d3fdrs3 += (1.0 + q1)*(1.0 + q1)*
-    (-6.0*q0*dq1*dq1*dq1 + 6.0*q1*dq1*(dq0*dq1 + q0*d2q1)
-     -q1*q1*(3.0*dq0*d2q1 + q0*d3q1));
-  *d3fdrs3 /= aux1*aux1*aux1;
+    d3q1 = (3.0/4.0)*aa*(bb[0]/(rs[0][ip]*rs[2][ip]) - bb[2]/(rs[0][ip]*rs[1][ip]));
+
+    d3fdrs3[ip]  =  2.0*q0*(2.0 + 3.0*q1)*dq1*dq1*dq1;
+    d3fdrs3[ip] += -3.0*aux1*dq1*(dq0*dq1 + q0*d2q1);
+    d3fdrs3[ip] += (1.0 + q1)*(1.0 + q1)*
+      (-6.0*q0*dq1*dq1*dq1 + 6.0*q1*dq1*(dq0*dq1 + q0*d2q1)
+       -q1*q1*(3.0*dq0*d2q1 + q0*d3q1));
+    d3fdrs3[ip] /= aux1*aux1*aux1;
+  }
 }
 
 
 /* the functional */
-static inline void 
-func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
+static void 
+func_batch(const XC(lda_type) *p, XC(lda_rs_zeta_batch) *b)
 {
-  static FLOAT fz20[3] = {
-    1.709921,                           /* PW */
-    1.709920934161365617563962776245,   /* PW (modified) */
-    1.709921                            /* OB */
-  };
+  /* paramagnetic, ferromagnetic and -alpha_c */
+  FLOAT ec[3][LDA_BATCH_SIZE], vc[3][LDA_BATCH_SIZE], fc[3][LDA_BATCH_SIZE], kc[3][LDA_BATCH_SIZE];
+  XC(spin_scaling_batch) ss;
 
-  int func;
+  int func, ip;
   FLOAT ecp, vcp, fcp, kcp;
   FLOAT ecf, vcf, fcf, kcf;
   FLOAT alpha, dalpha, d2alpha, d3alpha;
-  FLOAT z2, z3, z4, fz, dfz, d2fz, d3fz;  
+  FLOAT zeta, z2, z3, z4, fz, dfz, d2fz, d3fz;  
 
   func = p->info->number - XC_LDA_C_PW;
   assert(func==0 || func==1 || func==2);
   
   /* ec(rs, 0) */
-  g(func, r->order, 0, r->rs, &ecp, &vcp, &fcp, &kcp);
-  
-  if(p->nspin == XC_UNPOLARIZED)
-    r->zk = ecp;
-  else{
-    /* get ferromagnetic values */
-    g(func, r->order, 1, r->rs, &ecf, &vcf, &fcf, &kcf);
-
-    /* get -alpha_c */
-    g(func, r->order, 2, r->rs, &alpha, &dalpha, &d2alpha, &d3alpha);
-    alpha *= -1.0;
-
-    fz  = FZETA(r->zeta);
-    z2  = r->zeta*r->zeta;
-    z3  = r->zeta*z2;
-    z4  = r->zeta*z3;
-    r->zk = ecp + z4*fz*(ecf - ecp - alpha/fz20[func]) + fz*alpha/fz20[func];
+  if(p->nspin == XC_UNPOLARIZED){
+    g(func, b->order, 0, b->np, b->rs, b->zk, b->dedrs, b->d2edrs2, b->d3edrs3);
+    return;
   }
 
-  if(r->order < 1) return;
+  g(func, b->order, 0, b->np, b->rs, ec[0], vc[0], fc[0], kc[0]);
+
+  /* get ferromagnetic values */
+  g(func, b->order, 1, b->np, b->rs, ec[1], vc[1], fc[1], kc[1]);
+
+  /* get -alpha_c */
+  g(func, b->order, 2, b->np, b->rs, ec[2], vc[2], fc[2], kc[2]);
 
-  if(p->nspin == XC_UNPOLARIZED)
-    r->dedrs = vcp;
-  else{
-    dalpha *= -1.0;
+  XC(spin_scaling)(b->np, b->order, b->zeta, &ss);
 
-    dfz = DFZETA(r->zeta);
-    r->dedrs = vcp + z4*fz*(vcf - vcp - dalpha/fz20[func]) + fz*dalpha/fz20[func];
-    r->dedz  = (4.0*z3*fz + z4*dfz)*(ecf - ecp - alpha/fz20[func])
+  for(ip=0; ip<b->np; ip++){
+    ecp   = ec[0][ip];
+    ecf   = ec[1][ip];
+    alpha = -ec[2][ip];
+
+    zeta = b->zeta[ip];
+    fz   = ss.fz[0][ip];
+    z2   = zeta*zeta;
+    z3   = zeta*z2;
+    z4   = zeta*z3;
+    b->zk[ip] = ecp + z4*fz*(ecf - ecp - alpha/fz20[func]) + fz*alpha/fz20[func];
+
+    if(b->order < 1) continue;
+
+    vcp    = vc[0][ip];
+    vcf    = vc[1][ip];
+    dalpha = -vc[2][ip];
+
+    dfz = ss.fz[1][ip];
+    b->dedrs[ip] = vcp + z4*fz*(vcf - vcp - dalpha/fz20[func]) + fz*dalpha/fz20[func];
+    b->dedz[ip]  = (4.0*z3*fz + z4*dfz)*(ecf - ecp - alpha/fz20[func])
       + dfz*alpha/fz20[func];
-  }
 
-  if(r->order < 2) return;
+    if(b->order < 2) continue;
 
-  if(p->nspin == XC_UNPOLARIZED)
-    r->d2edrs2 = fcp;
-  else{
-    d2alpha *= -1.0;
+    fcp     = fc[0][ip];
+    fcf     = fc[1][ip];
+    d2alpha = -fc[2][ip];
 
-    d2fz = D2FZETA(r->zeta);
-    r->d2edrs2 = fcp + z4*fz*(fcf - fcp - d2alpha/fz20[func]) + fz*d2alpha/fz20[func];
-    r->d2edrsz = (4.0*z3*fz + z4*dfz)*(vcf - vcp - dalpha/fz20[func])
+    d2fz = ss.fz[2][ip];
+    b->d2edrs2[ip] = fcp + z4*fz*(fcf - fcp - d2alpha/fz20[func]) + fz*d2alpha/fz20[func];
+    b->d2edrsz[ip] = (4.0*z3*fz + z4*dfz)*(vcf - vcp - dalpha/fz20[func])
       + dfz*dalpha/fz20[func];
-    r->d2edz2  = (12.0*z2*fz + 8.0*z3*dfz + z4*d2fz)*(ecf - ecp - alpha/fz20[func])
+    b->d2edz2[ip]  = (12.0*z2*fz + 8.0*z3*dfz + z4*d2fz)*(ecf - ecp - alpha/fz20[func])
       + d2fz*alpha/fz20[func];
-  }
 
-  if(r->order < 3) return;
+    if(b->order < 3) continue;
 
-  if(p->nspin == XC_UNPOLARIZED)
-    r->d3edrs3 = kcp;
-  else{
-    d3alpha *= -1.0;
+    kcp     = kc[0][ip];
+    kcf     = kc[1][ip];
+    d3alpha = -kc[2][ip];
 
-    d3fz = D3FZETA(r->zeta);
+    d3fz = ss.fz[3][ip];
 
-    r->d3edrs3  = kcp + z4*fz*(kcf - kcp - d3alpha/fz20[func]) + fz*d3alpha/fz20[func];
-    r->d3edrs2z = (4.0*z3*fz + z4*dfz)*(fcf - fcp - d2alpha/fz20[func])
+    b->d3edrs3[ip]  = kcp + z4*fz*(kcf - kcp - d3alpha/fz20[func]) + fz*d3alpha/fz20[func];
+    b->d3edrs2z[ip] = (4.0*z3*fz + z4*dfz)*(fcf - fcp - d2alpha/fz20[func])
       + dfz*d2alpha/fz20[func];
-    r->d3edrsz2 = (12.0*z2*fz + 8.0*z3*dfz + z4*d2fz)*(vcf - vcp - dalpha/fz20[func])
+    b->d3edrsz2[ip] = (12.0*z2*fz + 8.0*z3*dfz + z4*d2fz)*(vcf - vcp - dalpha/fz20[func])
       + d2fz*dalpha/fz20[func];
-    r->d3edz3   = (24.0*r->zeta*fz + 36.0*z2*dfz + 12*z3*d2fz + z4*d3fz)*(ecf - ecp - alpha/fz20[func])
+    b->d3edz3[ip]   = (24.0*zeta*fz + 36.0*z2*dfz + 12*z3*d2fz + z4*d3fz)*(ecf - ecp - alpha/fz20[func])
       + d3fz*alpha/fz20[func];
   }
 }
 
+#define FUNC_BATCH
 #include "work_lda.c"
 
 const XC(func_info_type) XC(func_info_lda_c_pw) = {
@@ -39,7 +39,7 @@ typedef struct {
   FLOAT a[2], b[2], c[2], d[2];
 } pz_consts_type;
 
-static pz_consts_type
+static const pz_consts_type
 pz_consts[3] = {
   {    /* PZ Original */
     {-0.1423, -0.0843},  /* gamma */
@@ -72,8 +72,8 @@ pz_consts[3] = {
 
 
 /* Auxiliary functions to handle parametrizations */
-static void
-ec_pot_low(pz_consts_type *X, int order, int i, FLOAT *rs, 
+static inline void
+ec_pot_low(const pz_consts_type *X, int order, int i, FLOAT *rs, 
 	   FLOAT *zk, FLOAT *dedrs, FLOAT *d2edrs2, FLOAT *d3edrs3)
 {
   FLOAT f1, f12, beta12, beta22;
@@ -109,11 +109,11 @@ ec_pot_low(pz_consts_type *X, int order, int i, FLOAT *rs,
 }
 
 
-static void 
-ec_pot_high(pz_consts_type *X, int order, int i, FLOAT *rs, 
+static inline void 
+ec_pot_high(const pz_consts_type *X, int order, int i, FLOAT *rs, 
 	    FLOAT *zk, FLOAT *dedrs, FLOAT *d2edrs2, FLOAT *d3edrs3)
 {
-  FLOAT lrs = log(rs[1]);
+  FLOAT lrs = LOG(rs[1]);
 
   /* Eq. [1].C5 */
   *zk  = X->a[i]*lrs + X->b[i] + X->c[i]*rs[1]*lrs + X->d[i]*rs[1];
@@ -132,11 +132,36 @@ ec_pot_high(pz_consts_type *X, int order, int i, FLOAT *rs,
 }
 
 
+/* parametrization i for all the points of the block */
+static void
+ec_pot(const pz_consts_type *X, int order, int i, int np, const FLOAT rs[3][LDA_BATCH_SIZE],
+       FLOAT *zk, FLOAT *dedrs, FLOAT *d2edrs2, FLOAT *d3edrs3)
+{
+  FLOAT rs_[3];
+  int ip;
+
+  for(ip=0; ip<np; ip++){
+    rs_[0] = rs[0][ip];
+    rs_[1] = rs[1][ip];
+    rs_[2] = rs[2][ip];
+
+    if(rs_[1] >= 1.0)
+      ec_pot_low (X, order, i, rs_, zk + ip, dedrs + ip, d2edrs2 + ip, d3edrs3 + ip);
+    else
+      ec_pot_high(X, order, i, rs_, zk + ip, dedrs + ip, d2edrs2 + ip, d3edrs3 + ip);
+  }
+}
+
+
 /* the functional */
-static inline void 
-func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
+static void 
+func_batch(const XC(lda_type) *p, XC(lda_rs_zeta_batch) *b)
 {
-  int func;
+  /* paramagnetic and ferromagnetic */
+  FLOAT ec[2][LDA_BATCH_SIZE], vc[2][LDA_BATCH_SIZE], fc[2][LDA_BATCH_SIZE], kc[2][LDA_BATCH_SIZE];
+  XC(spin_scaling_batch) ss;
+
+  int func, ip;
   FLOAT ecp, vcp, fcp, kcp;
   FLOAT ecf, vcf, fcf, kcf;
   FLOAT fz, dfz, d2fz, d3fz;
@@ -144,62 +169,58 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   func= p->info->number - XC_LDA_C_PZ;
   assert(func==0 || func==1 || func==2);
   
-  if(r->rs[1] >= 1.0)
-    ec_pot_low (&pz_consts[func], r->order, 0, r->rs, &ecp, &vcp, &fcp, &kcp);
-  else
-    ec_pot_high(&pz_consts[func], r->order, 0, r->rs, &ecp, &vcp, &fcp, &kcp);
-
-  if(p->nspin == XC_UNPOLARIZED)
-    r->zk = ecp;
-  else{
-    fz  =  FZETA(r->zeta);
-
-    /* get ferromagnetic values */
-    if(r->rs[1] >= 1.0)
-      ec_pot_low (&pz_consts[func], r->order, 1, r->rs, &ecf, &vcf, &fcf, &kcf);
-    else
-      ec_pot_high(&pz_consts[func], r->order, 1, r->rs, &ecf, &vcf, &fcf, &kcf);
-
-    r->zk = ecp + (ecf - ecp)*fz;
+  if(p->nspin == XC_UNPOLARIZED){
+    ec_pot(&pz_consts[func], b->order, 0, b->np, b->rs, b->zk, b->dedrs, b->d2edrs2, b->d3edrs3);
+    return;
   }
 
-  if(r->order < 1) return;
+  ec_pot(&pz_consts[func], b->order, 0, b->np, b->rs, ec[0], vc[0], fc[0], kc[0]);
 
-  if(p->nspin == XC_UNPOLARIZED)
-    r->dedrs = vcp;
-  else{
-    dfz = DFZETA(r->zeta);
+  /* get ferromagnetic values */
+  ec_pot(&pz_consts[func], b->order, 1, b->np, b->rs, ec[1], vc[1], fc[1], kc[1]);
 
-    r->dedrs = vcp + (vcf - vcp)*fz;
-    r->dedz  = (ecf - ecp)*dfz;
-  }
+  XC(spin_scaling)(b->np, b->order, b->zeta, &ss);
+
+  for(ip=0; ip<b->np; ip++){
+    ecp  = ec[0][ip];
+    ecf  = ec[1][ip];
+
+    fz  = ss.fz[0][ip];
+    b->zk[ip] = ecp + (ecf - ecp)*fz;
+
+    if(b->order < 1) continue;
+
+    vcp = vc[0][ip];
+    vcf = vc[1][ip];
+
+    dfz = ss.fz[1][ip];
+    b->dedrs[ip] = vcp + (vcf - vcp)*fz;
+    b->dedz[ip]  = (ecf - ecp)*dfz;
     
-  if(r->order < 2) return;
-
-  if(p->nspin == XC_UNPOLARIZED)
-    r->d2edrs2 = fcp;
-  else{
-    d2fz = D2FZETA(r->zeta);
-
-    r->d2edrs2 = fcp + (fcf - fcp)*fz;
-    r->d2edrsz =       (vcf - vcp)*dfz;
-    r->d2edz2  =       (ecf - ecp)*d2fz;
-  }  
-
-  if(r->order < 3) return;
-
-  if(p->nspin == XC_UNPOLARIZED)
-    r->d3edrs3 = kcp;
-  else{
-    d3fz = D3FZETA(r->zeta);
-
-    r->d3edrs3  = kcp + (kcf - kcp)*fz;
-    r->d3edrs2z =       (fcf - fcp)*dfz;
-    r->d3edrsz2 =       (vcf - vcp)*d2fz;
-    r->d3edz3   =       (ecf - ecp)*d3fz;
-  }  
+    if(b->order < 2) continue;
+
+    fcp = fc[0][ip];
+    fcf = fc[1][ip];
+
+    d2fz = ss.fz[2][ip];
+    b->d2edrs2[ip] = fcp + (fcf - fcp)*fz;
+    b->d2edrsz[ip] =       (vcf - vcp)*dfz;
+    b->d2edz2[ip]  =       (ecf - ecp)*d2fz;
+
+    if(b->order < 3) continue;
+
+    kcp = kc[0][ip];
+    kcf = kc[1][ip];
+
+    d3fz = ss.fz[3][ip];
+    b->d3edrs3[ip]  = kcp + (kcf - kcp)*fz;
+    b->d3edrs2z[ip] =       (fcf - fcp)*dfz;
+    b->d3edrsz2[ip] =       (vcf - vcp)*d2fz;
+    b->d3edz3[ip]   =       (ecf - ecp)*d3fz;
+  }
 }
 
+#define FUNC_BATCH
 #include "work_lda.c"
 
 const XC(func_info_type) XC(func_info_lda_c_pz) = {
@@ -28,10 +28,6 @@
 #define XC_LDA_C_VWN      7   /* Vosko, Wilk, & Nussair       */
 #define XC_LDA_C_VWN_RPA  8   /* Vosko, Wilk, & Nussair (RPA) */
 
-typedef struct{
-  int spin_interpolation; /* 0: VWN; 1: HL */
-} lda_c_vwn_params;
-
 /* some constants         e_c^P      e_c^F      alpha_c */
 typedef struct {
   FLOAT  A[3]; /* e_c^P, e_c^F, alpha_c */
@@ -42,9 +38,14 @@ typedef struct {
   FLOAT  fpp;
 } vwn_consts_type;
 
+typedef struct{
+  int spin_interpolation; /* 0: VWN; 1: HL */
+  vwn_consts_type X;      /* the constants of this instance */
+} lda_c_vwn_params;
+
 /* These numbers are taken from the original reference, but divided by
      two to convert from Rydbergs to Hartrees */
-static vwn_consts_type vwn_consts[2] = {
+static const vwn_consts_type vwn_consts[2] = {
   /* VWN parametrization of the correlation energy */
   {
     { 0.0310907, 0.01554535,  0.0      }, /*  A */
@@ -73,7 +74,7 @@ init_vwn_constants(vwn_consts_type *X)
 
   X->A[2] = -1.0/(6.0*M_PI*M_PI);
   for(i=0; i<3; i++){
-    X->Q[i] = sqrt(4.0*X->c[i] - X->b[i]*X->b[i]);
+    X->Q[i] = SQRT(4.0*X->c[i] - X->b[i]*X->b[i]);
   }
   X->fpp = 4.0/(9.0*(POW(2.0, 1.0/3.0) - 1));
 }
@@ -87,7 +88,7 @@ lda_c_vwn_init(void *p_)
 
   assert(p->params == NULL);
 
-  p->params = malloc(sizeof(lda_c_vwn_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(lda_c_vwn_params));
   params = (lda_c_vwn_params *) (p->params);
 
   params->spin_interpolation = 0;
@@ -95,7 +96,8 @@ lda_c_vwn_init(void *p_)
   func = p->info->number - XC_LDA_C_VWN;
   assert(func==0 || func==1);
 
-  init_vwn_constants(&vwn_consts[func]);
+  params->X = vwn_consts[func];
+  init_vwn_constants(&params->X);
 }
 
 
@@ -113,114 +115,148 @@ void XC(lda_c_vwn_set_params_)(XC(lda_type) *p, int spin_interpolation)
   params = (lda_c_vwn_params *) (p->params);
 
   params->spin_interpolation = spin_interpolation;
+
+  /* a table of the uniform gas has to follow the parameters */
+  XC(lda_table_update)(p);
 }
 
 
-/* Eq. (4.4) of [1] */
+/* Eq. (4.4) of [1], for all the points of the block */
 static void
-ec_i(vwn_consts_type *X, int order, int i, FLOAT x, 
+ec_i(const vwn_consts_type *X, int order, int i, int np, const FLOAT *xs, 
      FLOAT *zk, FLOAT *dedrs, FLOAT *d2edrs2, FLOAT *d3edrs3)
 {
-  FLOAT f1, f2, f3, fx, qx, xx0, t1, t2, t3, x2, x3, fx2, fx3;
+  FLOAT f1, f2, f3, x, fx, xx0, t1, t2, t3, x2, x3, fx2, fx3;
+  FLOAT qx[LDA_BATCH_SIZE], lx[LDA_BATCH_SIZE], lxx0[LDA_BATCH_SIZE];
   FLOAT drs, d2rs, d3rs;
+  int ip;
+
+  if(np <= 0) return;
   
   /* constants */
   f1  = 2.0*X->b[i]/X->Q[i];
   f2  = X->b[i]*X->x0[i]/(X->x0[i]*X->x0[i] + X->b[i]*X->x0[i] + X->c[i]);
   f3  = 2.0*(2.0*X->x0[i] + X->b[i])/X->Q[i];
 
-  /* a couple of handy functions */
-  fx  = x*x + X->b[i]*x + X->c[i];  /* X(x) */
-  qx  = atan(X->Q[i]/(2.0*x + X->b[i]));
-  xx0 = x - X->x0[i];
+  /* the transcendental functions, for all the points at once */
+  for(ip=0; ip<np; ip++){
+    x   = xs[ip];
+    fx  = x*x + X->b[i]*x + X->c[i];  /* X(x) */
+    xx0 = x - X->x0[i];
+
+    qx  [ip] = X->Q[i]/(2.0*x + X->b[i]);
+    lx  [ip] = x*x/fx;
+    lxx0[ip] = xx0*xx0/fx;
+  }
+  XC(vatan)(np, qx, qx);
+  XC(vlog) (np, lx, lx);
+  XC(vlog) (np, lxx0, lxx0);
+
+  for(ip=0; ip<np; ip++){
+    x = xs[ip];
+
+    /* a couple of handy functions */
+    fx  = x*x + X->b[i]*x + X->c[i];  /* X(x) */
+    xx0 = x - X->x0[i];
   
-  *zk = X->A[i]*(log(x*x/fx) + (f1 - f2*f3)*qx - f2*log(xx0*xx0/fx));
+    zk[ip] = X->A[i]*(lx[ip] + (f1 - f2*f3)*qx[ip] - f2*lxx0[ip]);
   
-  if(order < 1) return;
+    if(order < 1) continue;
 
-  t1 = 2.0*x + X->b[i];
-  t2 = 2.0*X->c[i] + X->b[i]*x;
-  t3 = t1*t1 + X->Q[i]*X->Q[i];
+    t1 = 2.0*x + X->b[i];
+    t2 = 2.0*X->c[i] + X->b[i]*x;
+    t3 = t1*t1 + X->Q[i]*X->Q[i];
 
-  drs  = X->A[i];
-  drs *= -2.0*f2/xx0 + (f2*t1 + t2/x)/fx 
-    - 2.0*X->Q[i]*(f1 - f2*f3)/t3;
+    drs  = X->A[i];
+    drs *= -2.0*f2/xx0 + (f2*t1 + t2/x)/fx 
+      - 2.0*X->Q[i]*(f1 - f2*f3)/t3;
 
-  *dedrs = drs/(2.0*x); /* change of sqrt(rs) -> rs */
+    dedrs[ip] = drs/(2.0*x); /* change of sqrt(rs) -> rs */
 
-  if(order < 2) return;
+    if(order < 2) continue;
   
-  x2    = x*x;
-  x3    = x*x2;
-  fx2   = fx*fx;
+    x2    = x*x;
+    x3    = x*x2;
+    fx2   = fx*fx;
 
-  d2rs  = X->A[i];
-  d2rs *= -f2*t1*t1/fx2 - t1*t2/(x*fx2) + 2.0*f2/fx
-    + X->b[i]/(x*fx) - t2/(x2*fx) + 8.0*(f1 - f2*f3)*X->Q[i]*t1/(t3*t3)
-    + 2.0*f2/(xx0*xx0);
+    d2rs  = X->A[i];
+    d2rs *= -f2*t1*t1/fx2 - t1*t2/(x*fx2) + 2.0*f2/fx
+      + X->b[i]/(x*fx) - t2/(x2*fx) + 8.0*(f1 - f2*f3)*X->Q[i]*t1/(t3*t3)
+      + 2.0*f2/(xx0*xx0);
 
-  *d2edrs2 = (d2rs*x - drs)/(4.0*x3);
+    d2edrs2[ip] = (d2rs*x - drs)/(4.0*x3);
 
-  if(order < 3) return;
+    if(order < 3) continue;
 
-  fx3   = fx*fx2;
+    fx3   = fx*fx2;
 
-  d3rs  = 2.0*X->A[i];
-  d3rs *= f2*t1*t1*t1/fx3 + t1*t1*t2/(x*fx3) - 3.0*f2*t1/fx2 -  X->b[i]*t1/(x*fx2)
-    -t2/(x*fx2) + t1*t2/(x2*fx2) -  X->b[i]/(x2*fx) + t2/(x3*fx)
-    + (f1 - f2*f3)*X->Q[i]/(t3*t3)*(-32.0*t1*t1/t3 + 8.0) - 2.0*f2/(xx0*xx0*xx0);
+    d3rs  = 2.0*X->A[i];
+    d3rs *= f2*t1*t1*t1/fx3 + t1*t1*t2/(x*fx3) - 3.0*f2*t1/fx2 -  X->b[i]*t1/(x*fx2)
+      -t2/(x*fx2) + t1*t2/(x2*fx2) -  X->b[i]/(x2*fx) + t2/(x3*fx)
+      + (f1 - f2*f3)*X->Q[i]/(t3*t3)*(-32.0*t1*t1/t3 + 8.0) - 2.0*f2/(xx0*xx0*xx0);
 
-  *d3edrs3 = (d3rs*x2 - 3.0*d2rs*x + 3.0*drs)/(8.0*x3*x2);
+    d3edrs3[ip] = (d3rs*x2 - 3.0*d2rs*x + 3.0*drs)/(8.0*x3*x2);
+  }
 }
 
 /* the functional */
-static inline void 
-func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
+static void 
+func_batch(const XC(lda_type) *p, XC(lda_rs_zeta_batch) *b)
 {
-  int func;
-  vwn_consts_type *X;
+  /* paramagnetic, ferromagnetic and spin stiffness */
+  FLOAT ec[3][LDA_BATCH_SIZE], vc[3][LDA_BATCH_SIZE], fc[3][LDA_BATCH_SIZE], kc[3][LDA_BATCH_SIZE];
+  XC(spin_scaling_batch) ss;
+
+  const vwn_consts_type *X;
   lda_c_vwn_params *params;
 
+  int ip;
   FLOAT ec1, ec2, ec3, vc1, vc2, vc3, fc1, fc2, fc3, kc1, kc2, kc3;
-  FLOAT z3, z4, t1, dt1, d2t1, d3t1, t2, dt2, d2t2, d3t2, fz, dfz, d2fz, d3fz;
-
-  func = p->info->number - XC_LDA_C_VWN;
-  assert(func==0 || func==1);
+  FLOAT zeta, z3, z4, t1, dt1, d2t1, d3t1, t2, dt2, d2t2, d3t2, fz, dfz, d2fz, d3fz;
 
   assert(p->params != NULL);
   params = (lda_c_vwn_params *) (p->params);
 
-  X = &vwn_consts[func];
+  X = &params->X;
 
-  ec_i(X, r->order, 0, r->rs[0], &ec1, &vc1, &fc1, &kc1);
-  
-  if(p->nspin==XC_UNPOLARIZED)
-    r->zk = ec1;
-  else{
-    ec_i(X, r->order, 1, r->rs[0], &ec2, &vc2, &fc2, &kc2);
-    ec_i(X, r->order, 2, r->rs[0], &ec3, &vc3, &fc3, &kc3);
+  if(p->nspin==XC_UNPOLARIZED){
+    ec_i(X, b->order, 0, b->np, b->rs[0], b->zk, b->dedrs, b->d2edrs2, b->d3edrs3);
+    return;
+  }
+
+  ec_i(X, b->order, 0, b->np, b->rs[0], ec[0], vc[0], fc[0], kc[0]);
+  ec_i(X, b->order, 1, b->np, b->rs[0], ec[1], vc[1], fc[1], kc[1]);
+  ec_i(X, b->order, 2, b->np, b->rs[0], ec[2], vc[2], fc[2], kc[2]);
+
+  XC(spin_scaling)(b->np, b->order, b->zeta, &ss);
+
+  for(ip=0; ip<b->np; ip++){
+    zeta = b->zeta[ip];
+    ec1  = ec[0][ip];
+    ec2  = ec[1][ip];
+    ec3  = ec[2][ip];
     
-    fz  = FZETA(r->zeta);
+    fz  = ss.fz[0][ip];
 
     if(params->spin_interpolation == 1){
       t1 = 0.0;
       t2 = fz;
     }else{
-      z3  = POW(r->zeta, 3);
-      z4  = z3*r->zeta;
+      z3  = zeta*zeta*zeta;
+      z4  = z3*zeta;
       t1  = (fz/X->fpp)*(1.0 - z4);
       t2  = fz*z4;
     }
 
-    r->zk =  ec1 +  ec3*t1 + (ec2 -  ec1)*t2;
-  }
+    b->zk[ip] =  ec1 +  ec3*t1 + (ec2 -  ec1)*t2;
 
-  if(r->order < 1) return;
+    if(b->order < 1) continue;
 
-  if(p->nspin == XC_UNPOLARIZED)
-    r->dedrs = vc1;
-  else{
-    dfz  = DFZETA(r->zeta);
+    vc1 = vc[0][ip];
+    vc2 = vc[1][ip];
+    vc3 = vc[2][ip];
+
+    dfz  = ss.fz[1][ip];
 
     if(params->spin_interpolation == 1){
       dt1 = 0.0;
@@ -231,55 +267,55 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
       dt2  = dfz*z4 + 4.0*fz*z3;
     }
 
-    r->dedrs = vc1 + vc3* t1 + (vc2 - vc1)* t2;
-    r->dedz  =       ec3*dt1 + (ec2 - ec1)*dt2;
-  }
+    b->dedrs[ip] = vc1 + vc3* t1 + (vc2 - vc1)* t2;
+    b->dedz[ip]  =       ec3*dt1 + (ec2 - ec1)*dt2;
 
-  if(r->order < 2) return;
+    if(b->order < 2) continue;
 
-  if(p->nspin == XC_UNPOLARIZED)
-    r->d2edrs2 = fc1;
-  else{
-    d2fz  = D2FZETA(r->zeta);
+    fc1 = fc[0][ip];
+    fc2 = fc[1][ip];
+    fc3 = fc[2][ip];
+
+    d2fz  = ss.fz[2][ip];
 
     if(params->spin_interpolation == 1){
       d2t1 = 0.0;
       d2t2 = d2fz;
     }else{
-      d2t1  = d2fz*(1.0 - z4) - 8.0*dfz*z3 - 4.0*3.0*fz*r->zeta*r->zeta;
+      d2t1  = d2fz*(1.0 - z4) - 8.0*dfz*z3 - 4.0*3.0*fz*zeta*zeta;
       d2t1 /= X->fpp;
-      d2t2  = d2fz*z4 + 8.0*dfz*z3 + 4.0*3.0*fz*r->zeta*r->zeta;
+      d2t2  = d2fz*z4 + 8.0*dfz*z3 + 4.0*3.0*fz*zeta*zeta;
     }
 
-    r->d2edrs2 = fc1 + fc3*  t1 + (fc2 - fc1)*  t2;
-    r->d2edrsz =       vc3* dt1 + (vc2 - vc1)* dt2;
-    r->d2edz2  =       ec3*d2t1 + (ec2 - ec1)*d2t2;
-  }
+    b->d2edrs2[ip] = fc1 + fc3*  t1 + (fc2 - fc1)*  t2;
+    b->d2edrsz[ip] =       vc3* dt1 + (vc2 - vc1)* dt2;
+    b->d2edz2[ip]  =       ec3*d2t1 + (ec2 - ec1)*d2t2;
   
-  if(r->order < 3) return;
+    if(b->order < 3) continue;
 
-  if(p->nspin == XC_UNPOLARIZED)
-    r->d3edrs3 = kc1;
-  else{
-    d3fz  = D3FZETA(r->zeta);
+    kc1 = kc[0][ip];
+    kc2 = kc[1][ip];
+    kc3 = kc[2][ip];
+
+    d3fz  = ss.fz[3][ip];
 
     if(params->spin_interpolation == 1){
       d3t1 = 0.0;
       d3t2 = d3fz;
     }else{
-      d3t1  = d3fz*(1.0 - z4) - 12.0*d2fz*z3 - 36.0*dfz*r->zeta*r->zeta - 24.0*fz*r->zeta;
+      d3t1  = d3fz*(1.0 - z4) - 12.0*d2fz*z3 - 36.0*dfz*zeta*zeta - 24.0*fz*zeta;
       d3t1 /= X->fpp;
-      d3t2  = d3fz*z4 + 12.0*d2fz*z3 + 36.0*dfz*r->zeta*r->zeta + 24.0*fz*r->zeta;
+      d3t2  = d3fz*z4 + 12.0*d2fz*z3 + 36.0*dfz*zeta*zeta + 24.0*fz*zeta;
     }
 
-    r->d3edrs3  = kc1 + kc3*  t1 + (kc2 - kc1)*  t2;
-    r->d3edrs2z =       fc3* dt1 + (fc2 - fc1)* dt2;
-    r->d3edrsz2 =       vc3*d2t1 + (vc2 - vc1)*d2t2;
-    r->d3edz3   =       ec3*d3t1 + (ec2 - ec1)*d3t2;
+    b->d3edrs3[ip]  = kc1 + kc3*  t1 + (kc2 - kc1)*  t2;
+    b->d3edrs2z[ip] =       fc3* dt1 + (fc2 - fc1)* dt2;
+    b->d3edrsz2[ip] =       vc3*d2t1 + (vc2 - vc1)*d2t2;
+    b->d3edz3[ip]   =       ec3*d3t1 + (ec2 - ec1)*d3t2;
   }
-  
 }
 
+#define FUNC_BATCH
 #include "work_lda.c"
 
 const XC(func_info_type) XC(func_info_lda_c_vwn) = {
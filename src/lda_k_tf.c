@@ -28,12 +28,14 @@ static inline void
 func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
 {
   static FLOAT ax = 1.10495056570586000209883207952; /* 3/10*POW(9*M_PI/4, 4/3) */
-  FLOAT fz, dfz, d2fz, d3fz;
+  FLOAT fz, dfz, d2fz, d3fz, opz13, omz13;
 
   r->zk = ax/r->rs[2];
 
   if(p->nspin == XC_POLARIZED){
-    fz  = 0.5*(pow(1.0 + r->zeta,  5.0/3.0) + pow(1.0 - r->zeta,  5.0/3.0));
+    opz13 = CBRT(1.0 + r->zeta);
+    omz13 = CBRT(1.0 - r->zeta);
+    fz  = 0.5*(POW_5_3(1.0 + r->zeta, opz13) + POW_5_3(1.0 - r->zeta, omz13));
     r->zk *= fz;
   }
 
@@ -42,7 +44,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   r->dedrs = -2.0*ax/(r->rs[1]*r->rs[2]);
 
   if(p->nspin == XC_POLARIZED){
-    dfz = 5.0/(2.0*3.0)*(pow(1.0 + r->zeta,  2.0/3.0) - pow(1.0 - r->zeta,  2.0/3.0));
+    dfz = 5.0/(2.0*3.0)*(POW_2_3(opz13) - POW_2_3(omz13));
 
     r->dedrs *=             fz;
     r->dedz   = ax/r->rs[2]*dfz;
@@ -56,7 +58,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
     if(ABS(r->zeta) == 1.0)
       d2fz = FLT_MAX;
     else
-      d2fz = 10.0/(2.0*9.0)*(pow(1.0 + r->zeta,  -1.0/3.0) + pow(1.0 - r->zeta,  -1.0/3.0));
+      d2fz = 10.0/(2.0*9.0)*(1.0/opz13 + 1.0/omz13);
     
     r->d2edrs2 *=                             fz;
     r->d2edrsz  = -2.0*ax/(r->rs[1]*r->rs[2])*dfz;
@@ -71,7 +73,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
     if(ABS(r->zeta) == 1.0)
       d3fz = FLT_MAX;
     else
-      d3fz = -10.0/(2.0*27.0)*(pow(1.0 + r->zeta,  -4.0/3.0) - pow(1.0 - r->zeta,  -4.0/3.0));
+      d3fz = -10.0/(2.0*27.0)*(1.0/POW_4_3(1.0 + r->zeta, opz13) - 1.0/POW_4_3(1.0 - r->zeta, omz13));
 
     r->d3edrs3 *= fz;
     r->d3edrs2z = 2.0*3.0*ax/(r->rs[2]*r->rs[2])*dfz;
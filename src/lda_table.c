@@ -0,0 +1,482 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "util.h"
+
+/************************************************************************
+  Spline tables of the energy per particle of the uniform gas.
+
+  The LDA correlations of the uniform gas (PW, PW_MOD, VWN, PZ, ...)
+  all have the spin dependence
+
+    e(rs, z) = P(rs) + f(z) z^4 D(rs) + f(z) (1 - z^4) S(rs)
+
+  where f = FZETA, P is the paramagnetic energy, D = F - P the
+  difference to the ferromagnetic energy, and S the spin stiffness
+  divided by f''(0). The three channels are obtained from the
+  functional itself at z = 0, 1 and LDA_TABLE_Z0, and are tabulated as
+  polynomials of degree LDA_TABLE_DEGREE on a uniform grid in log(rs).
+  The grid is refined until all channels are reproduced to the
+  requested tolerance, relative to |P|. Tolerances below
+  LDA_TABLE_NOISE are raised to it, as the functionals themselves lose
+  digits at large rs. The derivatives returned are
+  the exact derivatives of the table.
+
+  Functionals that do not follow this form, are not three-dimensional,
+  or do not provide the energy are left untouched.
+
+  The table is rebuilt by the set_params routines of the functionals,
+  so it always corresponds to the current parameters.
+************************************************************************/
+
+#define LDA_TABLE_DEGREE 5
+#define LDA_TABLE_TMIN   -9.0   /* log(rs) in [TMIN, TMAX]; TMAX is just below MIN_DENS */
+#define LDA_TABLE_TMAX   8.95
+#define LDA_TABLE_NMIN   32     /* number of intervals below rs = 1, which is always a node */
+#define LDA_TABLE_NMAX   8192
+#define LDA_TABLE_Z0     0.6    /* polarization used to extract S */
+#define LDA_TABLE_NOISE  (1e6*FLOAT_EPSILON) /* rounding noise of the functionals at large rs */
+
+#define NC (LDA_TABLE_DEGREE + 1)
+
+typedef struct XC(struct_lda_table) {
+  FLOAT tol;          /* the tolerance it was built for */
+  int   nchannel;     /* 1 (P) for unpolarized, 3 (P, D, S) for polarized functionals */
+  int   n;            /* number of intervals */
+  FLOAT tmin, h;      /* first node and spacing in log(rs) */
+  FLOAT *coef;        /* coef[(i*nchannel + c)*NC + k], power k of (t - t_i)/h */
+} XC(lda_table_type);
+
+
+/* nodes of the interpolation in [0, 1] (Chebyshev) and the points where the error is checked.
+   The nodes are inside the intervals, so that a functional defined piecewise, like PZ at rs = 1,
+   is never evaluated on the wrong side of a node. */
+static void
+table_nodes(FLOAT *s)
+{
+  int j;
+
+  for(j=0; j<NC; j++)
+    s[j] = 0.5*(1.0 - cos((2*j + 1)*M_PI/(2*NC)));
+}
+
+static const FLOAT check_s[] = {0.2, 0.5, 0.8};
+#define NCHECK 3
+
+
+/* inverse of the Vandermonde matrix of the nodes, by Gauss-Jordan elimination */
+static void
+vandermonde_inverse(const FLOAT *s, FLOAT inv[NC][NC])
+{
+  FLOAT a[NC][2*NC], tmp;
+  int i, j, k, piv;
+
+  for(i=0; i<NC; i++){
+    a[i][0] = 1.0;
+    for(j=1; j<NC; j++) a[i][j] = a[i][j-1]*s[i];
+    for(j=0; j<NC; j++) a[i][NC + j] = (i == j) ? 1.0 : 0.0;
+  }
+
+  for(k=0; k<NC; k++){
+    piv = k;
+    for(i=k+1; i<NC; i++)
+      if(ABS(a[i][k]) > ABS(a[piv][k])) piv = i;
+    for(j=0; j<2*NC; j++){
+      tmp = a[k][j]; a[k][j] = a[piv][j]; a[piv][j] = tmp;
+    }
+
+    tmp = a[k][k];
+    for(j=0; j<2*NC; j++) a[k][j] /= tmp;
+
+    for(i=0; i<NC; i++){
+      if(i == k) continue;
+      tmp = a[i][k];
+      for(j=0; j<2*NC; j++) a[i][j] -= tmp*a[k][j];
+    }
+  }
+
+  for(i=0; i<NC; i++)
+    for(j=0; j<NC; j++)
+      inv[i][j] = a[i][NC + j];
+}
+
+
+/* the two spin interpolation factors f z^4 and f (1 - z^4), and their
+   derivatives, for point ip of a block with the spin scaling functions
+   ss. The derivatives beyond order are set to zero. */
+static void
+spin_factors(int order, const XC(spin_scaling_batch) *ss, int ip, FLOAT z, FLOAT *g4, FLOAT *g0)
+{
+  FLOAT z2, z3, z4, fz[4];
+  int k;
+
+  z2 = z*z; z3 = z2*z; z4 = z2*z2;
+
+  for(k=0; k<4; k++)
+    fz[k] = (k <= order) ? ss->fz[k][ip] : 0.0;
+
+  g4[0] = fz[0]*z4;
+  g4[1] = fz[1]*z4 + 4.0*fz[0]*z3;
+  g4[2] = fz[2]*z4 + 8.0*fz[1]*z3 + 12.0*fz[0]*z2;
+  g4[3] = fz[3]*z4 + 12.0*fz[2]*z3 + 36.0*fz[1]*z2 + 24.0*fz[0]*z;
+
+  for(k=0; k<4; k++)
+    g0[k] = fz[k] - g4[k];
+}
+
+
+/* energy per particle of the functional at the np values of rs, for fixed zeta */
+static void
+lda_energy(const XC(lda_type) *p, int np, const FLOAT *rs, FLOAT zeta, FLOAT *zk)
+{
+  XC(lda_type) l;
+  FLOAT *rho, dens;
+  int ip;
+
+  /* evaluate the functional itself, not the table, in the default layout */
+  l        = *p;
+  l.layout = NULL;
+  l.table  = NULL;
+
+  rho = (FLOAT *) malloc(2*np*sizeof(FLOAT));
+  for(ip=0; ip<np; ip++){
+    dens = 3.0/(4.0*M_PI*rs[ip]*rs[ip]*rs[ip]);
+    if(p->nspin == XC_UNPOLARIZED)
+      rho[ip] = dens;
+    else{
+      rho[2*ip    ] = 0.5*dens*(1.0 + zeta);
+      rho[2*ip + 1] = 0.5*dens*(1.0 - zeta);
+    }
+  }
+
+  p->info->lda(&l, np, rho, zk, NULL, NULL, NULL);
+
+  free(rho);
+}
+
+
+/* the channels P, D and S at the np values of rs; ch[c*np + ip] */
+static void
+lda_channels(const XC(lda_type) *p, int nchannel, int np, const FLOAT *rs, FLOAT *ch)
+{
+  const FLOAT z0 = LDA_TABLE_Z0;
+  XC(spin_scaling_batch) ss;
+  FLOAT *ef, *e0, g4[4], g0[4];
+  int ip;
+
+  lda_energy(p, np, rs, 0.0, ch);
+  if(nchannel == 1) return;
+
+  ef = ch +   np;
+  e0 = ch + 2*np;
+  lda_energy(p, np, rs, 1.0, ef);
+  lda_energy(p, np, rs, LDA_TABLE_Z0, e0);
+
+  XC(spin_scaling)(1, 0, &z0, &ss);
+  spin_factors(0, &ss, 0, z0, g4, g0);
+  for(ip=0; ip<np; ip++){
+    ef[ip] -= ch[ip];
+    e0[ip]  = (e0[ip] - ch[ip] - g4[0]*ef[ip])/g0[0];
+  }
+}
+
+
+/* is the spin dependence of the functional of the form above? */
+static int
+lda_table_check_form(const XC(lda_type) *p, FLOAT tol)
+{
+  static const FLOAT zz[] = {0.3, -0.85};
+  XC(spin_scaling_batch) ss;
+  FLOAT rs[9], ch[3*9], e[9], g4[4], g0[4];
+  int ip, iz;
+
+  for(ip=0; ip<9; ip++)
+    rs[ip] = EXP(LDA_TABLE_TMIN + (LDA_TABLE_TMAX - LDA_TABLE_TMIN)*ip/8.0);
+
+  lda_channels(p, 3, 9, rs, ch);
+  for(iz=0; iz<2; iz++){
+    lda_energy(p, 9, rs, zz[iz], e);
+    XC(spin_scaling)(1, 0, &zz[iz], &ss);
+    spin_factors(0, &ss, 0, zz[iz], g4, g0);
+
+    for(ip=0; ip<9; ip++)
+      if(ABS(e[ip] - ch[ip] - g4[0]*ch[9 + ip] - g0[0]*ch[18 + ip]) > tol*ABS(ch[ip]))
+	return 0;
+  }
+
+  return 1;
+}
+
+
+/* builds the table with n intervals below rs = 1; returns the largest relative error at the check points */
+static FLOAT
+lda_table_fill(const XC(lda_type) *p, XC(lda_table_type) *tab, int n)
+{
+  FLOAT s[NC], inv[NC][NC], *rs, *ch, *val, err, d, v;
+  int i, j, k, c, np, nc;
+
+  tab->h    = -LDA_TABLE_TMIN/n;
+  tab->tmin =  LDA_TABLE_TMIN;
+  tab->n    = n + (int) (LDA_TABLE_TMAX/tab->h);
+  nc        = tab->nchannel;
+  n         = tab->n;
+
+  table_nodes(s);
+  vandermonde_inverse(s, inv);
+
+  /* nodes of all intervals, followed by the check points */
+  np = n*NC;
+  rs = (FLOAT *) malloc((np + n*NCHECK)*sizeof(FLOAT));
+  ch = (FLOAT *) malloc(nc*(np + n*NCHECK)*sizeof(FLOAT));
+
+  for(i=0; i<n; i++){
+    for(j=0; j<NC; j++)
+      rs[i*NC + j] = EXP(tab->tmin + tab->h*(i + s[j]));
+    for(j=0; j<NCHECK; j++)
+      rs[np + i*NCHECK + j] = EXP(tab->tmin + tab->h*(i + check_s[j]));
+  }
+
+  lda_channels(p, nc, np + n*NCHECK, rs, ch);
+
+  if(tab->coef != NULL) free(tab->coef);
+  tab->coef = (FLOAT *) malloc(n*nc*NC*sizeof(FLOAT));
+
+  err = 0.0;
+  for(i=0; i<n; i++){
+    for(c=0; c<nc; c++){
+      val = ch + c*(np + n*NCHECK);
+
+      for(k=0; k<NC; k++){
+	d = 0.0;
+	for(j=0; j<NC; j++)
+	  d += inv[k][j]*val[i*NC + j];
+	tab->coef[(i*nc + c)*NC + k] = d;
+      }
+
+      for(j=0; j<NCHECK; j++){
+	v = 0.0;
+	for(k=NC-1; k>=0; k--)
+	  v = v*check_s[j] + tab->coef[(i*nc + c)*NC + k];
+
+	d = ABS(v - val[np + i*NCHECK + j])/(ABS(ch[np + i*NCHECK + j]) + FLOAT_MIN);
+	if(d > err) err = d;
+      }
+    }
+  }
+
+  free(rs);
+  free(ch);
+
+  return err;
+}
+
+
+/* builds the table of p, refining the grid until the tolerance is reached */
+int
+XC(lda_table_init)(XC(lda_type) *p, FLOAT tol)
+{
+  XC(lda_table_type) *tab;
+  int n;
+
+  XC(lda_table_end)(p);
+
+  if(tol <= 0.0 ||
+     !(p->info->flags & XC_FLAGS_3D) || !(p->info->flags & XC_FLAGS_HAVE_EXC))
+    return 0;
+
+  /* no table can be more accurate than the functional itself */
+  tol = max(tol, LDA_TABLE_NOISE);
+
+  if(p->nspin == XC_POLARIZED && !lda_table_check_form(p, tol))
+    return 0;
+
+  tab = (XC(lda_table_type) *) malloc(sizeof(XC(lda_table_type)));
+  tab->tol      = tol;
+  tab->nchannel = (p->nspin == XC_POLARIZED) ? 3 : 1;
+  tab->coef     = NULL;
+
+  for(n=LDA_TABLE_NMIN; n<=LDA_TABLE_NMAX; n*=2)
+    if(lda_table_fill(p, tab, n) <= tol){
+      p->table = tab;
+      return 1;
+    }
+
+  /* the tolerance is too small for the functional */
+  free(tab->coef);
+  free(tab);
+  return 0;
+}
+
+
+/* called by the set_params routines, when the parameters change */
+void
+XC(lda_table_update)(XC(lda_type) *p)
+{
+  if(p->table != NULL)
+    XC(lda_table_init)(p, p->table->tol);
+}
+
+
+void
+XC(lda_table_end)(XC(lda_type) *p)
+{
+  if(p->table == NULL) return;
+
+  free(p->table->coef);
+  free(p->table);
+  p->table = NULL;
+}
+
+
+/* replaces the table of p, that it shares with the functional it was
+   copied from, by a copy of its own */
+void
+XC(lda_table_dup)(XC(lda_type) *p)
+{
+  const XC(lda_table_type) *src = p->table;
+  size_t ncoef;
+
+  if(src == NULL) return;
+
+  ncoef = (size_t) src->n*src->nchannel*NC;
+
+  p->table = (XC(lda_table_type) *) malloc(sizeof(XC(lda_table_type)));
+  *(p->table) = *src;
+  p->table->coef = (FLOAT *) malloc(ncoef*sizeof(FLOAT));
+  memcpy(p->table->coef, src->coef, ncoef*sizeof(FLOAT));
+}
+
+
+/* fills the block from the table; returns 0, and does nothing, if a point is outside of it */
+int
+XC(lda_table_eval)(const XC(lda_type) *p, XC(lda_rs_zeta_batch) *b)
+{
+  const XC(lda_table_type) *tab = p->table;
+  const FLOAT *a;
+  XC(spin_scaling_batch) ss;
+  FLOAT x[LDA_BATCH_SIZE], s, rs, f[3][4], g4[4], g0[4], h1, h2, h3;
+  int ip, ic, i;
+
+  for(ip=0; ip<b->np; ip++){
+    x[ip] = (LOG(b->rs[1][ip]) - tab->tmin)/tab->h;
+    if(!(x[ip] >= 0.0 && x[ip] < tab->n)) return 0;
+  }
+
+  h1 = 1.0/tab->h; h2 = h1*h1; h3 = h2*h1;
+
+  if(p->nspin == XC_POLARIZED)
+    XC(spin_scaling)(b->np, b->order, b->zeta, &ss);
+
+  for(ip=0; ip<b->np; ip++){
+    rs = b->rs[1][ip];
+    i  = (int) x[ip];
+    s  = x[ip] - i;
+
+    /* the channels and their derivatives with respect to rs */
+    for(ic=0; ic<tab->nchannel; ic++){
+      FLOAT v, d1, d2, d3;
+
+      a  = tab->coef + (i*tab->nchannel + ic)*NC;
+      v  = ((((a[5]*s + a[4])*s + a[3])*s + a[2])*s + a[1])*s + a[0];
+      f[ic][0] = v;
+      if(b->order < 1) continue;
+
+      d1 = ((((5.0*a[5]*s + 4.0*a[4])*s + 3.0*a[3])*s + 2.0*a[2])*s + a[1])*h1;
+      f[ic][1] = d1/rs;
+      if(b->order < 2) continue;
+
+      d2 = (((20.0*a[5]*s + 12.0*a[4])*s + 6.0*a[3])*s + 2.0*a[2])*h2;
+      f[ic][2] = (d2 - d1)/(rs*rs);
+      if(b->order < 3) continue;
+
+      d3 = ((60.0*a[5]*s + 24.0*a[4])*s + 6.0*a[3])*h3;
+      f[ic][3] = (d3 - 3.0*d2 + 2.0*d1)/(rs*rs*rs);
+    }
+
+    if(p->nspin == XC_UNPOLARIZED){
+      b->zk[ip] = f[0][0];
+      if(b->order < 1) continue;
+      b->dedrs[ip] = f[0][1];
+      if(b->order < 2) continue;
+      b->d2edrs2[ip] = f[0][2];
+      if(b->order < 3) continue;
+      b->d3edrs3[ip] = f[0][3];
+      continue;
+    }
+
+    spin_factors(b->order, &ss, ip, b->zeta[ip], g4, g0);
+
+    b->zk[ip] = f[0][0] + g4[0]*f[1][0] + g0[0]*f[2][0];
+    if(b->order < 1) continue;
+
+    b->dedrs[ip] = f[0][1] + g4[0]*f[1][1] + g0[0]*f[2][1];
+    b->dedz[ip]  =           g4[1]*f[1][0] + g0[1]*f[2][0];
+    if(b->order < 2) continue;
+
+    b->d2edrs2[ip] = f[0][2] + g4[0]*f[1][2] + g0[0]*f[2][2];
+    b->d2edrsz[ip] =           g4[1]*f[1][1] + g0[1]*f[2][1];
+    b->d2edz2[ip]  =           g4[2]*f[1][0] + g0[2]*f[2][0];
+    if(b->order < 3) continue;
+
+    b->d3edrs3[ip]  = f[0][3] + g4[0]*f[1][3] + g0[0]*f[2][3];
+    b->d3edrs2z[ip] =           g4[1]*f[1][2] + g0[1]*f[2][2];
+    b->d3edrsz2[ip] =           g4[2]*f[1][1] + g0[2]*f[2][1];
+    b->d3edz3[ip]   =           g4[3]*f[1][0] + g0[3]*f[2][0];
+  }
+
+  return 1;
+}
+
+
+/* tabulates all the uniform-gas LDAs used by p, including those inside GGAs and meta-GGAs */
+int
+XC(func_set_lda_table)(XC(func_type) *p, FLOAT tol)
+{
+  XC(func_type) **aux = NULL;
+  int ii, naux = 0, ntab = 0;
+
+  assert(p != NULL);
+
+  switch(p->info->family){
+  case XC_FAMILY_LDA:
+    ntab += XC(lda_table_init)(p->lda, tol);
+    break;
+
+  case XC_FAMILY_GGA:
+  case XC_FAMILY_HYB_GGA:
+    naux = p->gga->n_func_aux;
+    aux  = p->gga->func_aux;
+    break;
+
+  case XC_FAMILY_MGGA:
+    naux = p->mgga->n_func_aux;
+    aux  = p->mgga->func_aux;
+    break;
+  }
+
+  for(ii=0; ii<naux; ii++)
+    ntab += XC(func_set_lda_table)(aux[ii], tol);
+
+  return ntab;
+}
@@ -53,7 +53,7 @@ lda_x_init(void *p_)
   XC(lda_type) *p = (XC(lda_type) *)p_;
 
   assert(p->params == NULL);
-  p->params = malloc(sizeof(XC(lda_x_params)));
+  p->params = XC(arena_alloc)(p->arena, sizeof(XC(lda_x_params)));
 
   /* exchange is equal to xalpha with a parameter of 4/3 */
   XC(lda_x_set_params_)(p, 4.0/3.0, XC_NON_RELATIVISTIC);
@@ -65,23 +65,12 @@ lda_c_xalpha_init(void *p_)
   XC(lda_type) *p = (XC(lda_type) *)p_;
 
   assert(p->params == NULL);
-  p->params = malloc(sizeof(XC(lda_x_params)));
+  p->params = XC(arena_alloc)(p->arena, sizeof(XC(lda_x_params)));
 
   /* This gives the usual Xalpha functional */
   XC(lda_x_set_params_)(p, 1.0, XC_NON_RELATIVISTIC);
 }
 
-static void 
-lda_x_end(void *p_)
-{
-  XC(lda_type) *p = (XC(lda_type) *)p_;
-
-  assert(p->params != NULL);
-  free(p->params);
-  p->params = NULL;
-}
-
-
 void 
 XC(lda_c_xalpha_set_params)(XC(func_type) *p, FLOAT alpha)
 {
@@ -106,144 +95,171 @@ XC(lda_x_set_params_)(XC(lda_type) *p, FLOAT alpha, int relativistic)
 
   params->alpha = 1.5*alpha - 1.0;
   params->relativistic = relativistic;
-  
+
+  /* a table of the uniform gas has to follow the parameters */
+  XC(lda_table_update)(p);
 }
 
 
-static inline void 
-func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
+/* the non-relativistic part, for all the points of the block */
+static void
+func_nr(const XC(lda_type) *p, FLOAT ax, XC(lda_rs_zeta_batch) *r)
 {
-  FLOAT ax, fz, dfz, d2fz, d3fz;
-  FLOAT beta, beta2, beta4, beta6, f1, f1_3, f1_5, f2, f3;
-  FLOAT phi, dphi, d2phi, d3phi, dphidbeta, d2phidbeta2, d3phidbeta3, dbetadrs, d2betadrs2, d3betadrs3;
-  FLOAT zk_nr, dedrs_nr, dedz_nr, d2edrs2_nr, d2edrsz_nr, d2edz2_nr;
-  XC(lda_x_params) *params;
+  FLOAT fz, dfz, d2fz, d3fz, zeta, opz13, omz13;
+  int ip;
 
-  assert(p->params != NULL);
-  params = (XC(lda_x_params) *) (p->params);  
+  for(ip=0; ip<r->np; ip++){
+    r->zk[ip] = ax/r->rs[1][ip];
 
-  ax = -params->alpha*0.458165293283142893475554485052; /* -alpha * 3/4*POW(3/(2*M_PI), 2/3) */
+    if(p->nspin == XC_POLARIZED){
+      zeta  = r->zeta[ip];
+      opz13 = CBRT(1.0 + zeta);
+      omz13 = CBRT(1.0 - zeta);
+      fz    = 0.5*(POW_4_3(1.0 + zeta, opz13) + POW_4_3(1.0 - zeta, omz13));
+      r->zk[ip] *= fz;
+    }
+
+    if(r->order < 1) continue;
   
-  r->zk = ax/r->rs[1];
+    r->dedrs[ip] = -ax/r->rs[2][ip];
 
-  if(p->nspin == XC_POLARIZED){
-    fz  = 0.5*(pow(1.0 + r->zeta,  4.0/3.0) + pow(1.0 - r->zeta,  4.0/3.0));
-    r->zk *= fz;
+    if(p->nspin == XC_POLARIZED){
+      dfz = 2.0/3.0*(opz13 - omz13);
+
+      r->dedrs[ip] *= fz;
+      r->dedz[ip]   = ax/r->rs[1][ip]*dfz;
+    }
+
+    if(r->order < 2) continue;
+    
+    r->d2edrs2[ip] = 2.0*ax/(r->rs[1][ip]*r->rs[2][ip]);
+
+    if(p->nspin == XC_POLARIZED){
+      if(ABS(zeta) == 1.0)
+	d2fz = FLT_MAX;
+      else
+	d2fz = 2.0/9.0*(1.0/POW_2_3(opz13) + 1.0/POW_2_3(omz13));
+    
+      r->d2edrs2[ip] *= fz;
+      r->d2edrsz[ip] = -ax/r->rs[2][ip]*dfz;
+      r->d2edz2[ip]  =  ax/r->rs[1][ip]*d2fz;
+    }
+
+    if(r->order < 3) continue;
+
+    r->d3edrs3[ip] = -6.0*ax/(r->rs[2][ip]*r->rs[2][ip]);
+
+    if(p->nspin == XC_POLARIZED){
+      if(ABS(zeta) == 1.0)
+	d3fz = FLT_MAX;
+      else
+	d3fz = -4.0/27.0*(1.0/POW_5_3(1.0 + zeta, opz13) - 1.0/POW_5_3(1.0 - zeta, omz13));
+
+      r->d3edrs3[ip] *= fz;
+      r->d3edrs2z[ip] = 2.0*ax/(r->rs[1][ip]*r->rs[2][ip])*dfz;
+      r->d3edrsz2[ip] =    -ax/r->rs[2][ip]              *d2fz;
+      r->d3edz3[ip]   =     ax/r->rs[1][ip]              *d3fz;
+    }
   }
+}
 
-  if(params->relativistic == XC_RELATIVISTIC){
-    beta   = POW(9.0*M_PI/4.0, 1.0/3.0)/(r->rs[1]*M_C);
+
+/* multiplies the non-relativistic result by the correction phi(beta) */
+static void
+func_rel(const XC(lda_type) *p, XC(lda_rs_zeta_batch) *r)
+{
+  FLOAT beta, beta2, beta4, beta6, f1, f1_3, f1_5, f2, f3;
+  FLOAT phi, dphi, d2phi, d3phi, dphidbeta, d2phidbeta2, d3phidbeta3, dbetadrs, d2betadrs2, d3betadrs3;
+  FLOAT zk_nr, dedrs_nr, dedz_nr, d2edrs2_nr, d2edrsz_nr, d2edz2_nr;
+  int ip;
+
+  for(ip=0; ip<r->np; ip++){
+    beta   = POW(9.0*M_PI/4.0, 1.0/3.0)/(r->rs[1][ip]*M_C);
     beta2  = beta*beta;
-    f1     = sqrt(1.0 + beta2);
-    f2     = asinh(beta);
+    f1     = SQRT(1.0 + beta2);
+    f2     = ASINH(beta);
     f3     = f1/beta - f2/beta2;
     phi    = 1.0 - 3.0/2.0*f3*f3;
 
-    zk_nr  = r->zk;
-    r->zk *= phi;
-  }
-
-  if(r->order < 1) return;
-  
-  r->dedrs = -ax/r->rs[2];
+    zk_nr      = r->zk[ip];
+    r->zk[ip] *= phi;
 
-  if(p->nspin == XC_POLARIZED){
-    dfz = 2.0/3.0*(pow(1.0 + r->zeta,  1.0/3.0) - pow(1.0 - r->zeta,  1.0/3.0));
+    if(r->order < 1) continue;
 
-    r->dedrs *= fz;
-    r->dedz   = ax/r->rs[1]*dfz;
-  }
-
-  if(params->relativistic == XC_RELATIVISTIC){
     beta4 = beta2*beta2;
     dphidbeta = 6.0/(beta4*beta)*(beta2 - beta*(2 + beta2)*f2/f1 + f2*f2);
-    dbetadrs = -beta/r->rs[1];
+    dbetadrs = -beta/r->rs[1][ip];
 
-    dedrs_nr = r->dedrs;
+    dedrs_nr = r->dedrs[ip];
     dphi     = dphidbeta*dbetadrs;
 
-    r->dedrs = r->dedrs*phi + zk_nr*dphi;
+    r->dedrs[ip] = r->dedrs[ip]*phi + zk_nr*dphi;
     if(p->nspin == XC_POLARIZED){
-      dedz_nr = r->dedz;
-      r->dedz = r->dedz*phi;
+      dedz_nr = r->dedz[ip];
+      r->dedz[ip] = r->dedz[ip]*phi;
     }
-  }
-
 
-  if(r->order < 2) return;
-    
-  r->d2edrs2 = 2.0*ax/(r->rs[1]*r->rs[2]);
-
-  if(p->nspin == XC_POLARIZED){
-    if(ABS(r->zeta) == 1.0)
-      d2fz = FLT_MAX;
-    else
-      d2fz = 2.0/9.0*(pow(1.0 + r->zeta,  -2.0/3.0) + pow(1.0 - r->zeta,  -2.0/3.0));
-    
-    r->d2edrs2 *= fz;
-    r->d2edrsz = -ax/r->rs[2]*dfz;
-    r->d2edz2  =  ax/r->rs[1]*d2fz;
-  }
+    if(r->order < 2) continue;
 
-  if(params->relativistic == XC_RELATIVISTIC){
     f1_3 = f1*f1*f1;
     d2phidbeta2 = -(beta2*f1*(5.0 + 4.0*beta2) - 
 		    beta*(10.0 + 14.0*beta2 + 3.0*beta4)*f2 +
 		    5.0*f1_3*f2*f2) * 6.0/(beta4*beta2*f1_3);
-    d2betadrs2 = -2.0*dbetadrs/r->rs[1];
+    d2betadrs2 = -2.0*dbetadrs/r->rs[1][ip];
 
-    d2edrs2_nr = r->d2edrs2;
+    d2edrs2_nr = r->d2edrs2[ip];
     d2phi      = d2phidbeta2*dbetadrs*dbetadrs + dphidbeta*d2betadrs2;
 
-    r->d2edrs2 = r->d2edrs2*phi + 2.0*dedrs_nr*dphi + zk_nr*d2phi;
+    r->d2edrs2[ip] = r->d2edrs2[ip]*phi + 2.0*dedrs_nr*dphi + zk_nr*d2phi;
     if(p->nspin == XC_POLARIZED){
-      d2edz2_nr  = r->d2edz2;
-      d2edrsz_nr = r->d2edrsz;
+      d2edz2_nr  = r->d2edz2[ip];
+      d2edrsz_nr = r->d2edrsz[ip];
 
-      r->d2edrsz = r->d2edrsz*phi + dedz_nr*dphi;
-      r->d2edz2  = r->d2edz2*phi;
-      
+      r->d2edrsz[ip] = r->d2edrsz[ip]*phi + dedz_nr*dphi;
+      r->d2edz2[ip]  = r->d2edz2[ip]*phi;
     }
-  }
-
-  if(r->order < 3) return;
-
-  r->d3edrs3 = -6.0*ax/(r->rs[2]*r->rs[2]);
 
-  if(p->nspin == XC_POLARIZED){
-    if(ABS(r->zeta) == 1.0)
-      d3fz = FLT_MAX;
-    else
-      d3fz = -4.0/27.0*(pow(1.0 + r->zeta,  -5.0/3.0) - pow(1.0 - r->zeta,  -5.0/3.0));
-
-    r->d3edrs3 *= fz;
-    r->d3edrs2z = 2.0*ax/(r->rs[1]*r->rs[2])*dfz;
-    r->d3edrsz2 =    -ax/r->rs[2]           *d2fz;
-    r->d3edz3   =     ax/r->rs[1]           *d3fz;
-  }
+    if(r->order < 3) continue;
 
-  if(params->relativistic == XC_RELATIVISTIC){
     beta6 = beta4*beta2;
     f1_5  = f1_3*f1*f1;
 
     d3phidbeta3 = (beta2*f1*(30.0 + 52.0*beta2 + 19.0*beta4) -
 		   beta*f2*(60.0 + 142.0*beta2 + 97.0*beta4 + 12.0*beta6) +
 		   30.0*f1_5*f2*f2) * 6.0/(beta6*beta*f1_5);
-    d3betadrs3 = -3.0*d2betadrs2/r->rs[1];
+    d3betadrs3 = -3.0*d2betadrs2/r->rs[1][ip];
 
     d3phi = d3phidbeta3*dbetadrs*dbetadrs*dbetadrs + 3.0*d2phidbeta2*dbetadrs*d2betadrs2 +
       dphidbeta*d3betadrs3;
 
-    r->d3edrs3 = r->d3edrs3*phi + 3.0*d2edrs2_nr*dphi + 3.0*dedrs_nr*d2phi + zk_nr*d3phi;
+    r->d3edrs3[ip] = r->d3edrs3[ip]*phi + 3.0*d2edrs2_nr*dphi + 3.0*dedrs_nr*d2phi + zk_nr*d3phi;
     if(p->nspin == XC_POLARIZED){
-      r->d3edrs2z = r->d3edrs2z*phi + 2.0*d2edrsz_nr*dphi + dedz_nr*d2phi;
-      r->d3edrsz2 = r->d3edrsz2*phi + d2edz2_nr*dphi;
-      r->d3edz3   = r->d3edz3*phi;
+      r->d3edrs2z[ip] = r->d3edrs2z[ip]*phi + 2.0*d2edrsz_nr*dphi + dedz_nr*d2phi;
+      r->d3edrsz2[ip] = r->d3edrsz2[ip]*phi + d2edz2_nr*dphi;
+      r->d3edz3[ip]   = r->d3edz3[ip]*phi;
     }
   }
+}
+
+
+static void 
+func_batch(const XC(lda_type) *p, XC(lda_rs_zeta_batch) *r)
+{
+  FLOAT ax;
+  XC(lda_x_params) *params;
+
+  assert(p->params != NULL);
+  params = (XC(lda_x_params) *) (p->params);  
+
+  ax = -params->alpha*0.458165293283142893475554485052; /* -alpha * 3/4*POW(3/(2*M_PI), 2/3) */
+
+  func_nr(p, ax, r);
 
+  if(params->relativistic == XC_RELATIVISTIC)
+    func_rel(p, r);
 }
 
+#define FUNC_BATCH
 #include "work_lda.c"
 
 const XC(func_info_type) XC(func_info_lda_x) = {
@@ -255,7 +271,7 @@ const XC(func_info_type) XC(func_info_lda_x) = {
   "F Bloch, Zeitschrift fuer Physik 57, 545 (1929)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC | XC_FLAGS_HAVE_KXC,
   lda_x_init,
-  lda_x_end,
+  NULL,
   work_lda
 };
 
@@ -267,7 +283,7 @@ const XC(func_info_type) XC(func_info_lda_c_xalpha) = {
   "JC Slater, Phys. Rev. 81, 385 (1951)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
   lda_c_xalpha_init,
-  lda_x_end,
+  NULL,
   work_lda
 };
 
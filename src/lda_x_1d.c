@@ -23,18 +23,56 @@
 
 #define XC_LDA_X_1D          21 /* Exchange in 1D     */
 
+/* The exchange energy per particle is written in terms of the integrals
+     int1(R) = int_0^R dx FT(x)    and    int2(R) = int_0^R dx x FT(x)
+   of the Fourier transform FT of the interaction. These depend only on
+   R and on the interaction, so when the parameters are set we tabulate
+     g1 = int1(R)/R    and    g2 = int2(R)/R^2
+   as quintic Hermite polynomials in t = log(R), on TABLE_N intervals
+   between TABLE_RMIN and TABLE_RMAX. The derivatives of g1 and g2 with
+   respect to t follow from FT and its derivative, so the interpolation
+   is exact at the nodes up to second order. For TABLE_N = 448 the
+   energies from the table agree with the quadrature to a relative
+   3e-10 for all densities; the largest differences are below
+   TABLE_RMIN, where the expansion uses the exact Euler constant and
+   the special functions a rounded one. Both are as accurate as
+   bessk0 and expint, a relative 2e-7.
+
+   Below TABLE_RMIN we use the small R expansion of the integrals, which
+   is exact up to terms of order R^2 log(R). Above TABLE_RMAX we add the asymptotic expansion of the
+   integrals between TABLE_RMAX and R. The adaptive quadrature at every
+   point is kept as a reference, see XC(lda_x_1d_set_quadrature). */
+
+#define TABLE_N    448
+#define TABLE_RMIN 1.0e-8
+#define TABLE_RMAX 20.0
+
 typedef struct{
   int interaction;  /* 0: exponentially screened; 1: soft-Coulomb */
   FLOAT bb;         /* screening parameter beta */
+
+  int quadrature;   /* evaluate the integrals by quadrature at every point */
+
+  int   table_interaction;   /* interaction the table was built for, or -1 */
+  FLOAT aa;                  /* FT(x) = aa - 2 log(x) for small x */
+  FLOAT int_rmax[2];         /* int1 and int2 at TABLE_RMAX */
+  FLOAT coef[TABLE_N][2][6]; /* polynomials in s = (t - t_k)/dt for g1 and g2 */
 } lda_x_1d_params;
 
+static void table_build(lda_x_1d_params *params);
+
 static void 
 lda_x_1d_init(void *p_)
 {
   XC(lda_type) *p = (XC(lda_type) *)p_;
+  lda_x_1d_params *params;
 
   assert(p->params == NULL);
-  p->params = malloc(sizeof(lda_x_1d_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(lda_x_1d_params));
+  params = (lda_x_1d_params *)(p->params);
+
+  params->quadrature        = 0;
+  params->table_interaction = -1;
 
   /* default value is soft-Coulomb with beta=1.0 */
   XC(lda_x_1d_set_params_)(p, 1, 1.0);
@@ -59,6 +97,17 @@ XC(lda_x_1d_set_params_)(XC(lda_type) *p, int interaction, FLOAT bb)
 
   params->interaction = interaction;
   params->bb          = bb;
+
+  if(params->table_interaction != interaction)
+    table_build(params);
+}
+
+
+void 
+XC(lda_x_1d_set_quadrature)(XC(func_type) *p, int quadrature)
+{
+  assert(p != NULL && p->lda != NULL && p->lda->params != NULL);
+  ((lda_x_1d_params *)(p->lda->params))->quadrature = quadrature;
 }
 
 
@@ -67,30 +116,212 @@ static inline FLOAT FT_inter(FLOAT x, int interaction)
   assert(interaction == 0 || interaction == 1);
 
   if(interaction == 0){
-    FLOAT x2 = x*x;
-    return expint(x2)*exp(x2);
+    FLOAT x2 = x*x, x4;
+
+    if(x2 < 400.0)
+      return expint(x2)*EXP(x2);
+
+    /* asymptotic expansion, as the exponentials over- and underflow */
+    x4 = x2*x2;
+    return (1.0 - 1.0/x2 + 2.0/x4 - 6.0/(x4*x2) + 24.0/(x4*x4))/x2;
   }else
     return 2.0*bessk0(x); 
 }
 
 
+/* x times the derivative of FT_inter */
+static inline FLOAT xdFT_inter(FLOAT x, FLOAT ft, int interaction)
+{
+  if(interaction == 0)
+    return 2.0*(x*x*ft - 1.0);
+  else
+    return -2.0*x*bessk1(x);
+}
+
+
+/* The integrands of int1 and int2 on the interval [a, a + w], as
+   functions of u = (x - a)/w in [0, 1]. The integrand of int2 is
+   divided by a + w. Both are of order FT, so the tolerances of
+   integrate are relative to the integrals, however small the interval. */
+typedef struct{
+  int   interaction;
+  FLOAT a, w;
+} quad_interval;
+
 static void func1(FLOAT *x, int n, void *ex)
 {
-  int interaction = *(int *)ex;
+  const quad_interval *q = (const quad_interval *)ex;
   int ii;
   
   for(ii=0; ii<n; ii++)
-    x[ii] = FT_inter(x[ii], interaction);
+    x[ii] = FT_inter(q->a + q->w*x[ii], q->interaction);
 }
 
 
 static void func2(FLOAT *x, int n, void *ex)
 {
-  int interaction = *(int *)ex;
+  const quad_interval *q = (const quad_interval *)ex;
+  FLOAT xx;
   int ii;
   
-  for(ii=0; ii<n; ii++)
-    x[ii] = x[ii]*FT_inter(x[ii], interaction);
+  for(ii=0; ii<n; ii++){
+    xx    = q->a + q->w*x[ii];
+    x[ii] = xx/(q->a + q->w)*FT_inter(xx, q->interaction);
+  }
+}
+
+
+/* adds the integrals between a and b to int1 and int2 */
+static void
+quad_add(int interaction, FLOAT a, FLOAT b, FLOAT *int1, FLOAT *int2)
+{
+  quad_interval q;
+
+  q.interaction = interaction;
+  q.a           = a;
+  q.w           = b - a;
+
+  *int1 += q.w  *integrate(func1, (void *)(&q), 0.0, 1.0);
+  *int2 += q.w*b*integrate(func2, (void *)(&q), 0.0, 1.0);
+}
+
+
+/* The integrals from 0 to R. Beyond x = 1 the range is split in
+   intervals that double in length, as a single quadrature misses the
+   peak of FT at small x when R is large. */
+static void
+quad_int(int interaction, FLOAT R, FLOAT *int1, FLOAT *int2)
+{
+  FLOAT a;
+
+  *int1 = *int2 = 0.0;
+  quad_add(interaction, 0.0, min(R, 1.0), int1, int2);
+  for(a=1.0; a<R; a*=2.0)
+    quad_add(interaction, a, min(R, 2.0*a), int1, int2);
+}
+
+
+static void
+table_build(lda_x_1d_params *params)
+{
+  FLOAT tmin, dt, R, Rold, ft, xdft, int1, int2;
+  FLOAT g[2][3], gold[2][3], y0, d0, e0, y1, d1, e1;
+  int interaction, k, i;
+
+  interaction = params->interaction;
+  tmin = LOG(TABLE_RMIN);
+  dt   = (LOG(TABLE_RMAX) - tmin)/TABLE_N;
+
+  /* for small x, FT(x) = aa - 2 log(x) + O(x^2 log(x)) */
+  params->aa = (interaction == 0) ? -M_EULER : 2.0*(M_LN2 - M_EULER);
+
+  R    = TABLE_RMIN;
+  int1 = R  *(params->aa - 2.0*LOG(R) + 2.0);
+  int2 = R*R*(params->aa - 2.0*LOG(R) + 1.0)/2.0;
+
+  for(k=0; k<=TABLE_N; k++){
+    if(k > 0){
+      Rold = R;
+      R    = (k == TABLE_N) ? TABLE_RMAX : EXP(tmin + k*dt);
+
+      /* the integrals are accumulated interval by interval */
+      quad_add(interaction, Rold, R, &int1, &int2);
+    }
+
+    ft   = FT_inter(R, interaction);
+    xdft = xdFT_inter(R, ft, interaction);
+
+    /* g and its first two derivatives with respect to t = log(R) */
+    g[0][0] = int1/R;
+    g[0][1] = ft - g[0][0];
+    g[0][2] = xdft - g[0][1];
+
+    g[1][0] = int2/(R*R);
+    g[1][1] = ft - 2.0*g[1][0];
+    g[1][2] = xdft - 2.0*g[1][1];
+
+    if(k > 0){
+      for(i=0; i<2; i++){
+	y0 = gold[i][0]; d0 = dt*gold[i][1]; e0 = dt*dt*gold[i][2];
+	y1 =    g[i][0]; d1 = dt*   g[i][1]; e1 = dt*dt*   g[i][2];
+
+	params->coef[k-1][i][0] = y0;
+	params->coef[k-1][i][1] = d0;
+	params->coef[k-1][i][2] = 0.5*e0;
+	params->coef[k-1][i][3] = -10.0*y0 - 6.0*d0 - 1.5*e0 + 0.5*e1 - 4.0*d1 + 10.0*y1;
+	params->coef[k-1][i][4] =  15.0*y0 + 8.0*d0 + 1.5*e0 -     e1 + 7.0*d1 - 15.0*y1;
+	params->coef[k-1][i][5] =  -6.0*y0 - 3.0*d0 - 0.5*e0 + 0.5*e1 - 3.0*d1 +  6.0*y1;
+      }
+    }
+
+    for(i=0; i<2; i++){
+      gold[i][0] = g[i][0]; gold[i][1] = g[i][1]; gold[i][2] = g[i][2];
+    }
+  }
+
+  params->int_rmax[0] = int1;
+  params->int_rmax[1] = int2;
+  params->table_interaction = interaction;
+}
+
+
+/* asymptotic expansion of int_R^infinity dx FT(x) for large R */
+static FLOAT
+tail1(FLOAT R, int interaction)
+{
+  FLOAT R2 = R*R, R4 = R2*R2;
+
+  if(interaction == 0)
+    return (1.0 - 1.0/(3.0*R2) + 2.0/(5.0*R4) - 6.0/(7.0*R4*R2) + 24.0/(9.0*R4*R4) - 120.0/(11.0*R4*R4*R2))/R;
+  else
+    return SQRT(2.0*M_PI/R)*EXP(-R)*(1.0 - (5.0/8.0 - 129.0/(128.0*R))/R);
+}
+
+
+/* and the same for int_0^R dx x FT(x), up to a constant */
+static FLOAT
+tail2(FLOAT R, int interaction)
+{
+  FLOAT U = R*R, U2 = U*U;
+
+  if(interaction == 0)
+    return 0.5*(LOG(U) + 1.0/U - 1.0/U2 + 2.0/(U2*U) - 6.0/(U2*U2) + 24.0/(U2*U2*U));
+  else
+    return -2.0*R*bessk1(R);
+}
+
+
+static void
+table_int(const lda_x_1d_params *params, FLOAT R, FLOAT *int1, FLOAT *int2)
+{
+  const FLOAT *c1, *c2;
+  FLOAT tmin, dt, x, s;
+  int k;
+
+  if(R >= TABLE_RMAX){
+    *int1 = params->int_rmax[0] + tail1(TABLE_RMAX, params->interaction) - tail1(R, params->interaction);
+    *int2 = params->int_rmax[1] - tail2(TABLE_RMAX, params->interaction) + tail2(R, params->interaction);
+    return;
+  }
+
+  tmin = LOG(TABLE_RMIN);
+  dt   = (LOG(TABLE_RMAX) - tmin)/TABLE_N;
+  x    = (LOG(R) - tmin)/dt;
+
+  if(x <= 0.0){
+    *int1 = R  *(params->aa - 2.0*LOG(R) + 2.0);
+    *int2 = R*R*(params->aa - 2.0*LOG(R) + 1.0)/2.0;
+    return;
+  }
+
+  k = (int)x;
+  if(k >= TABLE_N) k = TABLE_N - 1;
+  s = x - k;
+
+  c1 = params->coef[k][0];
+  c2 = params->coef[k][1];
+  *int1 = R  *(c1[0] + s*(c1[1] + s*(c1[2] + s*(c1[3] + s*(c1[4] + s*c1[5])))));
+  *int2 = R*R*(c2[0] + s*(c2[1] + s*(c2[2] + s*(c2[3] + s*(c2[4] + s*c2[5])))));
 }
 
 
@@ -100,13 +331,14 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   static int spin_sign[2] = {+1, -1};
   static int spin_fact[2] = { 2,  1};
 
+  const lda_x_1d_params *params;
   int interaction, is;
-  FLOAT bb, bb2, R, int1[2], int2[2];
+  FLOAT bb, R, int1[2], int2[2];
 
   assert(p->params != NULL);
-  interaction = ((lda_x_1d_params *)p->params)->interaction;
-  bb  =         ((lda_x_1d_params *)p->params)->bb;
-  bb2 = bb*bb;
+  params      = (const lda_x_1d_params *)(p->params);
+  interaction = params->interaction;
+  bb          = params->bb;
 
   r->zk = 0.0;
   for(is=0; is<p->nspin; is++){
@@ -114,8 +346,10 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
 
     if(R == 0.0) continue;
 
-    int1[is] = integrate(func1, (void *)(&interaction), 0.0, R);
-    int2[is] = integrate(func2, (void *)(&interaction), 0.0, R);
+    if(params->quadrature)
+      quad_int(interaction, R, &int1[is], &int2[is]);
+    else
+      table_int(params, R, &int1[is], &int2[is]);
 
     r->zk -= (1.0 + spin_sign[is]*r->zeta) *
       (int1[is] - int2[is]/R);
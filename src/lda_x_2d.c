@@ -28,11 +28,13 @@ static inline void
 func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
 {
   const FLOAT ax = -0.600210877438070713036799460671; /* -4/3*SQRT(2)/M_PI */
-  FLOAT fz, dfz, d2fz, d3fz;
+  FLOAT fz, dfz, d2fz, d3fz, opz12, omz12;
 
   r->zk = ax/r->rs[1];
   if(p->nspin == XC_POLARIZED){
-    fz  = 0.5*(pow(1.0 + r->zeta,  3.0/2.0) + pow(1.0 - r->zeta,  3.0/2.0));
+    opz12 = SQRT(1.0 + r->zeta);
+    omz12 = SQRT(1.0 - r->zeta);
+    fz  = 0.5*((1.0 + r->zeta)*opz12 + (1.0 - r->zeta)*omz12);
     r->zk *= fz;
   }
 
@@ -40,7 +42,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   
   r->dedrs = -ax/r->rs[2];
   if(p->nspin == XC_POLARIZED){
-    dfz = 3.0/4.0*(pow(1.0 + r->zeta,  1.0/2.0) - pow(1.0 - r->zeta,  1.0/2.0));
+    dfz = 3.0/4.0*(opz12 - omz12);
 
     r->dedrs *= fz;
     r->dedz   = ax/r->rs[1]*dfz;
@@ -50,7 +52,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
 
   r->d2edrs2 = 2.0*ax/(r->rs[1]*r->rs[2]);
   if(p->nspin == XC_POLARIZED){
-    d2fz = 3.0/8.0*(pow(1.0 + r->zeta,  -1.0/2.0) + pow(1.0 - r->zeta, -1.0/2.0));
+    d2fz = 3.0/8.0*(1.0/opz12 + 1.0/omz12);
 
     r->d2edrs2 *=                fz;
     r->d2edrsz  = -ax/r->rs[2]* dfz;
@@ -61,7 +63,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
 
   r->d3edrs3 = -6.0*ax/(r->rs[2]*r->rs[2]);
   if(p->nspin == XC_POLARIZED){
-    d3fz = -3.0/16.0*(pow(1.0 + r->zeta,  -3.0/2.0) - pow(1.0 - r->zeta, -3.0/2.0));
+    d3fz = -3.0/16.0*(1.0/((1.0 + r->zeta)*opz12) - 1.0/((1.0 - r->zeta)*omz12));
 
     r->d3edrs3 *=                             fz;
     r->d3edrs2z = 2.0*ax/(r->rs[1]*r->rs[2])*dfz;
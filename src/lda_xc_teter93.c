@@ -36,6 +36,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
 {
   FLOAT mrs[5], aa[4], bb[4];
   FLOAT fz, dfz, d2fz, d3fz;
+  XC(spin_scaling_batch) ss;
 
   FLOAT nn, dd, dd2, dd3;
   FLOAT DnnDrs, DddDrs, DnnDz, DddDz;
@@ -50,7 +51,9 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
   mrs[3] = mrs[1]*mrs[2];
   mrs[4] = mrs[1]*mrs[3];
   
-  fz = FZETA(r->zeta);
+  XC(spin_scaling)(1, r->order, &(r->zeta), &ss);
+
+  fz = ss.fz[0][0];
   for(ii=0; ii<4; ii++){
     aa[ii] = teter_a[ii] + teter_ap[ii]*fz;
     bb[ii] = teter_b[ii] + teter_bp[ii]*fz;
@@ -62,7 +65,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
 
   if(r->order < 1) return; /* nothing else to do */
 
-  dfz    = DFZETA(r->zeta);
+  dfz    = ss.fz[1][0];
   DnnDrs = aa[1] + 2*aa[2]*mrs[1] + 3*aa[3]*mrs[2];
   DddDrs = bb[0] + 2*bb[1]*mrs[1] + 3*bb[2]*mrs[2] + 4*bb[3]*mrs[3];
 
@@ -76,7 +79,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
 
   if(r->order < 2) return; /* nothing else to do */
 
-  d2fz = D2FZETA(r->zeta);
+  d2fz = ss.fz[2][0];
 
   D2nnDrs2 = 2*aa[2] + 3*2*aa[3]*mrs[1];
   D2ddDrs2 = 2*bb[1] + 3*2*bb[2]*mrs[1] + 4*3*bb[3]*mrs[2];
@@ -98,7 +101,7 @@ func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
 
   if(r->order < 3) return; /* nothing else to do */
 
-  d3fz = D3FZETA(r->zeta);
+  d3fz = ss.fz[3][0];
 
   D3nnDrs3  = 3*2*aa[3];
   D3ddDrs3  = 3*2*bb[2] + 4*3*2*bb[3]*mrs[1];
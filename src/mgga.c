@@ -41,6 +41,8 @@ int XC(mgga_init)(XC(func_type) *p, const XC(func_info_type) *info, int nspin)
   func->n_func_aux = 0;
   func->func_aux   = NULL;
   func->mix_coef   = NULL;
+  func->stats      = p->stats;
+  func->arena      = p->arena;
 
   /* initialize spin counters */
   func->n_zk  = 1;
@@ -50,9 +52,13 @@ int XC(mgga_init)(XC(func_type) *p, const XC(func_info_type) *info, int nspin)
   if(func->nspin == XC_UNPOLARIZED){
     func->n_sigma  = func->n_vsigma = 1;
     func->n_v2rho2 = func->n_v2rhosigma = func->n_v2sigma2 = 1;
+    func->n_v2rhotau = func->n_v2tausigma = func->n_v2tau2 = 1;
   }else{
     func->n_sigma      = func->n_vsigma = func->n_v2rho2 = 3;
     func->n_v2rhosigma = func->n_v2sigma2 = 6;
+    func->n_v2rhotau   = 4;
+    func->n_v2tausigma = 6;
+    func->n_v2tau2     = 3;
   }
 
   /* see if we need to initialize the functional */
@@ -77,33 +83,191 @@ void XC(mgga_end)(XC(func_type) *p)
   if(func->n_func_aux > 0){
     int ii;
     
-    for(ii=0; ii<func->n_func_aux; ii++){
+    for(ii=0; ii<func->n_func_aux; ii++)
       XC(func_end)(func->func_aux[ii]);
-      free(func->func_aux[ii]);
+    func->func_aux = NULL;
+  }
+
+  func->mix_coef = NULL;
+
+  /* the parameters are in the arena of the functional */
+  func->params = NULL;
+}
+
+
+/* evaluates a contiguous block of points, clearing the outputs in
+   chunks right before the kernel adds to them (see gga_block) */
+static void
+mgga_block(const XC(mgga_type) *func, int np,
+	   const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
+	   FLOAT *zk, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau,
+	   FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2, FLOAT *v2rhotau, FLOAT *v2tausigma, FLOAT *v2tau2)
+{
+  int ib, nb;
+
+  for(ib=0; ib<np; ib+=OUTPUT_BLOCK_SIZE){
+    nb = min(np - ib, OUTPUT_BLOCK_SIZE);
+
+    /* initialize output to zero */
+    if(zk != NULL)
+      memset(zk, 0, nb*sizeof(FLOAT)*func->n_zk);
+
+    if(vrho != NULL){
+      assert(vsigma != NULL);
+
+      memset(vrho,      0, nb*sizeof(FLOAT)*func->n_vrho);
+      memset(vsigma,    0, nb*sizeof(FLOAT)*func->n_vsigma);
+      memset(vtau,      0, nb*sizeof(FLOAT)*func->n_vtau);
+      memset(vlapl_rho, 0, nb*sizeof(FLOAT)*func->n_vlapl_rho);
+    }
+
+    if(v2rho2 != NULL){
+      /* warning : lapl_rho terms missing here */
+      assert(v2rhosigma!=NULL && v2sigma2!=NULL && v2rhotau!=NULL && v2tausigma!=NULL && v2tau2!=NULL);
+
+      memset(v2rho2,     0, nb*sizeof(FLOAT)*func->n_v2rho2);
+      memset(v2rhosigma, 0, nb*sizeof(FLOAT)*func->n_v2rhosigma);
+      memset(v2sigma2,   0, nb*sizeof(FLOAT)*func->n_v2sigma2);
+      memset(v2rhotau,   0, nb*sizeof(FLOAT)*func->n_v2rhotau);
+      memset(v2tausigma, 0, nb*sizeof(FLOAT)*func->n_v2tausigma);
+      memset(v2tau2,     0, nb*sizeof(FLOAT)*func->n_v2tau2);
+    }
+
+    /* call functional */
+    if(func->info->mgga != NULL)
+      func->info->mgga(func, nb, rho, sigma, lapl_rho, tau, zk, vrho, vsigma, vlapl_rho, vtau, 
+		       v2rho2, v2rhosigma, v2sigma2, v2rhotau, v2tausigma, v2tau2);
+
+    /* Mixing still not implemented for mggas
+    if(func->mix_coef != NULL){
+      XC(mix_func)(p, func->n_func_aux, func->func_aux, func->mix_coef, 
+		   nb, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+    }
+    */
+
+    /* increment pointers */
+    rho   += nb*func->n_rho;
+    sigma += nb*func->n_sigma;
+    if(lapl_rho != NULL)
+      lapl_rho += nb*func->n_lapl_rho;
+    if(tau != NULL)
+      tau      += nb*func->n_tau;
+
+    if(zk != NULL)
+      zk += nb*func->n_zk;
+
+    if(vrho != NULL){
+      vrho      += nb*func->n_vrho;
+      vsigma    += nb*func->n_vsigma;
+      vlapl_rho += nb*func->n_vlapl_rho;
+      vtau      += nb*func->n_vtau;
+    }
+
+    if(v2rho2 != NULL){
+      v2rho2     += nb*func->n_v2rho2;
+      v2rhosigma += nb*func->n_v2rhosigma;
+      v2sigma2   += nb*func->n_v2sigma2;
+      v2rhotau   += nb*func->n_v2rhotau;
+      v2tausigma += nb*func->n_v2tausigma;
+      v2tau2     += nb*func->n_v2tau2;
     }
-    free(func->func_aux);
   }
+}
+
 
-  if(func->mix_coef != NULL){
-    free(func->mix_coef);
-    func->mix_coef = NULL;
+/* evaluates a block of points stored in the layout of p, or adds the
+   results to the output arrays, through interleaved buffers (see
+   gga_block_layout) */
+static void
+mgga_block_layout(const XC(func_type) *p, int np,
+		  const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
+		  FLOAT *zk, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau,
+		  FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2, FLOAT *v2rhotau, FLOAT *v2tausigma, FLOAT *v2tau2)
+{
+  const XC(mgga_type) *func = p->mgga;
+  const XC(layout_type) *l = p->layout;
+  int accumulate = (p->output_mode == XC_OUTPUT_ACCUMULATE);
+
+  FLOAT rho_[2*LAYOUT_BLOCK_SIZE], sigma_[3*LAYOUT_BLOCK_SIZE], lapl_rho_[2*LAYOUT_BLOCK_SIZE], tau_[2*LAYOUT_BLOCK_SIZE];
+  FLOAT zk_[LAYOUT_BLOCK_SIZE], vrho_[2*LAYOUT_BLOCK_SIZE], vsigma_[3*LAYOUT_BLOCK_SIZE];
+  FLOAT vlapl_rho_[2*LAYOUT_BLOCK_SIZE], vtau_[2*LAYOUT_BLOCK_SIZE];
+  FLOAT v2rho2_[3*LAYOUT_BLOCK_SIZE], v2rhosigma_[6*LAYOUT_BLOCK_SIZE], v2sigma2_[6*LAYOUT_BLOCK_SIZE];
+  FLOAT v2rhotau_[4*LAYOUT_BLOCK_SIZE], v2tausigma_[6*LAYOUT_BLOCK_SIZE], v2tau2_[3*LAYOUT_BLOCK_SIZE];
+  const FLOAT *rho_in, *sigma_in, *lapl_rho_in, *tau_in;
+  int ip, nb;
+
+  if(l == NULL && !accumulate){
+    mgga_block(func, np, rho, sigma, lapl_rho, tau, zk, vrho, vsigma, vlapl_rho, vtau,
+	       v2rho2, v2rhosigma, v2sigma2, v2rhotau, v2tausigma, v2tau2);
+    return;
   }
 
-  /* deallocate any used parameter */
-  if(func->params != NULL){
-    free(func->params);
-    func->params = NULL;
+  for(ip=0; ip<np; ip+=LAYOUT_BLOCK_SIZE){
+    nb = min(np - ip, LAYOUT_BLOCK_SIZE);
+
+    if(l != NULL){
+      XC(layout_gather)(nb, func->n_rho,   &l->rho,   rho   + ip*l->rho.point,   rho_);
+      XC(layout_gather)(nb, func->n_sigma, &l->sigma, sigma + ip*l->sigma.point, sigma_);
+      if(lapl_rho != NULL)
+	XC(layout_gather)(nb, func->n_lapl_rho, &l->lapl_rho, lapl_rho + ip*l->lapl_rho.point, lapl_rho_);
+      if(tau != NULL)
+	XC(layout_gather)(nb, func->n_tau,      &l->tau,      tau      + ip*l->tau.point,      tau_);
+
+      rho_in      = rho_;
+      sigma_in    = sigma_;
+      lapl_rho_in = (lapl_rho == NULL) ? NULL : lapl_rho_;
+      tau_in      = (tau      == NULL) ? NULL : tau_;
+    }else{
+      /* the input is already interleaved */
+      rho_in      = rho   + ip*func->n_rho;
+      sigma_in    = sigma + ip*func->n_sigma;
+      lapl_rho_in = PT_OFFSET(lapl_rho, ip, func->n_lapl_rho);
+      tau_in      = PT_OFFSET(tau,      ip, func->n_tau);
+    }
+
+    mgga_block(func, nb, rho_in, sigma_in, lapl_rho_in, tau_in,
+	       (zk == NULL) ? NULL : zk_,
+	       (vrho == NULL) ? NULL : vrho_, (vrho == NULL) ? NULL : vsigma_,
+	       (vrho == NULL) ? NULL : vlapl_rho_, (vrho == NULL) ? NULL : vtau_,
+	       (v2rho2 == NULL) ? NULL : v2rho2_,   (v2rho2 == NULL) ? NULL : v2rhosigma_,
+	       (v2rho2 == NULL) ? NULL : v2sigma2_, (v2rho2 == NULL) ? NULL : v2rhotau_,
+	       (v2rho2 == NULL) ? NULL : v2tausigma_, (v2rho2 == NULL) ? NULL : v2tau2_);
+
+#define SCATTER(q) XC(layout_scatter)(nb, func->n_##q, (l == NULL) ? NULL : &l->q, \
+				      q##_, q + ip*PT_STRIDE(l, q, func->n_##q), accumulate)
+    if(zk != NULL)
+      SCATTER(zk);
+
+    if(vrho != NULL){
+      SCATTER(vrho);
+      SCATTER(vsigma);
+      SCATTER(vlapl_rho);
+      SCATTER(vtau);
+    }
+
+    if(v2rho2 != NULL){
+      SCATTER(v2rho2);
+      SCATTER(v2rhosigma);
+      SCATTER(v2sigma2);
+      SCATTER(v2rhotau);
+      SCATTER(v2tausigma);
+      SCATTER(v2tau2);
+    }
+#undef SCATTER
   }
 }
 
 
 void 
-XC(mgga)(const XC(func_type) *p, int np,
-	 const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
-	 FLOAT *zk, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau,
-	 FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2, FLOAT *v2rhotau, FLOAT *v2tausigma, FLOAT *v2tau2)
+XC(mgga64)(const XC(func_type) *p, size_t np,
+	   const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
+	   FLOAT *zk, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau,
+	   FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2, FLOAT *v2rhotau, FLOAT *v2tausigma, FLOAT *v2tau2)
 {
   XC(mgga_type) *func;
+  size_t bs;
+  int ib, nblocks;
+  XC(stats_mark_type) mark;
 
   assert(p != NULL && p->mgga != NULL);
   func = p->mgga;
@@ -127,42 +291,149 @@ XC(mgga)(const XC(func_type) *p, int np,
     exit(1);
   }
 
-  /* initialize output to zero */
-  if(zk != NULL)
-    memset(zk, 0, func->n_zk*np*sizeof(FLOAT));
+  nblocks = XC(get_nblocks)(np, p->nthreads, &bs);
+
+  if(p->stats != NULL) XC(stats_begin)(p, &mark);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(p->nthreads) schedule(dynamic) if(nblocks > 1 && p->nthreads > 1)
+#endif
+  for(ib=0; ib<nblocks; ib++){
+    size_t ip = ib*bs;
+
+    mgga_block_layout(p, (ip + bs < np) ? bs : np - ip,
+		      rho   + ip*PT_STRIDE(p->layout, rho,   func->n_rho),
+		      sigma + ip*PT_STRIDE(p->layout, sigma, func->n_sigma),
+		      PT_OFFSET(lapl_rho,   ip, PT_STRIDE(p->layout, lapl_rho,   func->n_lapl_rho)),
+		      PT_OFFSET(tau,        ip, PT_STRIDE(p->layout, tau,        func->n_tau)),
+		      PT_OFFSET(zk,         ip, PT_STRIDE(p->layout, zk,         func->n_zk)),
+		      PT_OFFSET(vrho,       ip, PT_STRIDE(p->layout, vrho,       func->n_vrho)),
+		      PT_OFFSET(vsigma,     ip, PT_STRIDE(p->layout, vsigma,     func->n_vsigma)),
+		      PT_OFFSET(vlapl_rho,  ip, PT_STRIDE(p->layout, vlapl_rho,  func->n_vlapl_rho)),
+		      PT_OFFSET(vtau,       ip, PT_STRIDE(p->layout, vtau,       func->n_vtau)),
+		      PT_OFFSET(v2rho2,     ip, PT_STRIDE(p->layout, v2rho2,     func->n_v2rho2)),
+		      PT_OFFSET(v2rhosigma, ip, PT_STRIDE(p->layout, v2rhosigma, func->n_v2rhosigma)),
+		      PT_OFFSET(v2sigma2,   ip, PT_STRIDE(p->layout, v2sigma2,   func->n_v2sigma2)),
+		      PT_OFFSET(v2rhotau,   ip, PT_STRIDE(p->layout, v2rhotau,   func->n_v2rhotau)),
+		      PT_OFFSET(v2tausigma, ip, PT_STRIDE(p->layout, v2tausigma, func->n_v2tausigma)),
+		      PT_OFFSET(v2tau2,     ip, PT_STRIDE(p->layout, v2tau2,     func->n_v2tau2)));
+  }
+
+  if(p->stats != NULL)
+    XC(stats_end)(p, &mark, np, (v2rho2 != NULL) ? 2 : (vrho != NULL) ? 1 : 0);
+}
+
+void 
+XC(mgga)(const XC(func_type) *p, int np,
+	 const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
+	 FLOAT *zk, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau,
+	 FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2, FLOAT *v2rhotau, FLOAT *v2tausigma, FLOAT *v2tau2)
+{
+  XC(mgga64)(p, (np > 0) ? np : 0, rho, sigma, lapl_rho, tau, zk, vrho, vsigma, vlapl_rho, vtau,
+	     v2rho2, v2rhosigma, v2sigma2, v2rhotau, v2tausigma, v2tau2);
+}
+
+/* evaluates a chunk of points for XC(mgga_exc_vxc_weighted) */
+static void
+mgga_weighted_block(const XC(mgga_type) *func, int np, 
+		    const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau, const FLOAT *weights,
+		    FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau, int accumulate)
+{
+  FLOAT zk_[WEIGHTED_BLOCK_SIZE], vrho_[2*WEIGHTED_BLOCK_SIZE], vsigma_[3*WEIGHTED_BLOCK_SIZE];
+  FLOAT vlapl_rho_[2*WEIGHTED_BLOCK_SIZE], vtau_[2*WEIGHTED_BLOCK_SIZE];
+  FLOAT *lvrho, *lvsigma, *lvlapl_rho, *lvtau;
+
+  /* without accumulation the potential is written in place and then weighted */
+  lvrho      = (vrho == NULL) ? NULL : (accumulate ? vrho_      : vrho);
+  lvsigma    = (vrho == NULL) ? NULL : (accumulate ? vsigma_    : vsigma);
+  lvlapl_rho = (vrho == NULL) ? NULL : (accumulate ? vlapl_rho_ : vlapl_rho);
+  lvtau      = (vrho == NULL) ? NULL : (accumulate ? vtau_      : vtau);
+
+  mgga_block(func, np, rho, sigma, lapl_rho, tau, (exc != NULL) ? zk_ : NULL, 
+	     lvrho, lvsigma, lvlapl_rho, lvtau, NULL, NULL, NULL, NULL, NULL, NULL);
+
+  if(exc != NULL)
+    *exc = XC(weighted_energy)(np, func->nspin, func->n_rho, rho, weights, zk_);
 
   if(vrho != NULL){
-    assert(vsigma != NULL);
+    XC(weight_potential)(np, func->n_vrho,      weights, lvrho,      vrho,      accumulate);
+    XC(weight_potential)(np, func->n_vsigma,    weights, lvsigma,    vsigma,    accumulate);
+    XC(weight_potential)(np, func->n_vlapl_rho, weights, lvlapl_rho, vlapl_rho, accumulate);
+    XC(weight_potential)(np, func->n_vtau,      weights, lvtau,      vtau,      accumulate);
+  }
+}
+
+
+/* Returns the integrated energy exc = sum_i weights_i rho_i zk_i and the
+   potentials multiplied by the weights. See XC(lda_exc_vxc_weighted). */
+void 
+XC(mgga_exc_vxc_weighted64)(const XC(func_type) *p, size_t np,
+			    const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau, const FLOAT *weights,
+			    FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau, int accumulate)
+{
+  XC(mgga_type) *func;
+  FLOAT *partial;
+  size_t ic, nchunks;
+  long long jc;
+  XC(stats_mark_type) mark;
+
+  assert(p != NULL && p->mgga != NULL);
+  func = p->mgga;
 
-    memset(vrho,      0, func->n_vrho     *np*sizeof(FLOAT));
-    memset(vsigma,    0, func->n_vsigma   *np*sizeof(FLOAT));
-    memset(vtau,      0, func->n_vtau     *np*sizeof(FLOAT));
-    memset(vlapl_rho, 0, func->n_vlapl_rho*np*sizeof(FLOAT));
+  if(exc != NULL && !(func->info->flags & XC_FLAGS_HAVE_EXC)){
+    fprintf(stderr, "Functional '%s' does not provide an implementation of Exc",
+	    func->info->name);
+    exit(1);
   }
 
-  if(v2rho2 != NULL){
-    /* warning : lapl_rho terms missing here */
-    assert(v2rhosigma!=NULL && v2sigma2!=NULL && v2rhotau!=NULL && v2tausigma!=NULL && v2tau2!=NULL);
+  if(vrho != NULL && !(func->info->flags & XC_FLAGS_HAVE_VXC)){
+    fprintf(stderr, "Functional '%s' does not provide an implementation of vxc",
+	    func->info->name);
+    exit(1);
+  }
 
-    memset(v2rho2,     0, func->n_v2rho2    *np*sizeof(FLOAT));
-    memset(v2rhosigma, 0, func->n_v2rhosigma*np*sizeof(FLOAT));
-    memset(v2sigma2,   0, func->n_v2sigma2  *np*sizeof(FLOAT));
-    memset(v2rhotau,   0, func->n_v2rhotau  *np*sizeof(FLOAT));
-    memset(v2tausigma, 0, func->n_v2tausigma*np*sizeof(FLOAT));
-    memset(v2tau2,     0, func->n_v2tau2    *np*sizeof(FLOAT));
+  if(p->layout != NULL){
+    fprintf(stderr, "The weighted entry points only work with the default memory layout");
+    exit(1);
   }
 
-  /* call functional */
-  if(func->info->mgga != NULL)
-    func->info->mgga(func, np, rho, sigma, lapl_rho, tau, zk, vrho, vsigma, vlapl_rho, vtau, 
-		     v2rho2, v2rhosigma, v2sigma2, v2rhotau, v2tausigma, v2tau2);
+  nchunks = (np + WEIGHTED_BLOCK_SIZE - 1)/WEIGHTED_BLOCK_SIZE;
+  partial = (exc == NULL) ? NULL : (FLOAT *) XC(arena_scratch_get)(p->arena, nchunks*sizeof(FLOAT));
 
-  /* Mixing still not implemented for mggas
-  if(func->mix_coef != NULL){
-    XC(mix_func)(p, func->n_func_aux, func->func_aux, func->mix_coef, 
-		 np, rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+  if(p->stats != NULL) XC(stats_begin)(p, &mark);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(p->nthreads) schedule(dynamic) if(p->nthreads > 1)
+#endif
+  for(jc=0; jc<(long long) nchunks; jc++){
+    size_t ip = (size_t) jc*WEIGHTED_BLOCK_SIZE;
+
+    mgga_weighted_block(func, (np - ip < WEIGHTED_BLOCK_SIZE) ? np - ip : WEIGHTED_BLOCK_SIZE, 
+			rho + ip*func->n_rho, sigma + ip*func->n_sigma,
+			PT_OFFSET(lapl_rho, ip, func->n_lapl_rho), PT_OFFSET(tau, ip, func->n_tau), weights + ip,
+			(partial == NULL) ? NULL : partial + jc, 
+			PT_OFFSET(vrho, ip, func->n_vrho), PT_OFFSET(vsigma, ip, func->n_vsigma),
+			PT_OFFSET(vlapl_rho, ip, func->n_vlapl_rho), PT_OFFSET(vtau, ip, func->n_vtau), accumulate);
   }
-  */
+
+  if(exc != NULL){
+    *exc = 0.0;
+    for(ic=0; ic<nchunks; ic++)
+      *exc += partial[ic];
+    XC(arena_scratch_release)(p->arena, partial);
+  }
+
+  if(p->stats != NULL)
+    XC(stats_end)(p, &mark, np, (vrho != NULL) ? 1 : 0);
+}
+
+void 
+XC(mgga_exc_vxc_weighted)(const XC(func_type) *p, int np,
+			  const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau, const FLOAT *weights,
+			  FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau, int accumulate)
+{
+  XC(mgga_exc_vxc_weighted64)(p, (np > 0) ? np : 0, rho, sigma, lapl_rho, tau, weights,
+			      exc, vrho, vsigma, vlapl_rho, vtau, accumulate);
 }
 
 /* especializations */
@@ -171,7 +442,7 @@ XC(mgga_exc)(const XC(func_type) *p, int np,
 	     const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
 	     FLOAT *zk)
 {
-  XC(mgga)(p, np, rho, sigma, tau, zk, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+  XC(mgga)(p, np, rho, sigma, lapl_rho, tau, zk, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
 }
 
 inline void 
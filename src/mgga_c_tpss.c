@@ -36,12 +36,12 @@ mgga_c_tpss_init(void *p_)
   XC(mgga_type) *p = (XC(mgga_type) *)p_;
 
   p->n_func_aux  = 2;
-  p->func_aux    = (XC(func_type) **) malloc(sizeof(XC(func_type) *)*p->n_func_aux);
-  p->func_aux[0] = (XC(func_type) *)  malloc(sizeof(XC(func_type)));
-  p->func_aux[1] = (XC(func_type) *)  malloc(sizeof(XC(func_type)));
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, sizeof(XC(func_type) *)*p->n_func_aux);
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
+  p->func_aux[1] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  XC(func_init)(p->func_aux[0], XC_GGA_C_PBE, p->nspin);
-  XC(func_init)(p->func_aux[1], XC_GGA_C_PBE, XC_POLARIZED);
+  XC(func_init_aux)(p->func_aux[0], XC_GGA_C_PBE, p->nspin, p->arena);
+  XC(func_init_aux)(p->func_aux[1], XC_GGA_C_PBE, XC_POLARIZED, p->arena);
 }
 
 
@@ -51,7 +51,7 @@ static FLOAT param_d = 2.8; /* Hartree^-1 */
 static void
 eq_13_14(FLOAT zeta, FLOAT csi, int order, FLOAT *C, FLOAT *dCdzeta, FLOAT *dCdcsi)
 {
-  FLOAT fz, C0, dC0dz, dfzdz, aa, a4;
+  FLOAT opz43, omz43, fz, C0, dC0dz, dfzdz, aa, a4;
   FLOAT z2=zeta*zeta, csi2=csi*csi;
   
   if(zeta==1.0 || zeta==-1.0){
@@ -63,18 +63,23 @@ eq_13_14(FLOAT zeta, FLOAT csi, int order, FLOAT *C, FLOAT *dCdzeta, FLOAT *dCdc
 
   /* Equation (13) */
   C0    = 0.53 + z2*(0.87 + z2*(0.50 + z2*2.26));
-  fz    = 0.5*(POW(1.0 + zeta, -4.0/3.0) + POW(1.0 - zeta, -4.0/3.0));
+
+  /* the (1 +- zeta)^(-4/3) of Eq. (14) are not among the spin
+     functions of XC(spin_scaling), so they are computed here */
+  opz43 = POW_4_3(1.0 + zeta, CBRT(1.0 + zeta));
+  omz43 = POW_4_3(1.0 - zeta, CBRT(1.0 - zeta));
+  fz    = 0.5*(1.0/opz43 + 1.0/omz43);
 
   /* Equation (14) */
   aa = 1.0 + csi2*fz;
-  a4 = POW(aa, 4);
+  a4 = aa*aa*aa*aa;
   
   *C =  C0 / a4;
 
   if(order > 0){
     /* Equation (13) */
     dC0dz = zeta*(2.0*0.87 + z2*(4.0*0.5 + z2*6.0*2.26));
-    dfzdz = 0.5*(POW(1.0 + zeta, -7.0/3.0) - POW(1.0 - zeta, -7.0/3.0))*(-4.0/3.0);
+    dfzdz = 0.5*(1.0/(opz43*(1.0 + zeta)) - 1.0/(omz43*(1.0 - zeta)))*(-4.0/3.0);
   
     /* Equation (14) */
     *dCdcsi = -8.0*C0*csi*fz/(aa*a4);
@@ -172,9 +177,9 @@ static void eq_12(const XC(mgga_type) *p, int order, const FLOAT *rho, const FLO
       +     sigma[2]*(1.0 + zeta)*(1.0 + zeta);
 
     gzeta2 = max(gzeta2, MIN_GRAD*MIN_GRAD);
-    gzeta  = sqrt(gzeta2);
+    gzeta  = SQRT(gzeta2);
 
-    aa  = 2.0*POW(3.0*M_PI*M_PI*dens, 1.0/3.0);
+    aa  = 2.0*KF_FACTOR*CBRT(dens);
     csi = gzeta/aa;
   
     eq_13_14(zeta, csi, order, &C, &dCdzeta, &dCdcsi);
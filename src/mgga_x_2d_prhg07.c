@@ -48,7 +48,7 @@ prhg_newt(FLOAT c, FLOAT tol, FLOAT * res, int *ierr)
    if (c < 4.0) {
      y = 2.0;
      do {
-       ey = exp(y);
+       ey = EXP(y);
        yf = (y-1.0)*ey;
        f = yf - c;
        fp = ey*y;
@@ -64,9 +64,9 @@ prhg_newt(FLOAT c, FLOAT tol, FLOAT * res, int *ierr)
    }
    else {
      y = 6.0;
-     c = log(c);
+     c = LOG(c);
      do {
-       yf = log(y-1.0)+y;
+       yf = LOG(y-1.0)+y;
        f = yf - c;
        fp = 1.0 + 1.0/(-1.0 + y);
        
@@ -115,8 +115,8 @@ func(const XC(mgga_type) *p, FLOAT x, FLOAT t, FLOAT u, int order,
 {
   FLOAT y;
   FLOAT vrho, v_PRHG, C;
-  FLOAT sqrt_two = sqrt(2.0);
-  FLOAT sqrt_pi = sqrt(M_PI);
+  FLOAT sqrt_two = SQRT(2.0);
+  FLOAT sqrt_pi = SQRT(M_PI);
 
   assert(p != NULL);
   
@@ -132,7 +132,7 @@ func(const XC(mgga_type) *p, FLOAT x, FLOAT t, FLOAT u, int order,
     *f = v_PRHG / 2.0;
   }
   else if (p->info->number == XC_MGGA_X_2D_PRHG07_PRP10) {
-    *vrho0 = (v_PRHG - ((2.0*sqrt_two)/(3.0*M_PI))*sqrt(max(t - 0.25*x*x,0.0))/X_FACTOR_2D_C)*(1.0 / 3.0);
+    *vrho0 = (v_PRHG - ((2.0*sqrt_two)/(3.0*M_PI))*SQRT(max(t - 0.25*x*x,0.0))/X_FACTOR_2D_C)*(1.0 / 3.0);
     *f = *vrho0 * (3.0 / 2.0);
   }
   else
@@ -49,7 +49,7 @@ static void mgga_x_tb09_init(void *p_)
   case XC_MGGA_X_RPP09: p->func = 3; break;
   }
 
-  p->params = malloc(sizeof(mgga_x_tb09_params));
+  p->params = XC(arena_alloc)(p->arena, sizeof(mgga_x_tb09_params));
   params = (mgga_x_tb09_params *) (p->params);
 
   /* value of c in Becke-Johnson */
@@ -57,17 +57,6 @@ static void mgga_x_tb09_init(void *p_)
 }
 
 
-static void mgga_x_tb09_end(void *p_)
-{
-  XC(mgga_type) *p = (XC(mgga_type) *)p_;
-
-  assert(p->params != NULL);
-  free(p->params);
-  p->params = NULL;
-
-}
-
-
 void XC(mgga_x_tb09_set_params)(XC(func_type) *p, FLOAT c)
 {
   assert(p != NULL && p->mgga != NULL);
@@ -84,15 +73,17 @@ void XC(mgga_x_tb09_set_params_)(XC(mgga_type) *p, FLOAT c)
   params->c = c;
 }
 
-/* This code follows the inversion done in the PINY_MD package */
+/* This code follows the inversion done in the PINY_MD package. It is
+   now only used for the points where the batched solver below fails */
 FLOAT inline 
-br_newt_raph(FLOAT a, FLOAT tol,  FLOAT * res, int *ierr)
+br_newt_raph(FLOAT a, FLOAT tol,  FLOAT * res, int *ierr, int *niter)
 {
   int count;
   double x, f;
   static int max_iter = 50;
 
    *ierr = 1;
+   *niter = 0;
    if(a == 0.0)
      return 0.0;
    
@@ -105,7 +96,7 @@ br_newt_raph(FLOAT a, FLOAT tol,  FLOAT * res, int *ierr)
 
      xm2 = x - 2.0;
      arg = 2.0*x/3.0;
-     eee = exp(-arg)/a;
+     eee = EXP(-arg)/a;
 
      f  = x*eee - xm2;
      fp = eee*(1.0 - 2.0/3.0*x) - 1.0;
@@ -117,16 +108,18 @@ br_newt_raph(FLOAT a, FLOAT tol,  FLOAT * res, int *ierr)
      *res = fabs(f);
    } while((*res > tol) && (count < max_iter));
 
+   *niter = count;
    if(count == max_iter) *ierr=0; 
    return x;
 }
 
-FLOAT inline br_bisect(FLOAT a, FLOAT tol, int *ierr) { 
+FLOAT inline br_bisect(FLOAT a, FLOAT tol, int *ierr, int *niter) { 
   int count; 
   FLOAT f, x, x1, x2; 
   static int max_iter = 500; 
  	 
   *ierr = 1; 
+  *niter = 0;
   if(a == 0.0) 
     return 0.0; 
 		   
@@ -146,7 +139,7 @@ FLOAT inline br_bisect(FLOAT a, FLOAT tol, int *ierr) {
     x   = 0.5*(x1 + x2); 
     xm2 = x - 2.0; 
     arg = 2.0*x/3.0; 
-    eee = exp(-arg); 
+    eee = EXP(-arg); 
     f   = x*eee - a*xm2; 
 	 	 
     if(f > 0.0) x1 = x; 
@@ -155,14 +148,18 @@ FLOAT inline br_bisect(FLOAT a, FLOAT tol, int *ierr) {
     count++; 
   }while((fabs(f) > tol)  && (count < max_iter)); 
  	 
+  *niter = count;
   if(count == max_iter) *ierr=0;  
   return x; 
 } 
-	 	 
-FLOAT XC(mgga_x_br89_get_x)(FLOAT Q)
+
+
+/* the iterative solver, for a single right-hand side */
+static FLOAT
+br_iterate(FLOAT rhs, int *niter)
 {
-  FLOAT rhs, br_x, tol, res;
-  int ierr;
+  FLOAT br_x, tol, res;
+  int ierr, nbisect;
 
 #if SINGLE_PRECISION
   tol = 1e-6;
@@ -170,13 +167,10 @@ FLOAT XC(mgga_x_br89_get_x)(FLOAT Q)
   tol = 5e-12;
 #endif
 
-  /* build right-hand side of the non-linear equation 
-     Remember we use a different definition of tau */
-  rhs = 2.0/3.0*POW(M_PI, 2.0/3.0)/Q;
-
-  br_x = br_newt_raph(rhs, tol, &res, &ierr);
+  br_x = br_newt_raph(rhs, tol, &res, &ierr, niter);
   if(ierr == 0){
-    br_x = br_bisect(rhs, tol, &ierr);
+    br_x = br_bisect(rhs, tol, &ierr, &nbisect);
+    *niter += nbisect;
     if(ierr == 0){
       fprintf(stderr, 
 	      "Warning: Convergence not reached in Becke-Roussel functional\n"
@@ -187,20 +181,186 @@ FLOAT XC(mgga_x_br89_get_x)(FLOAT Q)
   return br_x;
 }
 
+
+/* The Becke-Roussel equation x exp(-2x/3)/(x - 2) = rhs is solved for a
+   block of points with a fixed number of Halley steps. Each stage of
+   the solution is a loop over the block without branches, that takes
+   its logarithms and exponentials from XC(vlog) and XC(vexp), so that
+   it can be vectorized.
+
+   The steps are taken on h = log(x/|x - 2|) - 2x/3 - log|rhs|, which is
+   close to linear in x. For rhs < 0 the root is in (0, 2) and we iterate
+   on x; for rhs > 0 it is above 2 and we iterate on d = x - 2, which
+   keeps its precision as x approaches 2. The initial guesses below are
+   within 11% of the root for any rhs, and BR_HALLEY_STEPS = 3 steps then
+   give a relative error below 1e-14. A point is converged if its last
+   step was below BR_STEP_TOL relative to the solution; the others are
+   solved again, in a separate pass, with the iterative solver above. */
+
+#define BR_HALLEY_STEPS 3
+#define BR_STEP_TOL     1e-8
+#define BR_BLOCK        (2*MGGA_X_BATCH_SIZE)
+
+/* the Halley steps for a block of at most BR_BLOCK points. Returns the
+   number of points that had to be solved (Q != 0 and rhs != 0), and
+   marks in fail those that did not converge. */
+static int
+br_halley_block(int np, const FLOAT *Q, FLOAT *br_x, int *fail)
+{
+  FLOAT r0[BR_BLOCK], rhs[BR_BLOCK], a[BR_BLOCK], lna[BR_BLOCK], v[BR_BLOCK], w1[BR_BLOCK], w2[BR_BLOCK];
+  FLOAT cq, x0, d0, c, x, d, h, hp, hpp, vn;
+  int ip, iter, neg, nsolve;
+
+  /* the right-hand side. Remember we use a different definition of tau.
+     The points with Q = 0 (x = 2) or rhs = 0 (x = 0) are solved for
+     rhs = 1 and set at the end. */
+  cq = 2.0/3.0*POW(M_PI, 2.0/3.0);
+  for(ip=0; ip<np; ip++){
+    r0[ip]  = (Q[ip] == 0.0) ? 0.0 : cq/Q[ip];
+    rhs[ip] = (r0[ip] == 0.0) ? 1.0 : r0[ip];
+    a[ip]   = ABS(rhs[ip]);
+    w1[ip]  = 1.0 + 0.35/a[ip];
+  }
+  XC(vlog)(np, a,  lna);
+  XC(vlog)(np, w1, w1);
+
+  /* initial guess */
+  for(ip=0; ip<np; ip++){
+    neg = (rhs[ip] < 0.0);
+    d0  = 1.5*w1[ip];
+
+    x0     = neg ? 2.0*a[ip]/(1.0 + a[ip]) : 2.0 + d0;
+    v[ip]  = x0;
+    w1[ip] = neg ? 2.0*x0/3.0 : -2.0*x0/3.0;
+    w2[ip] = neg ? 1.0 : x0/(a[ip]*d0);
+  }
+  XC(vexp)(np, w1, w1);
+  XC(vlog)(np, w2, w2);
+
+  for(ip=0; ip<np; ip++){
+    x0 = v[ip];
+    c  = a[ip]*w1[ip];
+
+    v[ip] = (rhs[ip] < 0.0) ? 2.0*c/(1.0 + c) :
+      (a[ip] < 1.0) ? 1.5*w2[ip] - 2.0 : x0*w1[ip]/a[ip];
+  }
+
+  for(iter=0; iter<BR_HALLEY_STEPS; iter++){
+    for(ip=0; ip<np; ip++){
+      neg = (rhs[ip] < 0.0);
+      x   = neg ? v[ip]       : 2.0 + v[ip];
+      d   = neg ? v[ip] - 2.0 : v[ip];
+      d   = (d == 0.0) ? -4.0*FLOAT_EPSILON : d;
+
+      w1[ip] = x/ABS(d);
+    }
+    XC(vlog)(np, w1, w1);
+
+    for(ip=0; ip<np; ip++){
+      neg = (rhs[ip] < 0.0);
+      x   = neg ? v[ip]       : 2.0 + v[ip];
+      d   = neg ? v[ip] - 2.0 : v[ip];
+      d   = (d == 0.0) ? -4.0*FLOAT_EPSILON : d;
+
+      h   = w1[ip] - 2.0*x/3.0 - lna[ip];
+      hp  = 1.0/x - 2.0/3.0 - 1.0/d;
+      hpp = 1.0/(d*d) - 1.0/(x*x);
+
+      /* the last step is kept in w2 for the convergence test */
+      w2[ip] = 2.0*h*hp/(2.0*hp*hp - h*hpp);
+      vn     = v[ip] - w2[ip];
+
+      /* do not leave the interval of the root */
+      vn = (vn <= 0.0)        ? 0.5*v[ip]         : vn;
+      vn = (neg && vn >= 2.0) ? 0.5*(v[ip] + 2.0) : vn;
+      v[ip] = vn;
+    }
+  }
+
+  for(ip=0; ip<np; ip++){
+    x = (rhs[ip] < 0.0) ? v[ip] : 2.0 + v[ip];
+    x = (Q[ip]  == 0.0) ? 2.0   : x;
+    br_x[ip] = (r0[ip] == 0.0 && Q[ip] != 0.0) ? 0.0 : x;
+  }
+
+  /* the points solved, and those that have not converged */
+  nsolve = 0;
+  for(ip=0; ip<np; ip++){
+    fail[ip] = (r0[ip] != 0.0) && !(ABS(w2[ip]) <= BR_STEP_TOL*v[ip]);
+    nsolve  += (r0[ip] != 0.0);
+  }
+
+  return nsolve;
+}
+
+
+void
+XC(mgga_x_br89_get_x_batch)(int np, const FLOAT *Q, FLOAT *br_x, XC(mgga_x_br89_stats) *stats)
+{
+  int fail[BR_BLOCK];
+  int ib, nb, ip, niter, nsolve, nfall, nfall_iter;
+
+  nsolve = nfall = nfall_iter = 0;
+
+  for(ib=0; ib<np; ib+=BR_BLOCK){
+    nb = min(np - ib, BR_BLOCK);
+
+    nsolve += br_halley_block(nb, Q + ib, br_x + ib, fail);
+
+    /* the points where the Halley steps did not converge */
+    for(ip=0; ip<nb; ip++){
+      if(!fail[ip]) continue;
+
+      br_x[ib + ip] = br_iterate(2.0/3.0*POW(M_PI, 2.0/3.0)/Q[ib + ip], &niter);
+      nfall++;
+      nfall_iter += niter;
+    }
+  }
+
+  if(stats != NULL){
+    stats->npoints             = nsolve;
+    stats->iterations          = BR_HALLEY_STEPS*nsolve;
+    stats->fallbacks           = nfall;
+    stats->fallback_iterations = nfall_iter;
+  }
+}
+
+
+FLOAT XC(mgga_x_br89_get_x)(FLOAT Q)
+{
+  FLOAT br_x;
+
+  XC(mgga_x_br89_get_x_batch)(1, &Q, &br_x, NULL);
+  return br_x;
+}
+
+
+/* br_x of a block of (point, spin) pairs, see work_mgga_x.c */
+static void
+func_prepare(const XC(mgga_type) *pt, int n, const FLOAT *x, const FLOAT *t, const FLOAT *u, FLOAT *br_x)
+{
+  FLOAT Q[2*MGGA_X_BATCH_SIZE];
+  int ii;
+
+  for(ii=0; ii<n; ii++)
+    Q[ii] = (u[ii] - 2.0*br89_gamma*t[ii] + 0.5*br89_gamma*x[ii]*x[ii])/6.0;
+
+  XC(mgga_x_br89_get_x_batch)(n, Q, br_x, NULL);
+}
+
 static void 
-func(const XC(mgga_type) *pt, FLOAT x, FLOAT t, FLOAT u, int order,
+func(const XC(mgga_type) *pt, FLOAT br_x, FLOAT x, FLOAT t, FLOAT u, int order,
      FLOAT *f, FLOAT *vrho0, FLOAT *dfdx, FLOAT *dfdt, FLOAT *dfdu,
      FLOAT *d2fdx2, FLOAT *d2fdxt, FLOAT *d2fdt2)
 {
-  FLOAT Q, br_x, dfdbx, dxdu, ff, dff, v_BR;
+  FLOAT Q, dfdbx, dxdu, ff, dff, v_BR;
   FLOAT cnst, exp1, exp2;
 
   Q  = (u - 2.0*br89_gamma*t + 0.5*br89_gamma*x*x)/6.0;
-  br_x = XC(mgga_x_br89_get_x)(Q);
 
   cnst = -2.0*POW(M_PI, 1.0/3.0)/X_FACTOR_C;
-  exp1 = exp(br_x/3.0);
-  exp2 = exp(-br_x);
+  exp1 = EXP(br_x/3.0);
+  exp2 = EXP(-br_x);
 
   v_BR = (ABS(br_x) > MIN_TAU) ?
     exp1*(1.0 - exp2*(1.0 + br_x/2.0))/br_x :
@@ -223,7 +383,7 @@ func(const XC(mgga_type) *pt, FLOAT x, FLOAT t, FLOAT u, int order,
       1.0/6.0 - br_x/9.0;
     dfdbx *= cnst;
   
-    ff  = br_x*exp(-2.0/3.0*br_x)/(br_x - 2);
+    ff  = br_x*EXP(-2.0/3.0*br_x)/(br_x - 2);
     dff = -2.0/3.0 + 1.0/br_x - 1.0/(br_x - 2.0); /* dff / ff */
 
     dxdu  = -1.0/(6.0*Q*dff);
@@ -239,14 +399,15 @@ func(const XC(mgga_type) *pt, FLOAT x, FLOAT t, FLOAT u, int order,
       assert(pt->params != NULL);
       c = ((mgga_x_tb09_params *) (pt->params))->c;
     
-      *vrho0 = - c*v_BR - (3.0*c - 2.0)*sqrt(5.0/12.0)*sqrt(t)/(X_FACTOR_C*M_PI);
+      *vrho0 = - c*v_BR - (3.0*c - 2.0)*SQRT(5.0/12.0)*SQRT(t)/(X_FACTOR_C*M_PI);
 
     }else{ /* XC_MGGA_X_RPP09 */
-      *vrho0 = - v_BR - sqrt(5.0/12.0)*sqrt(max(t - x*x/4.0, 0.0))/(X_FACTOR_C*M_PI);
+      *vrho0 = - v_BR - SQRT(5.0/12.0)*SQRT(max(t - x*x/4.0, 0.0))/(X_FACTOR_C*M_PI);
     }
   }
 }
 
+#define FUNC_PREPARE
 #include "work_mgga_x.c"
 
 const XC(func_info_type) XC(func_info_mgga_x_br89) = {
@@ -269,7 +430,7 @@ const XC(func_info_type) XC(func_info_mgga_x_bj06) = {
   "AD Becke and ER Johnson, J. Chem. Phys. 124, 221101 (2006)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_VXC,
   mgga_x_tb09_init,
-  mgga_x_tb09_end,
+  NULL,
   NULL, NULL,        /* this is not an LDA                   */
   work_mgga_x,
 };
@@ -282,7 +443,7 @@ const XC(func_info_type) XC(func_info_mgga_x_tb09) = {
   "F Tran and P Blaha, Phys. Rev. Lett. 102, 226401 (2009)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_VXC,
   mgga_x_tb09_init,
-  mgga_x_tb09_end,
+  NULL,
   NULL, NULL,        /* this is not an LDA                   */
   work_mgga_x,
 };
@@ -295,7 +456,7 @@ const XC(func_info_type) XC(func_info_mgga_x_rpp09) = {
   "E Rasanen, S Pittalis & C Proetto, J. Chem. Phys. 132, 044112 (2010)",
   XC_FLAGS_3D | XC_FLAGS_HAVE_VXC,
   mgga_x_tb09_init,
-  mgga_x_tb09_end,
+  NULL,
   NULL, NULL,        /* this is not an LDA                   */
   work_mgga_x,
 };
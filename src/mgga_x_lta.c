@@ -56,7 +56,7 @@ const XC(func_info_type) XC(func_info_mgga_x_lta) = {
   "Local tau approximation",
   XC_FAMILY_MGGA,
   "M Ernzerhof and G Scuseria, J. Chem. Phys. 111, 911 (1999)",
-  XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC | XC_FLAGS_HAVE_FXC,
+  XC_FLAGS_3D | XC_FLAGS_HAVE_EXC | XC_FLAGS_HAVE_VXC,
   NULL, NULL,
   NULL, NULL,        /* this is not an LDA                   */
   work_mgga_x,
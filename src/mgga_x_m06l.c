@@ -31,26 +31,33 @@
 
 #define XC_MGGA_X_M06L          203 /* Zhao, Truhlar exchange */
 
-static FLOAT CFermi;
+typedef struct{
+  FLOAT CFermi;
+} mgga_x_m06l_params;
 
 static void
 mgga_x_m06l_init(void *p_)
 {
   XC(mgga_type) *p = (XC(mgga_type) *)p_;
+  mgga_x_m06l_params *params;
 
   p->n_func_aux  = 1;
-  p->func_aux    = (XC(func_type) **) malloc(sizeof(XC(func_type) *)*p->n_func_aux);
-  p->func_aux[0] = (XC(func_type) *)  malloc(sizeof(XC(func_type)));
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, sizeof(XC(func_type) *)*p->n_func_aux);
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  XC(func_init)(p->func_aux[0], XC_GGA_X_PBE, p->nspin);
+  XC(func_init_aux)(p->func_aux[0], XC_GGA_X_PBE, p->nspin, p->arena);
 
-  CFermi = (3.0/5.0) * POW(6.0*M_PI*M_PI, 2.0/3.0);
+  assert(p->params == NULL);
+  p->params = XC(arena_alloc)(p->arena, sizeof(mgga_x_m06l_params));
+  params = (mgga_x_m06l_params *) (p->params);
+
+  params->CFermi = (3.0/5.0) * POW(6.0*M_PI*M_PI, 2.0/3.0);
 }
 
 
 /* Eq. (8) */
 static void 
-x_m06l_fw(int order, FLOAT t, FLOAT *fw, FLOAT *dfwdt)
+x_m06l_fw(int order, FLOAT CFermi, FLOAT t, FLOAT *fw, FLOAT *dfwdt)
 {
   /*define the parameters for fw of Eq. (8) as in the reference paper*/
   static FLOAT a[12] = {
@@ -87,11 +94,14 @@ func(const XC(mgga_type) *pt, FLOAT x, FLOAT t, FLOAT u, int order,
   const FLOAT alpha = 0.00186726;   /* set alpha of Eq. (4) */
 
   FLOAT f_pbe, dfdx_pbe, ldfdx_pbe;
-  FLOAT h, dhdx, dhdz, fw, dfwdt;
+  FLOAT h, dhdx, dhdz, fw, dfwdt, CFermi;
+
+  assert(pt->params != NULL);
+  CFermi = ((mgga_x_m06l_params *) (pt->params))->CFermi;
 
   XC(gga_x_pbe_enhance)(pt->func_aux[0]->gga, x, order, &f_pbe, &dfdx_pbe, &ldfdx_pbe, NULL);
 
-  x_m06l_fw(order, t, &fw, &dfwdt);
+  x_m06l_fw(order, CFermi, t, &fw, &dfwdt);
 
   /* there is a factor if 2 in the definition of z, as in Theor. Chem. Account 120, 215 (2008) */
   XC(mgga_x_gvt4_func)(order, x, 2.0*t - CFermi, alpha, d, &h, &dhdx, &dhdz);
@@ -50,7 +50,7 @@ x_tpss_7(int order, FLOAT p, FLOAT z,
   alpha = h1*a1*p;
 
   /* Eq. (7) */
-  a2    = sqrt(1.0 + b*alpha*(alpha-1.0));
+  a2    = SQRT(1.0 + b*alpha*(alpha-1.0));
   h2    = 9.0/20.0;
 
   *qb   = h2*(alpha - 1.0)/a2 + 2.0*p/3.0;
@@ -96,20 +96,20 @@ void x_tpss_10(int order, FLOAT p, FLOAT z,
   a2 = 146.0/2025.0;                 /* second term */
   x1 += a2*qb*qb;
 
-  a3 = sqrt(0.5*(9.0*z2/25.0 + p2)); /* third term  */
+  a3 = SQRT(0.5*(9.0*z2/25.0 + p2)); /* third term  */
   h3 = -73.0/405;
   x1 += h3*qb*a3;
 
   a4 = aux1*aux1/kappa;              /* forth term  */
   x1 += a4*p2;
 
-  a5 = 2.0*sqrt(e)*aux1*9.0/25.0;    /* fifth term  */
+  a5 = 2.0*SQRT(e)*aux1*9.0/25.0;    /* fifth term  */
   x1 += a5*z2;
 
   a6 = e*mu;                         /* sixth term  */
   x1 += a6*p*p2;
 
-  d1 = 1.0 + sqrt(e)*p;              /* denominator */
+  d1 = 1.0 + SQRT(e)*p;              /* denominator */
   *x  = x1/(d1*d1);
 
   if(order < 1) return;              /* the derivatives */
@@ -132,7 +132,7 @@ void x_tpss_10(int order, FLOAT p, FLOAT z,
   
   dxdp1 += a6*3.0*p2;                        /* sixth term  */
   
-  *dxdp = (dxdp1*d1 - 2.0*sqrt(e)*x1)/(d1*d1*d1);   /* denominator */
+  *dxdp = (dxdp1*d1 - 2.0*SQRT(e)*x1)/(d1*d1*d1);   /* denominator */
   *dxdz = dxdz1/(d1*d1);
 }
 
@@ -23,6 +23,11 @@
 #include "util.h"
 
 
+/* number of points that are evaluated at once by each component. The
+   partial results live on the stack and are added to the output while
+   they are still in cache */
+#define MIX_BLOCK_SIZE 128
+
 /*****************************************************/
 void 
 XC(mix_func)(const XC(func_type) *dest_func, int n_func_aux, XC(func_type) **func_aux, FLOAT *mix_coef,
@@ -30,87 +35,96 @@ XC(mix_func)(const XC(func_type) *dest_func, int n_func_aux, XC(func_type) **fun
 	     FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
 	     FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
 {
-  FLOAT *zk_, *vrho_, *vsigma_, *v2rho2_, *v2rhosigma_, *v2sigma2_;
-  int n_zk, n_vrho, n_vsigma, n_v2rho2, n_v2rhosigma, n_v2sigma2;
-  int ip, ii;
+  /* buffers that hold the results of the individual functionals for one block */
+  FLOAT zk_[MIX_BLOCK_SIZE], vrho_[2*MIX_BLOCK_SIZE], vsigma_[3*MIX_BLOCK_SIZE];
+  FLOAT v2rho2_[3*MIX_BLOCK_SIZE], v2rhosigma_[6*MIX_BLOCK_SIZE], v2sigma2_[6*MIX_BLOCK_SIZE];
+
+  int n_rho, n_sigma, n_zk, n_vrho, n_vsigma, n_v2rho2, n_v2rhosigma, n_v2sigma2;
+  int is_gga, ip, ib, nb, ii;
 
   /* initialize spin counters */
   n_zk  = 1;
-  n_vrho = dest_func->nspin;
+  n_rho = n_vrho = dest_func->nspin;
   if(dest_func->nspin == XC_UNPOLARIZED){
-    n_vsigma = 1;
+    n_sigma  = n_vsigma = 1;
     n_v2rho2 = n_v2rhosigma = n_v2sigma2 = 1;
   }else{
-    n_vsigma = n_v2rho2 = 3;
+    n_sigma  = n_vsigma = n_v2rho2 = 3;
     n_v2rhosigma = n_v2sigma2 = 6;
   }
 
-  /* prepare buffers that will hold the results from the individual functionals */
-  zk_ = NULL;
-  vrho_ = vsigma_ = NULL;
-  v2rho2_ = v2rhosigma_ = v2sigma2_ = NULL;
+  is_gga = (dest_func->info->family > XC_FAMILY_LDA);
+
+  for(ib=0; ib<np; ib+=MIX_BLOCK_SIZE){
+    nb = (np - ib < MIX_BLOCK_SIZE) ? np - ib : MIX_BLOCK_SIZE;
+
+    /* we now add the different components */
+    for(ii=0; ii<n_func_aux; ii++){
+      int aux_is_gga = is_gga && (func_aux[ii]->info->family > XC_FAMILY_LDA);
+
+      switch(func_aux[ii]->info->family){
+      case XC_FAMILY_LDA:
+	XC(lda)(func_aux[ii], nb, rho,
+		(zk     != NULL) ? zk_     : NULL,
+		(vrho   != NULL) ? vrho_   : NULL,
+		(v2rho2 != NULL) ? v2rho2_ : NULL, NULL);
+	break;
+      case XC_FAMILY_GGA:
+	XC(gga)(func_aux[ii], nb, rho, sigma,
+		(zk     != NULL) ? zk_         : NULL,
+		(vrho   != NULL) ? vrho_       : NULL,
+		(vrho   != NULL) ? vsigma_     : NULL,
+		(v2rho2 != NULL) ? v2rho2_     : NULL,
+		(v2rho2 != NULL) ? v2rhosigma_ : NULL,
+		(v2rho2 != NULL) ? v2sigma2_   : NULL);
+	break;
+      }
 
-  if(zk != NULL)
-    zk_ = (FLOAT *) malloc(sizeof(FLOAT)*np*n_zk);
+      if(zk != NULL)
+	for(ip = 0; ip < nb*n_zk; ip++)
+	  zk[ip] += mix_coef[ii] * zk_[ip];
 
-  if(vrho != NULL){
-    vrho_ = (FLOAT *) malloc(sizeof(FLOAT)*np*n_vrho);
-    if(dest_func->info->family >  XC_FAMILY_LDA){
-      vsigma_ = (FLOAT *) malloc(sizeof(FLOAT)*np*n_vsigma);
-    }
-  }
+      if(vrho != NULL){
+	for(ip = 0; ip < nb*n_vrho; ip++)
+	  vrho[ip] += mix_coef[ii] * vrho_[ip];
 
-  if(v2rho2 != NULL){
-    v2rho2_ = (FLOAT *) malloc(sizeof(FLOAT)*np*n_v2rho2);
-    if(dest_func->info->family >  XC_FAMILY_LDA){
-      v2rhosigma_ = (FLOAT *) malloc(sizeof(FLOAT)*np*n_v2rhosigma);
-      v2sigma2_   = (FLOAT *) malloc(sizeof(FLOAT)*np*n_v2sigma2);
-    }
-  }
+	if(aux_is_gga)
+	  for(ip = 0; ip < nb*n_vsigma; ip++)
+	    vsigma[ip] += mix_coef[ii] * vsigma_[ip];
+      }
 
-  /* we now add the different components */
-  for(ii=0; ii<n_func_aux; ii++){
-    switch(func_aux[ii]->info->family){
-    case XC_FAMILY_LDA:
-      XC(lda)(func_aux[ii], np, rho, zk_, vrho_, v2rho2_, NULL);
-      break;
-    case XC_FAMILY_GGA:
-      XC(gga)(func_aux[ii], np, rho, sigma, zk_, vrho_, vsigma_, v2rho2_, v2rhosigma_, v2sigma2_);
-      break;
+      if(v2rho2 != NULL){
+	for(ip = 0; ip < nb*n_v2rho2; ip++)
+	  v2rho2[ip] += mix_coef[ii] * v2rho2_[ip];
+
+	if(aux_is_gga){
+	  for(ip = 0; ip < nb*n_v2rhosigma; ip++)
+	    v2rhosigma[ip] += mix_coef[ii] * v2rhosigma_[ip];
+
+	  for(ip = 0; ip < nb*n_v2sigma2; ip++)
+	    v2sigma2[ip] += mix_coef[ii] * v2sigma2_[ip];
+	}
+      }
     }
 
+    /* advance to the next block */
+    rho += nb*n_rho;
+    if(is_gga) sigma += nb*n_sigma;
+
     if(zk != NULL)
-      for(ip = 0; ip < np*n_zk; ip++)
-	zk[ip] += mix_coef[ii] * zk_[ip];
+      zk += nb*n_zk;
 
     if(vrho != NULL){
-      for(ip = 0; ip < np*n_vrho; ip++)
-	vrho[ip] += mix_coef[ii] * vrho_[ip];
-
-      if(dest_func->info->family > XC_FAMILY_LDA && func_aux[ii]->info->family > XC_FAMILY_LDA)
-	for(ip = 0; ip < np*n_vsigma; ip++)
-	  vsigma[ip] += mix_coef[ii] * vsigma_[ip];
+      vrho += nb*n_vrho;
+      if(is_gga) vsigma += nb*n_vsigma;
     }
 
     if(v2rho2 != NULL){
-      for(ip = 0; ip < np*n_v2rho2; ip++)
-	v2rho2[ip] += mix_coef[ii] * v2rho2_[ip];
-
-      if(dest_func->info->family > XC_FAMILY_LDA && func_aux[ii]->info->family > XC_FAMILY_LDA){
-	for(ip = 0; ip < np*n_v2rhosigma; ip++)
-	  v2rhosigma[ip] += mix_coef[ii] * v2rhosigma_[ip];
-
-	for(ip = 0; ip < np*n_v2sigma2; ip++)
-	  v2sigma2[ip] += mix_coef[ii] * v2sigma2_[ip];
+      v2rho2 += nb*n_v2rho2;
+      if(is_gga){
+	v2rhosigma += nb*n_v2rhosigma;
+	v2sigma2   += nb*n_v2sigma2;
       }
     }
   }
-
-  /* deallocate internal buffers */
-  if(zk_         != NULL) free(zk_);
-  if(vrho_       != NULL) free(vrho_);
-  if(vsigma_     != NULL) free(vsigma_);
-  if(v2rho2_     != NULL) free(v2rho2_);
-  if(v2rhosigma_ != NULL) free(v2rhosigma_);
-  if(v2sigma2_   != NULL) free(v2sigma2_);
 }
@@ -35,3 +35,144 @@ XC(rho2dzeta)(int nspin, const FLOAT *rho, FLOAT *d, FLOAT *zeta)
     *zeta = (*d > MIN_DENS) ? (rho[0] - rho[1])/(*d) : 0.0;
   }
 }
+
+
+/* all the spin scaling functions come from the cube roots of 1 + zeta
+   and 1 - zeta, which are taken once per point */
+void
+XC(spin_scaling)(int np, int order, const FLOAT *zeta, XC(spin_scaling_batch) *s)
+{
+  FLOAT opz, omz, opz13, omz13, iopz13, iomz13, iopz, iomz;
+  int ip, edge;
+
+  assert(np <= LDA_BATCH_SIZE);
+
+  s->np    = np;
+  s->order = order;
+
+  for(ip=0; ip<np; ip++){
+    opz   = 1.0 + zeta[ip];
+    omz   = 1.0 - zeta[ip];
+    opz13 = CBRT(opz);
+    omz13 = CBRT(omz);
+
+    s->fz [0][ip] = (POW_4_3(opz, opz13) + POW_4_3(omz, omz13) - 2.0)/FZETAFACTOR;
+    s->phi[0][ip] = 0.5*(POW_2_3(opz13) + POW_2_3(omz13));
+    s->dd [0][ip] = SQRT(0.5*(POW_5_3(opz, opz13) + POW_5_3(omz, omz13)));
+    if(order < 1) continue;
+
+    /* the derivatives of phi leave out the fully polarized channel, where they diverge */
+    iopz13 = (opz >= MIN_DENS) ? 1.0/opz13 : 0.0;
+    iomz13 = (omz >= MIN_DENS) ? 1.0/omz13 : 0.0;
+
+    s->fz [1][ip] = (4.0/3.0)*(opz13 - omz13)/FZETAFACTOR;
+    s->phi[1][ip] = (iopz13 - iomz13)/3.0;
+    s->dd [1][ip] = (5.0/12.0)*(POW_2_3(opz13) - POW_2_3(omz13))/s->dd[0][ip];
+    if(order < 2) continue;
+
+    edge = (ABS(zeta[ip]) == 1.0);
+    iopz = (opz >= MIN_DENS) ? 1.0/opz : 0.0;
+    iomz = (omz >= MIN_DENS) ? 1.0/omz : 0.0;
+
+    s->fz [2][ip] = ((4.0/9.0)/FZETAFACTOR)*
+      (edge ? FLT_MAX : 1.0/POW_2_3(opz13) + 1.0/POW_2_3(omz13));
+    s->phi[2][ip] = -(iopz13*iopz + iomz13*iomz)/9.0;
+    if(order < 3) continue;
+
+    s->fz [3][ip] = (-(8.0/27.0)/FZETAFACTOR)*
+      (edge ? FLT_MAX : 1.0/POW_5_3(opz, opz13) - 1.0/POW_5_3(omz, omz13));
+    s->phi[3][ip] = (4.0/27.0)*(iopz13*iopz*iopz - iomz13*iomz*iomz);
+  }
+}
+
+
+/* splits np points in blocks to be shared among nthreads threads.
+   Returns the number of blocks; all but the last have block_size points,
+   and none has more than MAX_BLOCK_SIZE */
+int
+XC(get_nblocks)(size_t np, int nthreads, size_t *block_size)
+{
+  size_t nblocks;
+
+  /* a few blocks per thread to balance the load */
+  nblocks     = (nthreads > 1) ? 4*nthreads : 1;
+  *block_size = (np + nblocks - 1)/nblocks;
+  if(nthreads > 1 && *block_size < MIN_BLOCK_SIZE) *block_size = MIN_BLOCK_SIZE;
+  if(*block_size > MAX_BLOCK_SIZE) *block_size = MAX_BLOCK_SIZE;
+  if(*block_size < 1) *block_size = 1;
+
+  return (np + *block_size - 1)/(*block_size);
+}
+
+
+/* copies np points with n components from an array stored with strides s
+   to an interleaved buffer */
+void
+XC(layout_gather)(int np, int n, const XC(stride_type) *s, const FLOAT *src, FLOAT *dst)
+{
+  int ip, ic;
+
+  for(ic=0; ic<n; ic++)
+    for(ip=0; ip<np; ip++)
+      dst[ip*n + ic] = src[ip*s->point + ic*s->comp];
+}
+
+
+/* the inverse operation: from an interleaved buffer to an array with
+   strides s (interleaved if s is NULL). The values are either copied or
+   added to the ones already in dst */
+void
+XC(layout_scatter)(int np, int n, const XC(stride_type) *s, const FLOAT *src, FLOAT *dst, int accumulate)
+{
+  size_t point, comp;
+  int ip, ic;
+
+  point = (s == NULL) ? n : s->point;
+  comp  = (s == NULL) ? 1 : s->comp;
+
+  for(ic=0; ic<n; ic++)
+    for(ip=0; ip<np; ip++){
+      if(accumulate)
+	dst[ip*point + ic*comp] += src[ip*n + ic];
+      else
+	dst[ip*point + ic*comp]  = src[ip*n + ic];
+    }
+}
+
+
+/* integrates rho*zk over a chunk of points, always summing in the same order */
+FLOAT
+XC(weighted_energy)(int np, int nspin, int n_rho, const FLOAT *rho, const FLOAT *weights, const FLOAT *zk)
+{
+  FLOAT exc, dens;
+  int ip;
+
+  exc = 0.0;
+  for(ip=0; ip<np; ip++){
+    dens = (nspin == XC_POLARIZED) ? rho[0] + rho[1] : rho[0];
+    exc += weights[ip]*dens*zk[ip];
+
+    rho += n_rho;
+  }
+
+  return exc;
+}
+
+
+/* out = weights*v (or out += weights*v if accumulate) for the n components of np points.
+   v and out may be the same array when not accumulating */
+void
+XC(weight_potential)(int np, int n, const FLOAT *weights, const FLOAT *v, FLOAT *out, int accumulate)
+{
+  int ip, k;
+
+  if(accumulate){
+    for(ip=0; ip<np; ip++)
+      for(k=0; k<n; k++)
+	out[ip*n + k] += weights[ip]*v[ip*n + k];
+  }else{
+    for(ip=0; ip<np; ip++)
+      for(k=0; k<n; k++)
+	out[ip*n + k]  = weights[ip]*v[ip*n + k];
+  }
+}
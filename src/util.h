@@ -28,6 +28,7 @@
 # define M_E            2.7182818284590452354   /* e */
 # define M_PI           3.14159265358979323846  /* pi */
 # define M_SQRT2        1.41421356237309504880  /* sqrt(2) */
+# define M_LN2          0.69314718055994530942  /* log_e 2 */
 double asinh (double x);
 float  asinhf(float  x);
 #endif
@@ -44,6 +45,15 @@ double bessk0(double x);
 double bessk1(double x);
 double expint(double x);
 
+/* elementary functions for arrays of points (vmath.c) */
+void XC(vexp)  (int n, const FLOAT *x, FLOAT *y);
+void XC(vlog)  (int n, const FLOAT *x, FLOAT *y);
+void XC(vpow)  (int n, const FLOAT *x, FLOAT a, FLOAT *y);
+void XC(vcbrt) (int n, const FLOAT *x, FLOAT *y);
+void XC(vasinh)(int n, const FLOAT *x, FLOAT *y);
+void XC(vatan) (int n, const FLOAT *x, FLOAT *y);
+void XC(verf)  (int n, const FLOAT *x, FLOAT *y);
+
 /* integration */
 typedef void integr_fn(FLOAT *x, int n, void *ex);
 FLOAT integrate(integr_fn func, void *ex, FLOAT a, FLOAT b);
@@ -53,28 +63,137 @@ void rdqagse(integr_fn f, void *ex, FLOAT *a, FLOAT *b,
 	     FLOAT *blist, FLOAT *rlist, FLOAT *elist, int *iord, int *last);
   
 #define M_C 137.0359996287515 /* speed of light */
-
-#define RS(x)          (pow((3.0/(4*M_PI*x)), 1.0/3.0))
+#define M_EULER 0.57721566490153286061 /* Euler-Mascheroni constant */
+
+/* Powers of x with exponents that are multiples of 1/3 or 1/6, from
+   x13 = CBRT(x). The cube root is computed once per point, and replaces
+   the calls to pow for all the powers of x a functional needs. The
+   negative exponents are the inverses of these. */
+#define POW_2_3(x13)       ((x13)*(x13))
+#define POW_4_3(x, x13)    ((x)*(x13))
+#define POW_5_3(x, x13)    ((x)*(x13)*(x13))
+#define POW_8_3(x, x13)    ((x)*(x)*(x13)*(x13))
+#define POW_7_6(x, x13)    ((x)*SQRT(x13))
+
+#define RS_FACTOR      0.6203504908994000166680068120477781673508     /* (3/(4*pi))^(1/3)      */
+#define RS(x)          (RS_FACTOR/CBRT(x))
+#define KF_FACTOR      3.093667726280135930968945207222386957954      /* (3*pi^2)^(1/3)        */
 #define X_FACTOR_C     0.9305257363491000250020102180716672510262     /* 3/8*cur(3/pi)*4^(2/3) */
 #define X_FACTOR_2D_C  1.504505556127350098528211870828726895584      /* 8/(3*sqrt(pi))        */
 #define K_FACTOR_C     4.557799872345597137288163759599305358515      /* 3/10*(6*pi^2)^(2/3)   */
 #define X2S            0.1282782438530421943003109254455883701296     /* 1/(2*(6*pi^2)^(1/3))  */
 #define X2S_2D         0.141047395886939071                           /* 1/(2*(4*pi)^(1/2)     */
-#define FZETAFACTOR    0.519842099789746380
-#define FZETA(x)       ((pow(1.0 + (x),  4.0/3.0) + pow(1.0 - (x),  4.0/3.0) - 2.0)/FZETAFACTOR)
-#define DFZETA(x)      ((pow(1.0 + (x),  1.0/3.0) - pow(1.0 - (x),  1.0/3.0))*(4.0/3.0)/FZETAFACTOR)
-#define D2FZETA(x)     ((4.0/9.0)/FZETAFACTOR)* \
-  (ABS(x)==1.0 ? (FLT_MAX) : (pow(1.0 + (x), -2.0/3.0) + pow(1.0 - (x), -2.0/3.0)))
-#define D3FZETA(x)     (-(8.0/27.0)/FZETAFACTOR)* \
-  (ABS(x)==1.0 ? (FLT_MAX) : (pow(1.0 + (x), -5.0/3.0) - pow(1.0 - (x), -5.0/3.0)))
+#define FZETAFACTOR    0.519842099789746380                           /* 2^(4/3) - 2           */
 
 #define MIN_DENS             5.0e-13
 #define MIN_GRAD             5.0e-13
 #define MIN_TAU              5.0e-13
 
+/* threads get blocks of at least this number of points */
+#define MIN_BLOCK_SIZE       64
+
+/* and at most this number, so that the kernels can count the points
+   of a block, and index its arrays, with an int */
+#define MAX_BLOCK_SIZE       (1 << 24)
+
+/* address of point ip in an (optional) array with n entries per point */
+#define PT_OFFSET(array, ip, n) (((array) == NULL) ? NULL : (array) + (ip)*(n))
+
 #include "xc.h"
 
+/* With --enable-op-count the elementary functions count their calls, by
+   thread, in XC(op_count) (indexed by XC_STATS_POW, ...), and the
+   statistics of the functionals report them per point. This build is
+   for the cost models only: the counting makes it much slower. */
+#if defined(XC_COUNT_OPS)
+extern long XC(op_count)[XC_STATS_NEVENTS];
+#ifdef _OPENMP
+#pragma omp threadprivate(XC(op_count))
+#endif
+
+#  define XC_OP_COUNT(ev, n) (XC(op_count)[ev] += (n))
+
+#  if SINGLE_PRECISION
+#    define XC_LIBM(fn) fn ## f
+#  else
+#    define XC_LIBM(fn) fn
+#  endif
+
+#  undef  POW
+#  undef  CBRT
+#  undef  LOG
+#  undef  EXP
+#  undef  SQRT
+#  undef  ASINH
+#  define POW(x, y) (XC_OP_COUNT(XC_STATS_POW,   1), XC_LIBM(pow)  (x, y))
+#  define CBRT(x)   (XC_OP_COUNT(XC_STATS_CBRT,  1), XC_LIBM(cbrt) (x))
+#  define LOG(x)    (XC_OP_COUNT(XC_STATS_LOG,   1), XC_LIBM(log)  (x))
+#  define EXP(x)    (XC_OP_COUNT(XC_STATS_EXP,   1), XC_LIBM(exp)  (x))
+#  define SQRT(x)   (XC_OP_COUNT(XC_STATS_SQRT,  1), XC_LIBM(sqrt) (x))
+#  define ASINH(x)  (XC_OP_COUNT(XC_STATS_ASINH, 1), XC_LIBM(asinh)(x))
+#else
+#  define XC_OP_COUNT(ev, n) ((void) 0)
+#endif
+
 void XC(rho2dzeta)(int nspin, const FLOAT *rho, FLOAT *d, FLOAT *zeta);
+int  XC(get_nblocks)(size_t np, int nthreads, size_t *block_size);
+
+/* point and component strides of quantity q, with n components, in the layout l */
+#define PT_STRIDE(l, q, n)  (((l) == NULL) ? (size_t) (n) : (l)->q.point)
+#define CMP_STRIDE(l, q)    (((l) == NULL) ? 1   : (l)->q.comp)
+
+/* the drivers copy the points of a non-default layout, or the results
+   to be accumulated, through interleaved buffers of this number of points */
+#define LAYOUT_BLOCK_SIZE 64
+
+/* the GGA and meta-GGA kernels add to outputs that were set to zero; this
+   is done in chunks of this number of points, right before calling the
+   kernel, so that both writes hit the cache */
+#define OUTPUT_BLOCK_SIZE 128
+
+void XC(layout_gather) (int np, int n, const XC(stride_type) *s, const FLOAT *src, FLOAT *dst);
+void XC(layout_scatter)(int np, int n, const XC(stride_type) *s, const FLOAT *src, FLOAT *dst, int accumulate);
+
+/* the weighted entry points work on chunks of this number of points;
+   the integrated energy is summed chunk by chunk in order, so it does
+   not depend on the number of threads */
+#define WEIGHTED_BLOCK_SIZE 128
+
+/* statistics of the evaluations (func_stats.c). The drivers time the
+   calls, the kernels count the points they screen; both only when the
+   stats pointer of the functional is set. */
+typedef struct XC(stats_mark_type) {
+  double time;
+  int    counted;                       /* 1 if the events were read */
+  double events[XC_STATS_NEVENTS];
+} XC(stats_mark_type);
+
+void   XC(stats_begin)(const XC(func_type) *p, XC(stats_mark_type) *m);
+void   XC(stats_end)  (const XC(func_type) *p, const XC(stats_mark_type) *m, size_t np, int order);
+void   XC(stats_screened)(XC(func_stats_type) *s, int ndens, int ngrad);
+void   XC(stats_screen_block)(XC(func_stats_type) *s, int nspin, int np,
+			      const FLOAT *rho, int n_rho, const FLOAT *sigma, int n_sigma);
+
+#define STATS_SCREENED(p, ndens, ngrad) \
+  do{ if((p)->stats != NULL) XC(stats_screened)((p)->stats, (ndens), (ngrad)); }while(0)
+
+/* memory of the functionals (func_arena.c). Everything allocated in
+   the arena of a functional is freed by XC(func_end). */
+typedef struct XC(struct_arena_type) XC(arena_type);
+
+XC(arena_type) *XC(arena_new)  (void);
+void           *XC(arena_alloc)(XC(arena_type) *a, size_t size);
+void            XC(arena_free) (XC(arena_type) *a);
+XC(arena_type) *XC(arena_copy) (const XC(arena_type) *src, size_t extra);
+void           *XC(arena_relocate)(const XC(arena_type) *src, XC(arena_type) *dst, const void *ptr);
+void           *XC(arena_scratch_get)    (XC(arena_type) *a, size_t size);
+void            XC(arena_scratch_release)(XC(arena_type) *a, void *mem);
+
+/* initializes an auxiliary functional in the arena of its parent */
+int  XC(func_init_aux)(XC(func_type) *p, int functional, int nspin, XC(arena_type) *arena);
+
+FLOAT XC(weighted_energy)(int np, int nspin, int n_rho, const FLOAT *rho, const FLOAT *weights, const FLOAT *zk);
+void  XC(weight_potential)(int np, int n, const FLOAT *weights, const FLOAT *v, FLOAT *out, int accumulate);
 
 /* LDAs */
 typedef struct XC(lda_rs_zeta) {
@@ -87,6 +206,40 @@ typedef struct XC(lda_rs_zeta) {
   FLOAT d3edrs3, d3edrs2z, d3edrsz2, d3edz3; /*  third derivatives of zk */
 } XC(lda_rs_zeta);
 
+/* the same quantities for a block of points, stored as arrays */
+#define LDA_BATCH_SIZE 64
+
+typedef struct XC(lda_rs_zeta_batch) {
+  int   order; /* to which order should I return the derivatives */
+  int   np;    /* number of points in the block */
+  FLOAT rs[3][LDA_BATCH_SIZE], zeta[LDA_BATCH_SIZE];
+
+  FLOAT zk[LDA_BATCH_SIZE];
+  FLOAT dedrs[LDA_BATCH_SIZE], dedz[LDA_BATCH_SIZE];
+  FLOAT d2edrs2[LDA_BATCH_SIZE], d2edrsz[LDA_BATCH_SIZE], d2edz2[LDA_BATCH_SIZE];
+  FLOAT d3edrs3[LDA_BATCH_SIZE], d3edrs2z[LDA_BATCH_SIZE], d3edrsz2[LDA_BATCH_SIZE], d3edz3[LDA_BATCH_SIZE];
+} XC(lda_rs_zeta_batch);
+
+/* the spin scaling functions of the correlations for a block of points,
+   with their derivatives with respect to zeta:
+     f(zeta)   = ((1 + zeta)^(4/3) + (1 - zeta)^(4/3) - 2)/(2^(4/3) - 2)
+     phi(zeta) = ((1 + zeta)^(2/3) + (1 - zeta)^(2/3))/2
+     D(zeta)   = sqrt(((1 + zeta)^(5/3) + (1 - zeta)^(5/3))/2)   (only up to first order) */
+typedef struct XC(spin_scaling_batch) {
+  int   order; /* to which order should I return the derivatives */
+  int   np;    /* number of points in the block */
+  FLOAT fz[4][LDA_BATCH_SIZE], phi[4][LDA_BATCH_SIZE], dd[2][LDA_BATCH_SIZE];
+} XC(spin_scaling_batch);
+
+void XC(spin_scaling)(int np, int order, const FLOAT *zeta, XC(spin_scaling_batch) *s);
+
+/* spline tables of the uniform gas, see lda_table.c */
+int  XC(lda_table_init)(XC(lda_type) *p, FLOAT tol);
+void XC(lda_table_update)(XC(lda_type) *p);
+void XC(lda_table_end) (XC(lda_type) *p);
+void XC(lda_table_dup) (XC(lda_type) *p);
+int  XC(lda_table_eval)(const XC(lda_type) *p, XC(lda_rs_zeta_batch) *b);
+
 void XC(lda_fxc_fd)(const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *fxc);
 void XC(lda_kxc_fd)(const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *kxc);
 
@@ -98,12 +251,17 @@ void XC(lda_c_2d_prm_set_params_) (XC(lda_type) *p, FLOAT N);
 void XC(lda_c_vwn_set_params_)    (XC(lda_type) *p, int spin_interpolation);
 
 /* GGAs */
+
+/* the GGA drivers work on blocks of this number of points */
+#define GGA_BATCH_SIZE 64
+
 typedef struct XC(perdew_t) {
   int    nspin;
   FLOAT dens, zeta, gdmt;
   FLOAT ecunif, vcunif[2], fcunif[3];
 
   FLOAT  rs,  kf,  ks,  phi, t;
+  FLOAT dphidz, d2phidz2;                     /* derivatives of phi with respect to zeta */
   FLOAT drs, dkf, dks, dphi, dt, decunif;
 
   FLOAT d2rs2, d2rskf, d2rsks, d2rsphi,  d2rst,  d2rsecunif;
@@ -114,13 +272,33 @@ typedef struct XC(perdew_t) {
   FLOAT                                           d2ecunif2;
 } XC(perdew_t);
 
-void XC(perdew_params)(const XC(gga_type) *gga_p, const FLOAT *rho, const FLOAT *sigma, int order, XC(perdew_t) *pp);
+void XC(perdew_params)(const XC(gga_type) *gga_p, int np, const FLOAT *rho, const FLOAT *sigma, int order, XC(perdew_t) *pt);
 void XC(perdew_potentials)(XC(perdew_t) *pt, const FLOAT *rho, FLOAT e_gga, int order, 
 			   FLOAT *vrho, FLOAT *vsigma, FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2);
 
 
 void XC(gga_x_pbe_enhance)(const XC(gga_type) *p, int order, FLOAT x, FLOAT *f, FLOAT *dfdx, FLOAT *ldfdx, FLOAT *d2fdx2);
 
+/* the enhancement factor of GGA exchange for a block of (point, spin) pairs */
+typedef struct XC(gga_x_batch) {
+  int   order; /* to which order should I return the derivatives */
+  int   np;    /* number of (point, spin) pairs in the block */
+  FLOAT x[2*GGA_BATCH_SIZE];
+  FLOAT sigma[2*GGA_BATCH_SIZE]; /* only for functionals that depend explicitly on sigma */
+  FLOAT ds[2*GGA_BATCH_SIZE];    /* only for functionals that depend explicitly on rho   */
+
+  FLOAT f[2*GGA_BATCH_SIZE], dfdx[2*GGA_BATCH_SIZE], ldfdx[2*GGA_BATCH_SIZE], d2fdx2[2*GGA_BATCH_SIZE];
+  FLOAT lvsigma[2*GGA_BATCH_SIZE], lv2sigma2[2*GGA_BATCH_SIZE], lvsigmax[2*GGA_BATCH_SIZE];
+  FLOAT lvrho[2*GGA_BATCH_SIZE];
+} XC(gga_x_batch);
+
+/* spline tables of the enhancement factor, see gga_x_table.c */
+int  XC(gga_x_table_init)  (XC(gga_type) *p, FLOAT tol);
+void XC(gga_x_table_update)(XC(gga_type) *p);
+void XC(gga_x_table_end)   (XC(gga_type) *p);
+void XC(gga_x_table_dup)   (XC(gga_type) *p);
+int  XC(gga_x_table_eval)  (const XC(gga_type) *p, XC(gga_x_batch) *b, int *miss);
+
 void gga_init_mix(XC(gga_type) *p, int n_funcs, const int *funcs_id, const FLOAT *mix_coef);
 
 /* internal versions of set_params routines */
@@ -133,6 +311,9 @@ void XC(gga_lb_set_params_)    (XC(gga_type) *p, int modified, FLOAT threshold,
 
 /* meta GGAs */
 
+/* the meta-GGA exchange drivers work on blocks of this number of points */
+#define MGGA_X_BATCH_SIZE 64
+
 void XC(mgga_x_gvt4_func)(int order, FLOAT x, FLOAT z, FLOAT alpha, const FLOAT *d, 
 			  FLOAT *h, FLOAT *dhdx, FLOAT *dhdz);
 
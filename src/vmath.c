@@ -0,0 +1,623 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "util.h"
+
+/************************************************************************
+  Elementary functions for arrays of points.
+
+    XC(vexp)  (n, x, y)      y[i] = exp(x[i])
+    XC(vlog)  (n, x, y)      y[i] = log(x[i])
+    XC(vpow)  (n, x, a, y)   y[i] = x[i]^a,  x[i] >= 0
+    XC(vcbrt) (n, x, y)      y[i] = x[i]^(1/3)
+    XC(vasinh)(n, x, y)      y[i] = asinh(x[i])
+    XC(vatan) (n, x, y)      y[i] = atan(x[i])
+    XC(verf)  (n, x, y)      y[i] = erf(x[i])
+
+  y may be the same array as x. The loops have no branches nor calls
+  to libm, so that the compiler vectorizes them for the instruction
+  set of CFLAGS and, when it supports target_clones, also for AVX2
+  and AVX-512. The special cases are resolved by selects at the end, which
+  is why configure adds -fno-trapping-math to the flags.
+
+  Largest errors found against long double libm, in units in the last
+  place of double precision:
+
+    exp    0.9 ulp   (results below DBL_MIN are flushed to zero)
+    log    1.2 ulp
+    pow    1.4 ulp   (log x is carried in double length)
+    cbrt   0.7 ulp
+    asinh  2.0 ulp
+    atan   2.3 ulp
+    erf    7.3 ulp   (around |x| = 2, where the power series ends)
+
+  The single precision versions use the same expansions, which are
+  then more accurate than float itself.
+
+  Configuring with --disable-vmath replaces all of them by loops over
+  the scalar functions of libm (the reference build).
+************************************************************************/
+
+#ifdef HAVE_VMATH
+
+#if SINGLE_PRECISION
+typedef uint32_t vm_uint;
+#  define VM_MANT      23
+#  define VM_BIAS      127
+#  define VM_EXP_MASK  0x7f800000U
+#  define VM_MANT_MASK 0x007fffffU
+#  define VM_ONE       0x3f800000U            /* bits of 1.0 */
+#  define VM_TWO_M     8388608.0              /* 2^23 */
+#  define VM_ROUND     12582912.0             /* 1.5*2^23, rounds to integers */
+#  define VM_SPLIT     4097.0                 /* 2^12 + 1 */
+#  define VM_DENORM    16777216.0             /* 2^24, scales the denormals */
+#  define VM_NDENORM   24
+#  define VM_LN2_HI    6.9313812256e-01
+#  define VM_LN2_LO    9.0580006145e-06
+#  define VM_EXP_HI    88.72283
+#  define VM_EXP_LO    -87.33654
+#  define VM_ASINH_BIG 4096.0
+#  define VM_ERF_ONE   4.0                    /* erf(x) = 1 from here on */
+#else
+typedef uint64_t vm_uint;
+#  define VM_MANT      52
+#  define VM_BIAS      1023
+#  define VM_EXP_MASK  0x7ff0000000000000ULL
+#  define VM_MANT_MASK 0x000fffffffffffffULL
+#  define VM_ONE       0x3ff0000000000000ULL  /* bits of 1.0 */
+#  define VM_TWO_M     4503599627370496.0     /* 2^52 */
+#  define VM_ROUND     6755399441055744.0     /* 1.5*2^52, rounds to integers */
+#  define VM_SPLIT     134217729.0            /* 2^27 + 1 */
+#  define VM_DENORM    18014398509481984.0    /* 2^54, scales the denormals */
+#  define VM_NDENORM   54
+#  define VM_LN2_HI    6.93147180369123816490e-01
+#  define VM_LN2_LO    1.90821492927058770002e-10
+#  define VM_EXP_HI    709.782712893383973096
+#  define VM_EXP_LO    -708.396418532264106224
+#  define VM_ASINH_BIG 268435456.0            /* 2^28 */
+#  define VM_ERF_ONE   6.0
+#endif
+
+/* the helpers below are much larger than what the compiler inlines by
+   itself, but the loops only vectorize if they are */
+#if defined(__GNUC__)
+#  define VM_INLINE static inline __attribute__((always_inline))
+#else
+#  define VM_INLINE static inline
+#endif
+
+/* the loops are compiled for AVX-512 and AVX2 as well, and the version
+   that the processor supports is chosen when the library is loaded */
+#if defined(HAVE_TARGET_CLONES)
+#  define VM_CLONES __attribute__((target_clones("avx512f","avx2","default")))
+#else
+#  define VM_CLONES
+#endif
+
+#define VM_LOG2E  1.44269504088896340736
+#define VM_LN2    0.693147180559945309417
+#define VM_SQRT2  1.41421356237309504880
+#define VM_SQRT3  1.73205080756887729353
+#define VM_PI6_HI 5.23598775598298873078e-01
+#define VM_PI6_LO -5.36040883225545497411e-17
+#define VM_PI2_HI 1.57079632679489661923e+00
+#define VM_PI2_LO 6.12323399573676588613e-17
+#define VM_ERF_CUT 2.0      /* from the power series to the continued fraction */
+#define VM_ERF_BLOCK 64
+
+VM_INLINE vm_uint
+as_uint(FLOAT x)
+{
+  vm_uint u;
+  memcpy(&u, &x, sizeof(u));
+  return u;
+}
+
+VM_INLINE FLOAT
+as_float(vm_uint u)
+{
+  FLOAT x;
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+/* x rounded to the nearest integer, for |x| < 2^(VM_MANT-1) */
+VM_INLINE FLOAT
+round_int(FLOAT x)
+{
+  return (x + (FLOAT)VM_ROUND) - (FLOAT)VM_ROUND;
+}
+
+/* 2^k for an integer valued k, between the smallest and the largest normal exponents */
+VM_INLINE FLOAT
+pow2_int(FLOAT k)
+{
+  return as_float(as_uint(k + (FLOAT)(VM_ROUND + VM_BIAS)) << VM_MANT);
+}
+
+/* the biased exponent of a positive normal x, as a FLOAT */
+VM_INLINE FLOAT
+biased_exponent(FLOAT x)
+{
+  return as_float(as_uint((FLOAT)VM_TWO_M) | (as_uint(x) >> VM_MANT)) - (FLOAT)VM_TWO_M;
+}
+
+/* the mantissa of a positive normal x, in [1, 2) */
+VM_INLINE FLOAT
+mantissa(FLOAT x)
+{
+  return as_float((as_uint(x) & VM_MANT_MASK) | VM_ONE);
+}
+
+
+/* exp(x) without the special cases: VM_EXP_LO <= x <= VM_EXP_HI */
+VM_INLINE FLOAT
+exp_core(FLOAT x)
+{
+  FLOAT k, r, p, h;
+
+  /* x = k ln2 + r, with |r| <= ln2/2 */
+  k = round_int(x*(FLOAT)VM_LOG2E);
+  r = (x - k*(FLOAT)VM_LN2_HI) - k*(FLOAT)VM_LN2_LO;
+
+  /* exp(r) = 1 + r + r^2 P(r), with P fitted on [-ln2/2, ln2/2] to 1.7e-19 */
+  p = 2.09146793765839351e-9;
+  p = p*r + 2.5105206373957011116e-8;
+  p = p*r + 2.7557273661348636219e-7;
+  p = p*r + 2.7557255425746434282e-6;
+  p = p*r + 0.000024801587325533363819;
+  p = p*r + 0.00019841269874800491981;
+  p = p*r + 0.0013888888888883752417;
+  p = p*r + 0.008333333333326140884;
+  p = p*r + 0.041666666666666669752;
+  p = p*r + 0.16666666666666670986;
+  p = p*r + 0.5;
+  p = 1.0 + (r + r*r*p);
+
+  /* 2^k may be one beyond the largest exponent, so it is applied in two steps */
+  h = (k > 0.0) ? 1.0 : 0.0;
+  return p*pow2_int(k - h)*(1.0 + h);
+}
+
+VM_INLINE FLOAT
+exp_1(FLOAT x)
+{
+  FLOAT y;
+
+  y = exp_core(min(max(x, (FLOAT)VM_EXP_LO), (FLOAT)VM_EXP_HI));
+
+  y = (x < (FLOAT)VM_EXP_LO) ? 0.0 : y;
+  y = (x > (FLOAT)VM_EXP_HI) ? (FLOAT)HUGE_VAL : y;
+  y = (x != x) ? x : y;
+  return y;
+}
+
+
+/* the sum a + b = *s + *e, exactly (Knuth) */
+VM_INLINE void
+two_sum(FLOAT a, FLOAT b, FLOAT *s, FLOAT *e)
+{
+  FLOAT bb;
+
+  *s = a + b;
+  bb = *s - a;
+  *e = (a - (*s - bb)) + (b - bb);
+}
+
+/* the product a*b = *p + *e, exactly (Dekker) */
+VM_INLINE void
+two_prod(FLOAT a, FLOAT b, FLOAT *p, FLOAT *e)
+{
+  FLOAT c, ah, al, bh, bl;
+
+  c  = (FLOAT)VM_SPLIT*a;
+  ah = c - (c - a);
+  al = a - ah;
+  c  = (FLOAT)VM_SPLIT*b;
+  bh = c - (c - b);
+  bl = b - bh;
+
+  *p = a*b;
+  *e = ((ah*bh - *p) + ah*bl + al*bh) + al*bl;
+}
+
+/* x = 2^e (1 + f), with sqrt(1/2) <= 1 + f < sqrt(2), and log(1 + f) = 2 atanh(s) = 2s + s r,
+   s = f/(2 + f), as in fdlibm. x is positive and finite. */
+VM_INLINE void
+log_reduce(FLOAT x, FLOAT *e, FLOAT *f, FLOAT *s, FLOAT *r)
+{
+  FLOAT xs, m, z, p, sub, up;
+
+  /* the denormals are brought to the normal range first */
+  sub = (x < (FLOAT)FLOAT_MIN) ? 1.0 : 0.0;
+  xs  = x*((sub > 0.0) ? (FLOAT)VM_DENORM : 1.0);
+
+  *e = biased_exponent(xs) - VM_BIAS - sub*VM_NDENORM;
+  m  = mantissa(xs);
+  up = (m > (FLOAT)VM_SQRT2) ? 1.0 : 0.0;
+  *e = *e + up;
+  m  = m*(1.0 - 0.5*up);
+
+  *f = m - 1.0;
+  *s = *f/(2.0 + *f);
+  z  = (*s)*(*s);
+
+  /* (2 atanh(s)/s - 2)/s^2, fitted for s^2 <= 0.0295 to 1.6e-18 */
+  p = 0.1461644968504340586;
+  p = p*z + 0.15331721600556041269;
+  p = p*z + 0.1818288912526172208;
+  p = p*z + 0.22222211134795079855;
+  p = p*z + 0.28571428625975484921;
+  p = p*z + 0.3999999999989950449;
+  p = p*z + 0.66666666666666696862;
+  *r = z*p;
+}
+
+/* log(x) without the special cases: x positive and finite */
+VM_INLINE FLOAT
+log_core(FLOAT x)
+{
+  FLOAT e, f, s, r, hfsq;
+
+  log_reduce(x, &e, &f, &s, &r);
+  hfsq = 0.5*f*f;
+
+  return e*(FLOAT)VM_LN2_HI + ((f - (hfsq - s*(hfsq + r))) + e*(FLOAT)VM_LN2_LO);
+}
+
+/* log(x) = *hi + *lo in double length, without the special cases */
+VM_INLINE void
+log_ext(FLOAT x, FLOAT *hi, FLOAT *lo)
+{
+  FLOAT e, f, s, r, f2, f2e, hfsq, t, u, ue, c, v, ve, we;
+
+  log_reduce(x, &e, &f, &s, &r);
+  two_prod(f, f, &f2, &f2e);
+  hfsq = 0.5*f2;
+
+  /* e ln2_hi is exact; the large terms are added keeping their rounding errors */
+  t  = e*(FLOAT)VM_LN2_HI;
+  u  = f - hfsq;
+  ue = (f - u) - hfsq;
+  c  = s*(hfsq + r) + ((ue - 0.5*f2e) + e*(FLOAT)VM_LN2_LO);
+
+  two_sum(t, u, &v, &ve);
+  two_sum(v, c, hi, &we);
+  *lo = ve + we;
+}
+
+VM_INLINE FLOAT
+log_1(FLOAT x)
+{
+  FLOAT y;
+
+  y = log_core(((x > 0.0) & (x < (FLOAT)HUGE_VAL)) ? x : 1.0);
+
+  y = (x == 0.0) ? -(FLOAT)HUGE_VAL : y;
+  y = (x == (FLOAT)HUGE_VAL) ? x : y;
+  y = ((x < 0.0) | (x != x)) ? (FLOAT)NAN : y;
+  return y;
+}
+
+
+/* log(1 + x) for x >= 0, with the rounding of 1 + x corrected to first order */
+VM_INLINE FLOAT
+log1p_core(FLOAT x)
+{
+  FLOAT u = 1.0 + x;
+
+  return log_core(u) + (x - (u - 1.0))/u;
+}
+
+
+VM_INLINE FLOAT
+cbrt_1(FLOAT x)
+{
+  FLOAT a, as, sub, e, q, r, m, y, y3;
+
+  a   = ABS(x);
+  sub = (a < (FLOAT)FLOAT_MIN) ? 1.0 : 0.0;
+  as  = a*((sub > 0.0) ? (FLOAT)VM_DENORM : 1.0);
+  as  = ((a > 0.0) & (a < (FLOAT)HUGE_VAL)) ? as : 1.0;
+
+  /* a = 2^(3q) m, with 1 <= m < 8 */
+  e = biased_exponent(as) - VM_BIAS;
+  q = round_int((e - 1.0)/3.0);
+  r = e - 3.0*q;
+  m = mantissa(as)*((r > 1.5) ? 4.0 : ((r > 0.5) ? 2.0 : 1.0));
+
+  /* a cubic fit on [1, 8], good to 1.3%, two Halley iterations and a
+     last Newton one, written as a small correction to keep the rounding low */
+  y = 0.0016274953380330931;
+  y = y*m - 0.03402605365290486;
+  y = y*m + 0.3288364544631474;
+  y = y*m + 0.7167346418604423;
+
+  y3 = y*y*y;
+  y  = y*(y3 + 2.0*m)/(2.0*y3 + m);
+  y3 = y*y*y;
+  y  = y*(y3 + 2.0*m)/(2.0*y3 + m);
+  y  = y + (m/(y*y) - y)/3.0;
+
+  y *= pow2_int(q - sub*(VM_NDENORM/3));
+  y  = ((a == 0.0) | (a == (FLOAT)HUGE_VAL) | (a != a)) ? a : y;
+  return (x < 0.0) ? -y : y;
+}
+
+
+VM_INLINE FLOAT
+asinh_1(FLOAT x)
+{
+  FLOAT a, a2, ys, yb, y;
+
+  a  = ABS(x);
+  a2 = a*a;
+
+  /* asinh(a) = log1p(a + a^2/(1 + sqrt(1 + a^2))) */
+  ys = log1p_core(a + a2/(1.0 + sqrt(1.0 + a2)));
+
+  /* for large a, asinh(a) = log(2a) */
+  yb = log_core((a < (FLOAT)HUGE_VAL) ? a : 1.0) + (FLOAT)VM_LN2;
+
+  y = (a > (FLOAT)VM_ASINH_BIG) ? yb : ys;
+  y = ((a == (FLOAT)HUGE_VAL) | (a != a)) ? a : y;
+  return (x < 0.0) ? -y : y;
+}
+
+
+VM_INLINE FLOAT
+atan_1(FLOAT x)
+{
+  FLOAT a, t, tr, big, inv, z, p, y;
+
+  /* atan(a) = pi/2 - atan(1/a) */
+  a   = ABS(x);
+  inv = (a > 1.0) ? 1.0 : 0.0;
+  t   = ((inv > 0.0) ? 1.0 : a)/((inv > 0.0) ? a : 1.0);
+
+  /* atan(t) = pi/6 + atan((sqrt(3) t - 1)/(t + sqrt(3))), so that |t| <= tan(pi/12) */
+  big = (t > 2.0 - (FLOAT)VM_SQRT3) ? 1.0 : 0.0;
+  tr  = ((FLOAT)VM_SQRT3*t - 1.0)/(t + (FLOAT)VM_SQRT3);
+  t   = (big > 0.0) ? tr : t;
+
+  /* Taylor series up to t^29 */
+  z = t*t;
+  p = 1.0/29.0;
+  p = -p*z + 1.0/27.0;
+  p = -p*z + 1.0/25.0;
+  p = -p*z + 1.0/23.0;
+  p = -p*z + 1.0/21.0;
+  p = -p*z + 1.0/19.0;
+  p = -p*z + 1.0/17.0;
+  p = -p*z + 1.0/15.0;
+  p = -p*z + 1.0/13.0;
+  p = -p*z + 1.0/11.0;
+  p = -p*z + 1.0/9.0;
+  p = -p*z + 1.0/7.0;
+  p = -p*z + 1.0/5.0;
+  p = -p*z + 1.0/3.0;
+  p = -p*z + 1.0;
+
+  /* pi/6 and pi/2 are added in two parts */
+  y = big*(FLOAT)VM_PI6_HI + (t*p + big*(FLOAT)VM_PI6_LO);
+  y = (inv > 0.0) ? ((FLOAT)VM_PI2_HI - (y - (FLOAT)VM_PI2_LO)) : y;
+  y = (a != a) ? a : y;
+  return (x < 0.0) ? -y : y;
+}
+
+
+VM_CLONES void
+XC(vexp)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  XC_OP_COUNT(XC_STATS_EXP, n);
+  for(i=0; i<n; i++)
+    y[i] = exp_1(x[i]);
+}
+
+VM_CLONES void
+XC(vlog)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  XC_OP_COUNT(XC_STATS_LOG, n);
+  for(i=0; i<n; i++)
+    y[i] = log_1(x[i]);
+}
+
+VM_CLONES void
+XC(vpow)(int n, const FLOAT *x, FLOAT a, FLOAT *y)
+{
+  FLOAT xx, hi, lo, ph, pl, yy;
+  int i;
+
+  XC_OP_COUNT(XC_STATS_POW, n);
+  for(i=0; i<n; i++){
+    xx = x[i];
+
+    /* exp(a log x), with a log x in double length */
+    log_ext((xx > 0.0 && xx < (FLOAT)HUGE_VAL) ? xx : 1.0, &hi, &lo);
+    two_prod(a, hi, &ph, &pl);
+    pl += a*lo;
+
+    yy = exp_core(min(max(ph, (FLOAT)VM_EXP_LO), (FLOAT)VM_EXP_HI));
+    yy = yy + yy*pl;
+    yy = (ph < (FLOAT)VM_EXP_LO) ? 0.0 : yy;
+    yy = (ph > (FLOAT)VM_EXP_HI) ? (FLOAT)HUGE_VAL : yy;
+
+    /* x = 0 and x = infinity */
+    yy = (xx == 0.0) ? ((a > 0.0) ? 0.0 : (FLOAT)HUGE_VAL) : yy;
+    yy = (xx == (FLOAT)HUGE_VAL) ? ((a > 0.0) ? xx : 0.0) : yy;
+    yy = (xx < 0.0 || xx != xx) ? (FLOAT)NAN : yy;
+    y[i] = (a == 0.0) ? 1.0 : yy;
+  }
+}
+
+VM_CLONES void
+XC(vcbrt)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  XC_OP_COUNT(XC_STATS_CBRT, n);
+  for(i=0; i<n; i++)
+    y[i] = cbrt_1(x[i]);
+}
+
+VM_CLONES void
+XC(vasinh)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  XC_OP_COUNT(XC_STATS_ASINH, n);
+  for(i=0; i<n; i++)
+    y[i] = asinh_1(x[i]);
+}
+
+VM_CLONES void
+XC(vatan)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  XC_OP_COUNT(XC_STATS_ATAN, n);
+  for(i=0; i<n; i++)
+    y[i] = atan_1(x[i]);
+}
+
+/* the series and the continued fraction of erf are summed one term at a
+   time for blocks of VM_ERF_BLOCK points, so that the inner loops vectorize */
+VM_CLONES void
+XC(verf)(int n, const FLOAT *x, FLOAT *y)
+{
+  FLOAT ac[VM_ERF_BLOCK], g[VM_ERF_BLOCK], t[VM_ERF_BLOCK], s[VM_ERF_BLOCK], v[VM_ERF_BLOCK];
+  FLOAT a, a2h, a2l, ys, yb, yy;
+  int i, ib, nb, k;
+
+  XC_OP_COUNT(XC_STATS_ERF, n);
+  for(ib=0; ib<n; ib+=VM_ERF_BLOCK){
+    nb = (n - ib < VM_ERF_BLOCK) ? n - ib : VM_ERF_BLOCK;
+
+    for(i=0; i<nb; i++){
+      ac[i] = min(ABS(x[ib + i]), (FLOAT)VM_ERF_ONE);
+
+      /* exp(-a^2), with a^2 in double length to keep the rounding out of the exponent */
+      two_prod(ac[i], ac[i], &a2h, &a2l);
+      g[i] = exp_core(-a2h)*(1.0 - a2l);
+      t[i] = 2.0*a2h;
+      s[i] = 1.0;
+      v[i] = ac[i];
+    }
+
+    /* erf(a) = 2a/sqrt(pi) exp(-a^2) sum_n (2a^2)^n/(1 3 ... (2n + 1)), all terms positive */
+    for(k=40; k>=1; k--)
+      for(i=0; i<nb; i++)
+	s[i] = 1.0 + s[i]*t[i]/(2*k + 1);
+
+    /* erfc(a) = exp(-a^2)/sqrt(pi) 1/(a + (1/2)/(a + 1/(a + (3/2)/(a + ...)))) */
+    for(k=48; k>=1; k--)
+      for(i=0; i<nb; i++)
+	v[i] = ac[i] + (0.5*k)/v[i];
+
+    for(i=0; i<nb; i++){
+      a  = ABS(x[ib + i]);
+      ys = (FLOAT)M_2_SQRTPI*ac[i]*g[i]*s[i];
+      yb = 1.0 - (FLOAT)(0.5*M_2_SQRTPI)*g[i]/v[i];
+
+      yy = (a < (FLOAT)VM_ERF_CUT) ? ys : yb;
+      yy = (a >= (FLOAT)VM_ERF_ONE) ? 1.0 : yy;
+      yy = (a != a) ? a : yy;
+      y[ib + i] = (x[ib + i] < 0.0) ? -yy : yy;
+    }
+  }
+}
+
+#else /* the reference build: the scalar functions of libm */
+
+void
+XC(vexp)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  for(i=0; i<n; i++)
+    y[i] = EXP(x[i]);
+}
+
+void
+XC(vlog)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  for(i=0; i<n; i++)
+    y[i] = LOG(x[i]);
+}
+
+void
+XC(vpow)(int n, const FLOAT *x, FLOAT a, FLOAT *y)
+{
+  int i;
+
+  for(i=0; i<n; i++)
+    y[i] = POW(x[i], a);
+}
+
+void
+XC(vcbrt)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  for(i=0; i<n; i++)
+    y[i] = CBRT(x[i]);
+}
+
+void
+XC(vasinh)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  for(i=0; i<n; i++)
+    y[i] = ASINH(x[i]);
+}
+
+void
+XC(vatan)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  XC_OP_COUNT(XC_STATS_ATAN, n);
+  for(i=0; i<n; i++)
+    y[i] = atan(x[i]);
+}
+
+void
+XC(verf)(int n, const FLOAT *x, FLOAT *y)
+{
+  int i;
+
+  XC_OP_COUNT(XC_STATS_ERF, n);
+  for(i=0; i<n; i++)
+    y[i] = erf(x[i]);
+}
+
+#endif
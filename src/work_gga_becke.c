@@ -29,10 +29,10 @@ work_gga_becke_init(void *p_)
   XC(gga_type) *p = (XC(gga_type) *)p_;
 
   p->n_func_aux  = 1;
-  p->func_aux    = (XC(func_type) **) malloc(1*sizeof(XC(func_type) *));
-  p->func_aux[0] = (XC(func_type) *)  malloc(  sizeof(XC(func_type)));
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, 1*sizeof(XC(func_type) *));
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  XC(func_init)(p->func_aux[0], XC_LDA_C_PW, XC_POLARIZED);
+  XC(func_init_aux)(p->func_aux[0], XC_LDA_C_PW, XC_POLARIZED, p->arena);
 }
 
 
@@ -44,9 +44,14 @@ work_gga_becke(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
   const XC(gga_type) *p = p_;
 
   FLOAT sfact, sfact2, dens;
-  FLOAT ds[2], sigmas[2], x[2], x_avg;
+  FLOAT ds[2], ds83[2], sigmas[2], x[2], x_avg;
   FLOAT e_LDA_opp, v_LDA_opp[2], f_LDA_opp[3];
-  int   is, ip, order;
+  int   is, ip, ib, nb, order;
+
+  /* spin-polarized LDA for the whole block: total density (opp) and
+     each spin alone (par), the latter stored at index ip*nspin + is */
+  FLOAT rho_opp[2*GGA_BATCH_SIZE], e_opp[GGA_BATCH_SIZE], v_opp[2*GGA_BATCH_SIZE], f_opp[3*GGA_BATCH_SIZE];
+  FLOAT rho_par[4*GGA_BATCH_SIZE], e_par[2*GGA_BATCH_SIZE], v_par[4*GGA_BATCH_SIZE], f_par[6*GGA_BATCH_SIZE];
 
   order = 0;
   if(vrho   != NULL) order = 1;
@@ -56,6 +61,36 @@ work_gga_becke(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
   sfact2 = sfact*sfact;
 
   for(ip=0; ip<np; ip++){
+    ib = ip % GGA_BATCH_SIZE;
+
+    if(ib == 0){ /* get the spin-polarized LDAs of the next block */
+      int jp;
+
+      nb = min(np - ip, GGA_BATCH_SIZE);
+      for(jp=0; jp<nb; jp++){
+	const FLOAT *rr = rho + jp*p->n_rho;
+
+	if(p->nspin == XC_POLARIZED){
+	  rho_opp[2*jp] = rr[0];     rho_opp[2*jp + 1] = rr[1];
+	}else{
+	  rho_opp[2*jp] = rr[0]/2.0; rho_opp[2*jp + 1] = rho_opp[2*jp];
+	}
+
+	for(is=0; is<p->nspin; is++){
+	  rho_par[2*(jp*p->nspin + is)    ] = rho_opp[2*jp + is];
+	  rho_par[2*(jp*p->nspin + is) + 1] = 0.0;
+	}
+      }
+
+      XC(lda)(p->func_aux[0], nb, rho_opp, e_opp, 
+	      (order > 0) ? v_opp : NULL, (order > 1) ? f_opp : NULL, NULL);
+      XC(lda)(p->func_aux[0], nb*p->nspin, rho_par, e_par, 
+	      (order > 0) ? v_par : NULL, (order > 1) ? f_par : NULL, NULL);
+
+      if(p->stats != NULL)
+	XC(stats_screen_block)(p->stats, p->nspin, nb, rho, p->n_rho, sigma, p->n_sigma);
+    }
+
     if(p->nspin == XC_POLARIZED){
       ds[0] = rho[0];     ds[1] = rho[1];
       dens  = rho[0] + rho[1];
@@ -64,19 +99,17 @@ work_gga_becke(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
       dens  = rho[0];
     }
 
-    if(dens <= 0.0) continue;
-
-    /* get spin-polarized LDA */
-    switch (order){
-    case 0:
-      XC(lda_exc)(p->func_aux[0], 1, ds, &e_LDA_opp);
-      break;
-    case 1:
-      XC(lda_exc_vxc)(p->func_aux[0], 1, ds, &e_LDA_opp, v_LDA_opp);
-      break;
-    case 2: /* to be implemented */
-      XC(lda)(p->func_aux[0], 1, ds, &e_LDA_opp, v_LDA_opp, f_LDA_opp, NULL);
-      break; 
+    if(dens <= 0.0) goto end_ip_loop;
+
+    e_LDA_opp = e_opp[ib];
+    if(order > 0){
+      v_LDA_opp[0] = v_opp[2*ib];
+      v_LDA_opp[1] = v_opp[2*ib + 1];
+    }
+    if(order > 1){
+      f_LDA_opp[0] = f_opp[3*ib];
+      f_LDA_opp[1] = f_opp[3*ib + 1];
+      f_LDA_opp[2] = f_opp[3*ib + 2];
     }
     e_LDA_opp *= dens;
 
@@ -85,17 +118,19 @@ work_gga_becke(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
 
     x_avg = 0.0;
     for(is=0; is<p->nspin; is++){
-      FLOAT gdm, rho13, mrho[2];
+      FLOAT gdm, rho13;
       FLOAT e_x, e_ss, e_LDA, v_LDA[2], f_LDA[3];
       FLOAT g_x, dg_x, d2g_x, g_ss, dg_ss, d2g_ss;
       int js = (is == 0) ? 0 : 2;
 
+      rho13    = CBRT(ds[is]);
+      ds83[is] = POW_8_3(ds[is], rho13);
+
       if(rho[is] < MIN_DENS) continue;
       
       sigmas[is] = max(MIN_GRAD*MIN_GRAD, sigma[js]/sfact2);
-      gdm    = sqrt(sigmas[is]);
+      gdm    = SQRT(sigmas[is]);
   
-      rho13 = POW(ds[is], 1.0/3.0);
       x[is] = gdm/(ds[is]*rho13);
       x_avg+= sfact*0.5*x[is]*x[is];
 
@@ -104,20 +139,10 @@ work_gga_becke(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
       
       func_gga_becke_parallel(p, x[is], order, &g_ss, &dg_ss, &d2g_ss);
       
-      /* get parallel spin LDA energy */
-      mrho[0] = ds[is];
-      mrho[1] = 0.0;
-      switch (order){
-      case 0:
-	XC(lda_exc)(p->func_aux[0], 1, mrho, &e_LDA);
-	break;
-      case 1:
-	XC(lda_exc_vxc)(p->func_aux[0], 1, mrho, &e_LDA, v_LDA);
-	break;
-      case 2:
-	XC(lda)(p->func_aux[0], 1, mrho, &e_LDA, v_LDA, f_LDA, NULL);
-	break;
-      }
+      /* parallel spin LDA energy */
+      e_LDA = e_par[ib*p->nspin + is];
+      v_LDA[0] = (order > 0) ? v_par[2*(ib*p->nspin + is)] : 0.0;
+      f_LDA[0] = (order > 1) ? f_par[3*(ib*p->nspin + is)] : 0.0;
 
       e_ss       = sfact*ds[is]*e_LDA;
       e_LDA_opp -= e_ss;
@@ -160,26 +185,26 @@ work_gga_becke(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
     {
       FLOAT g_ab, dg_ab, d2g_ab, dx_avg[2];
       
-      x_avg = sqrt(x_avg);
+      x_avg = SQRT(x_avg);
       func_gga_becke_opposite(p, x_avg, order, &g_ab, &dg_ab, &d2g_ab);
       
       if(zk != NULL)
 	*zk += e_LDA_opp*g_ab;
       
       if(vrho != NULL){
+	FLOAT dd = POW_4_3(dens, CBRT(dens));
+
 	for(is=0; is<p->nspin; is++){
-	  FLOAT dd;
 	  int js = (is == 0) ? 0 : 2;
 	  
 	  vrho[is] += v_LDA_opp[is]*g_ab;
 	  
-	  dd = POW(dens, 4.0/3.0);
 	  if(x_avg*dd < MIN_GRAD*MIN_GRAD || ds[is] < MIN_DENS) continue;
 	  
 	  dx_avg[is]  = -2.0*x[is]*x[is]/(3.0*x_avg*ds[is]);
 	  
 	  vrho[is]   += e_LDA_opp*dg_ab*dx_avg[is];
-	  vsigma[js] += e_LDA_opp*dg_ab*POW(ds[is], -8.0/3.0)/(sfact*4.0*x_avg);
+	  vsigma[js] += e_LDA_opp*dg_ab/(ds83[is]*sfact*4.0*x_avg);
 	}
       }
 
@@ -206,7 +231,7 @@ work_gga_becke(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
 	  
 	  ks2 = sp2[ks];
 	  
-	  v2sigma2[ks2] += e_LDA_opp*POW(ds[is], -8.0/3.0)*POW(ds[js], -8.0/3.0) *
+	  v2sigma2[ks2] += e_LDA_opp/(ds83[is]*ds83[js]) *
 	    (d2g_ab - dg_ab/x_avg)/(sfact2*16.0*x_avg*x_avg);
 	}
 	
@@ -232,6 +257,7 @@ work_gga_becke(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
     if(zk != NULL)
       *zk /= dens; /* we want energy per particle */
 
+  end_ip_loop:
     /* increment pointers */
     rho   += p->n_rho;
     sigma += p->n_sigma;
@@ -21,6 +21,28 @@
   functionals are written as a function of s = |grad n|/n^(4/3), this
   routine performs the necessary conversions between a functional of s
   and of rho.
+
+  The points are handled in blocks of GGA_BATCH_SIZE, with both spins
+  of a block flattened into a single list. Functionals that define
+  FUNC_BATCH provide
+
+    func_batch(const XC(gga_type) *p, XC(gga_x_batch) *b)
+
+  that fills the arrays of b for the b->np entries of the block. All
+  the others provide the single point version, with one of the
+  following signatures
+
+    HEADER 1: func(p, order, x, &f, &dfdx, &ldfdx, &d2fdx2)
+    HEADER 2: func(p, order, x, sigma, &f, &dfdx, &ldfdx, &lvsigma, &d2fdx2, &lv2sigma2, &lvsigmax)
+    HEADER 3: func(p, order, x, ds, &f, &dfdx, &lvrho)
+
+  which is called entry by entry.
+
+  The functionals with HEADER 1 depend on x alone. They also provide
+  work_gga_x_enhancement, to be set as the gga_x member of their info,
+  which allows f to be tabulated (see gga_x_table.c). If p carries
+  such a table, the entries of a block are evaluated from it, and only
+  those beyond the table go to func_batch.
 ************************************************************************/
 
 #ifndef HEADER
@@ -31,6 +53,80 @@
 #  define XC_DIMENSIONS 3
 #endif
 
+#ifndef FUNC_BATCH
+static void
+func_batch(const XC(gga_type) *p, XC(gga_x_batch) *b)
+{
+  int ip;
+
+  for(ip=0; ip<b->np; ip++){
+    b->dfdx[ip] = b->ldfdx[ip] = b->d2fdx2[ip] = 0.0;
+
+#if   HEADER == 1
+    func(p, b->order, b->x[ip], &b->f[ip], &b->dfdx[ip], &b->ldfdx[ip], &b->d2fdx2[ip]);
+#elif HEADER == 2
+    /* this second header is useful for functionals that depend
+       explicitly both on x and on sigma */
+    b->lvsigma[ip] = b->lv2sigma2[ip] = b->lvsigmax[ip] = 0.0;
+    func(p, b->order, b->x[ip], b->sigma[ip], &b->f[ip], &b->dfdx[ip], &b->ldfdx[ip], 
+	 &b->lvsigma[ip], &b->d2fdx2[ip], &b->lv2sigma2[ip], &b->lvsigmax[ip]);
+#elif HEADER == 3
+    /* this third header is useful for functionals that depend
+       explicitly both on x and on rho*/
+    b->lvrho[ip] = 0.0;
+    func(p, b->order, b->x[ip], b->ds[ip], &b->f[ip], &b->dfdx[ip], &b->lvrho[ip]);
+#endif
+  }
+}
+#endif
+
+#if HEADER == 1
+/* f and its derivatives at np arbitrary values of x, used to build the tables */
+static void
+work_gga_x_enhancement(const void *p_, int np, const FLOAT *x, FLOAT *f, FLOAT *dfdx, FLOAT *d2fdx2)
+{
+  XC(gga_x_batch) b;
+  int ip, ib;
+
+  b.order = 2;
+  for(ib = 0; ib < np; ib += b.np){
+    b.np = (np - ib < 2*GGA_BATCH_SIZE) ? np - ib : 2*GGA_BATCH_SIZE;
+
+    for(ip = 0; ip < b.np; ip++)
+      b.x[ip] = x[ib + ip];
+
+    func_batch((const XC(gga_type) *) p_, &b);
+
+    for(ip = 0; ip < b.np; ip++){
+      f     [ib + ip] = b.f[ip];
+      dfdx  [ib + ip] = b.dfdx[ip];
+      d2fdx2[ib + ip] = b.d2fdx2[ip];
+    }
+  }
+}
+
+/* the entries of b listed in miss are evaluated by the functional */
+static void
+work_gga_x_misses(const XC(gga_type) *p, XC(gga_x_batch) *b, int nmiss, const int *miss)
+{
+  XC(gga_x_batch) bm;
+  int ip;
+
+  bm.order = b->order;
+  bm.np    = nmiss;
+  for(ip = 0; ip < nmiss; ip++)
+    bm.x[ip] = b->x[miss[ip]];
+
+  func_batch(p, &bm);
+
+  for(ip = 0; ip < nmiss; ip++){
+    b->f     [miss[ip]] = bm.f[ip];
+    b->dfdx  [miss[ip]] = bm.dfdx[ip];
+    b->d2fdx2[miss[ip]] = bm.d2fdx2[ip];
+  }
+}
+#endif
+
 static void 
 work_gga_x(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
 	   FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
@@ -38,8 +134,14 @@ work_gga_x(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
 {
   const XC(gga_type) *p = p_;
 
-  FLOAT sfact, sfact2, x_factor_c, power, dens;
-  int is, ip, order;
+  XC(gga_x_batch) b;
+  FLOAT sfact, sfact2, x_factor_c, power, dens[GGA_BATCH_SIZE];
+  FLOAT gdm[2*GGA_BATCH_SIZE], rho1D[2*GGA_BATCH_SIZE];
+  int is, ip, ib, nb, idx[2*GGA_BATCH_SIZE], spin[2*GGA_BATCH_SIZE];
+  int ndens, ngrad;
+#if HEADER == 1
+  int nmiss, miss[2*GGA_BATCH_SIZE];
+#endif
 
 #ifndef XC_KINETIC_FUNCTIONAL
   power = 1.0/XC_DIMENSIONS;
@@ -59,93 +161,135 @@ work_gga_x(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma,
   sfact = (p->nspin == XC_POLARIZED) ? 1.0 : 2.0;
   sfact2 = sfact*sfact;
 
-  order = -1;
-  if(zk     != NULL) order = 0;
-  if(vrho   != NULL) order = 1;
-  if(v2rho2 != NULL) order = 2;
-  if(order < 0) return;
+  b.order = -1;
+  if(zk     != NULL) b.order = 0;
+  if(vrho   != NULL) b.order = 1;
+  if(v2rho2 != NULL) b.order = 2;
+  if(b.order < 0) return;
 
-  for(ip = 0; ip < np; ip++){
-    dens = (p->nspin == XC_UNPOLARIZED) ? rho[0] : rho[0] + rho[1];
-    if(dens < MIN_DENS) goto end_ip_loop;
+  for(ib = 0; ib < np; ib += GGA_BATCH_SIZE){
+    nb = (np - ib < GGA_BATCH_SIZE) ? np - ib : GGA_BATCH_SIZE;
 
-    for(is=0; is<p->nspin; is++){
-      FLOAT gdm, ds, rho1D;
-      FLOAT x, f, dfdx, ldfdx, d2fdx2, lvsigma, lv2sigma2, lvsigmax, lvrho;
-      int js = (is == 0) ? 0 : 2;
-      int ks = (is == 0) ? 0 : 5;
+    /* collect the (point, spin) pairs with enough density; idx and spin map them back */
+    b.np = 0;
+    for(ip = 0; ip < nb; ip++){
+      const FLOAT *rr = rho + ip*p->n_rho;
 
-      if(rho[is] < MIN_DENS) continue;
+      dens[ip] = (p->nspin == XC_UNPOLARIZED) ? rr[0] : rr[0] + rr[1];
+      if(dens[ip] < MIN_DENS) continue;
 
-      gdm   = sqrt(sigma[js])/sfact;
-      ds    = rho[is]/sfact;
-      rho1D = POW(ds, power);
-      x     = gdm/(ds*rho1D);
-      
-      dfdx = ldfdx = d2fdx2 = 0.0;
-      lvsigma = lv2sigma2 = lvsigmax = lvrho = 0.0;
+      for(is=0; is<p->nspin; is++){
+	if(rr[is] < MIN_DENS) continue;
 
-#if   HEADER == 1
-      func(p, order, x, &f, &dfdx, &ldfdx, &d2fdx2);
-#elif HEADER == 2
-      /* this second header is useful for functionals that depend
-	 explicitly both on x and on sigma */
-      func(p, order, x, gdm*gdm, &f, &dfdx, &ldfdx, &lvsigma, &d2fdx2, &lv2sigma2, &lvsigmax);
-      
-      lvsigma   /= sfact2;
-      lvsigmax  /= sfact2;
-      lv2sigma2 /= sfact2*sfact2;
-#elif HEADER == 3
-      /* this second header is useful for functionals that depend
-	 explicitly both on x and on rho*/
-      func(p, order, x, ds, &f, &dfdx, &lvrho);
+	idx [b.np] = ip;
+	spin[b.np] = is;
+	gdm [b.np] = SQRT(sigma[ip*p->n_sigma + ((is == 0) ? 0 : 2)])/sfact;
+	b.ds[b.np] = rr[is]/sfact;
+	b.np++;
+      }
+    }
+
+    if(p->stats != NULL){
+      for(ip = 0, ndens = 0; ip < nb;   ip++) ndens += (dens[ip] < MIN_DENS);
+      for(ip = 0, ngrad = 0; ip < b.np; ip++) ngrad += (gdm[ip] <= MIN_GRAD);
+      XC(stats_screened)(p->stats, ndens, ngrad);
+    }
+
+    XC(vpow)(b.np, b.ds, power, rho1D);
+    for(ip = 0; ip < b.np; ip++){
+      b.x[ip]     = gdm[ip]/(b.ds[ip]*rho1D[ip]);
+      b.sigma[ip] = gdm[ip]*gdm[ip];
+    }
+
+#if HEADER == 1
+    if(b.np > 0 && p->x_table != NULL){
+      nmiss = XC(gga_x_table_eval)(p, &b, miss);
+      if(nmiss > 0)
+	work_gga_x_misses(p, &b, nmiss, miss);
+    }else
 #endif
+    if(b.np > 0)
+      func_batch(p, &b);
 
-      if(zk != NULL && (p->info->flags & XC_FLAGS_HAVE_EXC))
-	*zk += sfact*x_factor_c*(ds*rho1D)*f;
-      
-      if(vrho != NULL && (p->info->flags & XC_FLAGS_HAVE_VXC)){
-	vrho[is] += (power + 1.0)*x_factor_c*rho1D*(f - dfdx*x)
-	  + x_factor_c*(ds*rho1D)*lvrho;
-	
-	if(gdm>MIN_GRAD)
-	  vsigma[js] = sfact*x_factor_c*(ds*rho1D)*(lvsigma + dfdx*x/(2.0*sigma[js]));
+#if HEADER == 2
+    for(ip = 0; ip < b.np; ip++){
+      b.lvsigma[ip]   /= sfact2;
+      b.lvsigmax[ip]  /= sfact2;
+      b.lv2sigma2[ip] /= sfact2*sfact2;
+    }
+#endif
+
+    if(zk != NULL && (p->info->flags & XC_FLAGS_HAVE_EXC)){
+      for(ip = 0; ip < b.np; ip++)
+	zk[idx[ip]*p->n_zk] += sfact*x_factor_c*(b.ds[ip]*rho1D[ip])*b.f[ip];
+
+      for(ip = 0; ip < nb; ip++)
+	if(dens[ip] >= MIN_DENS)
+	  zk[ip*p->n_zk] /= dens[ip]; /* we want energy per particle */
+    }
+
+    if(vrho != NULL && (p->info->flags & XC_FLAGS_HAVE_VXC)){
+      for(ip = 0; ip < b.np; ip++){
+	int js = (spin[ip] == 0) ? 0 : 2;
+	FLOAT sg = sigma[idx[ip]*p->n_sigma + js];
+	FLOAT lvsigma = 0.0;
+
+	vrho[idx[ip]*p->n_vrho + spin[ip]] += (power + 1.0)*x_factor_c*rho1D[ip]*(b.f[ip] - b.dfdx[ip]*b.x[ip])
+#if HEADER == 3
+	  + x_factor_c*(b.ds[ip]*rho1D[ip])*b.lvrho[ip]
+#endif
+	  ;
+
+#if HEADER == 2
+	lvsigma = b.lvsigma[ip];
+#endif
+	if(gdm[ip]>MIN_GRAD)
+	  vsigma[idx[ip]*p->n_vsigma + js] = sfact*x_factor_c*(b.ds[ip]*rho1D[ip])*(lvsigma + b.dfdx[ip]*b.x[ip]/(2.0*sg));
       }
-      
-      if(v2rho2 != NULL && (p->info->flags & XC_FLAGS_HAVE_FXC)){
-	v2rho2[js] = power*(power + 1.0)*x_factor_c*rho1D/ds*
-	  (f - dfdx*x + (power + 1.0)/power*d2fdx2*x*x)/sfact;
+    }
+
+    if(v2rho2 != NULL && (p->info->flags & XC_FLAGS_HAVE_FXC)){
+      for(ip = 0; ip < b.np; ip++){
+	int js = (spin[ip] == 0) ? 0 : 2;
+	int ks = (spin[ip] == 0) ? 0 : 5;
+	FLOAT sg = sigma[idx[ip]*p->n_sigma + js];
+	FLOAT x = b.x[ip], ds = b.ds[ip], dfdx = b.dfdx[ip], d2fdx2 = b.d2fdx2[ip];
+	FLOAT lvsigma = 0.0, lv2sigma2 = 0.0, lvsigmax = 0.0;
+
+#if HEADER == 2
+	lvsigma   = b.lvsigma[ip];
+	lv2sigma2 = b.lv2sigma2[ip];
+	lvsigmax  = b.lvsigmax[ip];
+#endif
+
+	v2rho2[idx[ip]*p->n_v2rho2 + js] = power*(power + 1.0)*x_factor_c*rho1D[ip]/ds*
+	  (b.f[ip] - dfdx*x + (power + 1.0)/power*d2fdx2*x*x)/sfact;
 	
-	if(gdm>MIN_GRAD){
-	  v2rhosigma[ks] = (power + 1.0)*x_factor_c*rho1D *
-	    (lvsigma - lvsigmax*x - d2fdx2*x*x/(2.0*sigma[js]));
-	  v2sigma2  [ks] = sfact*x_factor_c*(ds*rho1D)*
-	    (lv2sigma2 + lvsigmax*x/sigma[js] + (d2fdx2*x - dfdx)*x/(4.0*sigma[js]*sigma[js]));
+	if(gdm[ip]>MIN_GRAD){
+	  v2rhosigma[idx[ip]*p->n_v2rhosigma + ks] = (power + 1.0)*x_factor_c*rho1D[ip] *
+	    (lvsigma - lvsigmax*x - d2fdx2*x*x/(2.0*sg));
+	  v2sigma2  [idx[ip]*p->n_v2sigma2 + ks] = sfact*x_factor_c*(ds*rho1D[ip])*
+	    (lv2sigma2 + lvsigmax*x/sg + (d2fdx2*x - dfdx)*x/(4.0*sg*sg));
 	}
-	
       }
     }
 
-    if(zk != NULL && (p->info->flags & XC_FLAGS_HAVE_EXC))
-      *zk /= dens; /* we want energy per particle */
-    
-  end_ip_loop:
-    /* increment pointers */
-    rho   += p->n_rho;
-    sigma += p->n_sigma;
+    /* advance to the next block */
+    rho   += nb*p->n_rho;
+    sigma += nb*p->n_sigma;
     
     if(zk != NULL)
-      zk += p->n_zk;
+      zk += nb*p->n_zk;
     
     if(vrho != NULL){
-      vrho   += p->n_vrho;
-      vsigma += p->n_vsigma;
+      vrho   += nb*p->n_vrho;
+      vsigma += nb*p->n_vsigma;
     }
 
     if(v2rho2 != NULL){
-      v2rho2     += p->n_v2rho2;
-      v2rhosigma += p->n_v2rhosigma;
-      v2sigma2   += p->n_v2sigma2;
+      v2rho2     += nb*p->n_v2rho2;
+      v2rhosigma += nb*p->n_v2rhosigma;
+      v2sigma2   += nb*p->n_v2sigma2;
     }
   }
 }
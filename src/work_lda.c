@@ -21,123 +21,230 @@
   functionals are written as a function of rs and zeta, this
   routine performs the necessary conversions between this and a functional
   of rho.
+
+  The points are handled in blocks of LDA_BATCH_SIZE. Functionals that
+  define FUNC_BATCH provide
+
+    func_batch(const XC(lda_type) *p, XC(lda_rs_zeta_batch) *b)
+
+  that fills the arrays of b for the b->np points of the block. All
+  the others provide the single point version
+
+    func(const XC(lda_type) *p, XC(lda_rs_zeta) *r)
+
+  which is called point by point.
+
+  The input and output arrays are read and written directly in the
+  memory layout of p (see XC(func_set_layout)). Every requested output
+  is written once, so the caller does not need to clear the arrays.
+
+  If p carries a spline table (see lda_table.c), the blocks are
+  evaluated from it instead of calling func_batch.
 ************************************************************************/
 
 #ifndef XC_DIMENSIONS
 #define XC_DIMENSIONS 3
 #endif
 
+#ifndef FUNC_BATCH
+static void
+func_batch(const XC(lda_type) *p, XC(lda_rs_zeta_batch) *b)
+{
+  XC(lda_rs_zeta) r = {0};               /* func only fills the derivatives up to r.order */
+  int ip;
+
+  r.order = b->order;
+  for(ip=0; ip<b->np; ip++){
+    r.rs[0] = b->rs[0][ip];
+    r.rs[1] = b->rs[1][ip];
+    r.rs[2] = b->rs[2][ip];
+    r.zeta  = b->zeta[ip];
+
+    func(p, &r);
+
+    b->zk[ip] = r.zk;
+    if(r.order < 1) continue;
+
+    b->dedrs[ip] = r.dedrs;
+    if(p->nspin == XC_POLARIZED) b->dedz[ip] = r.dedz;
+    if(r.order < 2) continue;
+
+    b->d2edrs2[ip] = r.d2edrs2;
+    if(p->nspin == XC_POLARIZED){
+      b->d2edrsz[ip] = r.d2edrsz;
+      b->d2edz2 [ip] = r.d2edz2;
+    }
+    if(r.order < 3) continue;
+
+    b->d3edrs3[ip] = r.d3edrs3;
+    if(p->nspin == XC_POLARIZED){
+      b->d3edrs2z[ip] = r.d3edrs2z;
+      b->d3edrsz2[ip] = r.d3edrsz2;
+      b->d3edz3  [ip] = r.d3edz3;
+    }
+  }
+}
+#endif
+
 static void 
 work_lda(const void *p_, int np, const FLOAT *rho, 
 	 FLOAT *zk, FLOAT *vrho, FLOAT *v2rho2, FLOAT *v3rho3)
 {
   const XC(lda_type) *p = p_;
 
-  XC(lda_rs_zeta) r;
-  int is, ip;
-  FLOAT cnst_rs, dens, drs, d2rs, d3rs;
-
-  r.order = -1;
-  if(zk     != NULL) r.order = 0;
-  if(vrho   != NULL) r.order = 1;
-  if(v2rho2 != NULL) r.order = 2;
-  if(v3rho3 != NULL) r.order = 3;
-  if(r.order < 0) return;
-
-  for(ip = 0; ip < np; ip++){
-    XC(rho2dzeta)(p->nspin, rho, &dens, &r.zeta);
-
-    if(dens < MIN_DENS) goto end_ip_loop;
+  XC(lda_rs_zeta_batch) b;
+  int is, ip, ib, nb, idx[LDA_BATCH_SIZE];
+  size_t s_rho, s_zk, s_vrho, s_v2rho2, s_v3rho3; /* point strides     */
+  size_t c_rho, c_vrho, c_v2rho2, c_v3rho3;        /* component strides */
+  FLOAT cnst_rs, dens[LDA_BATCH_SIZE], drs, d2rs, d3rs;
+
+  b.order = -1;
+  if(zk     != NULL) b.order = 0;
+  if(vrho   != NULL) b.order = 1;
+  if(v2rho2 != NULL) b.order = 2;
+  if(v3rho3 != NULL) b.order = 3;
+  if(b.order < 0) return;
+
+  s_rho    = PT_STRIDE(p->layout, rho,    p->n_rho);    c_rho    = CMP_STRIDE(p->layout, rho);
+  s_zk     = PT_STRIDE(p->layout, zk,     p->n_zk);
+  s_vrho   = PT_STRIDE(p->layout, vrho,   p->n_vrho);   c_vrho   = CMP_STRIDE(p->layout, vrho);
+  s_v2rho2 = PT_STRIDE(p->layout, v2rho2, p->n_v2rho2); c_v2rho2 = CMP_STRIDE(p->layout, v2rho2);
+  s_v3rho3 = PT_STRIDE(p->layout, v3rho3, p->n_v3rho3); c_v3rho3 = CMP_STRIDE(p->layout, v3rho3);
 
   /* Wigner radius */
 # if   XC_DIMENSIONS == 1
-    cnst_rs = 1.0/2.0;
+  cnst_rs = 1.0/2.0;
 # elif XC_DIMENSIONS == 2
-    cnst_rs = 1.0/sqrt(M_PI);
+  cnst_rs = 1.0/SQRT(M_PI);
 # else /* three dimensions */
-    cnst_rs = POW(3.0/(4*M_PI), 1.0/3.0);
+  cnst_rs = RS_FACTOR;
 # endif
 
-    r.rs[1] = cnst_rs*POW(dens, -1.0/XC_DIMENSIONS);
-    r.rs[0] = sqrt(r.rs[1]);
-    r.rs[2] = r.rs[1]*r.rs[1];
+  for(ib = 0; ib < np; ib += LDA_BATCH_SIZE){
+    nb = (np - ib < LDA_BATCH_SIZE) ? np - ib : LDA_BATCH_SIZE;
+
+    /* keep only the points with enough density; idx maps them back to the block */
+    b.np = 0;
+    for(ip = 0; ip < nb; ip++){
+      FLOAT rr[2];
+
+      rr[0] = rho[ip*s_rho];
+      if(p->nspin == XC_POLARIZED) rr[1] = rho[ip*s_rho + c_rho];
+
+      XC(rho2dzeta)(p->nspin, rr, &dens[b.np], &b.zeta[b.np]);
+      if(dens[b.np] < MIN_DENS){
+	/* every output is written exactly once, so these get explicit zeros */
+	if(zk != NULL)
+	  zk[ip*s_zk] = 0.0;
+	if(vrho != NULL)
+	  for(is=0; is<p->n_vrho; is++)   vrho  [ip*s_vrho   + is*c_vrho]   = 0.0;
+	if(v2rho2 != NULL)
+	  for(is=0; is<p->n_v2rho2; is++) v2rho2[ip*s_v2rho2 + is*c_v2rho2] = 0.0;
+	if(v3rho3 != NULL)
+	  for(is=0; is<p->n_v3rho3; is++) v3rho3[ip*s_v3rho3 + is*c_v3rho3] = 0.0;
+	continue;
+      }
 
-    func(p, &r);
+      idx[b.np++] = ip;
+    }
+    STATS_SCREENED(p, nb - b.np, 0);
 
-    if(zk != NULL && (p->info->flags & XC_FLAGS_HAVE_EXC))
-      *zk = r.zk;
+    XC(vpow)(b.np, dens, -1.0/XC_DIMENSIONS, b.rs[1]);
+    for(ip = 0; ip < b.np; ip++){
+      b.rs[1][ip] *= cnst_rs;
+      b.rs[0][ip] = SQRT(b.rs[1][ip]);
+      b.rs[2][ip] = b.rs[1][ip]*b.rs[1][ip];
+    }
 
-    if(r.order < 1) goto end_ip_loop;
+    /* a point outside of the table sends the whole block to the functional */
+    if(b.np > 0 && (p->table == NULL || !XC(lda_table_eval)(p, &b)))
+      func_batch(p, &b);
+
+    if(zk != NULL && (p->info->flags & XC_FLAGS_HAVE_EXC))
+      for(ip = 0; ip < b.np; ip++)
+	zk[idx[ip]*s_zk] = b.zk[ip];
 
-    drs = -r.rs[1]/(XC_DIMENSIONS*dens);
-    
     if(vrho != NULL && (p->info->flags & XC_FLAGS_HAVE_VXC)){
-      vrho[0] = r.zk + dens*r.dedrs*drs;
+      for(ip = 0; ip < b.np; ip++){
+	FLOAT *v = vrho + idx[ip]*s_vrho;
+
+	drs  = -b.rs[1][ip]/(XC_DIMENSIONS*dens[ip]);
+	v[0] = b.zk[ip] + dens[ip]*b.dedrs[ip]*drs;
 
-      if(p->nspin == XC_POLARIZED){
-	vrho[1] = vrho[0] - (r.zeta + 1.0)*r.dedz;
-	vrho[0] = vrho[0] - (r.zeta - 1.0)*r.dedz;
+	if(p->nspin == XC_POLARIZED){
+	  v[c_vrho] = v[0] - (b.zeta[ip] + 1.0)*b.dedz[ip];
+	  v[0] = v[0] - (b.zeta[ip] - 1.0)*b.dedz[ip];
+	}
       }
     }
-  
-    if(r.order < 2) goto end_ip_loop;
-    
-    d2rs = -drs*(1.0 + XC_DIMENSIONS)/(XC_DIMENSIONS*dens);
-    
+
     if(v2rho2 != NULL && (p->info->flags & XC_FLAGS_HAVE_FXC)){
-      v2rho2[0] = r.dedrs*(2.0*drs + dens*d2rs) + dens*r.d2edrs2*drs*drs;
+      for(ip = 0; ip < b.np; ip++){
+	FLOAT *v2 = v2rho2 + idx[ip]*s_v2rho2;
+
+	drs  = -b.rs[1][ip]/(XC_DIMENSIONS*dens[ip]);
+	d2rs = -drs*(1.0 + XC_DIMENSIONS)/(XC_DIMENSIONS*dens[ip]);
+
+	v2[0] = b.dedrs[ip]*(2.0*drs + dens[ip]*d2rs) + dens[ip]*b.d2edrs2[ip]*drs*drs;
       
-      if(p->nspin == XC_POLARIZED){
-	FLOAT sign[3][2] = {{-1.0, -1.0}, {-1.0, +1.0}, {+1.0, +1.0}};
-	
-	for(is=2; is>=0; is--){
-	  v2rho2[is] = v2rho2[0] - r.d2edrsz*(2.0*r.zeta + sign[is][0] + sign[is][1])*drs
-	    + (r.zeta + sign[is][0])*(r.zeta + sign[is][1])*r.d2edz2/dens;
+	if(p->nspin == XC_POLARIZED){
+	  FLOAT sign[3][2] = {{-1.0, -1.0}, {-1.0, +1.0}, {+1.0, +1.0}};
+	  FLOAT zeta = b.zeta[ip];
+	  
+	  for(is=2; is>=0; is--){
+	    v2[is*c_v2rho2] = v2[0] - b.d2edrsz[ip]*(2.0*zeta + sign[is][0] + sign[is][1])*drs
+	      + (zeta + sign[is][0])*(zeta + sign[is][1])*b.d2edz2[ip]/dens[ip];
+	  }
 	}
       }
     }
-    
-    if(r.order < 3) goto end_ip_loop;
 
-    d3rs = -d2rs*(1.0 + 2.0*XC_DIMENSIONS)/(XC_DIMENSIONS*dens);
-    
     if(v3rho3 != NULL && (p->info->flags & XC_FLAGS_HAVE_KXC)){
-      v3rho3[0] = r.dedrs*(3.0*d2rs + dens*d3rs) + 
-	3.0*r.d2edrs2*drs*(drs + dens*d2rs) + r.d3edrs3*dens*drs*drs*drs;
+      for(ip = 0; ip < b.np; ip++){
+	FLOAT *v3 = v3rho3 + idx[ip]*s_v3rho3;
+	FLOAT dd = dens[ip];
+
+	drs  = -b.rs[1][ip]/(XC_DIMENSIONS*dd);
+	d2rs = -drs*(1.0 + XC_DIMENSIONS)/(XC_DIMENSIONS*dd);
+	d3rs = -d2rs*(1.0 + 2.0*XC_DIMENSIONS)/(XC_DIMENSIONS*dd);
+
+	v3[0] = b.dedrs[ip]*(3.0*d2rs + dd*d3rs) + 
+	  3.0*b.d2edrs2[ip]*drs*(drs + dd*d2rs) + b.d3edrs3[ip]*dd*drs*drs*drs;
       
-      if(p->nspin == XC_POLARIZED){
-	FLOAT sign[4][3] = {{-1.0, -1.0, -1.0}, {-1.0, -1.0, +1.0}, {-1.0, +1.0, +1.0}, {+1.0, +1.0, +1.0}};
+	if(p->nspin == XC_POLARIZED){
+	  FLOAT sign[4][3] = {{-1.0, -1.0, -1.0}, {-1.0, -1.0, +1.0}, {-1.0, +1.0, +1.0}, {+1.0, +1.0, +1.0}};
+	  FLOAT zeta = b.zeta[ip];
 	
-	for(is=3; is>=0; is--){
-	  FLOAT ff;
+	  for(is=3; is>=0; is--){
+	    FLOAT ff;
 	  
-	  v3rho3[is]  = v3rho3[0] - (2.0*r.zeta  + sign[is][0] + sign[is][1])*(d2rs*r.d2edrsz + drs*drs*r.d3edrs2z);
-	  v3rho3[is] += (r.zeta + sign[is][0])*(r.zeta + sign[is][1])*(-r.d2edz2/dens + r.d3edrsz2*drs)/dens;
+	    v3[is*c_v3rho3]  = v3[0] - (2.0*zeta  + sign[is][0] + sign[is][1])*(d2rs*b.d2edrsz[ip] + drs*drs*b.d3edrs2z[ip]);
+	    v3[is*c_v3rho3] += (zeta + sign[is][0])*(zeta + sign[is][1])*(-b.d2edz2[ip]/dd + b.d3edrsz2[ip]*drs)/dd;
 	  
-	  ff  = r.d2edrsz*(2.0*drs + dens*d2rs) + dens*r.d3edrs2z*drs*drs;
-	  ff += -2.0*r.d2edrsz*drs - r.d3edrsz2*(2.0*r.zeta + sign[is][0] + sign[is][1])*drs;
-	  ff += (r.zeta + sign[is][0])*(r.zeta + sign[is][1])*r.d3edz3/dens;
-	  ff += (2.0*r.zeta  + sign[is][0] + sign[is][1])*r.d2edz2/dens;
+	    ff  = b.d2edrsz[ip]*(2.0*drs + dd*d2rs) + dd*b.d3edrs2z[ip]*drs*drs;
+	    ff += -2.0*b.d2edrsz[ip]*drs - b.d3edrsz2[ip]*(2.0*zeta + sign[is][0] + sign[is][1])*drs;
+	    ff += (zeta + sign[is][0])*(zeta + sign[is][1])*b.d3edz3[ip]/dd;
+	    ff += (2.0*zeta  + sign[is][0] + sign[is][1])*b.d2edz2[ip]/dd;
 	  
-	  v3rho3[is] += -ff*(r.zeta + sign[is][2])/dens;
+	    v3[is*c_v3rho3] += -ff*(zeta + sign[is][2])/dd;
+	  }
 	}
       }
     }
 
-  end_ip_loop:
-    rho += p->n_rho;
+    /* advance to the next block */
+    rho += nb*s_rho;
 
     if(zk != NULL)
-      zk += p->n_zk;
+      zk += nb*s_zk;
     
     if(vrho != NULL)
-      vrho += p->n_vrho;
+      vrho += nb*s_vrho;
 
     if(v2rho2 != NULL)
-      v2rho2 += p->n_v2rho2;
+      v2rho2 += nb*s_v2rho2;
 
     if(v3rho3 != NULL)
-      v3rho3 += p->n_v3rho3;
-
-  } /* for(ip) */
+      v3rho3 += nb*s_v3rho3;
+  }
 }
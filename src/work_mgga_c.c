@@ -29,10 +29,10 @@ work_mgga_c_init(void *p_)
   XC(mgga_type) *p = (XC(mgga_type) *)p_;
 
   p->n_func_aux  = 1;
-  p->func_aux    = (XC(func_type) **) malloc(sizeof(XC(func_type) *)*p->n_func_aux);
-  p->func_aux[0] = (XC(func_type) *)  malloc(sizeof(XC(func_type)));
+  p->func_aux    = (XC(func_type) **) XC(arena_alloc)(p->arena, sizeof(XC(func_type) *)*p->n_func_aux);
+  p->func_aux[0] = (XC(func_type) *)  XC(arena_alloc)(p->arena, sizeof(XC(func_type)));
 
-  XC(func_init)(p->func_aux[0], XC_LDA_C_PW, XC_POLARIZED);
+  XC(func_init_aux)(p->func_aux[0], XC_LDA_C_PW, XC_POLARIZED, p->arena);
 }
 
 
@@ -44,8 +44,13 @@ work_mgga_c(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma, const
   const XC(mgga_type) *p = p_;
 
   FLOAT sfact, sfact2, dens;
-  FLOAT ds[2], sigmas[2], x[2], t[2], u[2], f_LDA[2], vrho_LDA[2];
-  int ip, is, order;
+  FLOAT ds[2], ds53[2], sigmas[2], x[2], t[2], u[2], f_LDA[2], vrho_LDA[2];
+  int ip, ib, nb, is, order;
+
+  /* spin-polarized LDA for the whole block: total density (opp) and
+     each spin alone (par), the latter stored at index ip*nspin + is */
+  FLOAT rho_opp[2*GGA_BATCH_SIZE], e_opp[GGA_BATCH_SIZE], v_opp[2*GGA_BATCH_SIZE];
+  FLOAT rho_par[4*GGA_BATCH_SIZE], e_par[2*GGA_BATCH_SIZE], v_par[4*GGA_BATCH_SIZE];
 
   order = -1;
   if(zk     != NULL) order = 0;
@@ -57,6 +62,31 @@ work_mgga_c(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma, const
   sfact2 = sfact*sfact;
 
   for(ip = 0; ip < np; ip++){
+    ib = ip % GGA_BATCH_SIZE;
+
+    if(ib == 0 && p->stats != NULL)
+      XC(stats_screen_block)(p->stats, p->nspin, min(np - ip, GGA_BATCH_SIZE), rho, p->n_rho, sigma, p->n_sigma);
+
+    if(ib == 0 && order < 2){ /* get the spin-polarized LDAs of the next block */
+      int jp;
+
+      nb = min(np - ip, GGA_BATCH_SIZE);
+      for(jp=0; jp<nb; jp++){
+	const FLOAT *rr = rho + jp*p->n_rho;
+
+	for(is=0; is<2; is++)
+	  rho_opp[2*jp + is] = (p->nspin == XC_POLARIZED) ? rr[is] : rr[0]/2.0;
+
+	for(is=0; is<p->nspin; is++){
+	  rho_par[2*(jp*p->nspin + is)    ] = rho_opp[2*jp + is];
+	  rho_par[2*(jp*p->nspin + is) + 1] = 0.0;
+	}
+      }
+
+      XC(lda)(p->func_aux[0], nb, rho_opp, e_opp, (order > 0) ? v_opp : NULL, NULL, NULL);
+      XC(lda)(p->func_aux[0], nb*p->nspin, rho_par, e_par, (order > 0) ? v_par : NULL, NULL, NULL);
+    }
+
     dens = (p->nspin == XC_UNPOLARIZED) ? rho[0] : rho[0] + rho[1];
     if(dens < MIN_DENS) goto end_ip_loop;
 
@@ -73,16 +103,17 @@ work_mgga_c(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma, const
       if(rho[is] < MIN_DENS) continue;
 
       sigmas[is] = max(MIN_GRAD*MIN_GRAD, sigma[js]/sfact2);
-      gdm        = sqrt(sigmas[is]);
+      gdm        = SQRT(sigmas[is]);
   
-      rho13  = POW(ds[is], 1.0/3.0);
-      x [is] = gdm/(ds[is]*rho13);
+      rho13    = CBRT(ds[is]);
+      ds53[is] = POW_5_3(ds[is], rho13);
+      x [is]   = gdm/POW_4_3(ds[is], rho13);
     
       ltau   = max(tau[is]/sfact, MIN_TAU);
-      t [is] = ltau/(ds[is]*rho13*rho13);  /* tau/rho^(5/3) */
+      t [is] = ltau/ds53[is];  /* tau/rho^(5/3) */
 
       lnr2   = max(MIN_TAU, lapl_rho[is]/sfact);
-      u [is] = lnr2/(ds[is]*rho13*rho13);  /* lapl_rho/rho^(5/3) */
+      u [is] = lnr2/ds53[is];  /* lapl_rho/rho^(5/3) */
 
       dfdx  = d2fdx2 = 0.0;
       dfdt = dfdu = 0.0;
@@ -90,23 +121,10 @@ work_mgga_c(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma, const
       func_c_parallel(p, x[is], t[is], u[is], order, 
 		      &f, &dfdx, &dfdt, &dfdu, &d2fdx2, &d2fdxt, &d2fdt2);
 
-      { /* get parallel spin LDA energy */
-	FLOAT tmp_rho[2], tmp_vrho[2];
-
-	tmp_rho[0] = ds[is];
-	tmp_rho[1] = 0.0;
-
-	switch (order){
-	case 0:
-	  XC(lda_exc)(p->func_aux[0], 1, tmp_rho, &(f_LDA[is]));
-	  break;
-	case 1:
-	  XC(lda_exc_vxc)(p->func_aux[0], 1, tmp_rho, &(f_LDA[is]), tmp_vrho);
-	  vrho_LDA[is] = tmp_vrho[0];
-	  break;
-	case 2: /* to be implemented */
-	  break; 
-	}
+      /* parallel spin LDA energy */
+      if(order < 2){
+	f_LDA[is] = e_par[ib*p->nspin + is];
+	if(order > 0) vrho_LDA[is] = v_par[2*(ib*p->nspin + is)];
       }
 
       if(zk != NULL)
@@ -134,15 +152,11 @@ work_mgga_c(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma, const
       FLOAT f, dfdx, dfdt, dfdu, d2fdx2, d2fdxt, d2fdt2;
       FLOAT xt, tt, uu;
 
-      switch (order){
-      case 0:
-	XC(lda_exc)(p->func_aux[0], 1, ds, &f_LDA_opp);
-	break;
-      case 1:
-	XC(lda_exc_vxc)(p->func_aux[0], 1, ds, &f_LDA_opp, vrho_LDA_opp);
-	break;
-      case 2: /* to be implemented */
-	break; 
+      /* order 2 is to be implemented */
+      f_LDA_opp = e_opp[ib];
+      if(order > 0){
+	vrho_LDA_opp[0] = v_opp[2*ib];
+	vrho_LDA_opp[1] = v_opp[2*ib + 1];
       }
       
       if(p->nspin == XC_POLARIZED){
@@ -153,9 +167,9 @@ work_mgga_c(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma, const
 	    tt += t[is];
 	    uu += u[is];
 	  }
-	xt = sqrt(xt);
+	xt = SQRT(xt);
       }else{
-	xt = sqrt(2.0)*x[0];
+	xt = SQRT(2.0)*x[0];
 	tt =      2.0 *t[0];
 	uu =      2.0 *u[0];
       }
@@ -174,8 +188,8 @@ work_mgga_c(const void *p_, int np, const FLOAT *rho, const FLOAT *sigma, const
 	  
 	  vrho[is]      += vrho_LDA_opp[is]*f - dens*f_LDA_opp*
 	    (4.0*dfdx*x[is]*x[is]/xt + 5.0*(dfdt*t[is] + dfdu*u[is]))/(3.0*ds[is]);
-	  vtau[is]      += f_LDA_opp*dfdt*dens/POW(ds[is], 5.0/3.0);
-	  vlapl_rho[is] += f_LDA_opp*dfdu*dens/POW(ds[is], 5.0/3.0);
+	  vtau[is]      += f_LDA_opp*dfdt*dens/ds53[is];
+	  vlapl_rho[is] += f_LDA_opp*dfdu*dens/ds53[is];
 	  vsigma[js] += dens*f_LDA_opp*dfdx*x[is]*x[is]/(2.0*xt*sfact*sigmas[is]);
 	}
       }
@@ -29,6 +29,46 @@
 #  define XC_DIMENSIONS 3
 #endif
 
+/************************************************************************
+  Functionals that define FUNC_PREPARE provide
+
+    func_prepare(p, n, x, t, u, aux)
+
+  which gets the variables x, t and u of the n (point, spin) pairs of a
+  block of MGGA_X_BATCH_SIZE points that are not screened, and computes
+  for all of them at once an auxiliary quantity aux, that is then passed
+  as the second argument of func.
+************************************************************************/
+
+/* the variables x, t and u of spin channel is; returns 0 if it is screened */
+static inline int
+work_mgga_x_vars(const XC(mgga_type) *p, int has_tail, FLOAT sfact, int is,
+		 const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
+		 FLOAT *gdm, FLOAT *ds, FLOAT *rho1D, FLOAT *x, FLOAT *t, FLOAT *u)
+{
+  FLOAT ltau, lnr2;
+  int js = (is == 0) ? 0 : 2;
+
+  if((!has_tail && (rho[is] < MIN_DENS || tau[is] < MIN_TAU)) || (rho[is] == 0.0)) return 0;
+
+  *gdm   = SQRT(sigma[js])/sfact;
+  *ds    = rho[is]/sfact;
+# if XC_DIMENSIONS == 3
+  *rho1D = CBRT(*ds);
+# else
+  *rho1D = POW(*ds, 1.0/XC_DIMENSIONS);
+# endif
+  *x     = *gdm/(*ds * *rho1D);
+    
+  ltau   = tau[is]/sfact;
+  *t     = ltau/(*ds * *rho1D * *rho1D);  /* tau/rho^((2+D)/D) */
+
+  lnr2   = lapl_rho[is]/sfact;            /* this can be negative */
+  *u     = lnr2/(*ds * *rho1D * *rho1D);  /* lapl_rho/rho^((2+D)/D) */
+
+  return 1;
+}
+
 static void 
 work_mgga_x(const void *p_, int np,
 	    const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
@@ -38,9 +78,15 @@ work_mgga_x(const void *p_, int np,
   const XC(mgga_type) *p = p_;
 
   FLOAT sfact, sfact2, dens, x_factor_c;
-  int is, ip, order;
+  int is, ip, ib, nb, order;
   int has_tail;
 
+#ifdef FUNC_PREPARE
+  FLOAT px[2*MGGA_X_BATCH_SIZE], pt[2*MGGA_X_BATCH_SIZE], pu[2*MGGA_X_BATCH_SIZE], aux[2*MGGA_X_BATCH_SIZE];
+  FLOAT gdm, ds, rho1D;
+  int iprep[2*MGGA_X_BATCH_SIZE], nprep;
+#endif
+
   #if XC_DIMENSIONS == 2
   x_factor_c = X_FACTOR_2D_C;
   #else /* three dimensions */
@@ -66,76 +112,99 @@ work_mgga_x(const void *p_, int np,
     break;
   }
   
-  for(ip = 0; ip < np; ip++){
-    dens = (p->nspin == XC_UNPOLARIZED) ? rho[0] : rho[0] + rho[1];
-    if(dens < MIN_DENS) goto end_ip_loop;
+  for(ib = 0; ib < np; ib += MGGA_X_BATCH_SIZE){
+    nb = min(np - ib, MGGA_X_BATCH_SIZE);
 
-    for(is=0; is<p->nspin; is++){
-      FLOAT gdm, ds, rho1D;
-      FLOAT x, t, u, f, lnr2, ltau, vrho0, dfdx, dfdt, dfdu, d2fdx2, d2fdxt, d2fdt2;
-      int js = (is == 0) ? 0 : 2;
+    if(p->stats != NULL)
+      XC(stats_screen_block)(p->stats, p->nspin, nb, rho, p->n_rho, sigma, p->n_sigma);
 
-      if((!has_tail && (rho[is] < MIN_DENS || tau[is] < MIN_TAU)) || (rho[is] == 0.0)) continue;
+#ifdef FUNC_PREPARE
+    /* first pass over the block, for func_prepare */
+    nprep = 0;
+    for(ip = 0; ip < nb; ip++){
+      const FLOAT *rho_ip = rho + ip*p->n_rho;
 
-      gdm   = sqrt(sigma[js])/sfact;
-      ds    = rho[is]/sfact;
-      rho1D = POW(ds, 1.0/XC_DIMENSIONS);
-      x     = gdm/(ds*rho1D);
-    
-      ltau  = tau[is]/sfact;
-      t     = ltau/(ds*rho1D*rho1D);  /* tau/rho^((2+D)/D) */
+      dens = (p->nspin == XC_UNPOLARIZED) ? rho_ip[0] : rho_ip[0] + rho_ip[1];
 
-      lnr2  = lapl_rho[is]/sfact;     /* this can be negative */
-      u     = lnr2/(ds*rho1D*rho1D);  /* lapl_rho/rho^((2+D)/D) */
+      for(is=0; is<p->nspin; is++){
+	iprep[2*ip + is] = -1;
 
-      vrho0 = dfdx = dfdt = dfdu = 0.0;
-      d2fdx2 = d2fdxt = d2fdt2 = 0.0;
+	if(dens < MIN_DENS || !work_mgga_x_vars(p, has_tail, sfact, is, rho_ip, sigma + ip*p->n_sigma,
+						lapl_rho + ip*p->n_lapl_rho, tau + ip*p->n_tau,
+						&gdm, &ds, &rho1D, &px[nprep], &pt[nprep], &pu[nprep])) continue;
 
-      func(p, x, t, u, order, &f, &vrho0,
-	   &dfdx, &dfdt, &dfdu, &d2fdx2, &d2fdxt, &d2fdt2);
+	iprep[2*ip + is] = nprep++;
+      }
+    }
+    func_prepare(p, nprep, px, pt, pu, aux);
+#endif
 
-      if(zk != NULL && (p->info->flags & XC_FLAGS_HAVE_EXC))
-	*zk += -sfact*x_factor_c*(ds*rho1D)*f;
+    for(ip = 0; ip < nb; ip++){
+      dens = (p->nspin == XC_UNPOLARIZED) ? rho[0] : rho[0] + rho[1];
+      if(dens < MIN_DENS) goto end_ip_loop;
 
-      if(vrho != NULL && (p->info->flags & XC_FLAGS_HAVE_VXC)){
-	vrho[is]      = -x_factor_c*rho1D*(vrho0 + 4.0/3.0*(f - dfdx*x) - 5.0/3.0*(dfdt*t + dfdu*u));
-	vtau[is]      = -x_factor_c*dfdt/rho1D;
-	vlapl_rho[is] = -x_factor_c*dfdu/rho1D;
-	if(gdm>MIN_GRAD)
-	  vsigma[js]    = -sfact*x_factor_c*(rho1D*ds)*dfdx*x/(2.0*sigma[js]);
-      }
+      for(is=0; is<p->nspin; is++){
+	FLOAT gdm, ds, rho1D;
+	FLOAT x, t, u, f, vrho0, dfdx, dfdt, dfdu, d2fdx2, d2fdxt, d2fdt2;
+	int js = (is == 0) ? 0 : 2;
+
+	if(!work_mgga_x_vars(p, has_tail, sfact, is, rho, sigma, lapl_rho, tau,
+			     &gdm, &ds, &rho1D, &x, &t, &u)) continue;
+
+	vrho0 = dfdx = dfdt = dfdu = 0.0;
+	d2fdx2 = d2fdxt = d2fdt2 = 0.0;
 
-      if(v2rho2 != NULL && (p->info->flags & XC_FLAGS_HAVE_FXC)){
-	/* Missing terms here */
-	exit(1);
+#ifdef FUNC_PREPARE
+	func(p, aux[iprep[2*ip + is]], x, t, u, order, &f, &vrho0,
+	     &dfdx, &dfdt, &dfdu, &d2fdx2, &d2fdxt, &d2fdt2);
+#else
+	func(p, x, t, u, order, &f, &vrho0,
+	     &dfdx, &dfdt, &dfdu, &d2fdx2, &d2fdxt, &d2fdt2);
+#endif
+
+	if(zk != NULL && (p->info->flags & XC_FLAGS_HAVE_EXC))
+	  *zk += -sfact*x_factor_c*(ds*rho1D)*f;
+
+	if(vrho != NULL && (p->info->flags & XC_FLAGS_HAVE_VXC)){
+	  vrho[is]      = -x_factor_c*rho1D*(vrho0 + 4.0/3.0*(f - dfdx*x) - 5.0/3.0*(dfdt*t + dfdu*u));
+	  vtau[is]      = -x_factor_c*dfdt/rho1D;
+	  vlapl_rho[is] = -x_factor_c*dfdu/rho1D;
+	  if(gdm>MIN_GRAD)
+	    vsigma[js]    = -sfact*x_factor_c*(rho1D*ds)*dfdx*x/(2.0*sigma[js]);
+	}
+
+	if(v2rho2 != NULL && (p->info->flags & XC_FLAGS_HAVE_FXC)){
+	  /* Missing terms here */
+	  exit(1);
+	}
       }
-    }
     
-    if(zk != NULL)
-      *zk /= dens; /* we want energy per particle */
-
-  end_ip_loop:
-    /* increment pointers */
-    rho      += p->n_rho;
-    sigma    += p->n_sigma;
-    tau      += p->n_tau;
-    lapl_rho += p->n_lapl_rho;
+      if(zk != NULL)
+	*zk /= dens; /* we want energy per particle */
+
+    end_ip_loop:
+      /* increment pointers */
+      rho      += p->n_rho;
+      sigma    += p->n_sigma;
+      tau      += p->n_tau;
+      lapl_rho += p->n_lapl_rho;
     
-    if(zk != NULL)
-      zk += p->n_zk;
+      if(zk != NULL)
+	zk += p->n_zk;
     
-    if(vrho != NULL){
-      vrho      += p->n_vrho;
-      vsigma    += p->n_vsigma;
-      vtau      += p->n_vtau;
-      vlapl_rho += p->n_vlapl_rho;
-    }
+      if(vrho != NULL){
+	vrho      += p->n_vrho;
+	vsigma    += p->n_vsigma;
+	vtau      += p->n_vtau;
+	vlapl_rho += p->n_vlapl_rho;
+      }
 
-    if(v2rho2 != NULL){
-      v2rho2     += p->n_v2rho2;
-      v2rhosigma += p->n_v2rhosigma;
-      v2sigma2   += p->n_v2sigma2;
-      /* warning: extra termns missing */
+      if(v2rho2 != NULL){
+	v2rho2     += p->n_v2rho2;
+	v2rhosigma += p->n_v2rhosigma;
+	v2sigma2   += p->n_v2sigma2;
+	/* warning: extra termns missing */
+      }
     }
   }
 }
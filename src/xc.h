@@ -23,6 +23,8 @@
 extern "C" {
 #endif
 
+#include <stdio.h>
+#include <stddef.h>
 #include "xc_config.h"
   
 #define XC_UNPOLARIZED          1
@@ -59,6 +61,10 @@ extern "C" {
 #define XC_TAU_EXPLICIT         0
 #define XC_TAU_EXPANSION        1
 
+/* what the drivers do with the output arrays */
+#define XC_OUTPUT_OVERWRITE     0
+#define XC_OUTPUT_ACCUMULATE    1
+
 typedef struct{
   int   number;   /* indentifier number */
   int   kind;     /* XC_EXCHANGE or XC_CORRELATION */
@@ -79,16 +85,84 @@ typedef struct{
   void (*mgga)(const void *p, int np, const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
 	       FLOAT *zk, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau,
 	       FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2, FLOAT *v2rhotau, FLOAT *v2tausigma, FLOAT *v2tau2);
+
+  /* enhancement factor of the GGA exchanges that depend only on x, see work_gga_x.c */
+  void (*gga_x)(const void *p, int np, const FLOAT *x, FLOAT *f, FLOAT *dfdx, FLOAT *d2fdx2);
 } XC(func_info_type);
 
 
+/* Memory layout of the arrays passed to XC(lda), XC(gga) and XC(mgga).
+   Component ic of point ip of a quantity is found at array[ip*point + ic*comp].
+   The default (interleaved) layout has point equal to the number of
+   components and comp = 1; a spin-planar layout has point = 1 and comp
+   equal to the leading dimension of the array. */
+typedef struct{
+  size_t point; /* distance between two consecutive points */
+  size_t comp;  /* distance between two components (spin, etc.) of the same point */
+} XC(stride_type);
+
+typedef struct{
+  XC(stride_type) rho, sigma, lapl_rho, tau;
+  XC(stride_type) zk, vrho, vsigma, vlapl_rho, vtau;
+  XC(stride_type) v2rho2, v2rhosigma, v2sigma2, v2rhotau, v2tausigma, v2tau2;
+  XC(stride_type) v3rho3;
+} XC(layout_type);
+
+/* what XC(func_set_stats) enables */
+#define XC_STATS_OFF            0
+#define XC_STATS_ON             1
+#define XC_STATS_COUNTERS       2  /* XC_STATS_ON and the hardware counters */
+
+/* the events of the statistics: the hardware counters, and the calls
+   to the elementary functions in a library configured with --enable-op-count */
+#define XC_STATS_CYCLES         0
+#define XC_STATS_INSTRUCTIONS   1
+#define XC_STATS_BRANCH_MISSES  2
+#define XC_STATS_L1D_MISSES     3
+#define XC_STATS_LLC_MISSES     4
+#define XC_STATS_POW            5
+#define XC_STATS_LOG            6
+#define XC_STATS_EXP            7
+#define XC_STATS_SQRT           8
+#define XC_STATS_CBRT           9
+#define XC_STATS_ASINH         10
+#define XC_STATS_ATAN          11
+#define XC_STATS_ERF           12
+#define XC_STATS_NEVENTS       13
+
+/* Statistics of the evaluations of a functional, see XC(func_set_stats).
+   The time and the events of a functional include those of its auxiliary
+   functionals. */
+typedef struct{
+  long   calls;         /* calls to the drivers (the aux functionals are called once per block) */
+  long   points;        /* points evaluated                                  */
+  long   screened_dens; /* points skipped because the density is below MIN_DENS */
+  long   screened_grad; /* points (spin channels for the exchanges) with the gradient below MIN_GRAD */
+  long   orders[4];     /* calls by the highest derivative requested: exc, vxc, fxc, kxc */
+  double time;          /* wall time in seconds                              */
+
+  long   order_points[4];  /* points by the highest derivative requested */
+  double order_time[4];    /* wall time by the highest derivative requested */
+  int    mode;             /* XC_STATS_ON or XC_STATS_COUNTERS              */
+  int    counters;         /* bit ie is set if the event ie is counted      */
+  long   order_counted[4]; /* points for which the events were counted       */
+  double events[4][XC_STATS_NEVENTS]; /* events by the highest derivative requested */
+} XC(func_stats_type);
+
 struct XC(struct_lda_type);
 struct XC(struct_gga_type);
 struct XC(struct_mgga_type);
+struct XC(struct_arena_type);
 
 typedef struct XC(struct_func_type){
   const XC(func_info_type) *info;       /* all the information concerning this functional */
   int nspin;                            /* this is a copy from the underlying functional */
+  int nthreads;                         /* number of threads used to evaluate the points */
+  XC(layout_type) *layout;              /* memory layout of the arrays, NULL for the default one */
+  int output_mode;                      /* XC_OUTPUT_OVERWRITE or XC_OUTPUT_ACCUMULATE */
+  XC(func_stats_type) *stats;           /* statistics of the evaluations, NULL when disabled */
+  struct XC(struct_arena_type) *arena;  /* memory of the functional and of its auxiliary functionals */
+  int own_arena;                        /* 0 for the auxiliary functionals, that use the arena of their parent */
 
   struct XC(struct_lda_type)  *lda;
   struct XC(struct_gga_type)  *gga;
@@ -98,8 +172,24 @@ typedef struct XC(struct_func_type){
 
 /* functionals */
 int  XC(family_from_id)(int id, int *family, int *number);
+int  XC(functional_get_number)(const char *name);
+const char *XC(functional_get_name)(int id);
+int  XC(number_of_functionals)(void);
+void XC(available_functional_numbers)(int *list);
 int  XC(func_init)(XC(func_type) *p, int functional, int nspin);
 void XC(func_end)(XC(func_type) *p);
+int  XC(func_copy)(XC(func_type) *dst, const XC(func_type) *src);
+XC(func_type) *XC(func_clone)(const XC(func_type) *src);
+void XC(func_set_nthreads)(XC(func_type) *p, int nthreads);
+void XC(func_set_layout)(XC(func_type) *p, const XC(layout_type) *layout);
+void XC(func_set_layout_planar)(XC(func_type) *p, size_t ld);
+void XC(func_set_output_mode)(XC(func_type) *p, int mode);
+int  XC(func_set_lda_table)(XC(func_type) *p, FLOAT tol);
+int  XC(func_set_gga_x_table)(XC(func_type) *p, FLOAT tol);
+void XC(func_set_stats)(XC(func_type) *p, int enable);
+void XC(func_stats_reset)(XC(func_type) *p);
+int  XC(func_stats_get)(const XC(func_type) *p, XC(func_stats_type) *stats);
+void XC(func_stats_print)(const XC(func_type) *p, FILE *out);
 
 #include "xc_funcs.h"
 
@@ -110,6 +200,10 @@ typedef struct XC(struct_lda_type) {
 
   int func;                             /* Shortcut in case of several functionals sharing the same interface */
   int n_rho, n_zk, n_vrho, n_v2rho2, n_v3rho3; /* spin dimensions of arguments */
+  const XC(layout_type) *layout;        /* copy of the layout of the func_type, read by the kernels */
+  struct XC(struct_lda_table) *table;   /* spline table of the uniform gas, see XC(func_set_lda_table) */
+  XC(func_stats_type) *stats;           /* copy of the statistics of the func_type, updated by the kernels */
+  struct XC(struct_arena_type) *arena;  /* copy of the arena of the func_type, for the init routines */
 
   void *params;                         /* this allows us to fix parameters in the functional */
 } XC(lda_type);
@@ -124,7 +218,17 @@ void XC(lda_vxc)    (const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *vr
 void XC(lda_fxc)    (const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *v2rho2);
 void XC(lda_kxc)    (const XC(func_type) *p, int np, const FLOAT *rho, FLOAT *v3rho3);
 
+/* weighted quadrature: integrated energy and weighted potential */
+void XC(lda_exc_vxc_weighted)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *weights,
+			      FLOAT *exc, FLOAT *vrho, int accumulate);
+
+/* the same for grids with more than 2^31 points */
+void XC(lda64)(const XC(func_type) *p, size_t np, const FLOAT *rho, FLOAT *zk, FLOAT *vrho, FLOAT *v2rho2, FLOAT *v3rho3);
+void XC(lda_exc_vxc_weighted64)(const XC(func_type) *p, size_t np, const FLOAT *rho, const FLOAT *weights,
+				FLOAT *exc, FLOAT *vrho, int accumulate);
+
 void XC(lda_x_1d_set_params)     (XC(func_type) *p, int interaction, FLOAT bb);
+void XC(lda_x_1d_set_quadrature) (XC(func_type) *p, int quadrature);
 void XC(lda_c_1d_csc_set_params) (XC(func_type) *p, int interaction, FLOAT bb);
 void XC(lda_c_xalpha_set_params) (XC(func_type) *p, FLOAT alpha);
 void XC(lda_x_set_params)        (XC(func_type) *p, int relativistic);
@@ -142,6 +246,9 @@ typedef struct XC(struct_gga_type){
   FLOAT *mix_coef;                      /* coefficients for the mixing */
 
   FLOAT exx_coef;                       /* the Hartree-Fock mixing parameter for the hybrids */
+  struct XC(struct_gga_x_table) *x_table; /* spline table of the enhancement factor, see XC(func_set_gga_x_table) */
+  XC(func_stats_type) *stats;           /* copy of the statistics of the func_type, updated by the kernels */
+  struct XC(struct_arena_type) *arena;  /* copy of the arena of the func_type, for the init routines */
 
   int func;                             /* Shortcut in case of several functionals sharing the same interface */
   int n_rho, n_zk, n_vrho, n_v2rho2;    /* spin dimensions of arguments */
@@ -164,6 +271,15 @@ void XC(gga_vxc)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *
 void XC(gga_fxc)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigma,
 		 FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2);
 
+void XC(gga_exc_vxc_weighted)(const XC(func_type) *p, int np, const FLOAT *rho, const FLOAT *sigma, const FLOAT *weights,
+			      FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, int accumulate);
+
+void XC(gga64)(const XC(func_type) *p, size_t np, const FLOAT *rho, const FLOAT *sigma, 
+	       FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
+	       FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2);
+void XC(gga_exc_vxc_weighted64)(const XC(func_type) *p, size_t np, const FLOAT *rho, const FLOAT *sigma, const FLOAT *weights,
+				FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, int accumulate);
+
 void XC(gga_lb_modified)  (const XC(gga_type) *p, int np, const FLOAT *rho, const FLOAT *sigma, 
 			   FLOAT r, FLOAT *vrho);
 
@@ -187,6 +303,8 @@ typedef struct XC(struct_mgga_type){
 
   int handle_tau;                       /* decides if tau should be handled explicitly (0) or
 					   though a gradient expansion (1) */
+  XC(func_stats_type) *stats;           /* copy of the statistics of the func_type, updated by the kernels */
+  struct XC(struct_arena_type) *arena;  /* copy of the arena of the func_type, for the init routines */
 
   int func;                             /* Shortcut in case of several functionals sharing the same interface */
   int n_rho, n_zk, n_vrho, n_v2rho2;    /* spin dimensions of arguments */
@@ -216,9 +334,32 @@ void XC(mgga_fxc)    (const XC(func_type) *p, int np,
 		      const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
 		      FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2, FLOAT *v2rhotau, FLOAT *v2tausigma, FLOAT *v2tau2);
 
+void XC(mgga_exc_vxc_weighted)(const XC(func_type) *p, int np,
+			       const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau, const FLOAT *weights,
+			       FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau, int accumulate);
+
+void XC(mgga64)(const XC(func_type) *p, size_t np,
+		const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau,
+		FLOAT *zk, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau,
+		FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2, FLOAT *v2rhotau, FLOAT *v2tausigma, FLOAT *v2tau2);
+void XC(mgga_exc_vxc_weighted64)(const XC(func_type) *p, size_t np,
+				 const FLOAT *rho, const FLOAT *sigma, const FLOAT *lapl_rho, const FLOAT *tau, const FLOAT *weights,
+				 FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau, int accumulate);
+
 void XC(mgga_set_handle_tau)(XC(func_type) *p, int handle_tau);
 void XC(mgga_x_tb09_set_params)(XC(func_type) *p, FLOAT c);
 
+/* the solution of the Becke-Roussel equation, for one or for a block of points */
+typedef struct{
+  int npoints;              /* points solved                                 */
+  int iterations;           /* Halley steps of the batched solver            */
+  int fallbacks;            /* points solved again by Newton and bisection   */
+  int fallback_iterations;  /* iterations of Newton and bisection            */
+} XC(mgga_x_br89_stats);
+
+FLOAT XC(mgga_x_br89_get_x)      (FLOAT Q);
+void  XC(mgga_x_br89_get_x_batch)(int np, const FLOAT *Q, FLOAT *br_x, XC(mgga_x_br89_stats) *stats);
+
 /* Functionals that are defined as mixtures of others */
 void XC(mix_func)(const XC(func_type) *dest_func, int n_func_aux, XC(func_type) **func_aux, FLOAT *mix_coef,
 		  int np, const FLOAT *rho, const FLOAT *sigma,
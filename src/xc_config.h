@@ -1,7 +1,10 @@
 #if SINGLE_PRECISION
 #  define FLOAT float
 #  define POW   powf
+#  define CBRT  cbrtf
 #  define LOG   logf
+#  define EXP   expf
+#  define SQRT  sqrtf
 #  define ASINH asinhf
 #  define ABS   fabsf
 #  define XC(x) xc_s_ ## x
@@ -12,7 +15,10 @@
 #else
 #  define FLOAT double
 #  define POW   pow
+#  define CBRT  cbrt
 #  define LOG   log
+#  define EXP   exp
+#  define SQRT  sqrt
 #  define ASINH asinh
 #  define ABS   fabs
 #  define XC(x) xc_ ## x
@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <assert.h>
 
 #include "config.h"
@@ -114,6 +115,37 @@ void XC_FC_FUNC(f90_func_end, F90_FUNC_END)
   *p = NULL;
 }
 
+void XC_FC_FUNC(f90_func_set_nthreads, F90_FUNC_SET_NTHREADS)
+     (void **p, CC_FORTRAN_INT *nthreads)
+{
+  XC(func_set_nthreads)((XC(func_type) *)(*p), (int) (*nthreads));
+}
+
+/* Fortran arrays rho(np, nspin), vsigma(np, 3), etc. are spin planar */
+void XC_FC_FUNC(f90_func_set_layout_planar, F90_FUNC_SET_LAYOUT_PLANAR)
+     (void **p, int64_t *ld)
+{
+  XC(func_set_layout_planar)((XC(func_type) *)(*p), (size_t) (*ld));
+}
+
+void XC_FC_FUNC(f90_func_set_output_mode, F90_FUNC_SET_OUTPUT_MODE)
+     (void **p, CC_FORTRAN_INT *mode)
+{
+  XC(func_set_output_mode)((XC(func_type) *)(*p), (int) (*mode));
+}
+
+void XC_FC_FUNC(f90_func_set_lda_table, F90_FUNC_SET_LDA_TABLE)
+     (void **p, FLOAT *tol, CC_FORTRAN_INT *ntab)
+{
+  *ntab = (CC_FORTRAN_INT) XC(func_set_lda_table)((XC(func_type) *)(*p), *tol);
+}
+
+void XC_FC_FUNC(f90_func_set_gga_x_table, F90_FUNC_SET_GGA_X_TABLE)
+     (void **p, FLOAT *tol, CC_FORTRAN_INT *ntab)
+{
+  *ntab = (CC_FORTRAN_INT) XC(func_set_gga_x_table)((XC(func_type) *)(*p), *tol);
+}
+
 
 /* LDAs */
 
@@ -159,6 +191,28 @@ void XC_FC_FUNC(f90_lda_kxc, F90_LDA_KXC)
   XC(lda)((XC(func_type) *)(*p), *np, rho, NULL, NULL, NULL, v3rho3);
 }
 
+void XC_FC_FUNC(f90_lda_exc_vxc_weighted, F90_LDA_EXC_VXC_WEIGHTED)
+     (void **p, CC_FORTRAN_INT *np, FLOAT *rho, FLOAT *weights,
+      FLOAT *exc, FLOAT *vrho, CC_FORTRAN_INT *accumulate)
+{
+  XC(lda_exc_vxc_weighted)((XC(func_type) *)(*p), *np, rho, weights, exc, vrho, (int) (*accumulate));
+}
+
+/* versions with an INTEGER(8) number of points */
+void XC_FC_FUNC(f90_lda64, F90_LDA64)
+     (void **p, int64_t *np, FLOAT *rho, 
+      FLOAT *zk, FLOAT *vrho, FLOAT *v2rho2, FLOAT *v3rho3)
+{
+  XC(lda64)((XC(func_type) *)(*p), (size_t) (*np), rho, zk, vrho, v2rho2, v3rho3);
+}
+
+void XC_FC_FUNC(f90_lda_exc_vxc_weighted64, F90_LDA_EXC_VXC_WEIGHTED64)
+     (void **p, int64_t *np, FLOAT *rho, FLOAT *weights,
+      FLOAT *exc, FLOAT *vrho, CC_FORTRAN_INT *accumulate)
+{
+  XC(lda_exc_vxc_weighted64)((XC(func_type) *)(*p), (size_t) (*np), rho, weights, exc, vrho, (int) (*accumulate));
+}
+
 
 /* Now come some special initializations */
 
@@ -169,6 +223,12 @@ void XC_FC_FUNC(f90_lda_x_1d_set_par, F90_LDA_X_1D_SET_PAR)
   XC(lda_x_1d_set_params)((XC(func_type) *)(*p), *interaction, *bb);
 }
 
+void XC_FC_FUNC(f90_lda_x_1d_set_quadrature, F90_LDA_X_1D_SET_QUADRATURE)
+  (void **p, CC_FORTRAN_INT *quadrature)
+{
+  XC(lda_x_1d_set_quadrature)((XC(func_type) *)(*p), *quadrature);
+}
+
 /* parameter of Xalpha */
 void XC_FC_FUNC(f90_lda_c_xalpha_set_par, F90_LDA_C_XALPHA_SET_PAR)
   (void **p, FLOAT *alpha)
@@ -236,6 +296,28 @@ void XC_FC_FUNC(f90_gga_fxc, F90_GGA_FXC)
   XC(gga)((XC(func_type) *)(*p), *np, rho, sigma, NULL, NULL, NULL, v2rho2, v2rhosigma, v2sigma2);
 }
 
+void XC_FC_FUNC(f90_gga_exc_vxc_weighted, F90_GGA_EXC_VXC_WEIGHTED)
+     (void **p, CC_FORTRAN_INT *np, FLOAT *rho, FLOAT *sigma, FLOAT *weights,
+      FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, CC_FORTRAN_INT *accumulate)
+{
+  XC(gga_exc_vxc_weighted)((XC(func_type) *)(*p), *np, rho, sigma, weights, exc, vrho, vsigma, (int) (*accumulate));
+}
+
+void XC_FC_FUNC(f90_gga64, F90_GGA64)
+     (void **p, int64_t *np, FLOAT *rho, FLOAT *sigma, 
+      FLOAT *zk, FLOAT *vrho, FLOAT *vsigma,
+      FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2)
+{
+  XC(gga64)((XC(func_type) *)(*p), (size_t) (*np), rho, sigma, zk, vrho, vsigma, v2rho2, v2rhosigma, v2sigma2);
+}
+
+void XC_FC_FUNC(f90_gga_exc_vxc_weighted64, F90_GGA_EXC_VXC_WEIGHTED64)
+     (void **p, int64_t *np, FLOAT *rho, FLOAT *sigma, FLOAT *weights,
+      FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, CC_FORTRAN_INT *accumulate)
+{
+  XC(gga_exc_vxc_weighted64)((XC(func_type) *)(*p), (size_t) (*np), rho, sigma, weights, exc, vrho, vsigma, (int) (*accumulate));
+}
+
 /* the van Leeuwen & Baerends functional is special */
 void XC_FC_FUNC(f90_gga_lb_set_par, F90_GGA_LB_SET_PAR)
   (void **p, CC_FORTRAN_INT *modified, FLOAT *threshold, FLOAT *ip, FLOAT *qtot)
@@ -305,6 +387,32 @@ void XC_FC_FUNC(f90_mgga_fxc, F90_MGGA_FXC)
 	   NULL, NULL, NULL, NULL, NULL, v2rho2, v2rhosigma, v2sigma2, v2rhotau, v2tausigma, v2tau2);  
 }
 
+void XC_FC_FUNC(f90_mgga_exc_vxc_weighted, F90_MGGA_EXC_VXC_WEIGHTED)
+  (void **p, CC_FORTRAN_INT *np, FLOAT *rho, FLOAT *sigma, FLOAT *lapl_rho, FLOAT *tau, FLOAT *weights,
+   FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau, CC_FORTRAN_INT *accumulate)
+{
+  XC(mgga_exc_vxc_weighted)((XC(func_type) *)(*p), *np, rho, sigma, lapl_rho, tau, weights, 
+			    exc, vrho, vsigma, vlapl_rho, vtau, (int) (*accumulate));
+}
+
+void XC_FC_FUNC(f90_mgga64, F90_MGGA64)
+  (void **p, int64_t *np, FLOAT *rho, FLOAT *sigma, FLOAT *lapl_rho, FLOAT *tau,
+   FLOAT *zk, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau,
+   FLOAT *v2rho2, FLOAT *v2rhosigma, FLOAT *v2sigma2, FLOAT *v2rhotau, FLOAT *v2tausigma, FLOAT *v2tau2)
+{
+  XC(mgga64)((XC(func_type) *)(*p), (size_t) (*np), rho, sigma, lapl_rho, tau, 
+	     zk, vrho, vsigma, vlapl_rho, vtau,
+	     v2rho2, v2rhosigma, v2sigma2, v2rhotau, v2tausigma, v2tau2);
+}
+
+void XC_FC_FUNC(f90_mgga_exc_vxc_weighted64, F90_MGGA_EXC_VXC_WEIGHTED64)
+  (void **p, int64_t *np, FLOAT *rho, FLOAT *sigma, FLOAT *lapl_rho, FLOAT *tau, FLOAT *weights,
+   FLOAT *exc, FLOAT *vrho, FLOAT *vsigma, FLOAT *vlapl_rho, FLOAT *vtau, CC_FORTRAN_INT *accumulate)
+{
+  XC(mgga_exc_vxc_weighted64)((XC(func_type) *)(*p), (size_t) (*np), rho, sigma, lapl_rho, tau, weights, 
+			      exc, vrho, vsigma, vlapl_rho, vtau, (int) (*accumulate));
+}
+
 /* parameter of TP09 */
 void XC_FC_FUNC(f90_mgga_x_tb09_set_par, F90_MGGA_X_TB09_SET_PAR)
   (void **p, FLOAT *cc)
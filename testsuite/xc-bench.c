@@ -0,0 +1,640 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/************************************************************************
+  xc-bench: throughput of every functional of the library.
+
+  Each functional is evaluated for exc, exc+vxc and fxc, in both spin
+  channels and for several numbers of points. The points are drawn
+  from a grid of model densities (xc-grid.c): the atoms from H to Kr,
+  or the file of xc-make_grid given by --grid. So the calls go through
+  the same branches and screenings as in a real calculation. For every
+  case we print the number of calls, the time per point, the
+  throughput and the number of allocations per call, as CSV (default)
+  or JSON.
+
+  A file written before with --format csv can be given as --baseline.
+  Every case is then compared to the same case of the baseline, and
+  the program exits with status 1 if any of them is slower by more
+  than the tolerance.
+
+  The allocations are counted by replacing the malloc of glibc. With
+  other C libraries they are reported as -1.
+************************************************************************/
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <xc.h>
+#include "xc-grid.h"
+
+extern const xc_func_info_type
+  *xc_lda_known_funct[],
+  *xc_gga_known_funct[],
+  *xc_hyb_gga_known_funct[],
+  *xc_mgga_known_funct[];
+
+#define MODE_EXC     0
+#define MODE_EXC_VXC 1
+#define MODE_FXC     2
+
+static const char *mode_name[] = {"exc", "exc_vxc", "fxc"};
+
+#define MAX_SIZES 16
+
+
+/*********** allocation counter ***********/
+#ifdef HAVE___LIBC_MALLOC
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static int  counting = 0;
+static long nalloc   = 0;
+
+void *malloc(size_t size)
+{
+  if(counting) __sync_fetch_and_add(&nalloc, 1);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+  if(counting) __sync_fetch_and_add(&nalloc, 1);
+  return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+  if(counting) __sync_fetch_and_add(&nalloc, 1);
+  return __libc_realloc(ptr, size);
+}
+
+static void alloc_count_start() { nalloc = 0; counting = 1; }
+static long alloc_count_stop()  { counting = 0; return nalloc; }
+#else
+static void alloc_count_start() {}
+static long alloc_count_stop()  { return -1; }
+#endif
+
+
+/*********** inputs ***********/
+typedef struct {
+  int np, nspin;
+  double *rho, *sigma, *lapl_rho, *tau;
+} input_type;
+
+static unsigned long long rng_state = 0x2545F4914F6CDD1DULL;
+
+/* uniform in [0, 1), the same sequence on every machine */
+static double rng()
+{
+  rng_state = rng_state*6364136223846793005ULL + 1442695040888963407ULL;
+  return (rng_state >> 11)*(1.0/9007199254740992.0);
+}
+
+/* points drawn at random from the grid, so that every block sees
+   the mixture of cores, valence regions and tails of the grid */
+static void input_fill(input_type *in, const grid_type *g)
+{
+  size_t jp;
+  int ip;
+
+  rng_state = 0x2545F4914F6CDD1DULL;
+  for(ip=0; ip<in->np; ip++){
+    jp = (size_t)(rng()*g->np);
+
+    if(in->nspin == XC_UNPOLARIZED){
+      in->rho[ip]      = g->rho[jp];
+      in->sigma[ip]    = g->sigma[jp];
+      in->lapl_rho[ip] = g->lapl_rho[jp];
+      in->tau[ip]      = g->tau[jp];
+    }else{
+      memcpy(in->rho      + 2*ip, g->rho_s      + 2*jp, 2*sizeof(double));
+      memcpy(in->sigma    + 3*ip, g->sigma_s    + 3*jp, 3*sizeof(double));
+      memcpy(in->lapl_rho + 2*ip, g->lapl_rho_s + 2*jp, 2*sizeof(double));
+      memcpy(in->tau      + 2*ip, g->tau_s      + 2*jp, 2*sizeof(double));
+    }
+  }
+}
+
+
+/*********** baseline ***********/
+typedef struct {
+  int id, nspin, np;
+  char mode[16];
+  double ns;
+} record_type;
+
+static record_type *baseline = NULL;
+static int nbaseline = 0;
+
+static void baseline_read(const char *fname)
+{
+  char line[1024], family[16];
+  record_type rec;
+  long calls;
+  double seconds;
+  int nmax = 0;
+  FILE *in;
+
+  in = fopen(fname, "r");
+  if(in == NULL){
+    fprintf(stderr, "Could not open baseline file '%s'\n", fname);
+    exit(1);
+  }
+
+  while(fgets(line, sizeof(line), in) != NULL){
+    /* family,id,nspin,np,mode,calls,seconds,ns_per_point,... */
+    if(sscanf(line, "%15[^,],%d,%d,%d,%15[^,],%ld,%lf,%lf", family, &rec.id, &rec.nspin, &rec.np,
+	      rec.mode, &calls, &seconds, &rec.ns) != 8)
+      continue; /* the header */
+
+    if(nbaseline == nmax){
+      nmax = (nmax == 0) ? 256 : 2*nmax;
+      baseline = (record_type *) realloc(baseline, nmax*sizeof(record_type));
+    }
+    baseline[nbaseline++] = rec;
+  }
+
+  fclose(in);
+}
+
+static const record_type *baseline_find(int id, int nspin, int np, const char *mode)
+{
+  int ii;
+
+  for(ii=0; ii<nbaseline; ii++)
+    if(baseline[ii].id == id && baseline[ii].nspin == nspin && baseline[ii].np == np &&
+       strcmp(baseline[ii].mode, mode) == 0)
+      return &baseline[ii];
+
+  return NULL;
+}
+
+
+/*********** options ***********/
+static struct {
+  int    json;
+  int    nsizes, sizes[MAX_SIZES];
+  int    nspin[2];
+  int    nfuncs, *funcs;
+  int    nthreads;
+  double min_time;
+  double tolerance;
+  FILE  *out;
+  FILE  *stats;
+  int    profile;
+  char  *grid;
+} opt;
+
+static void usage(const char *prog)
+{
+  printf("Usage: %s [options]\n\n", prog);
+  printf("  --format csv|json    output format (csv)\n");
+  printf("  --output FILE        write the results to FILE instead of the standard output\n");
+  printf("  --sizes N1,N2,...    numbers of points of each call (1,64,4096,1048576)\n");
+  printf("  --nspin 1|2          only this spin channel (both)\n");
+  printf("  --func F1,F2,...     only these functionals, by id or name, e.g. 101,gga_c_pbe (all)\n");
+  printf("  --threads N          threads used by the library (1)\n");
+  printf("  --min-time SECONDS   time spent on each case (0.1)\n");
+  printf("  --grid FILE          draw the points from a grid written by xc-make_grid\n");
+  printf("  --stats FILE         write the statistics of the functionals of every case to FILE\n");
+  printf("  --profile FILE       as --stats, with the hardware counters and the figures per point\n");
+  printf("  --baseline FILE      compare to the results of a previous CSV run\n");
+  printf("  --tolerance FRAC     slowdown that counts as a regression (0.1)\n");
+}
+
+static int parse_list(const char *str, int *list, int nmax)
+{
+  char *end;
+  int n = 0;
+
+  while(*str != '\0' && n < nmax){
+    list[n++] = (int) strtol(str, &end, 10);
+    if(end == str) break;
+    str = (*end == ',') ? end + 1 : end;
+  }
+  return n;
+}
+
+/* a list of functionals, given by their ids or their names */
+static int parse_funcs(const char *str, int *list)
+{
+  char name[64], *end;
+  int n = 0, len;
+
+  while(*str != '\0'){
+    len = (int) strcspn(str, ",");
+    list[n] = (int) strtol(str, &end, 10);
+    if(end != str + len){
+      if(len >= (int) sizeof(name)) len = sizeof(name) - 1;
+      memcpy(name, str, len);
+      name[len] = '\0';
+      if((list[n] = xc_functional_get_number(name)) < 0){
+	fprintf(stderr, "Unknown functional '%s'\n", name);
+	exit(1);
+      }
+    }
+    n++;
+    str += strcspn(str, ",");
+    if(*str == ',') str++;
+  }
+  return n;
+}
+
+static void parse_options(int argc, char *argv[])
+{
+  int ii;
+
+  opt.json      = 0;
+  opt.nsizes    = 4;
+  opt.sizes[0]  = 1;
+  opt.sizes[1]  = 64;
+  opt.sizes[2]  = 4096;
+  opt.sizes[3]  = 1048576;
+  opt.nspin[0]  = opt.nspin[1] = 1;
+  opt.nfuncs    = 0;
+  opt.funcs     = NULL;
+  opt.nthreads  = 1;
+  opt.min_time  = 0.1;
+  opt.tolerance = 0.1;
+  opt.out       = stdout;
+  opt.stats     = NULL;
+  opt.profile   = 0;
+  opt.grid      = NULL;
+
+  for(ii=1; ii<argc; ii++){
+    const char *arg = argv[ii], *val = (ii + 1 < argc) ? argv[ii + 1] : NULL;
+
+    if(strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0){
+      usage(argv[0]);
+      exit(0);
+    }
+
+    if(val == NULL){
+      fprintf(stderr, "Option '%s' needs a value\n", arg);
+      exit(1);
+    }
+    ii++;
+
+    if(strcmp(arg, "--format") == 0){
+      opt.json = (strcmp(val, "json") == 0);
+      if(!opt.json && strcmp(val, "csv") != 0){
+	fprintf(stderr, "Unknown format '%s'\n", val);
+	exit(1);
+      }
+    }else if(strcmp(arg, "--output") == 0){
+      opt.out = fopen(val, "w");
+      if(opt.out == NULL){
+	fprintf(stderr, "Could not open output file '%s'\n", val);
+	exit(1);
+      }
+    }else if(strcmp(arg, "--sizes") == 0){
+      opt.nsizes = parse_list(val, opt.sizes, MAX_SIZES);
+    }else if(strcmp(arg, "--nspin") == 0){
+      opt.nspin[0] = (atoi(val) == 1);
+      opt.nspin[1] = (atoi(val) == 2);
+    }else if(strcmp(arg, "--func") == 0){
+      opt.funcs  = (int *) malloc((strlen(val) + 1)*sizeof(int));
+      opt.nfuncs = parse_funcs(val, opt.funcs);
+    }else if(strcmp(arg, "--threads") == 0){
+      opt.nthreads = atoi(val);
+    }else if(strcmp(arg, "--min-time") == 0){
+      opt.min_time = atof(val);
+    }else if(strcmp(arg, "--tolerance") == 0){
+      opt.tolerance = atof(val);
+    }else if(strcmp(arg, "--stats") == 0 || strcmp(arg, "--profile") == 0){
+      opt.profile = (strcmp(arg, "--profile") == 0);
+      opt.stats = fopen(val, "w");
+      if(opt.stats == NULL){
+	fprintf(stderr, "Could not open statistics file '%s'\n", val);
+	exit(1);
+      }
+    }else if(strcmp(arg, "--grid") == 0){
+      opt.grid = argv[ii];
+    }else if(strcmp(arg, "--baseline") == 0){
+      baseline_read(val);
+    }else{
+      fprintf(stderr, "Unknown option '%s'\n", arg);
+      usage(argv[0]);
+      exit(1);
+    }
+  }
+
+  for(ii=0; ii<opt.nsizes; ii++)
+    if(opt.sizes[ii] <= 0){
+      fprintf(stderr, "Invalid number of points %d\n", opt.sizes[ii]);
+      exit(1);
+    }
+}
+
+static int selected(int id)
+{
+  int ii;
+
+  if(opt.nfuncs == 0) return 1;
+  for(ii=0; ii<opt.nfuncs; ii++)
+    if(opt.funcs[ii] == id) return 1;
+  return 0;
+}
+
+
+/*********** timing ***********/
+static double now()
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9*t.tv_nsec;
+}
+
+/* the outputs of a call; NULL are not computed */
+typedef struct {
+  double *zk, *vrho, *vsigma, *vlapl_rho, *vtau;
+  double *v2rho2, *v2rhosigma, *v2sigma2, *v2rhotau, *v2tausigma, *v2tau2;
+} output_type;
+
+static void evaluate(const xc_func_type *func, const input_type *g, int np, output_type *o)
+{
+  switch(func->info->family){
+  case XC_FAMILY_LDA:
+    xc_lda(func, np, g->rho, o->zk, o->vrho, o->v2rho2, NULL);
+    break;
+  case XC_FAMILY_GGA:
+  case XC_FAMILY_HYB_GGA:
+    xc_gga(func, np, g->rho, g->sigma, o->zk, o->vrho, o->vsigma,
+	   o->v2rho2, o->v2rhosigma, o->v2sigma2);
+    break;
+  case XC_FAMILY_MGGA:
+    xc_mgga(func, np, g->rho, g->sigma, g->lapl_rho, g->tau,
+	    o->zk, o->vrho, o->vsigma, o->vlapl_rho, o->vtau,
+	    o->v2rho2, o->v2rhosigma, o->v2sigma2, o->v2rhotau, o->v2tausigma, o->v2tau2);
+    break;
+  }
+}
+
+/* points the outputs needed by mode to pieces of pool. Returns 0 if
+   the functional does not provide them. */
+static int outputs_set(const xc_func_type *func, int mode, int np, double *pool, output_type *o)
+{
+  int flags = func->info->flags;
+
+  memset(o, 0, sizeof(output_type));
+
+  switch(mode){
+  case MODE_EXC:
+    if(!(flags & XC_FLAGS_HAVE_EXC)) return 0;
+    o->zk = pool;
+    break;
+
+  case MODE_EXC_VXC:
+    /* the potentials that have no energy, like LB94, are timed alone */
+    if(!(flags & XC_FLAGS_HAVE_VXC)) return 0;
+    if(flags & XC_FLAGS_HAVE_EXC){
+      o->zk = pool;  pool += np;
+    }
+    o->vrho      = pool;  pool += 2*np;
+    o->vsigma    = pool;  pool += 3*np;
+    o->vlapl_rho = pool;  pool += 2*np;
+    o->vtau      = pool;
+    break;
+
+  case MODE_FXC:
+    if(!(flags & XC_FLAGS_HAVE_FXC)) return 0;
+    o->v2rho2     = pool;  pool += 3*np;
+    o->v2rhosigma = pool;  pool += 6*np;
+    o->v2sigma2   = pool;  pool += 6*np;
+    o->v2rhotau   = pool;  pool += 4*np;
+    o->v2tausigma = pool;  pool += 6*np;
+    o->v2tau2     = pool;
+    break;
+  }
+
+  return 1;
+}
+
+
+/*********** results ***********/
+static int nresults = 0, nregressions = 0;
+
+static void print_result(const char *family, const xc_func_type *func, int np, int mode,
+			 long calls, double seconds, long allocs)
+{
+  const record_type *base = NULL;
+  double ns, ratio = 0.0;
+  const char *status = NULL;
+  char name[256];
+  int ii, jj;
+
+  ns = 1e9*seconds/((double)calls*np);
+
+  if(nbaseline > 0){
+    base = baseline_find(func->info->number, func->nspin, np, mode_name[mode]);
+    if(base == NULL)
+      status = "new";
+    else{
+      ratio  = ns/base->ns;
+      status = "ok";
+      if(ratio > 1.0 + opt.tolerance){
+	status = "slower";
+	nregressions++;
+      }else if(ratio < 1.0/(1.0 + opt.tolerance))
+	status = "faster";
+    }
+  }
+
+  /* the names have commas, but no quotes */
+  for(ii=0, jj=0; func->info->name[ii] != '\0' && jj < 255; ii++)
+    if(func->info->name[ii] != '"' && func->info->name[ii] != '\\')
+      name[jj++] = func->info->name[ii];
+  name[jj] = '\0';
+
+  if(!opt.json){
+    if(nresults == 0){
+      fprintf(opt.out, "family,id,nspin,np,mode,calls,seconds,ns_per_point,points_per_s,allocs_per_call");
+      if(nbaseline > 0) fprintf(opt.out, ",baseline_ns_per_point,ratio,status");
+      fprintf(opt.out, ",name\n");
+    }
+
+    fprintf(opt.out, "%s,%d,%d,%d,%s,%ld,%.6e,%.6e,%.6e,%.3f", family, func->info->number,
+	    func->nspin, np, mode_name[mode], calls, seconds, ns, 1e9/ns,
+	    (allocs < 0) ? -1.0 : (double)allocs/calls);
+    if(nbaseline > 0){
+      if(base == NULL)
+	fprintf(opt.out, ",,,%s", status);
+      else
+	fprintf(opt.out, ",%.6e,%.4f,%s", base->ns, ratio, status);
+    }
+    fprintf(opt.out, ",\"%s\"\n", name);
+
+  }else{
+    fprintf(opt.out, "%s\n  {\"family\": \"%s\", \"id\": %d, \"name\": \"%s\", \"nspin\": %d, \"np\": %d, \"mode\": \"%s\",\n",
+	    (nresults == 0) ? "[" : ",", family, func->info->number, name, func->nspin, np, mode_name[mode]);
+    fprintf(opt.out, "   \"calls\": %ld, \"seconds\": %.6e, \"ns_per_point\": %.6e, \"points_per_s\": %.6e, \"allocs_per_call\": %.3f",
+	    calls, seconds, ns, 1e9/ns, (allocs < 0) ? -1.0 : (double)allocs/calls);
+    if(nbaseline > 0){
+      if(base == NULL)
+	fprintf(opt.out, ",\n   \"status\": \"%s\"", status);
+      else
+	fprintf(opt.out, ",\n   \"baseline_ns_per_point\": %.6e, \"ratio\": %.4f, \"status\": \"%s\"", base->ns, ratio, status);
+    }
+    fprintf(opt.out, "}");
+  }
+
+  fflush(opt.out);
+  nresults++;
+}
+
+
+static void bench_case(const char *family, xc_func_type *func, input_type *in, int np, int mode, double *pool)
+{
+  output_type o;
+  long calls, batch, allocs;
+  double start, seconds;
+  int ii;
+
+  if(!outputs_set(func, mode, np, pool, &o)) return;
+
+  /* once to touch the memory and fill the caches */
+  evaluate(func, in, np, &o);
+
+  calls = 0;
+  batch = 1;
+  alloc_count_start();
+  start = now();
+  do{
+    for(ii=0; ii<batch; ii++)
+      evaluate(func, in, np, &o);
+    calls  += batch;
+    batch  *= 2;
+    seconds = now() - start;
+  }while(seconds < opt.min_time);
+  allocs = alloc_count_stop();
+
+  print_result(family, func, np, mode, calls, seconds, allocs);
+
+  if(opt.stats != NULL){
+    fprintf(opt.stats, "# %s nspin=%d np=%d mode=%s\n", family, func->nspin, np, mode_name[mode]);
+    xc_func_stats_print(func, opt.stats);
+    xc_func_stats_reset(func);
+  }
+}
+
+
+static void bench_family(const char *family, const xc_func_info_type **known, input_type *in, double *pool)
+{
+  xc_func_type func;
+  int ii, is, isize, mode;
+
+  for(ii=0; known[ii]!=NULL; ii++){
+    if(!selected(known[ii]->number)) continue;
+
+    for(is=0; is<2; is++){
+      if(!opt.nspin[is]) continue;
+
+      /* only defined for unpolarized densities */
+      if(known[ii]->number == XC_LDA_C_2D_PRM && is == 1) continue;
+
+      if(xc_func_init(&func, known[ii]->number, is + 1) != 0){
+	fprintf(stderr, "Functional '%d' not found\n", known[ii]->number);
+	continue;
+      }
+      if(opt.nthreads != 1)
+	xc_func_set_nthreads(&func, opt.nthreads);
+      if(opt.stats != NULL)
+	xc_func_set_stats(&func, opt.profile ? XC_STATS_COUNTERS : XC_STATS_ON);
+      if(known[ii]->number == XC_LDA_C_2D_PRM)
+	xc_lda_c_2d_prm_set_params(&func, 10.0);
+
+      for(mode=MODE_EXC; mode<=MODE_FXC; mode++)
+	for(isize=0; isize<opt.nsizes; isize++)
+	  bench_case(family, &func, &in[is], opt.sizes[isize], mode, pool);
+
+      xc_func_end(&func);
+    }
+  }
+}
+
+
+int main(int argc, char *argv[])
+{
+  grid_type grid;
+  input_type in[2];
+  double *pool;
+  int ii, is, npmax;
+
+  parse_options(argc, argv);
+
+  npmax = 1;
+  for(ii=0; ii<opt.nsizes; ii++)
+    if(opt.sizes[ii] > npmax) npmax = opt.sizes[ii];
+
+  if(opt.grid != NULL){
+    if(grid_map(&grid, opt.grid) != 0) exit(1);
+  }else
+    grid_build_atoms(&grid, 1, 36, 75, 8);
+
+  /* the same points for all the functionals */
+  for(is=0; is<2; is++){
+    in[is].np       = npmax;
+    in[is].nspin    = is + 1;
+    in[is].rho      = (double *) malloc(npmax*(is + 1)*sizeof(double));
+    in[is].sigma    = (double *) malloc(npmax*(2*is + 1)*sizeof(double));
+    in[is].lapl_rho = (double *) malloc(npmax*(is + 1)*sizeof(double));
+    in[is].tau      = (double *) malloc(npmax*(is + 1)*sizeof(double));
+    if(opt.nspin[is]) input_fill(&in[is], &grid);
+  }
+  grid_end(&grid);
+
+  /* enough for the second derivatives of a polarized meta-GGA */
+  pool = (double *) malloc((size_t)npmax*28*sizeof(double));
+  if(pool == NULL){
+    fprintf(stderr, "Could not allocate the outputs of %d points\n", npmax);
+    exit(1);
+  }
+
+  bench_family("lda",     xc_lda_known_funct,     in, pool);
+  bench_family("gga",     xc_gga_known_funct,     in, pool);
+  bench_family("hyb_gga", xc_hyb_gga_known_funct, in, pool);
+  bench_family("mgga",    xc_mgga_known_funct,    in, pool);
+
+  if(opt.json && nresults > 0)
+    fprintf(opt.out, "\n]\n");
+
+  if(nbaseline > 0)
+    fprintf(stderr, "%d of %d cases are slower than the baseline by more than %g%%\n",
+	    nregressions, nresults, 100.0*opt.tolerance);
+
+  for(is=0; is<2; is++){
+    free(in[is].rho);
+    free(in[is].sigma);
+    free(in[is].lapl_rho);
+    free(in[is].tau);
+  }
+  free(pool);
+  if(opt.out != stdout) fclose(opt.out);
+  if(opt.stats != NULL) fclose(opt.stats);
+
+  return (nregressions > 0) ? 1 : 0;
+}
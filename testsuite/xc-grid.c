@@ -0,0 +1,659 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/************************************************************************
+  Integration grids of model densities.
+
+  Every atom (H to Kr) is described by the Slater-type shells of the
+  Slater rules: the electrons of a group (1s)(2s,2p)(3s,3p)(3d)(4s,4p)
+  occupy orbitals with radial part r^(n*-1) exp(-zeta r), with
+  zeta = Z_eff/n*. The groups are filled in the aufbau order (Cr and
+  Cu take one 4s electron into 3d), and the spins of each subshell by
+  Hund's rule. From the orbital densities we get analytically
+
+    rho_s = sum_g N_gs |phi_g|^2
+    grad rho_s, lapl rho_s
+    tau_s = sum_g N_gs [|grad |phi_g||^2/(8 |phi_g|^2) + l(l+1)/(2 r^2)] |phi_g|^2
+
+  so tau_s is never smaller than its von Weizsaecker limit. Molecules
+  are superpositions of these atoms. The points are those of Becke's
+  scheme: a Gauss-Chebyshev radial grid mapped by r = (1 + x)/(1 - x)
+  times a Gauss-Legendre x trapezoidal angular grid around each atom,
+  and the fuzzy cells of Becke for more than one atom. The radial
+  grids extend far into the tails, and the open shells give
+  near-polarized regions, so the branches that screen small densities
+  and gradients see realistic statistics.
+
+  The binary file is a header followed by the arrays, each one
+  starting at a multiple of 64 bytes, so it can be mapped directly.
+************************************************************************/
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "xc-grid.h"
+
+#define GRID_ZMAX      36
+#define GRID_NGROUPS    5
+#define GRID_NARRAYS    9
+#define GRID_ALIGN     64
+#define GRID_VERSION    1
+#define GRID_ENDIAN    0x01020304
+#define BOHR_ANGSTROM  0.52917721067
+
+static const char *symbols[GRID_ZMAX + 1] = {"",
+  "H",                                                                                  "He",
+  "Li", "Be",                                                  "B",  "C",  "N",  "O",  "F",  "Ne",
+  "Na", "Mg",                                                  "Al", "Si", "P",  "S",  "Cl", "Ar",
+  "K",  "Ca", "Sc", "Ti", "V",  "Cr", "Mn", "Fe", "Co", "Ni", "Cu", "Zn", "Ga", "Ge", "As", "Se", "Br", "Kr"
+};
+
+/* the groups of the Slater rules, in order */
+static const int    group_n    [GRID_NGROUPS] = {1,   2,   3,   3,   4};
+static const double group_nstar[GRID_NGROUPS] = {1.0, 2.0, 3.0, 3.0, 3.7};
+
+typedef struct {
+  int    nocc[2];     /* electrons of each spin   */
+  double ll;          /* average of l(l+1)        */
+  double a, m, norm;  /* |phi|^2 = norm r^m exp(-a r) */
+} group_type;
+
+typedef struct {
+  int ngroups;
+  group_type g[GRID_NGROUPS];
+} atom_type;
+
+/* the order of the arrays in the file, and their values per point */
+static const int array_width[GRID_NARRAYS] = {1, 1, 1, 1, 1, 2, 3, 2, 2};
+
+typedef struct {
+  char     magic[8];
+  uint32_t endian;
+  uint32_t version;
+  uint64_t np;
+  uint64_t offset[GRID_NARRAYS];
+} header_type;
+
+static const char grid_magic[8] = "XCGRID\0\0";
+
+
+int grid_symbol_to_z(const char *symbol)
+{
+  int z;
+
+  for(z=1; z<=GRID_ZMAX; z++)
+    if(strcmp(symbols[z], symbol) == 0) return z;
+  return 0;
+}
+
+
+/* the shells of the atom of atomic number Z */
+static void atom_init(atom_type *at, int Z)
+{
+  /* subshells in the aufbau order: 1s 2s 2p 3s 3p 4s 3d 4p */
+  static const int sub_l[8]     = {0, 0, 1, 0, 1, 0, 2, 1};
+  static const int sub_group[8] = {0, 1, 1, 2, 2, 4, 3, 4};
+  int occ[8], ne, is, ig, jg, k;
+  double ss;
+
+  for(ne=Z, is=0; is<8; is++){
+    occ[is] = (ne < 2*(2*sub_l[is] + 1)) ? ne : 2*(2*sub_l[is] + 1);
+    ne -= occ[is];
+  }
+  if(Z == 24 || Z == 29){  /* Cr and Cu */
+    occ[5]--;
+    occ[6]++;
+  }
+
+  at->ngroups = GRID_NGROUPS;
+  for(ig=0; ig<GRID_NGROUPS; ig++){
+    at->g[ig].nocc[0] = at->g[ig].nocc[1] = 0;
+    at->g[ig].ll = 0.0;
+  }
+
+  for(is=0; is<8; is++){
+    group_type *g = &at->g[sub_group[is]];
+    int up = (occ[is] < 2*sub_l[is] + 1) ? occ[is] : 2*sub_l[is] + 1;
+
+    g->nocc[0] += up;
+    g->nocc[1] += occ[is] - up;
+    g->ll      += occ[is]*sub_l[is]*(sub_l[is] + 1.0);
+  }
+
+  for(ig=0; ig<GRID_NGROUPS; ig++){
+    group_type *g = &at->g[ig];
+    double nstar = group_nstar[ig], zeta;
+
+    k = g->nocc[0] + g->nocc[1];
+    if(k == 0) continue;
+    g->ll /= k;
+
+    /* the screening of the electrons of the same group and of the previous ones */
+    ss = (k - 1)*((ig == 0) ? 0.30 : 0.35);
+    for(jg=0; jg<ig; jg++){
+      int nj = at->g[jg].nocc[0] + at->g[jg].nocc[1];
+
+      if(ig != 3 && group_n[jg] == group_n[ig] - 1)
+	ss += 0.85*nj;
+      else
+	ss += 1.00*nj;
+    }
+
+    zeta    = (Z - ss)/nstar;
+    g->a    = 2.0*zeta;
+    g->m    = 2.0*nstar - 2.0;
+    g->norm = pow(2.0*zeta, 2.0*nstar + 1.0)/(tgamma(2.0*nstar + 1.0)*4.0*M_PI);
+  }
+}
+
+
+/* adds the density of the atom at distance d (vector) to the spin channels */
+static void atom_add(const atom_type *at, const double d[3],
+		     double rho[2], double grad[2][3], double lapl[2], double tau[2])
+{
+  double r, dens, d1, d2, lr;
+  int ig, is, k;
+
+  r = sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+  if(r < 1e-10) r = 1e-10;
+
+  for(ig=0; ig<at->ngroups; ig++){
+    const group_type *g = &at->g[ig];
+
+    if(g->nocc[0] + g->nocc[1] == 0) continue;
+
+    /* the orbital density and its radial derivatives */
+    dens = g->norm*pow(r, g->m)*exp(-g->a*r);
+    if(dens == 0.0) continue;
+
+    d1 = dens*(g->m/r - g->a);
+    d2 = dens*((g->m/r - g->a)*(g->m/r - g->a) - g->m/(r*r));
+    lr = d2 + 2.0*d1/r;
+
+    for(is=0; is<2; is++){
+      if(g->nocc[is] == 0) continue;
+
+      rho[is]  += g->nocc[is]*dens;
+      lapl[is] += g->nocc[is]*lr;
+      tau[is]  += g->nocc[is]*(d1*d1/(8.0*dens) + g->ll*dens/(2.0*r*r));
+      for(k=0; k<3; k++)
+	grad[is][k] += g->nocc[is]*d1*d[k]/r;
+    }
+  }
+}
+
+
+static void grid_alloc(grid_type *g, size_t np)
+{
+  double *p;
+
+  g->np     = np;
+  g->size   = 14*np*sizeof(double);
+  g->data   = malloc(g->size);
+  g->mapped = 0;
+
+  if(g->data == NULL){
+    fprintf(stderr, "Could not allocate a grid of %lu points\n", (unsigned long)np);
+    exit(1);
+  }
+
+  p = (double *) g->data;
+  g->weight     = p;  p += np;
+  g->rho        = p;  p += np;
+  g->sigma      = p;  p += np;
+  g->lapl_rho   = p;  p += np;
+  g->tau        = p;  p += np;
+  g->rho_s      = p;  p += 2*np;
+  g->sigma_s    = p;  p += 3*np;
+  g->lapl_rho_s = p;  p += 2*np;
+  g->tau_s      = p;
+}
+
+
+/* Becke's fuzzy cell function of atom ia at point r */
+static double becke_cell(int natoms, const double *xyz, int ia, const double r[3])
+{
+  double cell = 1.0, dia, dib, rab, mu;
+  int ib, k;
+
+  dia = sqrt((r[0] - xyz[3*ia])*(r[0] - xyz[3*ia]) + (r[1] - xyz[3*ia+1])*(r[1] - xyz[3*ia+1]) +
+	     (r[2] - xyz[3*ia+2])*(r[2] - xyz[3*ia+2]));
+
+  for(ib=0; ib<natoms; ib++){
+    if(ib == ia) continue;
+
+    dib = sqrt((r[0] - xyz[3*ib])*(r[0] - xyz[3*ib]) + (r[1] - xyz[3*ib+1])*(r[1] - xyz[3*ib+1]) +
+	       (r[2] - xyz[3*ib+2])*(r[2] - xyz[3*ib+2]));
+    rab = sqrt((xyz[3*ia] - xyz[3*ib])*(xyz[3*ia] - xyz[3*ib]) + (xyz[3*ia+1] - xyz[3*ib+1])*(xyz[3*ia+1] - xyz[3*ib+1]) +
+	       (xyz[3*ia+2] - xyz[3*ib+2])*(xyz[3*ia+2] - xyz[3*ib+2]));
+
+    mu = (dia - dib)/rab;
+    for(k=0; k<3; k++)
+      mu = 1.5*mu - 0.5*mu*mu*mu;
+    cell *= 0.5*(1.0 - mu);
+  }
+
+  return cell;
+}
+
+
+/* the nodes and weights of the Gauss-Legendre quadrature in [-1, 1] */
+static void gauss_legendre(int n, double *x, double *w)
+{
+  double z, z1, p1, p2, p3, pp;
+  int i, j;
+
+  for(i=0; i<n; i++){
+    z = cos(M_PI*(i + 0.75)/(n + 0.5));
+    do{
+      p1 = 1.0;
+      p2 = 0.0;
+      for(j=0; j<n; j++){
+	p3 = p2;
+	p2 = p1;
+	p1 = ((2.0*j + 1.0)*z*p2 - j*p3)/(j + 1.0);
+      }
+      pp = n*(z*p1 - p2)/(z*z - 1.0);
+      z1 = z;
+      z  = z1 - p1/pp;
+    }while(fabs(z - z1) > 1e-15);
+
+    x[i] = z;
+    w[i] = 2.0/((1.0 - z*z)*pp*pp);
+  }
+}
+
+
+/* fills the points of the grids of the atoms, from point ip0 on */
+static void grid_fill(grid_type *g, size_t ip0, int natoms, const int *Z, const double *xyz, int nrad, int ntheta)
+{
+  atom_type *atoms;
+  double *ct, *wt, r[3], d[3], rho[2], grad[2][3], lapl[2], tau[2], gt[3];
+  size_t ip = ip0;
+  int ia, ja, ir, it, jp, is, k, nphi = 2*ntheta;
+
+  atoms = (atom_type *) malloc(natoms*sizeof(atom_type));
+  for(ia=0; ia<natoms; ia++)
+    atom_init(&atoms[ia], Z[ia]);
+
+  ct = (double *) malloc(2*ntheta*sizeof(double));
+  wt = ct + ntheta;
+  gauss_legendre(ntheta, ct, wt);
+
+  for(ia=0; ia<natoms; ia++)
+    for(ir=1; ir<=nrad; ir++){
+      double th = M_PI*ir/(nrad + 1.0), x = cos(th), rr, wr, cell, sum;
+
+      rr = (1.0 + x)/(1.0 - x);
+      wr = M_PI/(nrad + 1.0)*sin(th)*2.0/((1.0 - x)*(1.0 - x))*rr*rr;
+
+      for(it=0; it<ntheta; it++)
+	for(jp=0; jp<nphi; jp++){
+	  double st = sqrt(1.0 - ct[it]*ct[it]), phi = 2.0*M_PI*jp/nphi;
+
+	  r[0] = xyz[3*ia]     + rr*st*cos(phi);
+	  r[1] = xyz[3*ia + 1] + rr*st*sin(phi);
+	  r[2] = xyz[3*ia + 2] + rr*ct[it];
+
+	  g->weight[ip] = wr*wt[it]*2.0*M_PI/nphi;
+	  if(natoms > 1){
+	    cell = becke_cell(natoms, xyz, ia, r);
+	    for(sum=0.0, ja=0; ja<natoms; ja++)
+	      sum += becke_cell(natoms, xyz, ja, r);
+	    g->weight[ip] *= (sum > 0.0) ? cell/sum : 0.0;
+	  }
+
+	  rho[0] = rho[1] = lapl[0] = lapl[1] = tau[0] = tau[1] = 0.0;
+	  for(k=0; k<3; k++) grad[0][k] = grad[1][k] = 0.0;
+
+	  for(ja=0; ja<natoms; ja++){
+	    for(k=0; k<3; k++) d[k] = r[k] - xyz[3*ja + k];
+	    atom_add(&atoms[ja], d, rho, grad, lapl, tau);
+	  }
+
+	  for(is=0; is<2; is++){
+	    g->rho_s     [2*ip + is] = rho[is];
+	    g->lapl_rho_s[2*ip + is] = lapl[is];
+	    g->tau_s     [2*ip + is] = tau[is];
+	  }
+	  g->sigma_s[3*ip + 0] = grad[0][0]*grad[0][0] + grad[0][1]*grad[0][1] + grad[0][2]*grad[0][2];
+	  g->sigma_s[3*ip + 1] = grad[0][0]*grad[1][0] + grad[0][1]*grad[1][1] + grad[0][2]*grad[1][2];
+	  g->sigma_s[3*ip + 2] = grad[1][0]*grad[1][0] + grad[1][1]*grad[1][1] + grad[1][2]*grad[1][2];
+
+	  for(k=0; k<3; k++) gt[k] = grad[0][k] + grad[1][k];
+	  g->rho[ip]      = rho[0] + rho[1];
+	  g->sigma[ip]    = gt[0]*gt[0] + gt[1]*gt[1] + gt[2]*gt[2];
+	  g->lapl_rho[ip] = lapl[0] + lapl[1];
+	  g->tau[ip]      = tau[0] + tau[1];
+
+	  ip++;
+	}
+    }
+
+  free(ct);
+  free(atoms);
+}
+
+
+static int check_atoms(int natoms, const int *Z, int nrad, int ntheta)
+{
+  int ia;
+
+  if(nrad < 1 || ntheta < 1){
+    fprintf(stderr, "The grids need at least one radial and one angular point\n");
+    return -1;
+  }
+  for(ia=0; ia<natoms; ia++)
+    if(Z[ia] < 1 || Z[ia] > GRID_ZMAX){
+      fprintf(stderr, "There is no model density for atomic number %d\n", Z[ia]);
+      return -1;
+    }
+  return 0;
+}
+
+
+int grid_build(grid_type *g, int natoms, const int *Z, const double *xyz, int nrad, int ntheta)
+{
+  if(natoms < 1 || check_atoms(natoms, Z, nrad, ntheta) != 0) return -1;
+
+  grid_alloc(g, (size_t)natoms*nrad*2*ntheta*ntheta);
+  grid_fill(g, 0, natoms, Z, xyz, nrad, ntheta);
+
+  return 0;
+}
+
+
+/* the isolated atoms from zmin to zmax, one after the other */
+int grid_build_atoms(grid_type *g, int zmin, int zmax, int nrad, int ntheta)
+{
+  const double origin[3] = {0.0, 0.0, 0.0};
+  size_t npa = (size_t)nrad*2*ntheta*ntheta;
+  int z;
+
+  if(zmin > zmax) return -1;
+  if(check_atoms(1, &zmin, nrad, ntheta) != 0 || check_atoms(1, &zmax, nrad, ntheta) != 0) return -1;
+
+  grid_alloc(g, (zmax - zmin + 1)*npa);
+  for(z=zmin; z<=zmax; z++)
+    grid_fill(g, (z - zmin)*npa, 1, &z, origin, nrad, ntheta);
+
+  return 0;
+}
+
+
+/* reads a molecule in the xyz format (symbols and coordinates in angstrom) */
+int grid_read_xyz(const char *fname, int *natoms, int **Z, double **xyz)
+{
+  char line[256], sym[8];
+  double x, y, z;
+  int ia;
+  FILE *in;
+
+  in = fopen(fname, "r");
+  if(in == NULL){
+    fprintf(stderr, "Could not open '%s'\n", fname);
+    return -1;
+  }
+
+  if(fgets(line, sizeof(line), in) == NULL || sscanf(line, "%d", natoms) != 1 || *natoms < 1 ||
+     fgets(line, sizeof(line), in) == NULL){
+    fprintf(stderr, "'%s' is not an xyz file\n", fname);
+    fclose(in);
+    return -1;
+  }
+
+  *Z   = (int *)    malloc(*natoms*sizeof(int));
+  *xyz = (double *) malloc(3*(*natoms)*sizeof(double));
+
+  for(ia=0; ia<*natoms; ia++){
+    if(fgets(line, sizeof(line), in) == NULL || sscanf(line, "%7s %lf %lf %lf", sym, &x, &y, &z) != 4){
+      fprintf(stderr, "'%s' has less than %d atoms\n", fname, *natoms);
+      fclose(in);
+      return -1;
+    }
+    sym[0] = toupper(sym[0]);
+    if(sym[1] != '\0') sym[1] = tolower(sym[1]);
+
+    (*Z)[ia] = grid_symbol_to_z(sym);
+    (*xyz)[3*ia + 0] = x/BOHR_ANGSTROM;
+    (*xyz)[3*ia + 1] = y/BOHR_ANGSTROM;
+    (*xyz)[3*ia + 2] = z/BOHR_ANGSTROM;
+    if((*Z)[ia] == 0){
+      fprintf(stderr, "Unknown element '%s' in '%s'\n", sym, fname);
+      fclose(in);
+      return -1;
+    }
+  }
+
+  fclose(in);
+  return 0;
+}
+
+
+static void grid_arrays(const grid_type *g, double *arrays[GRID_NARRAYS])
+{
+  arrays[0] = g->weight;
+  arrays[1] = g->rho;
+  arrays[2] = g->sigma;
+  arrays[3] = g->lapl_rho;
+  arrays[4] = g->tau;
+  arrays[5] = g->rho_s;
+  arrays[6] = g->sigma_s;
+  arrays[7] = g->lapl_rho_s;
+  arrays[8] = g->tau_s;
+}
+
+
+static uint64_t grid_layout(uint64_t np, header_type *h)
+{
+  uint64_t pos;
+  int ii;
+
+  memset(h, 0, sizeof(header_type));
+  memcpy(h->magic, grid_magic, 8);
+  h->endian  = GRID_ENDIAN;
+  h->version = GRID_VERSION;
+  h->np      = np;
+
+  pos = sizeof(header_type);
+  for(ii=0; ii<GRID_NARRAYS; ii++){
+    pos = (pos + GRID_ALIGN - 1)/GRID_ALIGN*GRID_ALIGN;
+    h->offset[ii] = pos;
+    pos += array_width[ii]*np*sizeof(double);
+  }
+
+  return pos;
+}
+
+
+int grid_write(const grid_type *g, const char *fname)
+{
+  static const char zeros[GRID_ALIGN] = {0};
+  header_type h;
+  double *arrays[GRID_NARRAYS];
+  uint64_t pos;
+  int ii;
+  FILE *out;
+
+  out = fopen(fname, "wb");
+  if(out == NULL){
+    fprintf(stderr, "Could not open '%s' for writing\n", fname);
+    return -1;
+  }
+
+  grid_layout(g->np, &h);
+  grid_arrays(g, arrays);
+
+  fwrite(&h, sizeof(header_type), 1, out);
+  pos = sizeof(header_type);
+  for(ii=0; ii<GRID_NARRAYS; ii++){
+    fwrite(zeros, 1, h.offset[ii] - pos, out);
+    fwrite(arrays[ii], sizeof(double), array_width[ii]*g->np, out);
+    pos = h.offset[ii] + array_width[ii]*g->np*sizeof(double);
+  }
+
+  if(fclose(out) != 0){
+    fprintf(stderr, "Could not write '%s'\n", fname);
+    return -1;
+  }
+  return 0;
+}
+
+
+/* maps a file written by grid_write. The pages are private, so the
+   arrays can be modified without changing the file. */
+int grid_map(grid_type *g, const char *fname)
+{
+  header_type h, ref;
+  double *arrays[GRID_NARRAYS];
+  char *base;
+  size_t size;
+  int ii;
+
+#ifdef HAVE_MMAP
+  struct stat st;
+  int fd;
+
+  fd = open(fname, O_RDONLY);
+  if(fd < 0 || fstat(fd, &st) != 0){
+    fprintf(stderr, "Could not open '%s'\n", fname);
+    if(fd >= 0) close(fd);
+    return -1;
+  }
+  size = st.st_size;
+
+  base = (size < sizeof(header_type)) ? MAP_FAILED :
+    (char *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(base == MAP_FAILED){
+    fprintf(stderr, "Could not map '%s'\n", fname);
+    return -1;
+  }
+  g->mapped = 1;
+#else
+  FILE *in;
+
+  in = fopen(fname, "rb");
+  if(in == NULL){
+    fprintf(stderr, "Could not open '%s'\n", fname);
+    return -1;
+  }
+  fseek(in, 0, SEEK_END);
+  size = ftell(in);
+  fseek(in, 0, SEEK_SET);
+  base = (char *) malloc(size);
+  if(base == NULL || fread(base, 1, size, in) != size){
+    fprintf(stderr, "Could not read '%s'\n", fname);
+    fclose(in);
+    free(base);
+    return -1;
+  }
+  fclose(in);
+  g->mapped = 0;
+#endif
+
+  g->data = base;
+  g->size = size;
+
+  memcpy(&h, base, (size < sizeof(header_type)) ? size : sizeof(header_type));
+  if(size < sizeof(header_type) || memcmp(h.magic, grid_magic, 8) != 0 ||
+     h.endian != GRID_ENDIAN || h.version != GRID_VERSION ||
+     grid_layout(h.np, &ref) != size || memcmp(h.offset, ref.offset, sizeof(h.offset)) != 0){
+    fprintf(stderr, "'%s' is not a grid of this version and machine\n", fname);
+    grid_end(g);
+    return -1;
+  }
+
+  g->np = h.np;
+  for(ii=0; ii<GRID_NARRAYS; ii++)
+    arrays[ii] = (double *) (base + h.offset[ii]);
+
+  g->weight     = arrays[0];
+  g->rho        = arrays[1];
+  g->sigma      = arrays[2];
+  g->lapl_rho   = arrays[3];
+  g->tau        = arrays[4];
+  g->rho_s      = arrays[5];
+  g->sigma_s    = arrays[6];
+  g->lapl_rho_s = arrays[7];
+  g->tau_s      = arrays[8];
+
+  return 0;
+}
+
+
+void grid_end(grid_type *g)
+{
+#ifdef HAVE_MMAP
+  if(g->mapped)
+    munmap(g->data, g->size);
+  else
+#endif
+    free(g->data);
+
+  g->data = NULL;
+  g->np   = 0;
+}
+
+
+/* what the library sees of the grid: the integrals, and how many
+   points fall into its screening of small densities and gradients */
+void grid_stats(const grid_type *g, FILE *out)
+{
+  const double min_dens = 5.0e-13, min_grad = 5.0e-13;
+  double nel[2] = {0.0, 0.0}, kin = 0.0, zeta;
+  size_t ip, nsmall = 0, nflat = 0, npol = 0, nin = 0;
+  int is;
+
+  for(ip=0; ip<g->np; ip++){
+    for(is=0; is<2; is++)
+      nel[is] += g->weight[ip]*g->rho_s[2*ip + is];
+    kin += g->weight[ip]*g->tau[ip];
+
+    if(g->rho[ip] < min_dens){
+      nsmall++;
+      continue;
+    }
+    nin++;
+
+    if(sqrt(g->sigma[ip])/2.0 < min_grad) nflat++;
+
+    zeta = (g->rho_s[2*ip] - g->rho_s[2*ip + 1])/g->rho[ip];
+    if(fabs(zeta) > 0.99) npol++;
+  }
+
+  fprintf(out, "points                          %lu\n", (unsigned long)g->np);
+  fprintf(out, "electrons (up, down)            %.6f  %.6f\n", nel[0], nel[1]);
+  fprintf(out, "kinetic energy                  %.6f\n", kin);
+  fprintf(out, "points with rho < %.0e        %.2f%%\n", min_dens, 100.0*nsmall/g->np);
+  fprintf(out, "  of the others, |grad| < %.0e %.2f%%\n", min_grad, (nin > 0) ? 100.0*nflat/nin : 0.0);
+  fprintf(out, "  of the others, |zeta| > 0.99  %.2f%%\n", (nin > 0) ? 100.0*npol/nin : 0.0);
+}
@@ -0,0 +1,54 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _XC_GRID_H
+#define _XC_GRID_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* Integration grids of model densities, used by the benchmarks and
+   the regression tests (see xc-grid.c for the models). Both spin
+   layouts are stored: the unpolarized arrays have one value per
+   point, the polarized ones are interleaved as the library expects
+   (2 values of rho, lapl_rho and tau, 3 of sigma). */
+typedef struct {
+  size_t  np;                                   /* number of points                 */
+  double *weight;                               /* quadrature weights               */
+  double *rho,   *sigma,   *lapl_rho,   *tau;   /* unpolarized                      */
+  double *rho_s, *sigma_s, *lapl_rho_s, *tau_s; /* polarized                        */
+
+  void   *data;                                 /* the memory behind the arrays     */
+  size_t  size;                                 /* its size in bytes                */
+  int     mapped;                               /* 1 if data is a map of a file     */
+} grid_type;
+
+int  grid_symbol_to_z(const char *symbol);
+
+/* the atoms are given by their atomic numbers (1 to 36) and positions in bohr */
+int  grid_build      (grid_type *g, int natoms, const int *Z, const double *xyz, int nrad, int ntheta);
+int  grid_build_atoms(grid_type *g, int zmin, int zmax, int nrad, int ntheta);
+int  grid_read_xyz   (const char *fname, int *natoms, int **Z, double **xyz);
+
+int  grid_write(const grid_type *g, const char *fname);
+int  grid_map  (grid_type *g, const char *fname);
+void grid_end  (grid_type *g);
+
+void grid_stats(const grid_type *g, FILE *out);
+
+#endif
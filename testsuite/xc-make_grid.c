@@ -0,0 +1,98 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* xc-make_grid: writes the grid of model densities of a molecule, or
+   of a range of isolated atoms, to a file that xc-bench --grid and
+   the tests can map. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xc-grid.h"
+
+static void usage(const char *prog)
+{
+  printf("Usage: %s [options] FILE\n\n", prog);
+  printf("  --xyz FILE       the molecule in FILE, in the xyz format (angstrom)\n");
+  printf("  --atoms Z1-Z2    the isolated atoms from Z1 to Z2 (1-36, the default)\n");
+  printf("  --nrad N         radial points of each atom (75)\n");
+  printf("  --ntheta N       polar angles; the azimuthal ones are twice as many (8)\n");
+}
+
+int main(int argc, char *argv[])
+{
+  grid_type grid;
+  const char *xyz_file = NULL, *out_file = NULL;
+  int zmin = 1, zmax = 36, nrad = 75, ntheta = 8;
+  int ii, natoms, *Z, ierr;
+  double *xyz;
+
+  for(ii=1; ii<argc; ii++){
+    const char *arg = argv[ii], *val = (ii + 1 < argc) ? argv[ii + 1] : NULL;
+
+    if(strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0){
+      usage(argv[0]);
+      return 0;
+    }
+    if(arg[0] != '-'){
+      out_file = arg;
+      continue;
+    }
+    if(val == NULL){
+      fprintf(stderr, "Option '%s' needs a value\n", arg);
+      exit(1);
+    }
+    ii++;
+
+    if(strcmp(arg, "--xyz") == 0)
+      xyz_file = val;
+    else if(strcmp(arg, "--atoms") == 0){
+      if(sscanf(val, "%d-%d", &zmin, &zmax) != 2) zmax = zmin;
+    }else if(strcmp(arg, "--nrad") == 0)
+      nrad = atoi(val);
+    else if(strcmp(arg, "--ntheta") == 0)
+      ntheta = atoi(val);
+    else{
+      fprintf(stderr, "Unknown option '%s'\n", arg);
+      usage(argv[0]);
+      exit(1);
+    }
+  }
+
+  if(out_file == NULL){
+    usage(argv[0]);
+    exit(1);
+  }
+
+  if(xyz_file != NULL){
+    if(grid_read_xyz(xyz_file, &natoms, &Z, &xyz) != 0) exit(1);
+    ierr = grid_build(&grid, natoms, Z, xyz, nrad, ntheta);
+    free(Z);
+    free(xyz);
+  }else
+    ierr = grid_build_atoms(&grid, zmin, zmax, nrad, ntheta);
+
+  if(ierr != 0) exit(1);
+
+  grid_stats(&grid, stdout);
+  if(grid_write(&grid, out_file) != 0) exit(1);
+  grid_end(&grid);
+
+  return 0;
+}
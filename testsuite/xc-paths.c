@@ -0,0 +1,578 @@
+/*
+ Copyright (C) 2006-2007 M.A.L. Marques
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* Compares the optional ways of evaluating a functional with the
+   default one, point by point. The exit code is the number of checks
+   that failed. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <xc.h>
+
+#define max(x,y)  ((x<y) ? (y) : (x))
+
+/* number of points: several blocks of every driver */
+#define NP 1000
+
+static const int test_funcs[] = {
+  XC_LDA_X, XC_GGA_X_PBE, XC_GGA_C_PBE, XC_GGA_XC_HCTH_93, XC_HYB_GGA_XC_B3LYP
+};
+#define NFUNCS ((int) (sizeof(test_funcs)/sizeof(test_funcs[0])))
+
+typedef struct{
+  double zk[NP], vrho[2*NP], vsigma[3*NP];
+} results;
+
+/* the points, in the default (interleaved) layout */
+static double rho[2*NP], sigma[3*NP], weights[NP];
+
+/* largest polarization of the points; close to full polarization the
+   minority spin cancels large terms, and approximations lose relative accuracy */
+static double zeta_max = 1.0;
+
+static int nfail = 0;
+
+/*----------------------------------------------------------*/
+static double rnd()
+{
+  static unsigned long seed = 1;
+
+  seed = (seed*1103515245 + 12345) % 2147483648UL;
+  return (double) seed/2147483648.0;
+}
+
+/* densities from 1e-12 to 1e4, reduced gradients from 0 to 5 */
+static void make_points(int nspin)
+{
+  double ss[2], dens, zeta;
+  int ip, is;
+
+  for(ip=0; ip<NP; ip++){
+    for(is=0; is<nspin; is++)
+      rho[nspin*ip + is] = pow(10.0, -12.0 + 16.0*rnd());
+
+    if(nspin == 2){
+      dens = rho[2*ip] + rho[2*ip + 1];
+      zeta = (rho[2*ip] - rho[2*ip + 1])/dens;
+      if(fabs(zeta) > zeta_max){
+	zeta = (zeta > 0.0) ? zeta_max : -zeta_max;
+	rho[2*ip]     = 0.5*dens*(1.0 + zeta);
+	rho[2*ip + 1] = 0.5*dens*(1.0 - zeta);
+      }
+    }
+
+    for(is=0; is<nspin; is++)
+      ss[is] = 5.0*rnd()*pow(rho[nspin*ip + is], 4.0/3.0);
+
+    if(nspin == 1)
+      sigma[ip] = ss[0]*ss[0];
+    else{
+      sigma[3*ip]     = ss[0]*ss[0];
+      sigma[3*ip + 1] = (2.0*rnd() - 1.0)*ss[0]*ss[1];
+      sigma[3*ip + 2] = ss[1]*ss[1];
+    }
+
+    weights[ip] = rnd();
+  }
+}
+
+static int is_gga(const xc_func_type *p)
+{
+  return (p->info->family == XC_FAMILY_GGA || p->info->family == XC_FAMILY_HYB_GGA);
+}
+
+/* the default entry points, for all the points */
+static void evaluate(const xc_func_type *p, results *r)
+{
+  if(is_gga(p))
+    xc_gga_exc_vxc(p, NP, rho, sigma, r->zk, r->vrho, r->vsigma);
+  else
+    xc_lda_exc_vxc(p, NP, rho, r->zk, r->vrho);
+}
+
+
+/*----------------------------------------------------------*/
+/* largest difference of val and ref, relative to ref where it is not tiny */
+static double max_diff(int n, const double *ref, const double *val)
+{
+  double diff, max = 0.0;
+  int i;
+
+  for(i=0; i<n; i++){
+    diff = fabs(val[i] - ref[i]);
+    if(fabs(ref[i]) > 1e-12)
+      diff /= fabs(ref[i]);
+    if(!(diff <= max)) max = diff; /* catches the NaNs too */
+  }
+
+  return max;
+}
+
+static void report(const char *what, double diff, double tol)
+{
+  printf(" :: %-66s %9.2e  %s\n", what, diff, (diff <= tol) ? "ok" : "FAILED");
+  if(!(diff <= tol)) nfail++;
+}
+
+/* compares the energies and the potentials of p */
+static void compare(const char *what, const xc_func_type *p, const results *ref, const results *val, double tol)
+{
+  char line[200];
+  double diff;
+
+  diff = max(max_diff(NP, ref->zk, val->zk), max_diff(p->nspin*NP, ref->vrho, val->vrho));
+  if(is_gga(p))
+    diff = max(diff, max_diff((p->nspin == 1 ? 1 : 3)*NP, ref->vsigma, val->vsigma));
+
+  sprintf(line, "%3d %s, nspin %d: %s", p->info->number, p->info->name, p->nspin, what);
+  report(line, diff, tol);
+}
+
+/* calls test for all the functionals of test_funcs, unpolarized and
+   polarized, with the results of the default path in ref */
+static void for_each_functional(void (*test)(xc_func_type *p, const results *ref))
+{
+  static results ref;
+  xc_func_type func;
+  int ii, nspin;
+
+  for(ii=0; ii<NFUNCS; ii++)
+    for(nspin=1; nspin<=2; nspin++){
+      make_points(nspin);
+
+      xc_func_init(&func, test_funcs[ii], nspin);
+      evaluate(&func, &ref);
+      test(&func, &ref);
+      xc_func_end(&func);
+    }
+}
+
+
+/*----------------------------------------------------------*/
+/* the blocks of points shared among several threads */
+static void test_threads(xc_func_type *p, const results *ref)
+{
+  static results r;
+
+  xc_func_set_nthreads(p, 4);
+  evaluate(p, &r);
+  compare("4 threads", p, ref, &r, 1e-14);
+}
+
+
+/*----------------------------------------------------------*/
+/* the integrated energy and the weighted potentials, written and
+   accumulated onto the default ones */
+static void test_weighted(xc_func_type *p, const results *ref)
+{
+  static results expected, r;
+  double exc, exc_ref, dens;
+  char what[100];
+  int ns, nsig, ip, ii, accumulate;
+
+  ns   = p->nspin;
+  nsig = (ns == 1) ? 1 : 3;
+
+  exc_ref = 0.0;
+  for(ip=0; ip<NP; ip++){
+    dens = (ns == 1) ? rho[ip] : rho[2*ip] + rho[2*ip + 1];
+    exc_ref += weights[ip]*dens*ref->zk[ip];
+  }
+  memcpy(expected.zk, ref->zk, NP*sizeof(double));
+  memcpy(r.zk,        ref->zk, NP*sizeof(double));
+
+  for(accumulate=0; accumulate<2; accumulate++){
+    for(ip=0; ip<NP; ip++){
+      for(ii=0; ii<ns; ii++){
+	expected.vrho[ns*ip + ii] = (accumulate + weights[ip])*ref->vrho[ns*ip + ii];
+	r.vrho[ns*ip + ii] = ref->vrho[ns*ip + ii];
+      }
+      for(ii=0; ii<nsig; ii++){
+	expected.vsigma[nsig*ip + ii] = (accumulate + weights[ip])*ref->vsigma[nsig*ip + ii];
+	r.vsigma[nsig*ip + ii] = ref->vsigma[nsig*ip + ii];
+      }
+    }
+
+    if(is_gga(p))
+      xc_gga_exc_vxc_weighted(p, NP, rho, sigma, weights, &exc, r.vrho, r.vsigma, accumulate);
+    else
+      xc_lda_exc_vxc_weighted(p, NP, rho, weights, &exc, r.vrho, accumulate);
+
+    sprintf(what, "weighted, accumulate %d", accumulate);
+    compare(what, p, &expected, &r, 1e-14);
+  }
+
+  sprintf(what, "%3d %s, nspin %d: integrated energy", p->info->number, p->info->name, ns);
+  report(what, fabs(exc - exc_ref)/fabs(exc_ref), 1e-13);
+}
+
+
+/*----------------------------------------------------------*/
+/* the spin-planar layout, with a leading dimension larger than the
+   number of points */
+#define LD (NP + 8)
+
+static void to_planar(int nc, const double *in, double *out)
+{
+  int ip, ic;
+
+  for(ip=0; ip<NP; ip++)
+    for(ic=0; ic<nc; ic++)
+      out[ip + ic*LD] = in[nc*ip + ic];
+}
+
+static void from_planar(int nc, const double *in, double *out)
+{
+  int ip, ic;
+
+  for(ip=0; ip<NP; ip++)
+    for(ic=0; ic<nc; ic++)
+      out[nc*ip + ic] = in[ip + ic*LD];
+}
+
+static void test_planar(xc_func_type *p, const results *ref)
+{
+  static double rho_p[2*LD], sigma_p[3*LD], zk_p[LD], vrho_p[2*LD], vsigma_p[3*LD];
+  static results r;
+  int ns, nsig;
+
+  ns   = p->nspin;
+  nsig = (ns == 1) ? 1 : 3;
+
+  to_planar(ns, rho, rho_p);
+  to_planar(nsig, sigma, sigma_p);
+
+  xc_func_set_layout_planar(p, LD);
+  if(is_gga(p))
+    xc_gga_exc_vxc(p, NP, rho_p, sigma_p, zk_p, vrho_p, vsigma_p);
+  else
+    xc_lda_exc_vxc(p, NP, rho_p, zk_p, vrho_p);
+
+  from_planar(1, zk_p, r.zk);
+  from_planar(ns, vrho_p, r.vrho);
+  if(is_gga(p))
+    from_planar(nsig, vsigma_p, r.vsigma);
+
+  compare("planar layout", p, ref, &r, 1e-14);
+}
+
+
+/*----------------------------------------------------------*/
+/* the entry points that count the points with a size_t */
+static void test_64(xc_func_type *p, const results *ref)
+{
+  static results r, rw, rw64;
+  double exc, exc64;
+  char what[100];
+
+  if(is_gga(p)){
+    xc_gga64(p, (size_t) NP, rho, sigma, r.zk, r.vrho, r.vsigma, NULL, NULL, NULL);
+    xc_gga_exc_vxc_weighted  (p, NP, rho, sigma, weights, &exc, rw.vrho, rw.vsigma, 0);
+    xc_gga_exc_vxc_weighted64(p, (size_t) NP, rho, sigma, weights, &exc64, rw64.vrho, rw64.vsigma, 0);
+  }else{
+    xc_lda64(p, (size_t) NP, rho, r.zk, r.vrho, NULL, NULL);
+    xc_lda_exc_vxc_weighted  (p, NP, rho, weights, &exc, rw.vrho, 0);
+    xc_lda_exc_vxc_weighted64(p, (size_t) NP, rho, weights, &exc64, rw64.vrho, 0);
+  }
+  compare("64-bit", p, ref, &r, 0.0);
+
+  memcpy(rw.zk,   ref->zk, NP*sizeof(double));
+  memcpy(rw64.zk, ref->zk, NP*sizeof(double));
+  compare("64-bit weighted potential", p, &rw, &rw64, 0.0);
+
+  sprintf(what, "%3d %s, nspin %d: 64-bit integrated energy", p->info->number, p->info->name, p->nspin);
+  report(what, fabs(exc64 - exc)/fabs(exc), 0.0);
+}
+
+
+/*----------------------------------------------------------*/
+static void fill(results *r, double val)
+{
+  int i;
+
+  for(i=0; i<NP;   i++) r->zk[i]     = val;
+  for(i=0; i<2*NP; i++) r->vrho[i]   = val;
+  for(i=0; i<3*NP; i++) r->vsigma[i] = val;
+}
+
+/* the output modes: every output has to be written once when
+   overwriting, so that no NaN survives, and added when accumulating */
+static void test_output_mode(xc_func_type *p, const results *ref)
+{
+  static results r, expected;
+  int i;
+
+  fill(&r, NAN);
+  xc_func_set_output_mode(p, XC_OUTPUT_OVERWRITE);
+  evaluate(p, &r);
+  compare("overwrite", p, ref, &r, 0.0);
+
+  for(i=0; i<NP;   i++) expected.zk[i]     = 1.0 + ref->zk[i];
+  for(i=0; i<2*NP; i++) expected.vrho[i]   = 1.0 + ref->vrho[i];
+  for(i=0; i<3*NP; i++) expected.vsigma[i] = 1.0 + ref->vsigma[i];
+
+  fill(&r, 1.0);
+  xc_func_set_output_mode(p, XC_OUTPUT_ACCUMULATE);
+  evaluate(p, &r);
+  compare("accumulate", p, &expected, &r, 1e-15);
+}
+
+
+/* the kernels by finite differences take and return interleaved
+   arrays, and overwrite them, whatever the output mode and the layout.
+   They are declared in util.h, which is not installed */
+void xc_lda_fxc_fd(const xc_func_type *p, int np, const double *rho, double *fxc);
+void xc_lda_kxc_fd(const xc_func_type *p, int np, const double *rho, double *kxc);
+
+static void test_lda_fd(xc_func_type *p, const results *ref)
+{
+  static double fxc_ref[3*NP], kxc_ref[4*NP], fxc[3*NP], kxc[4*NP];
+  char what[100];
+  int i;
+
+  if(is_gga(p)) return;
+
+  xc_lda_fxc_fd(p, NP, rho, fxc_ref);
+  xc_lda_kxc_fd(p, NP, rho, kxc_ref);
+
+  for(i=0; i<3*NP; i++) fxc[i] = 1.0;
+  for(i=0; i<4*NP; i++) kxc[i] = 1.0;
+  xc_func_set_output_mode(p, XC_OUTPUT_ACCUMULATE);
+  xc_lda_fxc_fd(p, NP, rho, fxc);
+  xc_lda_kxc_fd(p, NP, rho, kxc);
+  xc_func_set_output_mode(p, XC_OUTPUT_OVERWRITE);
+
+  sprintf(what, "%3d %s, nspin %d: fxc and kxc by differences, accumulate", p->info->number, p->info->name, p->nspin);
+  report(what, max(max_diff((p->nspin == 1 ? 1 : 3)*NP, fxc_ref, fxc), max_diff((p->nspin == 1 ? 1 : 4)*NP, kxc_ref, kxc)), 0.0);
+
+  for(i=0; i<3*NP; i++) fxc[i] = NAN;
+  for(i=0; i<4*NP; i++) kxc[i] = NAN;
+  xc_func_set_layout_planar(p, LD);
+  xc_lda_fxc_fd(p, NP, rho, fxc);
+  xc_lda_kxc_fd(p, NP, rho, kxc);
+
+  sprintf(what, "%3d %s, nspin %d: fxc and kxc by differences, planar layout", p->info->number, p->info->name, p->nspin);
+  report(what, max(max_diff((p->nspin == 1 ? 1 : 3)*NP, fxc_ref, fxc), max_diff((p->nspin == 1 ? 1 : 4)*NP, kxc_ref, kxc)), 0.0);
+}
+
+
+/*----------------------------------------------------------*/
+/* the spline tables of the uniform gas, in the functional or in its
+   auxiliary functionals */
+static void test_lda_table(xc_func_type *p, const results *ref)
+{
+  static results r;
+  char what[100];
+  int ntables;
+
+  ntables = xc_func_set_lda_table(p, 1e-10);
+  evaluate(p, &r);
+
+  /* the energies are tabulated to 1e-10; the potentials are derivatives
+     of the table, and HCTH takes differences of them */
+  sprintf(what, "%d LDA tables", ntables);
+  compare(what, p, ref, &r, 1e-6);
+}
+
+
+/*----------------------------------------------------------*/
+/* the spline tables of the exchange enhancement factors */
+static void test_gga_x_table(xc_func_type *p, const results *ref)
+{
+  static results r;
+  char what[100];
+  int ntables;
+
+  ntables = xc_func_set_gga_x_table(p, 1e-10);
+  evaluate(p, &r);
+
+  /* f and x dfdx are tabulated to 1e-10 */
+  sprintf(what, "%d exchange tables", ntables);
+  compare(what, p, ref, &r, 1e-8);
+}
+
+
+/*----------------------------------------------------------*/
+/* the copies share nothing with the functional they come from */
+static void test_copy(xc_func_type *p, const results *ref)
+{
+  static results r, r_tab;
+  xc_func_type copy, *clone;
+
+  /* a copy of a clone, used after the clone is freed */
+  clone = xc_func_clone(p);
+  xc_func_copy(&copy, clone);
+  xc_func_end(clone);
+
+  evaluate(&copy, &r);
+  compare("copy of a clone", &copy, ref, &r, 0.0);
+  xc_func_end(&copy);
+
+  /* the tables go with the copies */
+  xc_func_set_lda_table(p, 1e-10);
+  xc_func_set_gga_x_table(p, 1e-10);
+  evaluate(p, &r_tab);
+
+  clone = xc_func_clone(p);
+  evaluate(clone, &r);
+  compare("clone with the tables", clone, &r_tab, &r, 0.0);
+  xc_func_end(clone);
+}
+
+
+/*----------------------------------------------------------*/
+/* the names and the ids of all the functionals, both ways */
+static void test_lookup()
+{
+  static const char *unknown[] = {"", "xc_", "XC_", "gga_x_pbee", "gga_x_pb", "lda_x ",
+				  "gga_x_pbe_gga_x_pbe_gga_x_pbe_gga_x_pbe_gga_x_pbe_gga_x_pbe_gga_x_pbe"};
+  const char *name;
+  char key[100];
+  int *list, nfunc, ii, id, ic, nbad;
+
+  nfunc = xc_number_of_functionals();
+  list  = (int *) malloc(nfunc*sizeof(int));
+  xc_available_functional_numbers(list);
+
+  /* the lowercase name, with and without the prefix, and the uppercase one */
+  nbad = 0;
+  for(ii=0; ii<nfunc; ii++){
+    id   = list[ii];
+    name = xc_functional_get_name(id);
+    if((ii > 0 && id <= list[ii - 1]) || name == NULL || strlen(name) > 80){
+      nbad++;
+      continue;
+    }
+
+    sprintf(key, "xc_%s", name);
+    if(xc_functional_get_number(key + 3) != id || xc_functional_get_number(key) != id)
+      nbad++;
+
+    for(ic=0; key[ic] != '\0'; ic++)
+      key[ic] = toupper((unsigned char) key[ic]);
+    if(xc_functional_get_number(key + 3) != id || xc_functional_get_number(key) != id)
+      nbad++;
+  }
+  sprintf(key, "ids and names of the %d functionals", nfunc);
+  report(key, nbad, 0.0);
+
+  /* the ids between the functionals have no names */
+  nbad = 0;
+  for(ii=0, id=0; id<=list[nfunc - 1] + 1; id++){
+    if(ii < nfunc && id == list[ii]){
+      ii++;
+      continue;
+    }
+    if(xc_functional_get_name(id) != NULL) nbad++;
+  }
+  if(xc_functional_get_name(-1) != NULL) nbad++;
+  report("ids without a functional", nbad, 0.0);
+
+  nbad = (xc_functional_get_number(NULL) != -1);
+  for(ii=0; ii<(int) (sizeof(unknown)/sizeof(unknown[0])); ii++)
+    if(xc_functional_get_number(unknown[ii]) != -1) nbad++;
+  report("unknown names", nbad, 0.0);
+
+  free(list);
+}
+
+
+/*----------------------------------------------------------*/
+/* the table of the integrals of the 1D exchange against the quadrature */
+#define NP_1D 33
+
+static void test_lda_x_1d()
+{
+  xc_func_type tab, quad;
+  double rho_1d[2*NP_1D], zk[2][NP_1D], vrho[2][2*NP_1D], r;
+  char what[100];
+  int interaction, nspin, ip;
+
+  for(interaction=0; interaction<2; interaction++)
+    for(nspin=1; nspin<=2; nspin++){
+      /* from 1e-10 to 2e5, across both ends of the table */
+      for(ip=0, r=1e-10; ip<NP_1D; ip++, r*=3.0){
+	if(nspin == 1)
+	  rho_1d[ip] = r;
+	else{
+	  rho_1d[2*ip] = 0.7*r; rho_1d[2*ip + 1] = 0.3*r;
+	}
+      }
+
+      xc_func_init(&tab,  XC_LDA_X_1D, nspin);
+      xc_func_init(&quad, XC_LDA_X_1D, nspin);
+      xc_lda_x_1d_set_params(&tab,  interaction, 1.0);
+      xc_lda_x_1d_set_params(&quad, interaction, 1.0);
+      xc_lda_x_1d_set_quadrature(&quad, 1);
+
+      xc_lda_exc_vxc(&tab,  NP_1D, rho_1d, zk[0], vrho[0]);
+      xc_lda_exc_vxc(&quad, NP_1D, rho_1d, zk[1], vrho[1]);
+
+      sprintf(what, "1D exchange, interaction %d, nspin %d: table", interaction, nspin);
+      report(what, max(max_diff(NP_1D, zk[1], zk[0]), max_diff(nspin*NP_1D, vrho[1], vrho[0])), 1e-9);
+
+      xc_func_end(&tab);
+      xc_func_end(&quad);
+    }
+}
+
+
+/*----------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+  printf("Threads\n");
+  for_each_functional(test_threads);
+
+  printf("Weighted quadrature\n");
+  for_each_functional(test_weighted);
+
+  printf("Spin-planar layout\n");
+  for_each_functional(test_planar);
+
+  printf("64-bit entry points\n");
+  for_each_functional(test_64);
+
+  printf("Output modes\n");
+  for_each_functional(test_output_mode);
+
+  printf("Kernels by finite differences\n");
+  for_each_functional(test_lda_fd);
+
+  printf("Tables of the uniform gas\n");
+  zeta_max = 0.9;
+  for_each_functional(test_lda_table);
+  zeta_max = 1.0;
+
+  printf("Tables of the exchange enhancement factors\n");
+  for_each_functional(test_gga_x_table);
+
+  printf("Copies\n");
+  for_each_functional(test_copy);
+
+  printf("Names of the functionals\n");
+  test_lookup();
+
+  printf("Table of the 1D exchange\n");
+  test_lda_x_1d();
+
+  return nfail;
+}
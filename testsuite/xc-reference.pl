@@ -18,13 +18,14 @@
 
 use Getopt::Std;
 
-getopts("hf:s:b:");
+getopts("hf:s:b:o:");
 $opt_h && usage();
 $opt_f || usage();
 
 # Handle options
 $top_srcdir   = ($opt_s ? $opt_s : "..");
 $top_builddir = ($opt_b ? $opt_b : "..");
+$max_order    = (defined $opt_o ? $opt_o : 2);
 $opt_f        =~ s/(.*)/\L$1\E/;
 
 my $tmp_file =  "/tmp/xc.tmp.$$";
@@ -67,7 +68,7 @@ while(data_read(*DATA, \%data) != 0){
     close DATA2;
 
     @cmp = ("zk", "vrhoa", "vsigmaaa");
-    if($data2{"v2rhoa2"} != 0.0){
+    if($max_order > 1 && $data2{"v2rhoa2"} != 0.0){
       push @cmp, ("v2rhoa2", "v2rhoasigmaaa", "v2sigmaaa2");
     }
 
@@ -89,7 +90,7 @@ while(data_read(*DATA, \%data) != 0){
       if($data{"rhob"} != 0.0){
 	# compare both up and down channels
 	push @cmp, ("vrhob", "vsigmaab", "vsigmabb");
-	if($data2{"v2rhoa2"} != 0.0){
+	if($max_order > 1 && $data2{"v2rhoa2"} != 0.0){
 	  push @cmp, ("v2rhoab", "v2rhob2",
 		      "v2rhoasigmaab", "v2rhoasigmabb", "v2rhobsigmaaa", "v2rhobsigmaab", "v2rhobsigmabb",
 		      "v2sigmaaaab", "v2sigmaaabb", "v2sigmaab2", "v2sigmaabbb", "v2sigmabb2");
@@ -119,6 +120,7 @@ Usage: $0 [options] -f functional
     -f    Functional to test
     -b    The top level build tree directory, ../ if omitted
     -s    The top level source tree directory, ../ if omitted
+    -o    Highest order of the derivatives to compare, 2 if omitted
 
 Report bugs to <marques\@tddft.org>.
 EndOfUsage